@@ -42,11 +42,15 @@
 #include "source/public/oscap_source.h"
 #include "source/xslt_priv.h"
 #include <libgen.h>
+#include <string.h>
 #include <libxml/tree.h>
 
 struct ds_sds_session {
 	struct oscap_source *source;            ///< Source DataStream raw representation
 	struct ds_sds_index *index;             ///< Source DataStream index
+	const char *raw;                        ///< Raw content of the indexed datastream or NULL
+	xmlNode *datastream;                    ///< Selected datastream read from the raw content
+	char *datastream_read_id;               ///< ID the datastream above was read for
 	char *temp_dir;                         ///< Temp directory managed by the session
 	const char *target_dir;                 ///< Target directory for current split
 	const char *datastream_id;              ///< ID of selected datastream
@@ -77,10 +81,21 @@ struct ds_sds_session *ds_sds_session_new_from_source(struct oscap_source *sourc
 	return sds_session;
 }
 
+static void ds_sds_session_free_datastream(struct ds_sds_session *session)
+{
+	if (session->datastream != NULL) {
+		xmlFreeDoc(session->datastream->doc);
+		session->datastream = NULL;
+	}
+	oscap_free(session->datastream_read_id);
+	session->datastream_read_id = NULL;
+}
+
 void ds_sds_session_free(struct ds_sds_session *sds_session)
 {
 	if (sds_session != NULL) {
 		ds_sds_index_free(sds_session->index);
+		ds_sds_session_free_datastream(sds_session);
 		if (sds_session->temp_dir != NULL) {
 			oscap_acquire_cleanup_dir(&(sds_session->temp_dir));
 		}
@@ -94,6 +109,7 @@ void ds_sds_session_reset(struct ds_sds_session *session)
 	session->checklist_id = NULL;
 	session->datastream_id = NULL;
 	session->target_dir = NULL;
+	ds_sds_session_free_datastream(session);
 	oscap_htable_free(session->component_sources, (oscap_destruct_func) oscap_source_free);
 	session->component_sources = oscap_htable_new();
 }
@@ -101,6 +117,18 @@ void ds_sds_session_reset(struct ds_sds_session *session)
 struct ds_sds_index *ds_sds_session_get_sds_idx(struct ds_sds_session *session)
 {
 	if (session->index == NULL) {
+		// Unless the DOM of the whole datastream has been built already, the
+		// components are read from the raw content when they're needed.
+		// The streaming reader is available only if the DOM hasn't been built.
+		size_t size = 0;
+		xmlTextReader *streaming = oscap_source_get_streaming_xmlTextReader(session->source);
+		const char *raw = streaming != NULL ? oscap_source_get_raw_content(session->source, &size) : NULL;
+		xmlFreeTextReader(streaming);
+		if (raw != NULL && ds_sds_index_parse_memory(raw, size, &session->index) == 0) {
+			session->raw = raw;
+			return session->index;
+		}
+
 		xmlTextReader *reader = oscap_source_get_xmlTextReader(session->source);
 		if (reader == NULL) {
 			return NULL;
@@ -231,10 +259,48 @@ struct oscap_source *ds_sds_session_select_tailoring(struct ds_sds_session *sess
 	return tailoring;
 }
 
+static xmlNode *ds_sds_session_read_datastream(struct ds_sds_session *session)
+{
+	if (session->datastream != NULL && oscap_streq(session->datastream_read_id, session->datastream_id)) {
+		return session->datastream;
+	}
+	ds_sds_session_free_datastream(session);
+
+	if (ds_sds_session_get_sds_idx(session) == NULL || session->raw == NULL) {
+		return NULL;
+	}
+	xmlNode *datastream = ds_sds_index_read_element(session->index, session->raw, session->datastream_id);
+	if (datastream != NULL && strcmp((const char *) datastream->name, "data-stream") != 0) {
+		// ID of another element, let the DOM lookup decide
+		xmlFreeDoc(datastream->doc);
+		return NULL;
+	}
+	session->datastream = datastream;
+	session->datastream_read_id = oscap_strdup(session->datastream_id);
+	return datastream;
+}
+
+xmlNode *ds_sds_session_read_component(struct ds_sds_session *session, const char *component_id)
+{
+	if (ds_sds_session_get_sds_idx(session) == NULL || session->raw == NULL) {
+		return NULL;
+	}
+	xmlNode *component = ds_sds_index_read_element(session->index, session->raw, component_id);
+	if (component != NULL && strcmp((const char *) component->name, "component") != 0 &&
+			strcmp((const char *) component->name, "extended-component") != 0) {
+		xmlFreeDoc(component->doc);
+		return NULL;
+	}
+	return component;
+}
+
 xmlNode *ds_sds_session_get_selected_datastream(struct ds_sds_session *session)
 {
-	xmlDoc *doc = oscap_source_get_xmlDoc(session->source);
-	xmlNode *datastream = ds_sds_lookup_datastream_in_collection(doc, session->datastream_id);
+	xmlNode *datastream = ds_sds_session_read_datastream(session);
+	if (datastream == NULL) {
+		xmlDoc *doc = oscap_source_get_xmlDoc(session->source);
+		datastream = ds_sds_lookup_datastream_in_collection(doc, session->datastream_id);
+	}
 	if (datastream == NULL) {
 		const char* error = session->datastream_id ?
 			oscap_sprintf("Could not find any datastream of id '%s'", session->datastream_id) :
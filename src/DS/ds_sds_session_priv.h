@@ -35,6 +35,14 @@ OSCAP_HIDDEN_START;
 
 xmlNode *ds_sds_session_get_selected_datastream(struct ds_sds_session *session);
 xmlDoc *ds_sds_session_get_xmlDoc(struct ds_sds_session *session);
+/**
+ * Read a component from the raw content of the datastream, without building
+ * the DOM of the whole datastream.
+ * @returns the component element, the caller has to free it with
+ * xmlFreeDoc(component->doc), NULL if the component has to be looked up
+ * in the DOM instead
+ */
+xmlNode *ds_sds_session_read_component(struct ds_sds_session *session, const char *component_id);
 int ds_sds_session_register_component_source(struct ds_sds_session *session, const char *relative_filepath, struct oscap_source *component);
 const char *ds_sds_session_get_target_dir(struct ds_sds_session *session);
 struct oscap_htable *ds_sds_session_get_component_sources(struct ds_sds_session *session);
@@ -280,6 +280,16 @@ static xmlNodePtr ds_sds_get_component_root_by_id(xmlDoc *doc, const char* compo
 
 static int ds_sds_dump_local_component(const char* component_id, struct ds_sds_session *session, const char *target_filename_dirname, const char *relative_filepath)
 {
+	// Read just the component if possible, the rest of the datastream isn't needed
+	xmlNodePtr component = ds_sds_session_read_component(session, component_id);
+	if (component != NULL) {
+		xmlDoc *component_doc = component->doc;
+		int ret = ds_sds_register_component(session, component_doc, node_get_child_element(component, NULL),
+				component_id, target_filename_dirname, relative_filepath);
+		xmlFreeDoc(component_doc);
+		return ret;
+	}
+
 	xmlDoc *doc = ds_sds_session_get_xmlDoc(session);
 
 	xmlNodePtr inner_root = ds_sds_get_component_root_by_id(doc, component_id);
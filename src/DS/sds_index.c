@@ -29,10 +29,15 @@
 #include "common/_error.h"
 #include "common/alloc.h"
 #include "common/elements.h"
+#include "common/oscap_string.h"
+#include "common/util.h"
 #include "sds_index_priv.h"
+#include "sds_priv.h"
 #include "source/oscap_source_priv.h"
 #include "source/public/oscap_source.h"
 
+#include <libxml/parser.h>
+#include <libxml/parserInternals.h>
 #include <libxml/xmlreader.h>
 #include <string.h>
 
@@ -212,11 +217,26 @@ static struct ds_stream_index* ds_stream_index_parse(xmlTextReaderPtr reader)
 	return ret;
 }
 
+/// Byte range of a top level element in the raw datastream
+struct ds_sds_index_range
+{
+	size_t start;	///< offset of the start tag
+	size_t end;	///< offset just after the end tag
+	int line;	///< line of the start tag
+};
+
 struct ds_sds_index
 {
 	struct oscap_list *streams;
 
 	struct oscap_htable *benchmark_id_to_component_id;
+
+	/// byte ranges of data-streams and components by their ID, NULL if unknown
+	struct oscap_htable *element_ranges;
+	/// ID of the first data-stream
+	char *first_datastream_id;
+	/// start tag redeclaring the namespaces of the data-stream-collection
+	char *collection_context;
 };
 
 struct ds_sds_index* ds_sds_index_new(void)
@@ -226,6 +246,10 @@ struct ds_sds_index* ds_sds_index_new(void)
 
 	ret->benchmark_id_to_component_id = oscap_htable_new();
 
+	ret->element_ranges = NULL;
+	ret->first_datastream_id = NULL;
+	ret->collection_context = NULL;
+
 	return ret;
 }
 
@@ -236,6 +260,11 @@ void ds_sds_index_free(struct ds_sds_index* s)
 
 		oscap_htable_free(s->benchmark_id_to_component_id, (oscap_destruct_func)oscap_free);
 
+		if (s->element_ranges != NULL)
+			oscap_htable_free(s->element_ranges, (oscap_destruct_func)oscap_free);
+		oscap_free(s->first_datastream_id);
+		oscap_free(s->collection_context);
+
 		oscap_free(s);
 	}
 }
@@ -407,6 +436,269 @@ struct ds_sds_index* ds_sds_index_parse(xmlTextReaderPtr reader)
 	return ret;
 }
 
+#define DS_SDS_INDEX_CONTEXT "oscap-context"
+
+struct ds_sds_index_range_parser
+{
+	xmlParserCtxtPtr ctxt;
+	const char *buffer;
+	int depth;
+	struct ds_sds_index *index;
+	struct oscap_string *context;
+	struct ds_sds_index_range *range;	///< range of the element being read
+	char *range_id;
+	size_t line_offset;	///< offset up to which the lines are counted
+	int line;
+	bool is_datastream;
+	bool usable;
+};
+
+static void ds_sds_index_context_append_escaped(struct oscap_string *context, const char *value)
+{
+	for (; *value != '\0'; value++) {
+		switch (*value) {
+		case '<':
+			oscap_string_append_string(context, "&lt;");
+			break;
+		case '"':
+			oscap_string_append_string(context, "&quot;");
+			break;
+		default:
+			oscap_string_append_char(context, *value);
+		}
+	}
+}
+
+static void ds_sds_index_range_start(void *ctx, const xmlChar *localname, const xmlChar *prefix,
+		const xmlChar *URI, int nb_namespaces, const xmlChar **namespaces,
+		int nb_attributes, int nb_defaulted, const xmlChar **attributes)
+{
+	struct ds_sds_index_range_parser *parser = ctx;
+
+	if (++parser->depth == 1) {
+		// the components are read in the context of the collection element
+		for (int i = 0; i < nb_namespaces; i++) {
+			const char *ns_prefix = (const char *) namespaces[2 * i];
+			const char *ns_uri = (const char *) namespaces[2 * i + 1];
+
+			oscap_string_append_string(parser->context, " xmlns");
+			if (ns_prefix != NULL) {
+				oscap_string_append_char(parser->context, ':');
+				oscap_string_append_string(parser->context, ns_prefix);
+			}
+			oscap_string_append_string(parser->context, "=\"");
+			if (ns_uri != NULL) {
+				// libxml2 keeps character references to '&' in the namespace names
+				if (strchr(ns_uri, '&') != NULL)
+					parser->usable = false;
+				ds_sds_index_context_append_escaped(parser->context, ns_uri);
+			}
+			oscap_string_append_char(parser->context, '"');
+		}
+		return;
+	}
+	if (parser->depth != 2)
+		return;
+
+	parser->is_datastream = strcmp((const char *) localname, "data-stream") == 0;
+	if (!parser->is_datastream &&
+	    strcmp((const char *) localname, "component") != 0 &&
+	    strcmp((const char *) localname, "extended-component") != 0)
+		return;
+
+	for (int i = 0; i < nb_attributes; i++) {
+		const xmlChar **attribute = attributes + 5 * i;
+
+		if (attribute[2] == NULL && strcmp((const char *) attribute[0], "id") == 0) {
+			size_t len = attribute[4] - attribute[3];
+
+			parser->range_id = oscap_alloc(len + 1);
+			memcpy(parser->range_id, attribute[3], len);
+			parser->range_id[len] = '\0';
+			break;
+		}
+	}
+	if (parser->range_id == NULL)
+		return;
+
+	// the parser stopped at the end of the start tag, attribute values
+	// can't contain a raw '<'
+	const char *start = parser->buffer + xmlByteConsumed(parser->ctxt);
+	while (start > parser->buffer && *start != '<')
+		start--;
+
+	const char *counted = parser->buffer + parser->line_offset;
+	while ((counted = memchr(counted, '\n', start - counted)) != NULL) {
+		parser->line++;
+		counted++;
+	}
+	parser->line_offset = start - parser->buffer;
+
+	parser->range = oscap_alloc(sizeof(struct ds_sds_index_range));
+	parser->range->start = start - parser->buffer;
+	parser->range->end = 0;
+	parser->range->line = parser->line;
+}
+
+static void ds_sds_index_range_end(void *ctx, const xmlChar *localname, const xmlChar *prefix, const xmlChar *URI)
+{
+	struct ds_sds_index_range_parser *parser = ctx;
+
+	if (parser->depth-- != 2 || parser->range == NULL)
+		return;
+
+	// the parser stopped just after the end tag
+	parser->range->end = xmlByteConsumed(parser->ctxt);
+
+	if (parser->is_datastream && parser->index->first_datastream_id == NULL)
+		parser->index->first_datastream_id = oscap_strdup(parser->range_id);
+
+	// the first element of given ID is used, the same way as with DOM lookups
+	if (!oscap_htable_add(parser->index->element_ranges, parser->range_id, parser->range))
+		oscap_free(parser->range);
+
+	oscap_free(parser->range_id);
+	parser->range_id = NULL;
+	parser->range = NULL;
+}
+
+static void ds_sds_index_range_subset(void *ctx, const xmlChar *name, const xmlChar *ExternalID, const xmlChar *SystemID)
+{
+	struct ds_sds_index_range_parser *parser = ctx;
+
+	// entities declared in the DTD wouldn't be available to the components
+	parser->usable = false;
+}
+
+static void ds_sds_index_range_error(void *ctx, xmlErrorPtr error)
+{
+	// errors are reported when the DOM is built
+}
+
+static int ds_sds_index_parse_ranges(struct ds_sds_index *index, const char *buffer, size_t size)
+{
+	xmlSAXHandler sax;
+	memset(&sax, 0, sizeof(sax));
+	sax.initialized = XML_SAX2_MAGIC;
+	sax.startElementNs = ds_sds_index_range_start;
+	sax.endElementNs = ds_sds_index_range_end;
+	sax.internalSubset = ds_sds_index_range_subset;
+	sax.serror = ds_sds_index_range_error;
+
+	xmlParserCtxtPtr ctxt = xmlCreateMemoryParserCtxt(buffer, size);
+	if (ctxt == NULL)
+		return -1;
+	xmlFree(ctxt->sax);
+	ctxt->sax = &sax;
+
+	struct ds_sds_index_range_parser parser = {
+		.ctxt = ctxt,
+		.buffer = buffer,
+		.index = index,
+		.context = oscap_string_new(),
+		.line = 1,
+		.usable = true
+	};
+	ctxt->userData = &parser;
+	index->element_ranges = oscap_htable_new();
+
+	xmlParseDocument(ctxt);
+
+	// the offsets are valid only if the parser didn't need to convert the encoding
+	if (!ctxt->wellFormed || ctxt->input == NULL || ctxt->input->buf == NULL ||
+	    ctxt->input->buf->encoder != NULL)
+		parser.usable = false;
+
+	ctxt->sax = NULL;
+	xmlFreeParserCtxt(ctxt);
+	oscap_free(parser.range);
+	oscap_free(parser.range_id);
+
+	if (parser.usable) {
+		index->collection_context = oscap_sprintf("<" DS_SDS_INDEX_CONTEXT "%s>", oscap_string_get_cstr(parser.context));
+	} else {
+		oscap_htable_free(index->element_ranges, (oscap_destruct_func)oscap_free);
+		index->element_ranges = NULL;
+		oscap_free(index->first_datastream_id);
+		index->first_datastream_id = NULL;
+	}
+	oscap_string_free(parser.context);
+
+	return parser.usable ? 0 : -1;
+}
+
+int ds_sds_index_parse_memory(const char *buffer, size_t size, struct ds_sds_index **index)
+{
+	struct ds_sds_index *ranges = ds_sds_index_new();
+	if (ds_sds_index_parse_ranges(ranges, buffer, size) != 0) {
+		ds_sds_index_free(ranges);
+		return -1;
+	}
+
+	xmlTextReaderPtr reader = xmlReaderForMemory(buffer, size, NULL, NULL, 0);
+	if (reader == NULL) {
+		ds_sds_index_free(ranges);
+		return -1;
+	}
+	*index = ds_sds_index_parse(reader);
+	xmlFreeTextReader(reader);
+
+	if (*index == NULL) {
+		ds_sds_index_free(ranges);
+		return -1;
+	}
+
+	(*index)->element_ranges = ranges->element_ranges;
+	(*index)->first_datastream_id = ranges->first_datastream_id;
+	(*index)->collection_context = ranges->collection_context;
+	ranges->element_ranges = NULL;
+	ranges->first_datastream_id = NULL;
+	ranges->collection_context = NULL;
+	ds_sds_index_free(ranges);
+	return 0;
+}
+
+xmlNodePtr ds_sds_index_read_element(struct ds_sds_index *s, const char *buffer, const char *id)
+{
+	if (s->element_ranges == NULL)
+		return NULL;
+
+	if (id == NULL)
+		id = s->first_datastream_id;
+	struct ds_sds_index_range *range = (id != NULL) ? oscap_htable_get(s->element_ranges, id) : NULL;
+	if (range == NULL)
+		return NULL;
+
+	// The element is parsed inside of an element declaring the namespaces
+	// of the collection, the same as the namespaces in scope in the whole
+	// datastream. The buffer doesn't need to be copied.
+	static const char context_end[] = "</" DS_SDS_INDEX_CONTEXT ">";
+	xmlParserCtxtPtr ctxt = xmlCreatePushParserCtxt(NULL, NULL,
+			s->collection_context, strlen(s->collection_context), NULL);
+	if (ctxt == NULL)
+		return NULL;
+	xmlCtxtUseOptions(ctxt, 0);
+	// the context has no line breaks, keep the line numbers of the datastream
+	ctxt->input->line = range->line;
+
+	xmlParseChunk(ctxt, buffer + range->start, range->end - range->start, 0);
+	xmlParseChunk(ctxt, context_end, sizeof(context_end) - 1, 1);
+
+	xmlDocPtr doc = ctxt->myDoc;
+	bool well_formed = ctxt->wellFormed;
+	xmlFreeParserCtxt(ctxt);
+
+	xmlNodePtr element = NULL;
+	if (doc != NULL && well_formed) {
+		xmlNodePtr root = xmlDocGetRootElement(doc);
+		element = root != NULL ? node_get_child_element(root, NULL) : NULL;
+	}
+	if (element == NULL && doc != NULL)
+		xmlFreeDoc(doc);
+
+	return element;
+}
+
 struct ds_sds_index *ds_sds_index_import(const char* file)
 {
 	struct oscap_source *source = oscap_source_new_from_file(file);
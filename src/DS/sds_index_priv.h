@@ -34,5 +34,30 @@ OSCAP_HIDDEN_START;
 
 struct ds_sds_index* ds_sds_index_parse(xmlTextReaderPtr reader);
 
+/**
+ * Build the index of a Source DataStream from its raw content. The byte
+ * ranges of the data-streams and components are recorded as well, so that
+ * they can be read later without parsing the whole datastream.
+ * @param buffer raw content of the datastream
+ * @param size size of the content
+ * @param index the index, as returned by ds_sds_index_parse
+ * @returns 0 on success, -1 if the raw content can't be indexed (it isn't
+ * well-formed, it isn't encoded in UTF-8 or it has a DTD) or the index
+ * can't be parsed, *index is NULL then
+ */
+int ds_sds_index_parse_memory(const char *buffer, size_t size, struct ds_sds_index **index);
+
+/**
+ * Parse a single data-stream or component of a datastream indexed by
+ * ds_sds_index_parse_memory. The namespaces in scope are the same as in the
+ * whole datastream.
+ * @param s the index
+ * @param buffer the raw content which has been indexed
+ * @param id ID of the element, NULL for the first data-stream
+ * @returns the element in a new document, the caller has to free it with
+ * xmlFreeDoc(element->doc), NULL if the element isn't available
+ */
+xmlNodePtr ds_sds_index_read_element(struct ds_sds_index *s, const char *buffer, const char *id);
+
 OSCAP_HIDDEN_END;
 #endif
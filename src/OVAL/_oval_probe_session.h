@@ -45,6 +45,10 @@ struct oval_probe_session {
         struct oval_syschar_model *sys_model; /**< system characteristics model */
         char         *dir;  /**< probe session directory */
         uint32_t      flg;  /**< probe session flags */
+        struct oval_probe_sync *sync; /**< set if the session is used concurrently with other sessions */
+        bool          sync_held; /**< the thread using the session holds the lock of the group */
+        struct oval_definition_model *hint_model; /**< definition model the hints were computed for */
+        struct oval_string_map *hint_ents; /**< costly entities referenced by the states, by object ID */
 };
 
 #endif /* _OVAL_PROBE_SESSION */
@@ -191,7 +191,7 @@ void oval_string_map_free_string(struct oval_string_map *map)
 {
 	oval_string_map_free(map, oscap_free);
 }
-#else
+#elif defined(OVAL_STRINGMAP_RBT)
 # include <rbt/rbt.h>
 # include <assume.h>
 
@@ -330,4 +330,359 @@ struct oval_collection *oval_string_map_collect_values(struct oval_string_map *m
 	return (collection);
 }
 
-#endif /* OVAL_STRINGMAP_LINEAR */
+#else
+# include <stdint.h>
+# include <assume.h>
+# if defined(OSCAP_THREAD_SAFE)
+#  include <pthread.h>
+# endif
+# include "common/alloc.h"
+
+/*
+ * Open addressing hash table with linear probing. The entries are stored
+ * in an array in the order of insertion and the table contains indexes into
+ * that array, so growing the table doesn't move the entries. The keys are
+ * copied into large chunks of memory which are freed all at once together
+ * with the map. Entries are never removed.
+ *
+ * The iterators return the entries sorted by the key, like the red-black
+ * tree did. The sorted view is built on the first iteration and reused until
+ * the next insertion (which may move the entries).
+ */
+
+#define OVAL_STRING_MAP_INITSIZE  16       /**< initial size of the table, must be a power of 2 */
+#define OVAL_STRING_MAP_CHUNKSIZE 4096     /**< size of a key chunk */
+
+struct oval_string_map_entry {
+	const char *key;
+	void       *val;
+	uint32_t    hash;
+};
+
+struct oval_string_map_chunk {
+	struct oval_string_map_chunk *next;
+	size_t used;
+	size_t size;
+	char   data[];
+};
+
+struct oval_string_map {
+	uint32_t *table;  /**< index + 1 into entries, 0 is an empty slot */
+	size_t    tsize;
+	struct oval_string_map_entry *entries;
+	size_t    count;
+	size_t    alloc;
+	struct oval_string_map_entry **sorted; /**< entries sorted by key, NULL if not built */
+	struct oval_string_map_chunk *chunks;
+#if defined(OSCAP_THREAD_SAFE)
+	pthread_rwlock_t lock;
+#endif
+};
+
+#if defined(OSCAP_THREAD_SAFE)
+# define oval_string_map_rdlock(map) pthread_rwlock_rdlock(&(map)->lock)
+# define oval_string_map_wrlock(map) pthread_rwlock_wrlock(&(map)->lock)
+# define oval_string_map_unlock(map) pthread_rwlock_unlock(&(map)->lock)
+#else
+# define oval_string_map_rdlock(map) do {} while(0)
+# define oval_string_map_wrlock(map) do {} while(0)
+# define oval_string_map_unlock(map) do {} while(0)
+#endif
+
+static inline uint32_t oval_string_map_hash(const char *key, size_t *len)
+{
+	const unsigned char *p;
+	uint32_t h = 2166136261U; /* FNV-1a */
+
+	for (p = (const unsigned char *)key; *p != '\0'; ++p) {
+		h ^= *p;
+		h *= 16777619U;
+	}
+
+	*len = (const char *)p - key;
+
+	return (h);
+}
+
+struct oval_string_map *oval_string_map_new(void)
+{
+	struct oval_string_map *map;
+
+	map = oscap_talloc(struct oval_string_map);
+	map->tsize   = OVAL_STRING_MAP_INITSIZE;
+	map->table   = oscap_calloc(map->tsize, sizeof(uint32_t));
+	map->entries = NULL;
+	map->count   = 0;
+	map->alloc   = 0;
+	map->sorted  = NULL;
+	map->chunks  = NULL;
+#if defined(OSCAP_THREAD_SAFE)
+	pthread_rwlock_init(&map->lock, NULL);
+#endif
+	return (map);
+}
+
+/* the lock has to be held */
+static struct oval_string_map_entry *oval_string_map_find(struct oval_string_map *map, const char *key,
+							  uint32_t hash, size_t *slot)
+{
+	size_t i, mask = map->tsize - 1;
+	struct oval_string_map_entry *e;
+
+	for (i = hash & mask; map->table[i] != 0; i = (i + 1) & mask) {
+		e = map->entries + (map->table[i] - 1);
+
+		if (e->hash == hash && strcmp(e->key, key) == 0)
+			return (e);
+	}
+
+	if (slot != NULL)
+		*slot = i;
+
+	return (NULL);
+}
+
+static const char *oval_string_map_intern(struct oval_string_map *map, const char *key, size_t len)
+{
+	struct oval_string_map_chunk *c = map->chunks;
+	char *copy;
+
+	if (c == NULL || c->size - c->used < len + 1) {
+		size_t size = len + 1 > OVAL_STRING_MAP_CHUNKSIZE ? len + 1 : OVAL_STRING_MAP_CHUNKSIZE;
+
+		c = oscap_alloc(sizeof(struct oval_string_map_chunk) + size);
+		c->used = 0;
+		c->size = size;
+
+		/* keep the partially used chunk in front if the key doesn't fit into it */
+		if (map->chunks != NULL && size > OVAL_STRING_MAP_CHUNKSIZE) {
+			c->next = map->chunks->next;
+			map->chunks->next = c;
+		} else {
+			c->next = map->chunks;
+			map->chunks = c;
+		}
+	}
+
+	copy = c->data + c->used;
+	memcpy(copy, key, len + 1);
+	c->used += len + 1;
+
+	return (copy);
+}
+
+static void oval_string_map_grow(struct oval_string_map *map)
+{
+	size_t i, j, mask;
+
+	oscap_free(map->table);
+	map->tsize *= 2;
+	map->table  = oscap_calloc(map->tsize, sizeof(uint32_t));
+	mask = map->tsize - 1;
+
+	for (i = 0; i < map->count; ++i) {
+		for (j = map->entries[i].hash & mask; map->table[j] != 0; j = (j + 1) & mask);
+		map->table[j] = i + 1;
+	}
+}
+
+/* @return 0 on success, -1 if the key is already in the map */
+static int oval_string_map_add(struct oval_string_map *map, const char *key, void *val)
+{
+	struct oval_string_map_entry *e;
+	size_t len, slot;
+	uint32_t hash;
+
+	hash = oval_string_map_hash(key, &len);
+
+	oval_string_map_wrlock(map);
+
+	if (oval_string_map_find(map, key, hash, &slot) != NULL) {
+		oval_string_map_unlock(map);
+		return (-1);
+	}
+
+	if (map->count == map->alloc) {
+		map->alloc   = map->alloc == 0 ? OVAL_STRING_MAP_INITSIZE : map->alloc * 2;
+		map->entries = oscap_realloc(map->entries, map->alloc * sizeof(struct oval_string_map_entry));
+	}
+
+	e = map->entries + map->count;
+	e->key  = oval_string_map_intern(map, key, len);
+	e->val  = val;
+	e->hash = hash;
+
+	map->table[slot] = ++map->count;
+
+	/* keep the load factor under 1/2 */
+	if (map->count * 2 > map->tsize)
+		oval_string_map_grow(map);
+
+	if (map->sorted != NULL) {
+		oscap_free(map->sorted);
+		map->sorted = NULL;
+	}
+
+	oval_string_map_unlock(map);
+	return (0);
+}
+
+void oval_string_map_put(struct oval_string_map *map, const char *key, void *val)
+{
+	assume_d(map != NULL, /* void */);
+	assume_d(key != NULL, /* void */);
+
+	if (oval_string_map_add(map, key, val) != 0)
+		dW("oval_string_map_put: key '%s' already exists", key);
+}
+
+void oval_string_map_put_string(struct oval_string_map *map, const char *key, const char *val)
+{
+	char *str;
+
+	assume_d(map != NULL, /* void */);
+	assume_d(key != NULL, /* void */);
+
+	str = strdup(val);
+
+	if (oval_string_map_add(map, key, str) != 0)
+		oscap_free(str);
+}
+
+void *oval_string_map_get_value(struct oval_string_map *map, const char *key)
+{
+	struct oval_string_map_entry *e;
+	size_t len;
+	uint32_t hash;
+	void *val;
+
+	assume_d(map != NULL, NULL);
+	assume_d(key != NULL, NULL);
+
+	hash = oval_string_map_hash(key, &len);
+
+	oval_string_map_rdlock(map);
+	e   = oval_string_map_find(map, key, hash, NULL);
+	val = e != NULL ? e->val : NULL;
+	oval_string_map_unlock(map);
+
+	return (val);
+}
+
+void oval_string_map_free(struct oval_string_map *map, oscap_destruct_func destroy)
+{
+	struct oval_string_map_chunk *c, *next;
+	size_t i;
+
+	assume_d(map != NULL, /* void */);
+
+	if (destroy != NULL)
+		for (i = 0; i < map->count; ++i)
+			destroy(map->entries[i].val);
+
+	for (c = map->chunks; c != NULL; c = next) {
+		next = c->next;
+		oscap_free(c);
+	}
+
+#if defined(OSCAP_THREAD_SAFE)
+	pthread_rwlock_destroy(&map->lock);
+#endif
+	oscap_free(map->sorted);
+	oscap_free(map->entries);
+	oscap_free(map->table);
+	oscap_free(map);
+}
+
+void oval_string_map_free0(struct oval_string_map *map)
+{
+	oval_string_map_free(map, NULL);
+}
+
+void oval_string_map_free_string(struct oval_string_map *map)
+{
+	assume_d(map != NULL, /* void */);
+	oval_string_map_free(map, oscap_free);
+}
+
+static int __oval_string_map_keycmp(const void *a, const void *b)
+{
+	return strcmp((*(struct oval_string_map_entry * const *)a)->key,
+		      (*(struct oval_string_map_entry * const *)b)->key);
+}
+
+/*
+ * Calls the callback for each entry in the order of the keys.
+ */
+static void oval_string_map_walk(struct oval_string_map *map, void (*callback)(const struct oval_string_map_entry *, void *), void *arg)
+{
+	size_t i;
+
+	oval_string_map_wrlock(map);
+
+	if (map->sorted == NULL && map->count > 0) {
+		map->sorted = oscap_alloc(map->count * sizeof(struct oval_string_map_entry *));
+
+		for (i = 0; i < map->count; ++i)
+			map->sorted[i] = map->entries + i;
+
+		qsort(map->sorted, map->count, sizeof(struct oval_string_map_entry *), __oval_string_map_keycmp);
+	}
+
+	for (i = 0; i < map->count; ++i)
+		callback(map->sorted[i], arg);
+
+	oval_string_map_unlock(map);
+}
+
+static void __oval_iterator_addkey(const struct oval_string_map_entry *e, void *u)
+{
+	oval_collection_iterator_add((struct oval_iterator *)u, (void *)e->key);
+}
+
+static void __oval_iterator_addval(const struct oval_string_map_entry *e, void *u)
+{
+	oval_collection_iterator_add((struct oval_iterator *)u, e->val);
+}
+
+static void __oval_collection_addval(const struct oval_string_map_entry *e, void *u)
+{
+	oval_collection_add((struct oval_collection *)u, e->val);
+}
+
+struct oval_iterator *oval_string_map_keys(struct oval_string_map *map)
+{
+	struct oval_iterator *it;
+
+	assume_d(map != NULL, NULL);
+
+	it = oval_collection_iterator_new();
+	oval_string_map_walk(map, __oval_iterator_addkey, it);
+
+	return (it);
+}
+
+struct oval_iterator *oval_string_map_values(struct oval_string_map *map)
+{
+	struct oval_iterator *it;
+
+	assume_d(map != NULL, NULL);
+
+	it = oval_collection_iterator_new();
+	oval_string_map_walk(map, __oval_iterator_addval, it);
+
+	return (it);
+}
+
+struct oval_collection *oval_string_map_collect_values(struct oval_string_map *map, struct oval_collection *collection)
+{
+	assume_d(map != NULL, NULL);
+
+	if (collection == NULL)
+		collection = oval_collection_new();
+	oval_string_map_walk(map, __oval_collection_addval, collection);
+
+	return (collection);
+}
+
+#endif /* OVAL_STRINGMAP_OLD */
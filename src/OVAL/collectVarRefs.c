@@ -28,9 +28,11 @@
 #include "oval_definitions_impl.h"
 #include "adt/oval_string_map_impl.h"
 
-static void _var_collect_var_refs(struct oval_variable *var, struct oval_string_map *vm);
+static void _var_collect_var_refs(struct oval_variable *var, struct oval_string_map *vm, struct oval_string_map *om);
+static void _obj_collect_refs(struct oval_object *obj, struct oval_string_map *vm, struct oval_string_map *om);
+static void _ste_collect_refs(struct oval_state *ste, struct oval_string_map *vm, struct oval_string_map *om);
 
-static void _comp_collect_var_refs(struct oval_component *comp, struct oval_string_map *vm)
+static void _comp_collect_var_refs(struct oval_component *comp, struct oval_string_map *vm, struct oval_string_map *om)
 {
 	struct oval_object *obj;
 	struct oval_variable *var;
@@ -39,11 +41,11 @@ static void _comp_collect_var_refs(struct oval_component *comp, struct oval_stri
 	switch (oval_component_get_type(comp)) {
 	case OVAL_COMPONENT_OBJECTREF:
 		obj = oval_component_get_object(comp);
-		oval_obj_collect_var_refs(obj, vm);
+		_obj_collect_refs(obj, vm, om);
 		break;
 	case OVAL_COMPONENT_VARREF:
 		var = oval_component_get_variable(comp);
-		_var_collect_var_refs(var, vm);
+		_var_collect_var_refs(var, vm, om);
 		break;
 	case OVAL_FUNCTION_ARITHMETIC:
 	case OVAL_FUNCTION_BEGIN:
@@ -54,12 +56,15 @@ static void _comp_collect_var_refs(struct oval_component *comp, struct oval_stri
 	case OVAL_FUNCTION_SPLIT:
 	case OVAL_FUNCTION_SUBSTRING:
 	case OVAL_FUNCTION_TIMEDIF:
+	case OVAL_FUNCTION_COUNT:
+	case OVAL_FUNCTION_UNIQUE:
+	case OVAL_FUNCTION_GLOB_TO_REGEX:
 		cmp_itr = oval_component_get_function_components(comp);
 		while (oval_component_iterator_has_more(cmp_itr)) {
 			struct oval_component *cmp;
 
 			cmp = oval_component_iterator_next(cmp_itr);
-			_comp_collect_var_refs(cmp, vm);
+			_comp_collect_var_refs(cmp, vm, om);
 		}
 		oval_component_iterator_free(cmp_itr);
 		break;
@@ -68,7 +73,7 @@ static void _comp_collect_var_refs(struct oval_component *comp, struct oval_stri
 	}
 }
 
-static void _var_collect_var_refs(struct oval_variable *var, struct oval_string_map *vm)
+static void _var_collect_var_refs(struct oval_variable *var, struct oval_string_map *vm, struct oval_string_map *om)
 {
 	char *var_id;
 
@@ -79,11 +84,11 @@ static void _var_collect_var_refs(struct oval_variable *var, struct oval_string_
 		struct oval_component *comp;
 
 		comp = oval_variable_get_component(var);
-		_comp_collect_var_refs(comp, vm);
+		_comp_collect_var_refs(comp, vm, om);
 	}
 }
 
-static void _ent_collect_var_refs(struct oval_entity *ent, struct oval_string_map *vm)
+static void _ent_collect_var_refs(struct oval_entity *ent, struct oval_string_map *vm, struct oval_string_map *om)
 {
 	oval_entity_varref_type_t vrt;
 
@@ -93,11 +98,11 @@ static void _ent_collect_var_refs(struct oval_entity *ent, struct oval_string_ma
 		struct oval_variable *var;
 
 		var = oval_entity_get_variable(ent);
-		_var_collect_var_refs(var, vm);
+		_var_collect_var_refs(var, vm, om);
 	}
 }
 
-void oval_ste_collect_var_refs(struct oval_state *ste, struct oval_string_map *vm)
+static void _ste_collect_refs(struct oval_state *ste, struct oval_string_map *vm, struct oval_string_map *om)
 {
 	struct oval_state_content_iterator *cont_itr;
 
@@ -108,12 +113,12 @@ void oval_ste_collect_var_refs(struct oval_state *ste, struct oval_string_map *v
 
 		cont = oval_state_content_iterator_next(cont_itr);
 		ent = oval_state_content_get_entity(cont);
-		_ent_collect_var_refs(ent, vm);
+		_ent_collect_var_refs(ent, vm, om);
 	}
 	oval_state_content_iterator_free(cont_itr);
 }
 
-static void _set_collect_var_refs(struct oval_setobject *set, struct oval_string_map *vm)
+static void _set_collect_var_refs(struct oval_setobject *set, struct oval_string_map *vm, struct oval_string_map *om)
 {
 	struct oval_setobject_iterator *subset_itr;
 	struct oval_object_iterator *obj_itr;
@@ -126,7 +131,7 @@ static void _set_collect_var_refs(struct oval_setobject *set, struct oval_string
 			struct oval_setobject *subset;
 
 			subset = oval_setobject_iterator_next(subset_itr);
-			_set_collect_var_refs(subset, vm);
+			_set_collect_var_refs(subset, vm, om);
 		}
 		oval_setobject_iterator_free(subset_itr);
 		break;
@@ -136,7 +141,7 @@ static void _set_collect_var_refs(struct oval_setobject *set, struct oval_string
 			struct oval_object *obj;
 
 			obj = oval_object_iterator_next(obj_itr);
-			oval_obj_collect_var_refs(obj, vm);
+			_obj_collect_refs(obj, vm, om);
 		}
 		oval_object_iterator_free(obj_itr);
 		fil_itr = oval_setobject_get_filters(set);
@@ -146,7 +151,7 @@ static void _set_collect_var_refs(struct oval_setobject *set, struct oval_string
 
 			fil = oval_filter_iterator_next(fil_itr);
 			ste = oval_filter_get_state(fil);
-			oval_ste_collect_var_refs(ste, vm);
+			_ste_collect_refs(ste, vm, om);
 		}
 		oval_filter_iterator_free(fil_itr);
 		break;
@@ -155,10 +160,13 @@ static void _set_collect_var_refs(struct oval_setobject *set, struct oval_string
 	}
 }
 
-void oval_obj_collect_var_refs(struct oval_object *obj, struct oval_string_map *vm)
+static void _obj_collect_refs(struct oval_object *obj, struct oval_string_map *vm, struct oval_string_map *om)
 {
 	struct oval_object_content_iterator *cont_itr;
 
+	if (om != NULL)
+		oval_string_map_put(om, oval_object_get_id(obj), obj);
+
 	cont_itr = oval_object_get_object_contents(obj);
 	while (oval_object_content_iterator_has_more(cont_itr)) {
 		struct oval_object_content *cont;
@@ -172,16 +180,16 @@ void oval_obj_collect_var_refs(struct oval_object *obj, struct oval_string_map *
 		switch (oval_object_content_get_type(cont)) {
 		case OVAL_OBJECTCONTENT_ENTITY:
 			ent = oval_object_content_get_entity(cont);
-			_ent_collect_var_refs(ent, vm);
+			_ent_collect_var_refs(ent, vm, om);
 			break;
 		case OVAL_OBJECTCONTENT_SET:
 			set = oval_object_content_get_setobject(cont);
-			_set_collect_var_refs(set, vm);
+			_set_collect_var_refs(set, vm, om);
 			break;
 		case OVAL_OBJECTCONTENT_FILTER:
 			flt = oval_object_content_get_filter(cont);
 			ste = oval_filter_get_state(flt);
-			oval_ste_collect_var_refs(ste, vm);
+			_ste_collect_refs(ste, vm, om);
 			break;
 		default:
 			break;
@@ -189,3 +197,23 @@ void oval_obj_collect_var_refs(struct oval_object *obj, struct oval_string_map *
 	}
 	oval_object_content_iterator_free(cont_itr);
 }
+
+void oval_obj_collect_var_refs(struct oval_object *obj, struct oval_string_map *vm)
+{
+	_obj_collect_refs(obj, vm, NULL);
+}
+
+void oval_ste_collect_var_refs(struct oval_state *ste, struct oval_string_map *vm)
+{
+	_ste_collect_refs(ste, vm, NULL);
+}
+
+void oval_obj_collect_refs(struct oval_object *obj, struct oval_string_map *vm, struct oval_string_map *om)
+{
+	_obj_collect_refs(obj, vm, om);
+}
+
+void oval_ste_collect_refs(struct oval_state *ste, struct oval_string_map *vm, struct oval_string_map *om)
+{
+	_ste_collect_refs(ste, vm, om);
+}
@@ -35,6 +35,12 @@ OSCAP_HIDDEN_START;
 void oval_obj_collect_var_refs(struct oval_object *obj, struct oval_string_map *vm);
 void oval_ste_collect_var_refs(struct oval_state *ste, struct oval_string_map *vm);
 
+/* Same as above, but also collect the objects which are referenced from sets
+ * and object components (and the object itself) as pairs of (obj id, obj pointer).
+ */
+void oval_obj_collect_refs(struct oval_object *obj, struct oval_string_map *vm, struct oval_string_map *om);
+void oval_ste_collect_refs(struct oval_state *ste, struct oval_string_map *vm, struct oval_string_map *om);
+
 OSCAP_HIDDEN_END;
 
 #endif
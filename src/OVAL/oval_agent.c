@@ -32,6 +32,8 @@
 #include <config.h>
 #endif
 
+#include <errno.h>
+#include <pthread.h>
 #include <string.h>
 #include <time.h>
 #include <assume.h>
@@ -43,12 +45,15 @@
 #include "adt/oval_string_map_impl.h"
 #include "oval_system_characteristics_impl.h"
 #include "oval_probe_impl.h"
+#include "collectVarRefs_impl.h"
 #include "results/oval_results_impl.h"
+#include "results/oval_cmp_regex_impl.h"
 #include "common/list.h"
 #include "common/util.h"
 #include "common/debug_priv.h"
 #include "common/_error.h"
 #include "oval_agent_xccdf_api.h"
+#include "XCCDF_POLICY/xccdf_policy_model_priv.h"
 
 struct oval_agent_session {
 	char *filename;
@@ -60,6 +65,8 @@ struct oval_agent_session {
 	struct oval_syschar_model    * sys_models[2];
 	struct oval_results_model    * res_model;
 	oval_probe_session_t  * psess;
+	oval_probe_session_t ** psessv; /**< probe sessions of the parallel evaluation threads */
+	size_t                  psessc;
 };
 
 
@@ -103,6 +110,8 @@ oval_agent_session_t * oval_agent_new_session(struct oval_definition_model *mode
 	ag_sess->cur_var_model = NULL;
 	ag_sess->sys_model = oval_syschar_model_new(model);
 	ag_sess->psess     = oval_probe_session_new(ag_sess->sys_model);
+	ag_sess->psessv    = NULL;
+	ag_sess->psessc    = 0;
 
 	/* probe sysinfo */
 	ret = oval_probe_query_sysinfo(ag_sess->psess, &sysinfo);
@@ -238,12 +247,626 @@ int oval_agent_reset_session(oval_agent_session_t * ag_sess) {
 
 int oval_agent_abort_session(oval_agent_session_t *ag_sess)
 {
+	size_t i;
+
 	assume_d(ag_sess != NULL, -1);
 	assume_d(ag_sess->psess != NULL, -1);
 
+	for (i = 0; i < ag_sess->psessc; ++i)
+		oval_probe_session_abort(ag_sess->psessv[i]);
+
 	return oval_probe_session_abort(ag_sess->psess);
 }
 
+/**
+ * Report the result of an evaluated definition.
+ * @param ret return value of oval_agent_eval_definition() on input
+ * @returns 0 to continue with the next definition; 1 to stop the evaluation
+ * with *ret being the return value
+ */
+static int _oval_agent_report_definition(struct oval_result_definition *res_def, agent_reporter cb, void *arg, int *ret)
+{
+	if (*ret == -1)
+		return 1;
+
+	/* callback */
+	if (cb != NULL) {
+		*ret = cb(res_def, arg);
+		/* stop? */
+		if (*ret != 0)
+			return 1;
+	}
+
+	/* probe evaluation terminated by signal */
+	if (*ret == -2) {
+		*ret = 1;
+		return 1;
+	}
+
+	return 0;
+}
+
+static int _oval_agent_report(oval_agent_session_t *ag_sess, const char *id, agent_reporter cb, void *arg, int *ret)
+{
+	struct oval_result_definition *res_def = NULL;
+
+	if (*ret != -1 && cb != NULL)
+		res_def = oval_agent_get_result_definition(ag_sess, id);
+
+	return _oval_agent_report_definition(res_def, cb, arg, ret);
+}
+
+/**
+ * Evaluate a definition and report its result.
+ * @returns 0 to continue with the next definition; 1 to stop the evaluation
+ * with *ret being the return value
+ */
+static int _oval_agent_eval_and_report(oval_agent_session_t *ag_sess, const char *id, agent_reporter cb, void *arg, int *ret)
+{
+	/* probe and eval */
+	*ret = oval_agent_eval_definition(ag_sess, id);
+
+	return _oval_agent_report(ag_sess, id, cb, arg, ret);
+}
+
+/*
+ * Asynchronous dispatch: objects of all the definitions are pipelined to the
+ * probes up front and each definition is evaluated (in document order) as soon
+ * as all the objects referenced by its criteria are collected.
+ */
+struct oval_agent_prefetch_obj {
+	struct oval_object *obj;
+	size_t *defv;   /**< indexes of the definitions referencing the object */
+	size_t  defc;
+};
+
+struct oval_agent_prefetch {
+	oval_agent_session_t *ag_sess;
+	struct oval_definition **defv;
+	size_t *pending;                /**< number of uncollected objects per definition */
+	size_t  defc;
+	size_t  next;                   /**< next definition to evaluate */
+	struct oval_string_map *objmap; /**< object id -> struct oval_agent_prefetch_obj */
+	struct oval_object **objv;
+	size_t  objc;
+	agent_reporter cb;
+	void   *arg;
+	int     ret;
+	bool    stop;
+};
+
+static void _oval_agent_prefetch_obj_free(struct oval_agent_prefetch_obj *pobj)
+{
+	oscap_free(pobj->defv);
+	oscap_free(pobj);
+}
+
+static void _oval_agent_prefetch_criteria(struct oval_agent_prefetch *pf, size_t di,
+					  struct oval_criteria_node *cnode, struct oval_string_map *seen)
+{
+	switch (oval_criteria_node_get_type(cnode)) {
+	case OVAL_NODETYPE_CRITERION:{
+		struct oval_test *test = oval_criteria_node_get_test(cnode);
+		struct oval_object *obj = (test != NULL ? oval_test_get_object(test) : NULL);
+		struct oval_agent_prefetch_obj *pobj;
+		char *oid;
+
+		if (obj == NULL || oval_test_get_subtype(test) != oval_object_get_subtype(obj))
+			return;
+
+		oid = oval_object_get_id(obj);
+		pobj = oval_string_map_get_value(pf->objmap, oid);
+
+		if (pobj == NULL) {
+			pobj = oscap_talloc(struct oval_agent_prefetch_obj);
+			pobj->obj  = obj;
+			pobj->defv = NULL;
+			pobj->defc = 0;
+			oval_string_map_put(pf->objmap, oid, pobj);
+
+			pf->objv = oscap_realloc(pf->objv, sizeof(struct oval_object *) * (pf->objc + 1));
+			pf->objv[pf->objc++] = obj;
+		} else if (pobj->defc > 0 && pobj->defv[pobj->defc - 1] == di) {
+			return;
+		}
+
+		pobj->defv = oscap_realloc(pobj->defv, sizeof(size_t) * (pobj->defc + 1));
+		pobj->defv[pobj->defc++] = di;
+		++pf->pending[di];
+		return;
+	}
+	case OVAL_NODETYPE_CRITERIA:{
+		struct oval_criteria_node_iterator *cnode_it = oval_criteria_node_get_subnodes(cnode);
+
+		if (cnode_it == NULL)
+			return;
+		while (oval_criteria_node_iterator_has_more(cnode_it))
+			_oval_agent_prefetch_criteria(pf, di, oval_criteria_node_iterator_next(cnode_it), seen);
+		oval_criteria_node_iterator_free(cnode_it);
+		return;
+	}
+	case OVAL_NODETYPE_EXTENDDEF:{
+		struct oval_definition *def = oval_criteria_node_get_definition(cnode);
+		struct oval_criteria_node *criteria;
+		char *def_id;
+
+		if (def == NULL)
+			return;
+		def_id = oval_definition_get_id(def);
+		if (oval_string_map_get_value(seen, def_id) != NULL)
+			return;
+		oval_string_map_put(seen, def_id, def);
+
+		criteria = oval_definition_get_criteria(def);
+		if (criteria != NULL)
+			_oval_agent_prefetch_criteria(pf, di, criteria, seen);
+		return;
+	}
+	case OVAL_NODETYPE_UNKNOWN:
+		return;
+	}
+}
+
+/* evaluate the definitions at the head of the queue whose objects are collected */
+static void _oval_agent_prefetch_advance(struct oval_agent_prefetch *pf)
+{
+	while (!pf->stop && pf->next < pf->defc && pf->pending[pf->next] == 0) {
+		char *id = oval_definition_get_id(pf->defv[pf->next++]);
+
+		if (_oval_agent_eval_and_report(pf->ag_sess, id, pf->cb, pf->arg, &pf->ret) != 0)
+			pf->stop = true;
+	}
+}
+
+static int _oval_agent_prefetch_cb(struct oval_object *obj, void *arg)
+{
+	struct oval_agent_prefetch *pf = (struct oval_agent_prefetch *)arg;
+	struct oval_agent_prefetch_obj *pobj;
+	size_t i;
+
+	pobj = oval_string_map_get_value(pf->objmap, oval_object_get_id(obj));
+	if (pobj != NULL) {
+		for (i = 0; i < pobj->defc; ++i)
+			--pf->pending[pobj->defv[i]];
+		pobj->defc = 0;
+	}
+
+	_oval_agent_prefetch_advance(pf);
+
+	return (pf->stop ? 1 : 0);
+}
+
+static int _oval_agent_eval_system_async(oval_agent_session_t *ag_sess, agent_reporter cb, void *arg)
+{
+	struct oval_agent_prefetch pf;
+	struct oval_definition_iterator *oval_def_it;
+	struct oval_criteria_node *criteria;
+	struct oval_string_map *seen;
+	size_t i;
+
+	pf.ag_sess = ag_sess;
+	pf.defv    = NULL;
+	pf.pending = NULL;
+	pf.defc    = 0;
+	pf.next    = 0;
+	pf.objmap  = oval_string_map_new();
+	pf.objv    = NULL;
+	pf.objc    = 0;
+	pf.cb      = cb;
+	pf.arg     = arg;
+	pf.ret     = 0;
+	pf.stop    = false;
+
+	oval_def_it = oval_definition_model_get_definitions(ag_sess->def_model);
+	while (oval_definition_iterator_has_more(oval_def_it)) {
+		pf.defv = oscap_realloc(pf.defv, sizeof(struct oval_definition *) * (pf.defc + 1));
+		pf.defv[pf.defc++] = oval_definition_iterator_next(oval_def_it);
+	}
+	oval_definition_iterator_free(oval_def_it);
+
+	pf.pending = oscap_calloc(pf.defc > 0 ? pf.defc : 1, sizeof(size_t));
+
+	for (i = 0; i < pf.defc; ++i) {
+		criteria = oval_definition_get_criteria(pf.defv[i]);
+		if (criteria == NULL)
+			continue;
+		seen = oval_string_map_new();
+		_oval_agent_prefetch_criteria(&pf, i, criteria, seen);
+		oval_string_map_free(seen, NULL);
+	}
+
+	dI("Prefetching %zu object(s) of %zu definition(s).", pf.objc, pf.defc);
+
+	_oval_agent_prefetch_advance(&pf);
+	if (!pf.stop && oval_probe_query_objects_async(ag_sess->psess, pf.objv, pf.objc,
+						       &_oval_agent_prefetch_cb, &pf) != 0)
+		dW("Asynchronous dispatch failed, continuing synchronously.");
+
+	/* whatever wasn't evaluated yet (skipped or failed objects) */
+	for (i = 0; i < pf.defc; ++i)
+		pf.pending[i] = 0;
+	_oval_agent_prefetch_advance(&pf);
+
+	oval_string_map_free(pf.objmap, (oscap_destruct_func) _oval_agent_prefetch_obj_free);
+	oscap_free(pf.objv);
+	oscap_free(pf.pending);
+	oscap_free(pf.defv);
+
+	return pf.ret;
+}
+
+/*
+ * Parallel evaluation: the definitions are split into groups which don't share
+ * any tests, objects, variables or extended definitions and the groups are
+ * evaluated by a pool of threads. Each thread has its own probe session, the
+ * models are shared and protected by the lock of the synchronized group of the
+ * probe sessions (see struct oval_probe_sync). The lock is held only while the
+ * shared maps are looked up or modified, the criteria are evaluated without it.
+ * The results are reported in document order by the calling thread, which
+ * releases the lock while the callback runs.
+ */
+#define OVAL_AGENT_NODEF ((size_t)-1)
+
+struct oval_agent_parallel;
+
+struct oval_agent_worker {
+	struct oval_agent_parallel *pe;
+	oval_probe_session_t *psess;
+	pthread_t tid;
+};
+
+struct oval_agent_parallel {
+	oval_agent_session_t *ag_sess;
+	struct oval_probe_sync sync;
+	pthread_cond_t evaluated;   /**< broadcast when a definition is evaluated */
+	struct oval_definition **defv;
+	size_t  defc;
+	size_t *root;               /**< union-find forest of the definitions */
+	size_t *link;               /**< next definition of the same group */
+	size_t *grpv;               /**< first definition of each group */
+	size_t  grpc;
+	size_t  grp_next;           /**< next group to evaluate */
+	int    *status;             /**< return value of oval_agent_eval_definition() */
+	char  **errv;               /**< errors raised while evaluating the definition */
+	bool   *done;
+	bool    stop;
+};
+
+static size_t _oval_agent_parallel_find(struct oval_agent_parallel *pe, size_t di)
+{
+	while (pe->root[di] != di) {
+		pe->root[di] = pe->root[pe->root[di]];
+		di = pe->root[di];
+	}
+
+	return di;
+}
+
+/* put the definition into the same group as the definitions which claimed the id before */
+static void _oval_agent_parallel_claim(struct oval_agent_parallel *pe, struct oval_string_map *owners,
+				       const char *id, size_t di)
+{
+	size_t *owner, a, b;
+
+	owner = oval_string_map_get_value(owners, id);
+	if (owner == NULL) {
+		owner  = oscap_talloc(size_t);
+		*owner = di;
+		oval_string_map_put(owners, id, owner);
+		return;
+	}
+
+	a = _oval_agent_parallel_find(pe, *owner);
+	b = _oval_agent_parallel_find(pe, di);
+
+	if (a < b)
+		pe->root[b] = a;
+	else if (b < a)
+		pe->root[a] = b;
+}
+
+static void _oval_agent_parallel_criteria(struct oval_agent_parallel *pe, struct oval_string_map *owners, size_t di,
+					  struct oval_criteria_node *cnode, struct oval_string_map *seen)
+{
+	switch (oval_criteria_node_get_type(cnode)) {
+	case OVAL_NODETYPE_CRITERION:{
+		struct oval_test *test = oval_criteria_node_get_test(cnode);
+		struct oval_object *obj;
+		struct oval_state_iterator *ste_it;
+		struct oval_string_map *refs;
+		struct oval_iterator *ref_it;
+
+		if (test == NULL)
+			return;
+		_oval_agent_parallel_claim(pe, owners, oval_test_get_id(test), di);
+
+		/*
+		 * Variables and objects referenced by the test, including the
+		 * nested ones. Objects referenced from sets have to be collected
+		 * by the same probes as the set because the probe looks them up
+		 * in its own cache.
+		 */
+		refs = oval_string_map_new();
+		obj  = oval_test_get_object(test);
+		if (obj != NULL)
+			oval_obj_collect_refs(obj, refs, refs);
+
+		ste_it = oval_test_get_states(test);
+		while (oval_state_iterator_has_more(ste_it))
+			oval_ste_collect_refs(oval_state_iterator_next(ste_it), refs, refs);
+		oval_state_iterator_free(ste_it);
+
+		ref_it = oval_string_map_keys(refs);
+		while (oval_collection_iterator_has_more(ref_it))
+			_oval_agent_parallel_claim(pe, owners, oval_collection_iterator_next(ref_it), di);
+		oval_collection_iterator_free(ref_it);
+		oval_string_map_free(refs, NULL);
+		return;
+	}
+	case OVAL_NODETYPE_CRITERIA:{
+		struct oval_criteria_node_iterator *cnode_it = oval_criteria_node_get_subnodes(cnode);
+
+		if (cnode_it == NULL)
+			return;
+		while (oval_criteria_node_iterator_has_more(cnode_it))
+			_oval_agent_parallel_criteria(pe, owners, di, oval_criteria_node_iterator_next(cnode_it), seen);
+		oval_criteria_node_iterator_free(cnode_it);
+		return;
+	}
+	case OVAL_NODETYPE_EXTENDDEF:{
+		struct oval_definition *def = oval_criteria_node_get_definition(cnode);
+		struct oval_criteria_node *criteria;
+		char *def_id;
+
+		if (def == NULL)
+			return;
+		def_id = oval_definition_get_id(def);
+		if (oval_string_map_get_value(seen, def_id) != NULL)
+			return;
+		oval_string_map_put(seen, def_id, def);
+		_oval_agent_parallel_claim(pe, owners, def_id, di);
+
+		criteria = oval_definition_get_criteria(def);
+		if (criteria != NULL)
+			_oval_agent_parallel_criteria(pe, owners, di, criteria, seen);
+		return;
+	}
+	case OVAL_NODETYPE_UNKNOWN:
+		return;
+	}
+}
+
+/* split the definitions into independent groups */
+static void _oval_agent_parallel_group(struct oval_agent_parallel *pe)
+{
+	struct oval_string_map *owners, *seen;
+	struct oval_criteria_node *criteria;
+	size_t i, r, *last;
+
+	owners = oval_string_map_new();
+
+	for (i = 0; i < pe->defc; ++i)
+		pe->root[i] = i;
+
+	for (i = 0; i < pe->defc; ++i) {
+		_oval_agent_parallel_claim(pe, owners, oval_definition_get_id(pe->defv[i]), i);
+
+		criteria = oval_definition_get_criteria(pe->defv[i]);
+		if (criteria == NULL)
+			continue;
+		seen = oval_string_map_new();
+		_oval_agent_parallel_criteria(pe, owners, i, criteria, seen);
+		oval_string_map_free(seen, NULL);
+	}
+
+	oval_string_map_free(owners, (oscap_destruct_func) oscap_free);
+
+	/* link the definitions of each group in document order */
+	last = oscap_alloc(sizeof(size_t) * (pe->defc > 0 ? pe->defc : 1));
+
+	for (i = 0; i < pe->defc; ++i) {
+		r = _oval_agent_parallel_find(pe, i);
+		pe->link[i] = OVAL_AGENT_NODEF;
+
+		if (r == i)
+			pe->grpv[pe->grpc++] = i;
+		else
+			pe->link[last[r]] = i;
+
+		last[r] = i;
+	}
+
+	oscap_free(last);
+}
+
+static void *_oval_agent_parallel_worker(void *arg)
+{
+	struct oval_agent_worker *w = (struct oval_agent_worker *)arg;
+	struct oval_agent_parallel *pe = w->pe;
+	struct oval_result_system *rsystem;
+	struct oval_result_definition *rdef;
+	char  *err;
+	size_t di;
+	int    status;
+
+	if (oval_probe_sync_bind(&pe->sync, w->psess) != 0) {
+		pthread_mutex_lock(&pe->sync.lock);
+		pe->stop = true;
+		pthread_cond_broadcast(&pe->evaluated);
+		pthread_mutex_unlock(&pe->sync.lock);
+
+		return (NULL);
+	}
+
+	oval_probe_sync_enter(w->psess);
+	rsystem = _oval_agent_get_first_result_system(pe->ag_sess);
+
+	while (!pe->stop && pe->grp_next < pe->grpc) {
+		for (di = pe->grpv[pe->grp_next++]; di != OVAL_AGENT_NODEF && !pe->stop; di = pe->link[di]) {
+			/* the result definition and its tests are added to the shared model */
+			rdef = oval_result_system_prepare_definition(rsystem, oval_definition_get_id(pe->defv[di]));
+			oval_probe_sync_leave(w->psess);
+
+			/* the queries done by the criteria take the lock on their own */
+			status = -1;
+			if (rdef != NULL) {
+				oval_result_definition_eval(rdef);
+				status = 0;
+			}
+			/* errors are thread-local, hand them over to the reporting thread */
+			err = oscap_err_get_full_error();
+
+			oval_probe_sync_enter(w->psess);
+			pe->status[di] = status;
+			pe->errv[di]   = err;
+			pe->done[di]   = true;
+			pthread_cond_broadcast(&pe->evaluated);
+		}
+	}
+
+	oval_probe_sync_leave(w->psess);
+
+	return (NULL);
+}
+
+static void _oval_agent_parallel_free(struct oval_agent_parallel *pe)
+{
+	size_t i;
+
+	for (i = 0; i < pe->defc; ++i)
+		oscap_free(pe->errv[i]);
+
+	oscap_free(pe->defv);
+	oscap_free(pe->root);
+	oscap_free(pe->link);
+	oscap_free(pe->grpv);
+	oscap_free(pe->status);
+	oscap_free(pe->errv);
+	oscap_free(pe->done);
+}
+
+int oval_agent_eval_system_parallel(oval_agent_session_t *ag_sess, unsigned int jobs, agent_reporter cb, void *arg)
+{
+	struct oval_agent_parallel pe;
+	struct oval_agent_worker *wv;
+	struct oval_definition_iterator *oval_def_it;
+	struct oval_result_definition *res_def;
+	size_t i, n, cnt;
+	char *id;
+	int ret = 0;
+	bool stop;
+
+	if (jobs <= 1)
+		return oval_agent_eval_system(ag_sess, cb, arg);
+
+	memset(&pe, 0, sizeof pe);
+	pe.ag_sess = ag_sess;
+
+	oval_def_it = oval_definition_model_get_definitions(ag_sess->def_model);
+	while (oval_definition_iterator_has_more(oval_def_it)) {
+		pe.defv = oscap_realloc(pe.defv, sizeof(struct oval_definition *) * (pe.defc + 1));
+		pe.defv[pe.defc++] = oval_definition_iterator_next(oval_def_it);
+	}
+	oval_definition_iterator_free(oval_def_it);
+
+	cnt = (pe.defc > 0 ? pe.defc : 1);
+	pe.root   = oscap_alloc(sizeof(size_t) * cnt);
+	pe.link   = oscap_alloc(sizeof(size_t) * cnt);
+	pe.grpv   = oscap_alloc(sizeof(size_t) * cnt);
+	pe.status = oscap_calloc(cnt, sizeof(int));
+	pe.errv   = oscap_calloc(cnt, sizeof(char *));
+	pe.done   = oscap_calloc(cnt, sizeof(bool));
+
+	_oval_agent_parallel_group(&pe);
+
+	if (pe.grpc < 2 || oval_probe_sync_init(&pe.sync) != 0) {
+		_oval_agent_parallel_free(&pe);
+		return oval_agent_eval_system(ag_sess, cb, arg);
+	}
+
+	if (jobs > pe.grpc)
+		jobs = pe.grpc;
+
+	dI("OVAL agent started to evaluate OVAL definitions on your system.");
+
+	pthread_cond_init(&pe.evaluated, NULL);
+	wv = oscap_alloc(sizeof(struct oval_agent_worker) * jobs);
+	ag_sess->psessv = oscap_alloc(sizeof(oval_probe_session_t *) * jobs);
+	oval_probe_session_set_sync(ag_sess->psess, &pe.sync);
+
+	pthread_mutex_lock(&pe.sync.lock);
+
+	for (n = 0; n < jobs; ++n) {
+		wv[n].pe    = &pe;
+		wv[n].psess = oval_probe_session_new(ag_sess->sys_model);
+		oval_probe_session_set_sync(wv[n].psess, &pe.sync);
+
+		if ((errno = pthread_create(&wv[n].tid, NULL, &_oval_agent_parallel_worker, wv + n)) != 0) {
+			dE("Can't start an evaluation thread: %u, %s.", errno, strerror(errno));
+			oval_probe_session_destroy(wv[n].psess);
+			break;
+		}
+
+		ag_sess->psessv[n] = wv[n].psess;
+		ag_sess->psessc    = n + 1;
+	}
+
+	dI("Evaluating %zu definition(s) in %zu independent group(s) using %zu thread(s).",
+	   pe.defc, pe.grpc, n);
+
+	for (i = 0; i < pe.defc && n > 0; ++i) {
+		id = oval_definition_get_id(pe.defv[i]);
+
+		while (!pe.done[i] && !pe.stop)
+			pthread_cond_wait(&pe.evaluated, &pe.sync.lock);
+
+		if (!pe.done[i]) {
+			oscap_seterr(OSCAP_EFAMILY_OVAL, "Evaluation of definition '%s' wasn't finished.", id);
+			ret = -1;
+			break;
+		}
+
+		if (pe.errv[i] != NULL)
+			oscap_seterr(OSCAP_EFAMILY_OVAL, "%s", pe.errv[i]);
+
+		ret = pe.status[i];
+		res_def = (ret != -1 && cb != NULL) ? oval_agent_get_result_definition(ag_sess, id) : NULL;
+
+		/* the callback doesn't hold up the evaluation threads */
+		pthread_mutex_unlock(&pe.sync.lock);
+		stop = _oval_agent_report_definition(res_def, cb, arg, &ret);
+		pthread_mutex_lock(&pe.sync.lock);
+
+		if (stop)
+			break;
+	}
+
+	pe.stop = true;
+	pthread_mutex_unlock(&pe.sync.lock);
+
+	for (i = 0; i < n; ++i)
+		pthread_join(wv[i].tid, NULL);
+
+	ag_sess->psessc = 0;
+	oscap_free(ag_sess->psessv);
+	ag_sess->psessv = NULL;
+
+	for (i = 0; i < n; ++i)
+		oval_probe_session_destroy(wv[i].psess);
+
+	oval_probe_session_set_sync(ag_sess->psess, NULL);
+	oval_probe_sync_destroy(&pe.sync);
+	pthread_cond_destroy(&pe.evaluated);
+	oscap_free(wv);
+	_oval_agent_parallel_free(&pe);
+
+	if (n == 0)
+		return oval_agent_eval_system(ag_sess, cb, arg);
+
+	dI("OVAL agent finished evaluation.");
+	return ret;
+}
+
 int oval_agent_eval_system(oval_agent_session_t * ag_sess, agent_reporter cb, void *arg) {
 	struct oval_definition *oval_def;
 	struct oval_definition_iterator *oval_def_it;
@@ -251,34 +874,22 @@ int oval_agent_eval_system(oval_agent_session_t * ag_sess, agent_reporter cb, vo
 	int ret = 0;
 
 	dI("OVAL agent started to evaluate OVAL definitions on your system.");
+
+	if (oval_probe_session_get_async_window(ag_sess->psess) > 0) {
+		ret = _oval_agent_eval_system_async(ag_sess, cb, arg);
+		dI("OVAL agent finished evaluation.");
+		return ret;
+	}
+
 	oval_def_it = oval_definition_model_get_definitions(ag_sess->def_model);
 	while (oval_definition_iterator_has_more(oval_def_it)) {
 		oval_def = oval_definition_iterator_next(oval_def_it);
 		id = oval_definition_get_id(oval_def);
 
-		/* probe and eval */
-		ret = oval_agent_eval_definition(ag_sess, id);
-		if (ret==-1) {
-			goto cleanup;
-		}
-
-		/* callback */
-                if (cb != NULL) {
-			struct oval_result_definition * res_def = oval_agent_get_result_definition(ag_sess, id);
-			ret = cb(res_def,arg);
-			/* stop? */
-			if (ret!=0)
-				goto cleanup;
-		}
-
-		/* probe evaluation terminated by signal */
-		if (ret == -2) {
-			ret = 1;
+		if (_oval_agent_eval_and_report(ag_sess, id, cb, arg, &ret) != 0)
 			break;
-		}
 	}
 
-cleanup:
 	oval_definition_iterator_free(oval_def_it);
 	dI("OVAL agent finished evaluation.");
 	return ret;
@@ -298,6 +909,11 @@ const char * oval_agent_get_filename(oval_agent_session_t * ag_sess) {
 
 void oval_agent_destroy_session(oval_agent_session_t * ag_sess) {
 	if (ag_sess != NULL) {
+		size_t re_hits, re_misses;
+
+		oval_regex_cache_stats(&re_hits, &re_misses);
+		dI("Regex cache: %zu hit(s), %zu miss(es).", re_hits, re_misses);
+
 		oscap_free(ag_sess->product_name);
 		oval_probe_session_destroy(ag_sess->psess);
 		oval_syschar_model_free(ag_sess->sys_model);
@@ -608,9 +1224,14 @@ _oval_agent_list_definitions(void *usr, xccdf_policy_engine_query_t query_type,
 
 bool xccdf_policy_model_register_engine_oval(struct xccdf_policy_model * model, struct oval_agent_session * usr)
 {
+	const char *sysname = "http://oval.mitre.org/XMLSchema/oval-definitions-5";
 
-    return xccdf_policy_model_register_engine_and_query_callback(model, "http://oval.mitre.org/XMLSchema/oval-definitions-5",
-		oval_agent_eval_rule, (void *) usr, _oval_agent_list_definitions);
+	if (!xccdf_policy_model_register_engine_and_query_callback(model, (char *) sysname,
+		oval_agent_eval_rule, (void *) usr, _oval_agent_list_definitions))
+		return false;
+	/* The session evaluates only its own file and one definition at a time
+	 * (the default), sessions of other files may run concurrently. */
+	return xccdf_policy_model_set_engine_href(model, sysname, (void *) usr, usr->filename);
 }
 
 void oval_agent_export_sysinfo_to_xccdf_result(struct oval_agent_session * sess, struct xccdf_result * ritem)
@@ -52,6 +52,7 @@
 #include "common/_error.h"
 #include "common/oscap_string.h"
 #include "oval_glob_to_regex.h"
+#include "results/oval_cmp_regex_impl.h"
 #if defined USE_REGEX_PCRE
 #include <pcre.h>
 #elif defined USE_REGEX_POSIX
@@ -1941,19 +1942,21 @@ static long unsigned int _parse_fmt_sse(char *dt)
 static bool _match(const char *pattern, const char *string)
 {
 	bool match = false;
+	struct oval_regex *re;
 #if defined USE_REGEX_PCRE
-	pcre *re;
-	const char *error;
-	int erroffset = -1, ovector[60], ovector_len = sizeof (ovector) / sizeof (ovector[0]);
-	re = pcre_compile(pattern, PCRE_UTF8, &error, &erroffset, NULL);
-	match = (pcre_exec(re, NULL, string, strlen(string), 0, 0, ovector, ovector_len) >= 0);
-	pcre_free(re);
+	int ovector[60], ovector_len = sizeof (ovector) / sizeof (ovector[0]);
+
+	re = oval_regex_acquire(pattern, PCRE_UTF8, NULL, NULL);
+	if (re == NULL)
+		return false;
+	match = (pcre_exec(re->re, re->extra, string, strlen(string), 0, 0, ovector, ovector_len) >= 0);
 #elif defined USE_REGEX_POSIX
-	regex_t re;
-	regcomp(&re, pattern, REG_EXTENDED);
-	match = (regexec(&re, string, 0, NULL, 0) == 0);
-	regfree(&re);
+	re = oval_regex_acquire(pattern, REG_EXTENDED, NULL, NULL);
+	if (re == NULL)
+		return false;
+	match = (regexec(&re->re, string, 0, NULL, 0) == 0);
 #endif
+	oval_regex_release(re);
 	return match;
 }
 
@@ -2174,23 +2177,21 @@ static oval_syschar_collection_flag_t _oval_component_evaluate_REGEX_CAPTURE(ova
 	struct oval_component_iterator *subcomps = oval_component_get_function_components(component);
 	int rc;
 	char *pattern;
-#if defined USE_REGEX_PCRE
+	struct oval_regex *re;
+	const char *error = NULL;
 	int erroffset = -1;
-	pcre *re = NULL;
-	const char *error;
 
 	pattern = oval_component_get_regex_pattern(component);
-	re = pcre_compile(pattern, PCRE_UTF8, &error, &erroffset, NULL);
+#if defined USE_REGEX_PCRE
+	re = oval_regex_acquire(pattern, PCRE_UTF8, &error, &erroffset);
 	if (re == NULL) {
 		dE("pcre_compile() failed: \"%s\".", error);
 		return SYSCHAR_FLAG_ERROR;
 	}
 #elif defined USE_REGEX_POSIX
-	regex_t re;
-
-	pattern = oval_component_get_regex_pattern(component);
-	if ((rc = regcomp(&re, pattern, REG_EXTENDED | REG_NEWLINE)) != 0) {
-		dE("regcomp() failed: %d.", rc);
+	re = oval_regex_acquire(pattern, REG_EXTENDED | REG_NEWLINE, &error, &erroffset);
+	if (re == NULL) {
+		dE("regcomp() failed: %d.", erroffset);
 		return SYSCHAR_FLAG_ERROR;
 	}
 #endif
@@ -2210,7 +2211,7 @@ static oval_syschar_collection_flag_t _oval_component_evaluate_REGEX_CAPTURE(ova
 			for (i = 0; i < ovector_len; ++i)
 				ovector[i] = -1;
 
-			rc = pcre_exec(re, NULL, text, strlen(text), 0, 0, ovector, ovector_len);
+			rc = pcre_exec(re->re, re->extra, text, strlen(text), 0, 0, ovector, ovector_len);
 			if (rc < -1) {
 				dE("pcre_exec() failed: %d.", rc);
 				flag = SYSCHAR_FLAG_ERROR;
@@ -2230,7 +2231,7 @@ static oval_syschar_collection_flag_t _oval_component_evaluate_REGEX_CAPTURE(ova
 			regmatch_t pmatch[40];
 			int pmatch_len = sizeof (pmatch) / sizeof (pmatch[0]);
 
-			rc = regexec(&re, text, pmatch_len, pmatch, 0);
+			rc = regexec(&re->re, text, pmatch_len, pmatch, 0);
 			if (rc != REG_NOMATCH && pmatch[1].rm_so != -1) {
 				int substr_len = pmatch[1].rm_eo - pmatch[1].rm_so;
 
@@ -2255,9 +2256,7 @@ static oval_syschar_collection_flag_t _oval_component_evaluate_REGEX_CAPTURE(ova
 		oval_collection_free_items(subcoll, (oscap_destruct_func) oval_value_free);
 	}
 	oval_component_iterator_free(subcomps);
-#if defined USE_REGEX_PCRE
-        pcre_free(re);
-#endif
+	oval_regex_release(re);
 	return flag;
 }
 
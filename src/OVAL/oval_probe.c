@@ -43,6 +43,7 @@
 #include "common/util.h"
 #include "common/bfind.h"
 #include "common/debug_priv.h"
+#include "common/timing_priv.h"
 
 #include "_oval_probe_session.h"
 #include "_oval_probe_handler.h"
@@ -227,7 +228,56 @@ static void _syschar_add_bindings(struct oval_syschar *sc, struct oval_string_ma
 	oval_collection_iterator_free(var_itr);
 }
 
-int oval_probe_query_object(oval_probe_session_t *psess, struct oval_object *object, int flags, struct oval_syschar **out_syschar)
+/*
+ * Wait until no other synchronized session collects the object. Called
+ * with the sync lock held.
+ */
+static void oval_probe_sync_wait(oval_probe_session_t *psess, const char *oid)
+{
+	struct oval_probe_busy *b;
+
+	for (b = psess->sync->busy; b != NULL;) {
+		if (strcmp(b->oid, oid) == 0 && b->sess != psess) {
+			dI("Object '%s' is being collected by another session, waiting.", oid);
+			pthread_cond_wait(&psess->sync->done, &psess->sync->lock);
+			b = psess->sync->busy;
+		} else
+			b = b->next;
+	}
+}
+
+static void oval_probe_sync_unbusy(oval_probe_session_t *psess, struct oval_probe_busy *busy)
+{
+	struct oval_probe_busy **bp;
+
+	for (bp = &psess->sync->busy; *bp != NULL; bp = &(*bp)->next) {
+		if (*bp == busy) {
+			*bp = busy->next;
+			break;
+		}
+	}
+
+	pthread_cond_broadcast(&psess->sync->done);
+}
+
+static size_t oval_probe_count_items(struct oval_syschar *sysc)
+{
+	struct oval_sysitem_iterator *it = oval_syschar_get_sysitem(sysc);
+	size_t count = 0;
+
+	while (oval_sysitem_iterator_has_more(it)) {
+		oval_sysitem_iterator_next(it);
+		count++;
+	}
+	oval_sysitem_iterator_free(it);
+
+	return count;
+}
+
+/*
+ * Called with the sync lock held if the session is synchronized.
+ */
+static int _oval_probe_query_object(oval_probe_session_t *psess, struct oval_object *object, int flags, struct oval_syschar **out_syschar)
 {
 	char *oid;
 	struct oval_syschar *sysc;
@@ -236,6 +286,7 @@ int oval_probe_query_object(oval_probe_session_t *psess, struct oval_object *obj
         oval_ph_t *ph;
 	struct oval_string_map *vm;
 	struct oval_syschar_model *model;
+	struct oval_probe_busy busy;
 	int ret;
 
 	oid = oval_object_get_id(object);
@@ -245,6 +296,9 @@ int oval_probe_query_object(oval_probe_session_t *psess, struct oval_object *obj
 	type_name = oval_subtype_get_text(type);
 	dI("Querying %s object '%s', flags: %u.", type_name, oid, flags);
 
+	if (psess->sync != NULL)
+		oval_probe_sync_wait(psess, oid);
+
 	sysc = oval_syschar_model_get_syschar(model, oid);
 	if (sysc != NULL) {
 		int variable_instance_hint = oval_syschar_get_variable_instance_hint(sysc);
@@ -285,7 +339,22 @@ int oval_probe_query_object(oval_probe_session_t *psess, struct oval_object *obj
 		return 1;
         }
 
-	if ((ret = ph->func(type, ph->uptr, PROBE_HANDLER_ACT_EVAL, sysc, flags)) != 0) {
+	if (psess->sync != NULL) {
+		busy.oid  = oid;
+		busy.sess = psess;
+		busy.next = psess->sync->busy;
+		psess->sync->busy = &busy;
+	}
+
+	oscap_timing_object_begin(oid, type_name);
+	ret = ph->func(type, ph->uptr, PROBE_HANDLER_ACT_EVAL, sysc, flags);
+	if (oscap_timing_enabled())
+		oscap_timing_object_end(ret == 0 ? oval_probe_count_items(sysc) : 0);
+
+	if (psess->sync != NULL)
+		oval_probe_sync_unbusy(psess, &busy);
+
+	if (ret != 0) {
 		return ret;
 	}
 
@@ -299,6 +368,95 @@ int oval_probe_query_object(oval_probe_session_t *psess, struct oval_object *obj
 	return 0;
 }
 
+int oval_probe_query_object(oval_probe_session_t *psess, struct oval_object *object, int flags, struct oval_syschar **out_syschar)
+{
+	int ret;
+
+	psess = oval_probe_sync_session(psess);
+
+	/*
+	 * The lock is already held when the object is queried while another
+	 * object or a state is being converted for a probe.
+	 */
+	if (psess->sync == NULL || oval_probe_sync_held(psess))
+		return _oval_probe_query_object(psess, object, flags, out_syschar);
+
+	oval_probe_sync_enter(psess);
+	ret = _oval_probe_query_object(psess, object, flags, out_syschar);
+	oval_probe_sync_leave(psess);
+
+	return ret;
+}
+
+struct oval_probe_async_ctx {
+	int (*cb)(struct oval_object *, void *);
+	void *arg;
+};
+
+static int oval_probe_query_objects_async_cb(struct oval_syschar *sysc, void *arg)
+{
+	struct oval_probe_async_ctx *ctx = (struct oval_probe_async_ctx *)arg;
+	struct oval_string_map *vm;
+
+	if (oval_syschar_get_flag(sysc) != SYSCHAR_FLAG_UNKNOWN) {
+		vm = oval_string_map_new();
+		oval_obj_collect_var_refs(oval_syschar_get_object(sysc), vm);
+		_syschar_add_bindings(sysc, vm);
+		oval_string_map_free(vm, NULL);
+	}
+
+	return ctx->cb(oval_syschar_get_object(sysc), ctx->arg);
+}
+
+size_t oval_probe_session_get_async_window(oval_probe_session_t *sess)
+{
+	return sess->pext->async_window;
+}
+
+int oval_probe_query_objects_async(oval_probe_session_t *psess, struct oval_object **objv, size_t objc,
+				   int (*cb)(struct oval_object *, void *), void *arg)
+{
+	struct oval_probe_async_ctx ctx;
+	struct oval_syschar **sysv;
+	size_t i, sysc;
+	oval_ph_t *ph;
+	int ret;
+
+	sysv = oscap_alloc(sizeof(struct oval_syschar *) * (objc > 0 ? objc : 1));
+
+	for (i = 0, sysc = 0; i < objc; ++i) {
+		const char *oid = oval_object_get_id(objv[i]);
+
+		/*
+		 * Only objects that weren't queried yet and are handled by an external
+		 * probe are pipelined. Everything else is left for the synchronous path.
+		 */
+		ph = oval_probe_handler_get(psess->ph, oval_object_get_subtype(objv[i]));
+
+		if (ph == NULL || ph->func != &oval_probe_ext_handler
+		    || oval_syschar_model_get_syschar(psess->sys_model, oid) != NULL) {
+			if (cb(objv[i], arg) != 0) {
+				oscap_free(sysv);
+				return 0;
+			}
+			continue;
+		}
+
+		dI("Creating new syschar for %s_object '%s'.",
+		   oval_subtype_get_text(oval_object_get_subtype(objv[i])), oid);
+		sysv[sysc++] = oval_syschar_new(psess->sys_model, objv[i]);
+	}
+
+	ctx.cb  = cb;
+	ctx.arg = arg;
+
+	ret = oval_probe_ext_eval_async(psess->pext, sysv, sysc,
+					&oval_probe_query_objects_async_cb, &ctx);
+	oscap_free(sysv);
+
+	return ret;
+}
+
 int oval_probe_query_sysinfo(oval_probe_session_t *sess, struct oval_sysinfo **out_sysinfo)
 {
 	struct oval_sysinfo *sysinf;
@@ -0,0 +1,824 @@
+/**
+ * @file oval_probe_cache.c
+ * @brief Process-wide cache of collected objects
+ */
+/*
+ * Copyright 2016 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sexp.h>
+
+#include "common/alloc.h"
+#include "common/debug_priv.h"
+#include "common/util.h"
+#include "adt/oval_string_map_impl.h"
+#include "probes/public/probe-api.h"
+#include "probes/SEAP/_sexp-output.h"
+#include "probes/SEAP/_sexp-parser.h"
+#include "probes/SEAP/MurmurHash3.h"
+#include "probes/unix/linux/rpm-dbfiles.h"
+#include "oval_definitions_impl.h"
+#include "public/oval_system_characteristics.h"
+#include "oval_probe_cache.h"
+
+/*
+ * The cache file starts with the magic string, which is followed by the
+ * entries. Each entry is a 32-bit length and a S-exp in the binary SEAP
+ * encoding (i.e. in the host byte order, the file isn't portable):
+ *
+ *  (key stamp ((path mtime mtime_nsec size ino) ...) cobj)
+ */
+#define OVAL_PCACHE_MAGIC    "OSCAP-PCACHE\1\n"
+#define OVAL_PCACHE_MAGICLEN (sizeof OVAL_PCACHE_MAGIC - 1)
+
+/* objects with more hints are left to the probes */
+#define OVAL_PCACHE_HINTS_MAX 4096
+
+struct oval_pcache_hint {
+	char    *path;
+	int64_t  mtime;
+	int64_t  mtime_nsec;
+	int64_t  size; /**< -1 if the file doesn't exist */
+	uint64_t ino;
+};
+
+struct oval_pcache_entry {
+	time_t   stamp; /**< when was the collection started */
+	SEXP_t  *cobj;
+	struct oval_pcache_hint *hintv;
+	size_t   hintc;
+};
+
+static struct {
+	pthread_once_t  once;
+	pthread_mutex_t lock;
+	struct oval_string_map *map;
+	time_t ttl;
+	char  *path;
+	bool   dirty;
+} pcache = { PTHREAD_ONCE_INIT, PTHREAD_MUTEX_INITIALIZER, NULL, 0, NULL, false };
+
+/*
+ * The package databases. An object of the listed type is dropped from the
+ * cache when one of the paths changes. The types are from different enums,
+ * hence int.
+ */
+static const struct {
+	int         type;
+	const char *path;
+} pcache_pkgdb[] = {
+	{ OVAL_LINUX_DPKG_INFO,         "/var/lib/dpkg/status" }
+};
+
+/* objects which are collected from the rpm database */
+static const int pcache_rpmdb_types[] = {
+	OVAL_LINUX_RPM_INFO,
+	OVAL_LINUX_RPMVERIFY,
+	OVAL_LINUX_RPMVERIFYFILE,
+	OVAL_LINUX_RPMVERIFYPACKAGE
+};
+
+/* entity names which hold file or directory paths */
+static const char *pcache_pathents[] = {
+	"filepath", "path"
+};
+
+static void oval_pcache_hint_stat(struct oval_pcache_hint *hint)
+{
+	struct stat st;
+
+	if (stat(hint->path, &st) != 0) {
+		hint->mtime = hint->mtime_nsec = 0;
+		hint->size  = -1;
+		hint->ino   = 0;
+	} else {
+		hint->mtime      = st.st_mtim.tv_sec;
+		hint->mtime_nsec = st.st_mtim.tv_nsec;
+		hint->size       = st.st_size;
+		hint->ino        = st.st_ino;
+	}
+}
+
+static void oval_pcache_entry_free(struct oval_pcache_entry *entry)
+{
+	size_t i;
+
+	if (entry == NULL)
+		return;
+
+	for (i = 0; i < entry->hintc; ++i)
+		oscap_free(entry->hintv[i].path);
+
+	oscap_free(entry->hintv);
+	SEXP_free(entry->cobj);
+	oscap_free(entry);
+}
+
+static bool oval_pcache_entry_valid(const struct oval_pcache_entry *entry, time_t now)
+{
+	struct oval_pcache_hint cur;
+	size_t i;
+
+	if (entry->cobj == NULL || now < entry->stamp || now - entry->stamp >= pcache.ttl)
+		return (false);
+
+	for (i = 0; i < entry->hintc; ++i) {
+		cur.path = entry->hintv[i].path;
+		oval_pcache_hint_stat(&cur);
+
+		if (cur.mtime      != entry->hintv[i].mtime      ||
+		    cur.mtime_nsec != entry->hintv[i].mtime_nsec ||
+		    cur.size       != entry->hintv[i].size       ||
+		    cur.ino        != entry->hintv[i].ino) {
+			dD("Cached object invalidated by a change of %s.", cur.path);
+			return (false);
+		}
+	}
+
+	return (true);
+}
+
+static int oval_pcache_hint_add(struct oval_pcache_entry *entry, const char *root, const char *path)
+{
+	char   full[PATH_MAX];
+	size_t i;
+
+	if (path[0] != '/')
+		return (0);
+
+	if ((size_t)snprintf(full, sizeof full, "%s%s", root, path) >= sizeof full)
+		return (-1);
+
+	for (i = 0; i < entry->hintc; ++i)
+		if (strcmp(entry->hintv[i].path, full) == 0)
+			return (0);
+
+	if (entry->hintc == OVAL_PCACHE_HINTS_MAX)
+		return (-1);
+
+	entry->hintv = oscap_realloc(entry->hintv, sizeof(struct oval_pcache_hint) * (entry->hintc + 1));
+	entry->hintv[entry->hintc].path = oscap_strdup(full);
+	oval_pcache_hint_stat(entry->hintv + entry->hintc);
+	++entry->hintc;
+
+	return (0);
+}
+
+/*
+ * Add the values of the path entities of an object or item as hints.
+ */
+static int oval_pcache_hint_ents(struct oval_pcache_entry *entry, const char *root, const SEXP_t *s_obj)
+{
+	SEXP_t *s_val;
+	char    path[PATH_MAX];
+	size_t  i;
+	int     ret = 0;
+
+	for (i = 0; ret == 0 && i < sizeof pcache_pathents / sizeof pcache_pathents[0]; ++i) {
+		s_val = probe_obj_getentval(s_obj, pcache_pathents[i], 1);
+
+		if (s_val == NULL)
+			continue;
+
+		if (SEXP_stringp(s_val) &&
+		    SEXP_string_cstr_r(s_val, path, sizeof path) != (size_t)-1)
+			ret = oval_pcache_hint_add(entry, root, path);
+
+		SEXP_free(s_val);
+	}
+
+	return (ret);
+}
+
+/*
+ * Add the rpm database files as hints. The probes use the path from
+ * OSCAP_PROBE_RPMDB_PATH, otherwise the first default location which
+ * holds a database under the probe root.
+ */
+static int oval_pcache_hint_rpmdb(struct oval_pcache_entry *entry, const char *root)
+{
+	const char *dbpath;
+	char   path[PATH_MAX];
+	struct stat st;
+	size_t i, f;
+	int    ret;
+
+	dbpath = getenv("OSCAP_PROBE_RPMDB_PATH");
+
+	for (i = 0; dbpath == NULL && rpm_dbpaths[i] != NULL; ++i) {
+		for (f = 0; rpm_dbfiles[f] != NULL; ++f) {
+			if ((size_t)snprintf(path, sizeof path, "%s%s/%s", root, rpm_dbpaths[i], rpm_dbfiles[f]) < sizeof path &&
+			    stat(path, &st) == 0) {
+				dbpath = rpm_dbpaths[i];
+				break;
+			}
+		}
+	}
+
+	/* no database yet, watch for one to appear in the legacy location */
+	if (dbpath == NULL)
+		dbpath = rpm_dbpaths[1];
+
+	ret = oval_pcache_hint_add(entry, root, dbpath);
+
+	for (f = 0; ret == 0 && rpm_dbfiles[f] != NULL; ++f) {
+		if ((size_t)snprintf(path, sizeof path, "%s/%s", dbpath, rpm_dbfiles[f]) >= sizeof path)
+			return (-1);
+
+		ret = oval_pcache_hint_add(entry, root, path);
+	}
+
+	return (ret);
+}
+
+static SEXP_t *oval_pcache_entry_to_sexp(const char *key, const struct oval_pcache_entry *entry)
+{
+	SEXP_t *s_hints, *s_hint, *s_entry, *r0, *r1, *r2, *r3, *r4;
+	size_t  i;
+
+	s_hints = SEXP_list_new(NULL);
+
+	for (i = 0; i < entry->hintc; ++i) {
+		s_hint = SEXP_list_new(r0 = SEXP_string_newf("%s", entry->hintv[i].path),
+		                       r1 = SEXP_number_newi_64(entry->hintv[i].mtime),
+		                       r2 = SEXP_number_newi_64(entry->hintv[i].mtime_nsec),
+		                       r3 = SEXP_number_newi_64(entry->hintv[i].size),
+		                       r4 = SEXP_number_newu_64(entry->hintv[i].ino),
+		                       NULL);
+		SEXP_list_add(s_hints, s_hint);
+		SEXP_vfree(s_hint, r0, r1, r2, r3, r4, NULL);
+	}
+
+	s_entry = SEXP_list_new(r0 = SEXP_string_newf("%s", key),
+	                        r1 = SEXP_number_newi_64(entry->stamp),
+	                        s_hints, entry->cobj, NULL);
+	SEXP_vfree(s_hints, r0, r1, NULL);
+
+	return (s_entry);
+}
+
+static struct oval_pcache_entry *oval_pcache_entry_from_sexp(const SEXP_t *s_entry, char *key)
+{
+	struct oval_pcache_entry *entry;
+	SEXP_t *s_key, *s_stamp, *s_hints, *s_hint, *r0, *r1, *r2, *r3, *r4;
+
+	if (!SEXP_listp(s_entry) || SEXP_list_length(s_entry) != 4)
+		return (NULL);
+
+	s_key   = SEXP_list_nth(s_entry, 1);
+	s_stamp = SEXP_list_nth(s_entry, 2);
+	s_hints = SEXP_list_nth(s_entry, 3);
+
+	entry = oscap_talloc(struct oval_pcache_entry);
+	entry->cobj  = SEXP_list_nth(s_entry, 4);
+	entry->hintv = NULL;
+	entry->hintc = 0;
+
+	if (SEXP_string_length(s_key) != OVAL_PCACHE_KEYLEN ||
+	    !SEXP_numberp(s_stamp) || !SEXP_listp(s_hints) || !SEXP_listp(entry->cobj)) {
+		SEXP_vfree(s_key, s_stamp, s_hints, NULL);
+		oval_pcache_entry_free(entry);
+		return (NULL);
+	}
+
+	SEXP_string_cstr_r(s_key, key, OVAL_PCACHE_KEYLEN + 1);
+	entry->stamp = (time_t)SEXP_number_geti_64(s_stamp);
+
+	SEXP_list_foreach(s_hint, s_hints) {
+		r0 = SEXP_list_nth(s_hint, 1);
+		r1 = SEXP_list_nth(s_hint, 2);
+		r2 = SEXP_list_nth(s_hint, 3);
+		r3 = SEXP_list_nth(s_hint, 4);
+		r4 = SEXP_list_nth(s_hint, 5);
+
+		if (r0 != NULL && r4 != NULL && SEXP_stringp(r0)) {
+			entry->hintv = oscap_realloc(entry->hintv, sizeof(struct oval_pcache_hint) * (entry->hintc + 1));
+			entry->hintv[entry->hintc].path       = SEXP_string_cstr(r0);
+			entry->hintv[entry->hintc].mtime      = SEXP_number_geti_64(r1);
+			entry->hintv[entry->hintc].mtime_nsec = SEXP_number_geti_64(r2);
+			entry->hintv[entry->hintc].size       = SEXP_number_geti_64(r3);
+			entry->hintv[entry->hintc].ino        = SEXP_number_getu_64(r4);
+			++entry->hintc;
+		}
+
+		SEXP_vfree(r0, r1, r2, r3, r4, NULL);
+	}
+
+	SEXP_vfree(s_key, s_stamp, s_hints, NULL);
+
+	return (entry);
+}
+
+/*
+ * Replace the ID of an item. The ID is the value following the :id
+ * attribute name, see probe_ent_getattrval().
+ */
+static SEXP_t *oval_pcache_item_reid(const SEXP_t *s_item, const SEXP_t *s_id)
+{
+	SEXP_t *s_name, *s_attrs, *s_ents, *s_val, *s_new;
+	bool    is_id = false;
+
+	s_name  = SEXP_list_first(s_item);
+	s_attrs = SEXP_list_new(NULL);
+
+	SEXP_list_foreach(s_val, s_name) {
+		SEXP_list_add(s_attrs, is_id ? s_id : s_val);
+		is_id = (SEXP_stringp(s_val) && SEXP_strcmp(s_val, ":id") == 0);
+	}
+
+	s_new  = SEXP_list_new(s_attrs, NULL);
+	s_ents = SEXP_list_rest(s_item);
+
+	SEXP_list_foreach(s_val, s_ents)
+		SEXP_list_add(s_new, s_val);
+
+	SEXP_vfree(s_name, s_attrs, s_ents, NULL);
+
+	return (s_new);
+}
+
+/*
+ * The item IDs are assigned by the probes from their pid and a counter,
+ * the IDs of a previous run may be reused by the probes of this run for
+ * different items. The loaded items get IDs which the probes don't use
+ * ("2" instead of "1" followed by the digits), an item shared by several
+ * objects keeps a single ID.
+ */
+static void oval_pcache_entry_reid(struct oval_pcache_entry *entry, struct oval_string_map *ids)
+{
+	static unsigned int next_id = 0;
+	SEXP_t *s_items, *s_item, *s_new, *s_id, *s_old;
+	char   *old_id, *new_id;
+
+	s_items = probe_cobj_get_items(entry->cobj);
+
+	if (s_items == NULL)
+		return;
+
+	s_new = SEXP_list_new(NULL);
+
+	SEXP_list_foreach(s_item, s_items) {
+		s_id   = probe_ent_getattrval(s_item, "id");
+		old_id = (s_id != NULL ? SEXP_string_cstr(s_id) : NULL);
+		SEXP_free(s_id);
+
+		if (old_id == NULL) {
+			SEXP_list_add(s_new, s_item);
+			continue;
+		}
+
+		new_id = oval_string_map_get_value(ids, old_id);
+
+		if (new_id == NULL) {
+			new_id = oscap_sprintf("2%u", ++next_id);
+			oval_string_map_put(ids, old_id, new_id);
+		}
+
+		s_id  = SEXP_string_newf("%s", new_id);
+		s_old = oval_pcache_item_reid(s_item, s_id);
+		SEXP_list_add(s_new, s_old);
+		SEXP_vfree(s_id, s_old, NULL);
+		oscap_free(old_id);
+	}
+
+	s_old = SEXP_list_replace(entry->cobj, 3, s_new);
+	SEXP_vfree(s_items, s_new, s_old, NULL);
+}
+
+static void oval_pcache_load(void)
+{
+	struct oval_pcache_entry *entry;
+	char     key[OVAL_PCACHE_KEYLEN + 1];
+	uint8_t *buf;
+	size_t   len, off;
+	uint32_t slen;
+	SEXP_t  *s_entry;
+	FILE    *fp;
+	long     fsize;
+	time_t   now;
+	struct oval_string_map *ids;
+
+	fp = fopen(pcache.path, "r");
+
+	if (fp == NULL) {
+		dI("Can't open the probe cache file %s: %s.", pcache.path, strerror(errno));
+		return;
+	}
+
+	if (fseek(fp, 0, SEEK_END) != 0 || (fsize = ftell(fp)) < 0 || fseek(fp, 0, SEEK_SET) != 0) {
+		fclose(fp);
+		return;
+	}
+
+	len = (size_t)fsize;
+	buf = oscap_alloc(len > 0 ? len : 1);
+
+	if (fread(buf, 1, len, fp) != len ||
+	    len < OVAL_PCACHE_MAGICLEN || memcmp(buf, OVAL_PCACHE_MAGIC, OVAL_PCACHE_MAGICLEN) != 0) {
+		dW("Ignoring the invalid probe cache file %s.", pcache.path);
+		oscap_free(buf);
+		fclose(fp);
+		return;
+	}
+
+	fclose(fp);
+	now = time(NULL);
+	ids = oval_string_map_new();
+
+	for (off = OVAL_PCACHE_MAGICLEN; len - off >= sizeof slen; off += slen) {
+		memcpy(&slen, buf + off, sizeof slen);
+		off += sizeof slen;
+
+		if (len - off < slen)
+			break;
+
+		s_entry = SEXP_parse_b(buf + off, slen);
+
+		if (s_entry == NULL)
+			break;
+
+		entry = oval_pcache_entry_from_sexp(s_entry, key);
+		SEXP_free(s_entry);
+
+		if (entry == NULL)
+			break;
+
+		if (!oval_pcache_entry_valid(entry, now) || oval_string_map_get_value(pcache.map, key) != NULL) {
+			oval_pcache_entry_free(entry);
+		} else {
+			oval_pcache_entry_reid(entry, ids);
+			oval_string_map_put(pcache.map, key, entry);
+		}
+	}
+
+	if (off != len)
+		dW("The probe cache file %s is truncated or corrupted.", pcache.path);
+
+	oval_string_map_free(ids, oscap_free);
+	oscap_free(buf);
+}
+
+static void oval_pcache_init(void)
+{
+	const char *ttl, *path;
+	char *end;
+	long  val;
+
+	ttl = getenv("OSCAP_PROBE_CACHE_TTL");
+
+	if (ttl == NULL)
+		return;
+
+	errno = 0;
+	val   = strtol(ttl, &end, 10);
+
+	if (errno != 0 || *end != '\0' || val < 0) {
+		dW("Invalid value of OSCAP_PROBE_CACHE_TTL: \"%s\"", ttl);
+		return;
+	}
+
+	if (val == 0)
+		return;
+
+	pcache.ttl = (time_t)val;
+
+	pcache.map = oval_string_map_new();
+	path = getenv("OSCAP_PROBE_CACHE_FILE");
+
+	if (path != NULL && path[0] != '\0') {
+		pcache.path = oscap_strdup(path);
+		oval_pcache_load();
+	}
+
+	dI("Probe cache enabled: ttl=%lu, file=%s.", (unsigned long)pcache.ttl,
+	   pcache.path != NULL ? pcache.path : "(none)");
+}
+
+static bool oval_pcache_enabled(void)
+{
+	pthread_once(&pcache.once, &oval_pcache_init);
+	return (pcache.map != NULL);
+}
+
+int oval_pcache_key(struct oval_object *object, const SEXP_t *s_obj, char *key)
+{
+	struct oval_object_content_iterator *cit;
+	oval_object_content_type_t type;
+	SEXP_t   *s_over, *s_skip, *s_rest, *s_ent;
+	strbuf_t *sb;
+	char     *buf;
+	char      name[128];
+	const char *root;
+	uint64_t  hash[2];
+	size_t    len;
+	bool      cacheable = true;
+
+	if (!oval_pcache_enabled())
+		return (1);
+
+	/* the values of a variable_object are looked up in the session by the ID */
+	if ((int)oval_object_get_subtype(object) == OVAL_INDEPENDENT_VARIABLE)
+		return (1);
+
+	cit = oval_object_get_object_contents(object);
+
+	while (cacheable && oval_object_content_iterator_has_more(cit)) {
+		type = oval_object_content_get_type(oval_object_content_iterator_next(cit));
+		/* the referenced objects and states are fetched by their IDs */
+		cacheable = (type != OVAL_OBJECTCONTENT_SET && type != OVAL_OBJECTCONTENT_FILTER);
+	}
+
+	oval_object_content_iterator_free(cit);
+
+	if (!cacheable || probe_obj_attrexists(s_obj, "skip_eval"))
+		return (1);
+
+	/*
+	 * The hash covers everything but the object ID: the probe root, the
+	 * object name and version and the entities with resolved variables.
+	 */
+	root = getenv("OSCAP_PROBE_ROOT");
+	sb = strbuf_new(SEAP_STRBUF_MAX);
+
+	if (root != NULL)
+		strbuf_add(sb, root, strlen(root) + 1);
+
+	probe_obj_getname_r(s_obj, name, sizeof name);
+	strbuf_add(sb, name, strlen(name) + 1);
+
+	s_over = probe_obj_getattrval(s_obj, "oval_version");
+	if (s_over != NULL)
+		SEXP_sbprintf_t(s_over, sb);
+
+	/* the same object may be collected with and without the costly entities */
+	s_skip = probe_obj_getattrval(s_obj, "skip_ents");
+	if (s_skip != NULL)
+		SEXP_sbprintf_t(s_skip, sb);
+
+	s_rest = SEXP_list_rest(s_obj);
+	SEXP_list_foreach(s_ent, s_rest) {
+		if (SEXP_sbprintf_t(s_ent, sb) != 0) {
+			cacheable = false;
+			SEXP_free(s_ent);
+			break;
+		}
+	}
+	SEXP_vfree(s_over, s_rest, NULL);
+	SEXP_free(s_skip);
+
+	len = strbuf_size(sb);
+	buf = oscap_alloc(len > 0 ? len : 1);
+	strbuf_copy(sb, buf, len);
+	strbuf_free(sb);
+
+	MurmurHash3_x64_128(buf, (int)len, 0, hash);
+	oscap_free(buf);
+
+	if (!cacheable)
+		return (1);
+
+	snprintf(key, OVAL_PCACHE_KEYLEN + 1, "%016"PRIx64"%016"PRIx64, hash[0], hash[1]);
+
+	return (0);
+}
+
+SEXP_t *oval_pcache_get(const char *key)
+{
+	struct oval_pcache_entry *entry;
+	SEXP_t *s_cobj = NULL;
+
+	if (!oval_pcache_enabled())
+		return (NULL);
+
+	pthread_mutex_lock(&pcache.lock);
+	entry = oval_string_map_get_value(pcache.map, key);
+
+	if (entry != NULL) {
+		if (oval_pcache_entry_valid(entry, time(NULL))) {
+			s_cobj = SEXP_ref(entry->cobj);
+		} else if (entry->cobj != NULL) {
+			/* the entry is reused when the object gets collected again */
+			SEXP_free(entry->cobj);
+			entry->cobj = NULL;
+			pcache.dirty = true;
+		}
+	}
+
+	pthread_mutex_unlock(&pcache.lock);
+
+	dD("Probe cache %s: %s.", s_cobj != NULL ? "hit" : "miss", key);
+
+	return (s_cobj);
+}
+
+void oval_pcache_put(const char *key, oval_subtype_t type, time_t stamp, const SEXP_t *s_obj, const SEXP_t *s_cobj)
+{
+	struct oval_pcache_entry *entry, *old;
+	SEXP_t *s_items, *s_item;
+	const char *root;
+	size_t i;
+	int    ret = 0;
+
+	if (!oval_pcache_enabled())
+		return;
+
+	switch (probe_cobj_get_flag(s_cobj)) {
+	case SYSCHAR_FLAG_ERROR:
+	case SYSCHAR_FLAG_UNKNOWN:
+		return;
+	default:
+		break;
+	}
+
+	root = getenv("OSCAP_PROBE_ROOT");
+	if (root == NULL)
+		root = "";
+
+	entry = oscap_talloc(struct oval_pcache_entry);
+	entry->stamp = stamp;
+	entry->cobj  = NULL;
+	entry->hintv = NULL;
+	entry->hintc = 0;
+
+	for (i = 0; ret == 0 && i < sizeof pcache_pkgdb / sizeof pcache_pkgdb[0]; ++i)
+		if (pcache_pkgdb[i].type == (int)type)
+			ret = oval_pcache_hint_add(entry, root, pcache_pkgdb[i].path);
+
+	for (i = 0; ret == 0 && i < sizeof pcache_rpmdb_types / sizeof pcache_rpmdb_types[0]; ++i) {
+		if (pcache_rpmdb_types[i] == (int)type) {
+			ret = oval_pcache_hint_rpmdb(entry, root);
+			break;
+		}
+	}
+
+	if (ret == 0)
+		ret = oval_pcache_hint_ents(entry, root, s_obj);
+
+	s_items = probe_cobj_get_items(s_cobj);
+	SEXP_list_foreach(s_item, s_items) {
+		if (ret != 0) {
+			SEXP_free(s_item);
+			break;
+		}
+		ret = oval_pcache_hint_ents(entry, root, s_item);
+	}
+	SEXP_free(s_items);
+
+	if (ret != 0) {
+		dD("Too many files to watch, not caching %s.", key);
+		oval_pcache_entry_free(entry);
+		return;
+	}
+
+	/*
+	 * A file modified after the collection started might have been read
+	 * before or after the modification.
+	 */
+	for (i = 0; i < entry->hintc; ++i) {
+		if (entry->hintv[i].size != -1 && entry->hintv[i].mtime >= stamp) {
+			dD("%s changed during the collection, not caching %s.", entry->hintv[i].path, key);
+			oval_pcache_entry_free(entry);
+			return;
+		}
+	}
+
+	entry->cobj = SEXP_ref(s_cobj);
+
+	pthread_mutex_lock(&pcache.lock);
+	old = oval_string_map_get_value(pcache.map, key);
+
+	if (old != NULL) {
+		/* replace the contents, the map has no delete operation */
+		struct oval_pcache_entry tmp = *old;
+
+		*old   = *entry;
+		*entry = tmp;
+		oval_pcache_entry_free(entry);
+	} else
+		oval_string_map_put(pcache.map, key, entry);
+
+	pcache.dirty = true;
+	pthread_mutex_unlock(&pcache.lock);
+}
+
+int oval_pcache_save(void)
+{
+	struct oval_iterator *it;
+	struct oval_pcache_entry *entry;
+	strbuf_t *sb;
+	SEXP_t   *s_entry;
+	char     *tmp, *key;
+	uint32_t  slen;
+	size_t    tlen;
+	FILE     *fp;
+	time_t    now;
+	int       ret = 0;
+
+	if (!oval_pcache_enabled() || pcache.path == NULL)
+		return (0);
+
+	pthread_mutex_lock(&pcache.lock);
+
+	if (!pcache.dirty) {
+		pthread_mutex_unlock(&pcache.lock);
+		return (0);
+	}
+
+	/* write a temporary file and rename it, concurrent writers don't corrupt the file */
+	tlen = strlen(pcache.path) + sizeof ".XXXXXX";
+	tmp  = oscap_alloc(tlen);
+	snprintf(tmp, tlen, "%s.XXXXXX", pcache.path);
+
+	{
+		int fd = mkstemp(tmp);
+
+		fp = (fd != -1 ? fdopen(fd, "w") : NULL);
+
+		if (fp == NULL) {
+			dW("Can't create the probe cache file %s: %s.", tmp, strerror(errno));
+			if (fd != -1)
+				close(fd);
+			pthread_mutex_unlock(&pcache.lock);
+			oscap_free(tmp);
+			return (-1);
+		}
+	}
+
+	if (fwrite(OVAL_PCACHE_MAGIC, 1, OVAL_PCACHE_MAGICLEN, fp) != OVAL_PCACHE_MAGICLEN)
+		ret = -1;
+
+	now = time(NULL);
+	it  = oval_string_map_keys(pcache.map);
+
+	while (ret == 0 && oval_collection_iterator_has_more(it)) {
+		key   = oval_collection_iterator_next(it);
+		entry = oval_string_map_get_value(pcache.map, key);
+
+		if (entry == NULL || entry->cobj == NULL || now - entry->stamp >= pcache.ttl)
+			continue;
+
+		s_entry = oval_pcache_entry_to_sexp(key, entry);
+		sb = strbuf_new(SEAP_STRBUF_MAX);
+
+		if (SEXP_sbprintf_b(s_entry, sb) != 0 || strbuf_size(sb) > UINT32_MAX) {
+			ret = -1;
+		} else {
+			slen = (uint32_t)strbuf_size(sb);
+
+			if (fwrite(&slen, sizeof slen, 1, fp) != 1 || strbuf_fwrite(fp, sb) != slen)
+				ret = -1;
+		}
+
+		strbuf_free(sb);
+		SEXP_free(s_entry);
+	}
+
+	oval_collection_iterator_free(it);
+
+	if (fclose(fp) != 0)
+		ret = -1;
+
+	if (ret == 0 && rename(tmp, pcache.path) != 0)
+		ret = -1;
+
+	if (ret != 0) {
+		protect_errno {
+			dW("Can't write the probe cache file %s: %s.", pcache.path, strerror(errno));
+			unlink(tmp);
+		}
+	} else
+		pcache.dirty = false;
+
+	pthread_mutex_unlock(&pcache.lock);
+	oscap_free(tmp);
+
+	return (ret);
+}
@@ -0,0 +1,86 @@
+/**
+ * @file oval_probe_cache.h
+ * @brief Process-wide cache of collected objects
+ *
+ * The cache stores the collected objects (as received from the probes)
+ * under a hash of the object content, so that an object collected in one
+ * session is reused by the other sessions of the process, regardless of
+ * its ID. The cache is disabled by default, it's enabled by setting the
+ * OSCAP_PROBE_CACHE_TTL environment variable to the maximal age of the
+ * cached objects in seconds. If OSCAP_PROBE_CACHE_FILE is set too, the
+ * cache is loaded from and saved to that file.
+ *
+ * A cached object is dropped earlier if any of the files it was collected
+ * from (the package database of the package objects and the files, paths
+ * named in the object and its items) changed.
+ */
+/*
+ * Copyright 2016 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef OVAL_PROBE_CACHE_H
+#define OVAL_PROBE_CACHE_H
+
+#include <time.h>
+#include <sexp.h>
+#include "public/oval_definitions.h"
+#include "common/util.h"
+
+OSCAP_HIDDEN_START;
+
+#define OVAL_PCACHE_KEYLEN 32 /**< length of the hex encoded key */
+
+/**
+ * Compute the cache key of an object.
+ * @param object the object
+ * @param s_obj the object as sent to the probe (with the variables resolved)
+ * @param key buffer for the key, OVAL_PCACHE_KEYLEN + 1 bytes
+ * @retval 0 the object can be cached
+ * @retval 1 the cache is disabled or the object can't be cached, because
+ *           the result doesn't depend only on its content (it references
+ *           other objects or states)
+ */
+int oval_pcache_key(struct oval_object *object, const SEXP_t *s_obj, char *key);
+
+/**
+ * Get a collected object from the cache.
+ * @return new reference to the collected object or NULL if the object
+ *         isn't cached or the cached value isn't valid anymore
+ */
+SEXP_t *oval_pcache_get(const char *key);
+
+/**
+ * Store a collected object in the cache. Objects with an error flag and
+ * objects which changed since the collection started aren't stored.
+ * @param key key computed by oval_pcache_key
+ * @param type subtype of the object
+ * @param stamp time at which the collection started
+ * @param s_obj the object as sent to the probe
+ * @param s_cobj the collected object
+ */
+void oval_pcache_put(const char *key, oval_subtype_t type, time_t stamp, const SEXP_t *s_obj, const SEXP_t *s_cobj);
+
+/**
+ * Write the cache to the cache file, if there is one and the cache has
+ * changed since it was loaded or last saved.
+ * @return 0 on success, -1 on failure
+ */
+int oval_pcache_save(void);
+
+OSCAP_HIDDEN_END;
+
+#endif /* OVAL_PROBE_CACHE_H */
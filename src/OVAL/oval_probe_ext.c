@@ -39,10 +39,12 @@
 #include "common/util.h"
 #include "common/bfind.h"
 #include "common/debug_priv.h"
+#include "common/timing_priv.h"
 #include "probes/public/probe-api.h"
 #include "oval_probe_ext.h"
 #include "oval_sexp.h"
 #include "oval_probe_meta.h"
+#include "oval_probe_cache.h"
 
 #define __ERRBUF_SIZE 128
 
@@ -76,14 +78,38 @@ oval_pext_t *oval_pext_new(void)
                 pext->probe_dir = OVAL_PROBE_DIR;
 
         pext->pdtbl     = NULL;
+        pext->pdtbl_gen = 0;
         pext->pdsc      = NULL;
         pext->pdsc_cnt  = 0;
 
+        pext->async_window = 0;
+
+        {
+                const char *window = getenv("OSCAP_PROBE_ASYNC_WINDOW");
+                char *end;
+                long  val;
+
+                if (window != NULL) {
+                        errno = 0;
+                        val = strtol(window, &end, 10);
+
+                        if (errno != 0 || end == window || *end != '\0' || val < 0) {
+                                dW("Invalid value of OSCAP_PROBE_ASYNC_WINDOW: \"%s\"", window);
+                        } else if (val > OVAL_PEXT_ASYNC_WINDOW_MAX) {
+                                dW("OSCAP_PROBE_ASYNC_WINDOW too large, using %d", OVAL_PEXT_ASYNC_WINDOW_MAX);
+                                pext->async_window = OVAL_PEXT_ASYNC_WINDOW_MAX;
+                        } else
+                                pext->async_window = (size_t)val;
+                }
+        }
+
         return(pext);
 }
 
 void oval_pext_free(oval_pext_t *pext)
 {
+        oval_pcache_save();
+
         if (!pext->do_init) {
                 /* free structs */
 		oscap_free(pext->pdsc);
@@ -118,6 +144,11 @@ static void oval_pdtbl_free(oval_pdtbl_t *tbl)
         for (i = 0; i < tbl->count; ++i) {
                 SEAP_close(tbl->ctx, tbl->memb[i]->sd);
                 oscap_free(tbl->memb[i]->uri);
+
+                while (tbl->memb[i]->stash_cnt > 0)
+                        SEAP_msg_free(tbl->memb[i]->stash[--tbl->memb[i]->stash_cnt]);
+
+                oscap_free(tbl->memb[i]->stash);
 		oscap_free(tbl->memb[i]);
         }
 
@@ -153,6 +184,9 @@ static int oval_pdtbl_add(oval_pdtbl_t *tbl, oval_subtype_t type, int sd, const
 	pd->subtype = type;
 	pd->sd      = sd;
 	pd->uri     = strdup(uri);
+	pd->stash     = NULL;
+	pd->stash_cnt = 0;
+	pd->async_cnt = 0;
 
 	tbl->memb = oscap_realloc(tbl->memb, sizeof(oval_pd_t *) * (++tbl->count));
 
@@ -176,6 +210,59 @@ static oval_pd_t *oval_pdtbl_get(oval_pdtbl_t * tbl, oval_subtype_t type)
 	return (pdp == NULL ? NULL : *pdp);
 }
 
+/*
+ * Extract the id of the request a message replies to.
+ */
+static int oval_probe_msg_replyid(SEAP_msg_t *msg, SEAP_msgid_t *id)
+{
+	SEXP_t *r0;
+
+	r0 = SEAP_msgattr_get(msg, "reply-id");
+
+	if (r0 == NULL)
+		return (-1);
+#if SEAP_MSGID_BITS == 64
+	*id = SEXP_number_getu_64(r0);
+#else
+	*id = SEXP_number_getu_32(r0);
+#endif
+	SEXP_free(r0);
+
+	return (0);
+}
+
+/*
+ * Replies to pipelined requests may arrive while somebody else is waiting
+ * for a reply on the same descriptor (e.g. a synchronous query issued from
+ * a probe command handler). Such replies are kept in the stash until their
+ * owner asks for them.
+ */
+static void oval_pd_stash_add(oval_pd_t *pd, SEAP_msg_t *msg)
+{
+	pd->stash = oscap_realloc(pd->stash, sizeof(SEAP_msg_t *) * (pd->stash_cnt + 1));
+	pd->stash[pd->stash_cnt++] = msg;
+}
+
+static SEAP_msg_t *oval_pd_stash_get(oval_pd_t *pd, SEAP_msgid_t id)
+{
+	SEAP_msgid_t rid;
+	SEAP_msg_t  *msg;
+	size_t i;
+
+	for (i = 0; i < pd->stash_cnt; ++i) {
+		if (oval_probe_msg_replyid(pd->stash[i], &rid) != 0 || rid != id)
+			continue;
+
+		msg = pd->stash[i];
+		memmove(pd->stash + i, pd->stash + i + 1, sizeof(SEAP_msg_t *) * (pd->stash_cnt - i - 1));
+		--pd->stash_cnt;
+
+		return (msg);
+	}
+
+	return (NULL);
+}
+
 /*
  * oval_probe_cmd_
  */
@@ -240,11 +327,13 @@ static SEXP_t *oval_probe_cmd_obj_eval(SEXP_t *sexp, void *arg)
 	}
 
 	oscap_clearerr();
+	oval_probe_sync_enter(pext->sess_ptr);
 	r = oval_probe_query_object(pext->sess_ptr, obj, OVAL_PDFLAG_NOREPLY|OVAL_PDFLAG_SLAVE, &res);
 	if (r < 0)
 		ret_code = SEXP_number_newu((unsigned int) SYSCHAR_FLAG_COMPLETE);
 	else
 		ret_code = SEXP_number_newu((unsigned int) oval_syschar_get_flag(res));
+	oval_probe_sync_leave(pext->sess_ptr);
 
 	SEXP_list_add(ret, ret_code);
 	SEXP_free(ret_code);
@@ -293,7 +382,9 @@ static SEXP_t *oval_probe_cmd_ste_fetch(SEXP_t *sexp, void *arg)
 				return (NULL);
 			}
 
+			oval_probe_sync_enter(pext->sess_ptr);
 			ret = oval_state_to_sexp(pext->sess_ptr, ste, &ste_sexp);
+			oval_probe_sync_leave(pext->sess_ptr);
 			if (ret !=0) {
 				dE("Failed to convert OVAL state to SEXP, id: %s.",
 					       id_str);
@@ -374,7 +465,11 @@ static inline int _handle_SEAP_receive_failure(SEAP_CTX_t *ctx, oval_pd_t *pd, S
 		case  0:
 			break;
 		case  1: /* no error found */
-			dE("Internal error: An error was signaled on sd=%d but the error queue is empty.");
+			if (pd->async_cnt > 0) {
+				/* the error belongs to one of the pipelined requests */
+				return (1);
+			}
+			dE("Internal error: An error was signaled on sd=%d but the error queue is empty.", pd->sd);
 			oscap_seterr(OSCAP_EFAMILY_OVAL, "SEAP_recverr_byid: internal error: empty error queue.");
 			return (-1);
 		case -1: /* internal error */
@@ -551,13 +646,22 @@ static int oval_probe_comm(SEAP_CTX_t *ctx, oval_pd_t *pd, const SEXP_t *s_iobj,
 
 		dD("Waiting for reply.");
 
-		/* recv_retry: */
-		s_imsg = NULL;
+	recv_retry:
+		s_imsg = oval_pd_stash_get(pd, SEAP_msg_id(s_omsg));
+		ret    = 0;
+
+		if (s_imsg == NULL)
+			ret = SEAP_recvmsg(ctx, pd->sd, &s_imsg);
 
-		ret = SEAP_recvmsg(ctx, pd->sd, &s_imsg);
 		if (ret != 0) {
 			protect_errno {
 				ret = _handle_SEAP_receive_failure(ctx, pd, s_omsg, flags);
+			}
+
+			if (ret == 1)
+				goto recv_retry;
+
+			protect_errno {
 				SEAP_msg_free(s_imsg);
 				SEAP_msg_free(s_omsg);
 			}
@@ -583,6 +687,17 @@ static int oval_probe_comm(SEAP_CTX_t *ctx, oval_pd_t *pd, const SEXP_t *s_iobj,
 			}
 		}
 
+		if (pd->async_cnt > 0) {
+			SEAP_msgid_t rid;
+
+			if (oval_probe_msg_replyid(s_imsg, &rid) == 0
+			    && rid != SEAP_msg_id(s_omsg)) {
+				dD("Stashing reply to a pipelined request (id=%u).", rid);
+				oval_pd_stash_add(pd, s_imsg);
+				goto recv_retry;
+			}
+		}
+
 		dD("Message received.");
 		break;
 	}
@@ -817,6 +932,54 @@ int oval_probe_sys_handler(oval_subtype_t type, void *ptr, int act, ...)
         return(ret);
 }
 
+/*
+ * Get the probe descriptor of the probe handling objects of the given subtype.
+ * The probe descriptor is created if it doesn't exist yet.
+ * @return 0 on success, 1 if the subtype isn't supported, -1 on error
+ */
+static int oval_pext_getpd(oval_pext_t *pext, oval_subtype_t type, oval_pd_t **out_pd)
+{
+	oval_pd_t *pd;
+
+	pd = oval_pdtbl_get(pext->pdtbl, type);
+
+	if (pd == NULL) {
+		char         probe_uri[PATH_MAX + 1];
+		size_t       probe_urilen;
+		char        *probe_dir;
+		oval_pdsc_t *probe_dsc;
+
+		probe_dir = pext->probe_dir;
+		probe_dsc = oval_pdsc_lookup(pext->pdsc, pext->pdsc_cnt, type);
+
+		if (probe_dsc == NULL)
+			return (1);
+
+		probe_urilen = snprintf(probe_uri, sizeof probe_uri,
+					"%s://%s/%s", OVAL_PROBE_SCHEME, probe_dir, probe_dsc->file);
+
+		if (probe_urilen >= sizeof probe_uri) {
+			oscap_seterr (OSCAP_EFAMILY_GLIBC, "probe URI too long");
+			return (-1);
+		}
+
+		dI("Starting probe on URI '%s'.", probe_uri);
+
+		if (oval_pdtbl_add(pext->pdtbl, type, -1, probe_uri) != 0)
+			return (1);
+
+		pd = oval_pdtbl_get(pext->pdtbl, type);
+
+		if (pd == NULL) {
+			oscap_seterr (OSCAP_EFAMILY_OVAL, "internal error");
+			return (-1);
+		}
+	}
+
+	*out_pd = pd;
+	return (0);
+}
+
 int oval_probe_ext_handler(oval_subtype_t type, void *ptr, int act, ...)
 {
         int          ret = 0;
@@ -836,50 +999,19 @@ int oval_probe_ext_handler(oval_subtype_t type, void *ptr, int act, ...)
 		sys = va_arg(ap, struct oval_syschar *);
 		flags = va_arg(ap, int);
 		obj = oval_syschar_get_object(sys);
-                pd = oval_pdtbl_get(pext->pdtbl, oval_object_get_subtype(obj));
 
-                if (pd == NULL) {
-                        char         probe_uri[PATH_MAX + 1];
-                        size_t       probe_urilen;
-                        char        *probe_dir;
-                        oval_pdsc_t *probe_dsc;
-
-                        probe_dir = pext->probe_dir;
-                        probe_dsc = oval_pdsc_lookup(pext->pdsc, pext->pdsc_cnt, oval_object_get_subtype(obj));
-
-			if (probe_dsc == NULL) {
-				oval_syschar_add_new_message(sys, "OVAL object not supported", OVAL_MESSAGE_LEVEL_WARNING);
-				oval_syschar_set_flag(sys, SYSCHAR_FLAG_NOT_COLLECTED);
-				va_end(ap);
-				return (1);
-			}
-
-                        probe_urilen = snprintf(probe_uri, sizeof probe_uri,
-                                                "%s://%s/%s", OVAL_PROBE_SCHEME, probe_dir, probe_dsc->file);
-
-                        if (probe_urilen >= sizeof probe_uri) {
-                                oscap_seterr (OSCAP_EFAMILY_GLIBC, "probe URI too long");
-				va_end(ap);
-                                return (-1);
-                        }
-
-                        dI("Starting probe on URI '%s'.", probe_uri);
-
-                        if (oval_pdtbl_add(pext->pdtbl, oval_object_get_subtype(obj), -1, probe_uri) != 0) {
-				oval_syschar_add_new_message(sys, "OVAL object not supported", OVAL_MESSAGE_LEVEL_WARNING);
-				oval_syschar_set_flag(sys, SYSCHAR_FLAG_NOT_COLLECTED);
-				va_end(ap);
-                                return (1);
-			}
-
-			pd = oval_pdtbl_get(pext->pdtbl, oval_object_get_subtype(obj));
-
-                        if (pd == NULL) {
-                                oscap_seterr (OSCAP_EFAMILY_OVAL, "internal error");
-				va_end(ap);
-                                return (-1);
-                        }
-                }
+		switch (oval_pext_getpd(pext, oval_object_get_subtype(obj), &pd)) {
+		case 0:
+			break;
+		case 1:
+			oval_syschar_add_new_message(sys, "OVAL object not supported", OVAL_MESSAGE_LEVEL_WARNING);
+			oval_syschar_set_flag(sys, SYSCHAR_FLAG_NOT_COLLECTED);
+			va_end(ap);
+			return (1);
+		default:
+			va_end(ap);
+			return (-1);
+		}
 
 		ret = oval_probe_ext_eval(pext->pdtbl->ctx, pd, pext, sys, flags);
 
@@ -1035,6 +1167,7 @@ int oval_probe_ext_init(oval_pext_t *pext)
 		}
 
                 pext->pdtbl = oval_pdtbl_new();
+                ++pext->pdtbl_gen;
 
                 if (oval_probe_cmd_init(pext) != 0)
                         ret = -1;
@@ -1051,6 +1184,9 @@ int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struc
 {
         SEXP_t *s_obj, *s_sys;
 	struct oval_object *object;
+	char   pc_key[OVAL_PCACHE_KEYLEN + 1];
+	bool   pc_use = false;
+	time_t pc_stamp = 0;
 	int ret;
 
 	if (syschar == NULL) {
@@ -1064,7 +1200,39 @@ int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struc
 	if (ret != 0)
 		return (1);
 
-	ret = oval_probe_comm(ctx, pd, s_obj, flags, &s_sys);
+	if (!(flags & OVAL_PDFLAG_NOREPLY) && oval_pcache_key(object, s_obj, pc_key) == 0) {
+		s_sys = oval_pcache_get(pc_key);
+
+		if (s_sys != NULL) {
+			oscap_timing_object_cache(OSCAP_TIMING_CACHE_HIT);
+			SEXP_free(s_obj);
+			ret = oval_sexp_to_sysch(s_sys, syschar);
+			SEXP_free(s_sys);
+
+			return (ret);
+		}
+
+		oscap_timing_object_cache(OSCAP_TIMING_CACHE_MISS);
+		pc_use   = true;
+		pc_stamp = time(NULL);
+	}
+
+	/* don't block the other synchronized sessions while the probe works */
+	oval_probe_sync_leave(pext->sess_ptr);
+	if (oscap_timing_enabled()) {
+		uint64_t sent[2] = { 0, 0 }, received[2] = { 0, 0 };
+
+		SEAP_traffic(ctx, pd->sd, &sent[0], &received[0]);
+		ret = oval_probe_comm(ctx, pd, s_obj, flags, &s_sys);
+		if (SEAP_traffic(ctx, pd->sd, &sent[1], &received[1]) == 0)
+			oscap_timing_object_traffic(sent[1] - sent[0], received[1] - received[0]);
+	} else
+		ret = oval_probe_comm(ctx, pd, s_obj, flags, &s_sys);
+	oval_probe_sync_enter(pext->sess_ptr);
+
+	if (ret == 0 && pc_use && s_sys != NULL)
+		oval_pcache_put(pc_key, oval_object_get_subtype(object), pc_stamp, s_obj, s_sys);
+
 	SEXP_free(s_obj);
 
 	if (ret != 0) {
@@ -1100,6 +1268,528 @@ int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struc
 	return (ret);
 }
 
+/*
+ * Asynchronous (pipelined) evaluation
+ */
+struct oval_pasync_req {
+	SEAP_msgid_t         id;
+	struct oval_syschar *syschar;
+	SEXP_t              *pc_obj; /**< the object, if the reply goes to the probe cache */
+	char                 pc_key[OVAL_PCACHE_KEYLEN + 1];
+	time_t               pc_stamp;
+	double               tm_start; /**< when the request was sent, for the timing report */
+	uint64_t             tm_sent;
+};
+
+struct oval_pasync_grp {
+	oval_subtype_t          type;
+	oval_pd_t              *pd;
+	struct oval_syschar   **sysv; /**< syschars waiting to be sent */
+	size_t                  sysc;
+	size_t                  next;
+	struct oval_pasync_req *reqv; /**< requests waiting for a reply */
+	size_t                  reqc;
+};
+
+struct oval_pasync {
+	oval_pext_t            *pext;
+	SEAP_CTX_t             *ctx;
+	unsigned int            pdtbl_gen;
+	size_t                  window;
+	struct oval_pasync_grp *grpv;
+	size_t                  grpc;
+	oval_probe_async_cb_t  *cb;
+	void                   *arg;
+	bool                    stop;
+};
+
+/*
+ * The probe descriptor table is thrown away if a probe connection is aborted
+ * during a synchronous evaluation, which may happen in a completion callback.
+ */
+static bool oval_pasync_lost(struct oval_pasync *as)
+{
+	return (as->pext->do_init || as->pext->pdtbl_gen != as->pdtbl_gen);
+}
+
+static void oval_pasync_complete(struct oval_pasync *as, struct oval_syschar *syschar)
+{
+	if (as->stop)
+		return;
+
+	if (as->cb(syschar, as->arg) != 0) {
+		dI("Asynchronous evaluation stopped by the callback.");
+		as->stop = true;
+	}
+}
+
+static void oval_pasync_req_del(struct oval_pasync_grp *grp, size_t i)
+{
+	SEXP_free(grp->reqv[i].pc_obj);
+	grp->reqv[i] = grp->reqv[--grp->reqc];
+	--grp->pd->async_cnt;
+}
+
+/*
+ * Record the collection of an object for the timing report. The time is
+ * counted from sending the request, so it includes the time the request
+ * waited behind the other requests in flight. The received bytes are the
+ * bytes read while waiting for the reply.
+ */
+static void oval_pasync_timing(struct oval_pasync_grp *grp, struct oval_pasync_req *req,
+			       struct oval_syschar *syschar, uint64_t received, oscap_timing_cache_t cache)
+{
+	struct oval_sysitem_iterator *it;
+	size_t items = 0;
+
+	if (!oscap_timing_enabled())
+		return;
+
+	it = oval_syschar_get_sysitem(syschar);
+	while (oval_sysitem_iterator_has_more(it)) {
+		oval_sysitem_iterator_next(it);
+		++items;
+	}
+	oval_sysitem_iterator_free(it);
+
+	oscap_timing_object_add(oval_object_get_id(oval_syschar_get_object(syschar)),
+				oval_subtype_get_text(grp->type), oscap_timing_now() - req->tm_start,
+				items, req->tm_sent, received, cache);
+}
+
+/*
+ * Abandon the requests of a group. The syschars are left untouched so that
+ * the objects get collected (and errors reported) by the synchronous path.
+ */
+static void oval_pasync_grp_abandon(struct oval_pasync *as, struct oval_pasync_grp *grp)
+{
+	struct oval_syschar *syschar;
+
+	while (grp->reqc > 0) {
+		syschar = grp->reqv[grp->reqc - 1].syschar;
+		oval_pasync_req_del(grp, grp->reqc - 1);
+		oval_pasync_complete(as, syschar);
+	}
+
+	while (grp->next < grp->sysc)
+		oval_pasync_complete(as, grp->sysv[grp->next++]);
+}
+
+/*
+ * Fill the window of outstanding requests of the group.
+ */
+static int oval_pasync_send(struct oval_pasync *as, struct oval_pasync_grp *grp)
+{
+	struct oval_syschar *syschar;
+	struct oval_object  *object;
+	struct oval_pasync_req *req;
+	SEAP_msg_t *s_omsg;
+	SEXP_t     *s_obj, *s_sys;
+
+	while (!as->stop && grp->reqc < as->window && grp->next < grp->sysc) {
+		syschar = grp->sysv[grp->next++];
+
+		if (oval_syschar_get_flag(syschar) != SYSCHAR_FLAG_UNKNOWN) {
+			/* already collected by a synchronous query */
+			oval_pasync_complete(as, syschar);
+			continue;
+		}
+
+		object = oval_syschar_get_object(syschar);
+
+		if (oval_object_to_sexp(as->pext->sess_ptr, oval_subtype_to_str(grp->type), syschar, &s_obj) != 0) {
+			oval_pasync_complete(as, syschar);
+			continue;
+		}
+
+		req = grp->reqv + grp->reqc;
+		req->pc_obj = NULL;
+		req->tm_start = oscap_timing_enabled() ? oscap_timing_now() : 0;
+		req->tm_sent  = 0;
+
+		if (oval_pcache_key(object, s_obj, req->pc_key) == 0) {
+			s_sys = oval_pcache_get(req->pc_key);
+
+			if (s_sys != NULL) {
+				SEXP_free(s_obj);
+				oval_sexp_to_sysch(s_sys, syschar);
+				SEXP_free(s_sys);
+				oval_pasync_timing(grp, req, syschar, 0, OSCAP_TIMING_CACHE_HIT);
+				oval_pasync_complete(as, syschar);
+				continue;
+			}
+
+			req->pc_obj   = SEXP_ref(s_obj);
+			req->pc_stamp = time(NULL);
+		}
+
+		if (oval_pasync_lost(as)) {
+			SEXP_vfree(s_obj, req->pc_obj, NULL);
+			--grp->next; /* completed when the group is dropped */
+			return (-1);
+		}
+
+		if (grp->pd->sd == -1) {
+			grp->pd->sd = SEAP_connect(as->ctx, grp->pd->uri, 0);
+
+			if (grp->pd->sd < 0) {
+				protect_errno {
+					dW("Can't connect: %u, %s.", errno, strerror(errno));
+				}
+				grp->pd->sd = -1;
+				--grp->next;
+				SEXP_vfree(s_obj, req->pc_obj, NULL);
+				oval_pasync_grp_abandon(as, grp);
+
+				return (-1);
+			}
+		}
+
+		s_omsg = SEAP_msg_new();
+		SEAP_msg_set(s_omsg, s_obj);
+		SEXP_free(s_obj);
+
+		uint64_t sent = 0;
+
+		SEAP_traffic(as->ctx, grp->pd->sd, &sent, NULL);
+		req->tm_sent = sent;
+
+		if (SEAP_sendmsg(as->ctx, grp->pd->sd, s_omsg) != 0) {
+			protect_errno {
+				dW("Can't send message: %u, %s.", errno, strerror(errno));
+				SEAP_msg_free(s_omsg);
+				SEXP_free(req->pc_obj);
+			}
+			--grp->next;
+			oval_pasync_grp_abandon(as, grp);
+
+			return (-1);
+		}
+
+		dD("Sent %s object '%s' (id=%u), %zu request(s) in flight.",
+		   oval_subtype_to_str(grp->type), oval_object_get_id(object),
+		   SEAP_msg_id(s_omsg), grp->reqc + 1);
+
+		if (SEAP_traffic(as->ctx, grp->pd->sd, &sent, NULL) == 0)
+			req->tm_sent = sent - req->tm_sent;
+
+		req->id      = SEAP_msg_id(s_omsg);
+		req->syschar = syschar;
+		++grp->reqc;
+		++grp->pd->async_cnt;
+
+		SEAP_msg_free(s_omsg);
+	}
+
+	return (0);
+}
+
+/*
+ * Process a reply of the group, the received bytes are used for the timing
+ * report.
+ */
+static int oval_pasync_reply(struct oval_pasync *as, struct oval_pasync_grp *grp, SEAP_msg_t *s_imsg, uint64_t received)
+{
+	struct oval_syschar *syschar;
+	SEAP_msgid_t rid;
+	SEXP_t *s_sys;
+	size_t  i;
+
+	if (oval_probe_msg_replyid(s_imsg, &rid) == 0) {
+		for (i = 0; i < grp->reqc; ++i)
+			if (grp->reqv[i].id == rid)
+				break;
+	} else
+		i = grp->reqc;
+
+	if (i == grp->reqc) {
+		dW("Discarding an unexpected message from sd=%d.", grp->pd->sd);
+		SEAP_msg_free(s_imsg);
+
+		return (0);
+	}
+
+	syschar = grp->reqv[i].syschar;
+	s_sys   = SEAP_msg_get(s_imsg);
+
+	if (s_sys != NULL && grp->reqv[i].pc_obj != NULL)
+		oval_pcache_put(grp->reqv[i].pc_key, grp->type, grp->reqv[i].pc_stamp, grp->reqv[i].pc_obj, s_sys);
+
+	/*
+	 * The object might have been collected by a synchronous query while
+	 * the request was in flight.
+	 */
+	if (s_sys != NULL && oval_syschar_get_flag(syschar) == SYSCHAR_FLAG_UNKNOWN) {
+		oval_sexp_to_sysch(s_sys, syschar);
+		oval_pasync_timing(grp, &grp->reqv[i], syschar, received,
+				   grp->reqv[i].pc_obj != NULL ? OSCAP_TIMING_CACHE_MISS : OSCAP_TIMING_CACHE_NONE);
+	}
+
+	oval_pasync_req_del(grp, i);
+
+	SEXP_free(s_sys);
+	SEAP_msg_free(s_imsg);
+
+	/* keep the probe busy while the caller processes the result */
+	oval_pasync_send(as, grp);
+	oval_pasync_complete(as, syschar);
+
+	return (oval_pasync_lost(as) ? -1 : 0);
+}
+
+/*
+ * Process an error or a reply of the group which was received and queued
+ * while a synchronous query was waiting for its reply on the same descriptor.
+ * @return 1 if nothing was queued
+ */
+static int oval_pasync_recv_queued(struct oval_pasync *as, struct oval_pasync_grp *grp)
+{
+	struct oval_syschar *syschar;
+	SEAP_msg_t  *s_imsg;
+	SEAP_err_t  *err;
+	size_t  i;
+
+	for (i = 0; i < grp->reqc; ++i) {
+		err = NULL;
+
+		if (SEAP_recverr_byid(as->ctx, grp->pd->sd, &err, grp->reqv[i].id) == 0) {
+			syschar = grp->reqv[i].syschar;
+
+			dW("Probe at sd=%d (%s) reported an error for object '%s': %s",
+			   grp->pd->sd, oval_subtype_to_str(grp->type),
+			   oval_object_get_id(oval_syschar_get_object(syschar)),
+			   _probe_strerror(err->code));
+
+			SEAP_error_free(err);
+			oval_pasync_req_del(grp, i);
+			oval_pasync_send(as, grp);
+			oval_pasync_complete(as, syschar);
+
+			return (oval_pasync_lost(as) ? -1 : 0);
+		}
+	}
+
+	for (i = 0; i < grp->reqc; ++i) {
+		s_imsg = oval_pd_stash_get(grp->pd, grp->reqv[i].id);
+
+		if (s_imsg != NULL)
+			return (oval_pasync_reply(as, grp, s_imsg, 0));
+	}
+
+	return (1);
+}
+
+/*
+ * Receive and process one message of the group. The descriptor was reported
+ * ready by SEAP_poll(), an error is picked up by oval_pasync_recv_queued().
+ */
+static int oval_pasync_recv(struct oval_pasync *as, struct oval_pasync_grp *grp)
+{
+	SEAP_msg_t *s_imsg;
+	uint64_t    received[2] = { 0, 0 };
+	bool        counted;
+
+	counted = (SEAP_traffic(as->ctx, grp->pd->sd, NULL, &received[0]) == 0);
+
+	if (SEAP_recvmsg(as->ctx, grp->pd->sd, &s_imsg) != 0) {
+		if (errno == ECANCELED) {
+			/* the error is picked up on the next call */
+			return (0);
+		}
+
+		protect_errno {
+			dW("Can't receive message: %u, %s.", errno, strerror(errno));
+		}
+
+		SEAP_close(as->ctx, grp->pd->sd);
+		grp->pd->sd = -1;
+		oval_pasync_grp_abandon(as, grp);
+
+		return (-1);
+	}
+
+	if (counted && SEAP_traffic(as->ctx, grp->pd->sd, NULL, &received[1]) == 0)
+		received[0] = received[1] - received[0];
+	else
+		received[0] = 0;
+
+	return (oval_pasync_reply(as, grp, s_imsg, received[0]));
+}
+
+/*
+ * Complete the syschars of a group whose probe descriptor was thrown away,
+ * the requests in flight are lost and the objects are left to the
+ * synchronous path.
+ */
+static void oval_pasync_grp_drop(struct oval_pasync *as, struct oval_pasync_grp *grp)
+{
+	while (grp->reqc > 0) {
+		--grp->reqc;
+		SEXP_free(grp->reqv[grp->reqc].pc_obj);
+		oval_pasync_complete(as, grp->reqv[grp->reqc].syschar);
+	}
+
+	while (grp->next < grp->sysc)
+		oval_pasync_complete(as, grp->sysv[grp->next++]);
+}
+
+int oval_probe_ext_eval_async(oval_pext_t *pext, struct oval_syschar **sysv, size_t sysc, oval_probe_async_cb_t *cb, void *arg)
+{
+	struct oval_pasync      as;
+	struct oval_pasync_grp *grp;
+	oval_subtype_t type;
+	size_t i, g, n, turn;
+	size_t *grpv = NULL;
+	int   *sdv = NULL;
+	bool  *ready = NULL, queued;
+	int    ret = 0;
+
+	if (oval_probe_ext_init(pext) != 0)
+		return (-1);
+
+	as.pext      = pext;
+	as.ctx       = pext->pdtbl->ctx;
+	as.pdtbl_gen = pext->pdtbl_gen;
+	as.window    = (pext->async_window > 0 ? pext->async_window : 1);
+	as.grpv      = NULL;
+	as.grpc      = 0;
+	as.cb        = cb;
+	as.arg       = arg;
+	as.stop      = false;
+
+	/*
+	 * Split the syschars into groups by subtype, the document order is
+	 * preserved within each group.
+	 */
+	for (i = 0; i < sysc; ++i) {
+		type = oval_object_get_subtype(oval_syschar_get_object(sysv[i]));
+
+		for (g = 0; g < as.grpc; ++g)
+			if (as.grpv[g].type == type)
+				break;
+
+		if (g == as.grpc) {
+			as.grpv = oscap_realloc(as.grpv, sizeof(struct oval_pasync_grp) * (++as.grpc));
+			grp = as.grpv + g;
+			grp->type = type;
+			grp->sysv = NULL;
+			grp->sysc = 0;
+			grp->next = 0;
+			grp->reqv = oscap_alloc(sizeof(struct oval_pasync_req) * as.window);
+			grp->reqc = 0;
+
+			if (oval_pext_getpd(pext, type, &grp->pd) != 0)
+				grp->pd = NULL;
+		}
+
+		grp = as.grpv + g;
+		grp->sysv = oscap_realloc(grp->sysv, sizeof(struct oval_syschar *) * (grp->sysc + 1));
+		grp->sysv[grp->sysc++] = sysv[i];
+	}
+
+	dI("Pipelining %zu object(s) to %zu probe(s), window: %zu.", sysc, as.grpc, as.window);
+
+	/*
+	 * Unsupported objects are left to the synchronous path which takes care
+	 * of reporting them.
+	 */
+	for (g = 0; g < as.grpc; ++g)
+		if (as.grpv[g].pd == NULL)
+			oval_pasync_grp_abandon(&as, as.grpv + g);
+
+	for (g = 0; g < as.grpc && !oval_pasync_lost(&as); ++g)
+		if (as.grpv[g].pd != NULL)
+			oval_pasync_send(&as, as.grpv + g);
+
+	/*
+	 * Collect the replies. The probes work on their windows concurrently,
+	 * all of them are waited for at once and a reply is read from a probe
+	 * which has one ready, its window is refilled right away.
+	 */
+	sdv   = oscap_alloc(sizeof(int) * as.grpc);
+	grpv  = oscap_alloc(sizeof(size_t) * as.grpc);
+	ready = oscap_alloc(sizeof(bool) * as.grpc);
+
+	for (turn = 0; ; ++turn) {
+		if (oval_pasync_lost(&as)) {
+			dW("Probe descriptor table was reset, abandoning %zu group(s).", as.grpc);
+			for (g = 0; g < as.grpc; ++g)
+				oval_pasync_grp_drop(&as, as.grpv + g);
+			ret = -1;
+			goto cleanup;
+		}
+
+		queued = false;
+		n = 0;
+
+		for (g = 0; g < as.grpc && !queued; ++g) {
+			grp = as.grpv + g;
+
+			if (grp->pd == NULL || grp->reqc == 0)
+				continue;
+
+			switch (oval_pasync_recv_queued(&as, grp)) {
+			case 1:
+				sdv[n]  = grp->pd->sd;
+				grpv[n] = g;
+				++n;
+				break;
+			case 0:
+				queued = true;
+				break;
+			default:
+				queued = true;
+				ret = -1;
+			}
+		}
+
+		if (queued)
+			continue;
+		if (n == 0)
+			break;
+
+		if (SEAP_poll(as.ctx, sdv, ready, n, -1) <= 0) {
+			protect_errno {
+				dW("Can't wait for the probes: %u, %s.", errno, strerror(errno));
+			}
+			for (i = 0; i < n; ++i)
+				oval_pasync_grp_abandon(&as, as.grpv + grpv[i]);
+			ret = -1;
+			continue;
+		}
+
+		/*
+		 * Only one reply is read before polling again, a completion
+		 * callback may read from the other descriptors. The search
+		 * starts at a different group each time so that none of them
+		 * is starved.
+		 */
+		for (i = 0; i < n; ++i) {
+			g = (i + turn) % n;
+
+			if (ready[g]) {
+				if (oval_pasync_recv(&as, as.grpv + grpv[g]) != 0)
+					ret = -1;
+				break;
+			}
+		}
+	}
+
+	for (g = 0; g < as.grpc; ++g)
+		assume_d(as.grpv[g].pd == NULL || as.grpv[g].pd->async_cnt == 0, -1);
+cleanup:
+	for (g = 0; g < as.grpc; ++g) {
+		oscap_free(as.grpv[g].sysv);
+		oscap_free(as.grpv[g].reqv);
+	}
+	oscap_free(as.grpv);
+	oscap_free(grpv);
+	oscap_free(sdv);
+	oscap_free(ready);
+
+	return (ret);
+}
+
 int oval_probe_ext_reset(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext)
 {
         SEAP_cmd_exec(ctx, pd->sd, SEAP_EXEC_RECV, PROBECMD_RESET, NULL, SEAP_CMDTYPE_SYNC, NULL, NULL);
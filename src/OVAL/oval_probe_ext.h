@@ -33,6 +33,9 @@ typedef struct {
 	oval_subtype_t subtype;
 	int sd;
 	char *uri;
+	SEAP_msg_t **stash;     /**< replies received while waiting for a different message */
+	size_t       stash_cnt;
+	size_t       async_cnt; /**< number of pipelined requests waiting for a reply */
 } oval_pd_t;
 
 typedef struct {
@@ -49,6 +52,12 @@ struct oval_pdsc {
 
 typedef struct oval_pdsc oval_pdsc_t;
 
+/*
+ * Upper limit of OSCAP_PROBE_ASYNC_WINDOW, the slots of the window are
+ * allocated for each probe up front.
+ */
+#define OVAL_PEXT_ASYNC_WINDOW_MAX 1024
+
 struct oval_pext {
         pthread_mutex_t lock;
         bool            do_init;
@@ -57,8 +66,11 @@ struct oval_pext {
         oval_pdsc_t  *pdsc;
         size_t        pdsc_cnt;
         oval_pdtbl_t *pdtbl;
+        unsigned int  pdtbl_gen; /**< incremented each time the pdtbl is (re)created */
         char         *probe_dir;
 
+        size_t        async_window; /**< max. number of pipelined requests per probe, 0 = disabled */
+
         void *sess_ptr;
         struct oval_syschar_model **model;
 };
@@ -72,6 +84,18 @@ int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struc
 int oval_probe_ext_reset(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext);
 int oval_probe_ext_abort(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext);
 
+/**
+ * Completion callback of the asynchronous evaluation. It's called exactly once
+ * for every syschar passed to @ref oval_probe_ext_eval_async, either when the
+ * reply was processed or when the request could not be dispatched (the syschar
+ * flag is left set to SYSCHAR_FLAG_UNKNOWN in that case). Once the callback
+ * returns nonzero, no new requests are sent and it's not called anymore.
+ * @return 0 to continue, nonzero to stop
+ */
+typedef int (oval_probe_async_cb_t)(struct oval_syschar *syschar, void *arg);
+
+int oval_probe_ext_eval_async(oval_pext_t *pext, struct oval_syschar **sysv, size_t sysc, oval_probe_async_cb_t *cb, void *arg);
+
 int oval_probe_ext_handler(oval_subtype_t type, void *ptr, int act, ...);
 int oval_probe_sys_handler(oval_subtype_t type, void *ptr, int act, ...);
 
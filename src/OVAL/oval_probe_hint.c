@@ -24,11 +24,17 @@
 #include <config.h>
 #endif
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "public/oval_definitions.h"
 #include "public/oval_system_characteristics.h"
 #include "oval_system_characteristics_impl.h"
 #include "oval_probe_impl.h"
 #include "_oval_probe_session.h"
+#include "collectVarRefs_impl.h"
+#include "adt/oval_string_map_impl.h"
+#include "common/debug_priv.h"
 
 static int _oval_probe_hint_criteria(oval_probe_session_t *sess, struct oval_criteria_node *cnode, int variable_instance_hint);
 static int _oval_probe_hint_object(oval_probe_session_t *psess, struct oval_object *object, int variable_instance_hint);
@@ -99,3 +105,175 @@ int _oval_probe_hint_object(oval_probe_session_t *psess, struct oval_object *obj
 	}
 	return 0;
 }
+
+/*
+ * Item entities which are costly to collect. The probe can skip them when
+ * no state used with the object references them. The type is an int as the
+ * subtypes of the families are separate enums.
+ */
+static const struct {
+	int         type;
+	const char *name;
+} _oval_probe_costly_ents[] = {
+	{ OVAL_UNIX_FILE, "has_extended_acl" }
+};
+
+#define OVAL_COSTLY_ENTS (sizeof _oval_probe_costly_ents / sizeof _oval_probe_costly_ents[0])
+#define OVAL_COSTLY_ALL  ((1U << OVAL_COSTLY_ENTS) - 1)
+
+static unsigned int _oval_probe_hint_state_ents(struct oval_state *state)
+{
+	unsigned int refs = 0;
+	struct oval_state_content_iterator *cit = oval_state_get_contents(state);
+
+	while (oval_state_content_iterator_has_more(cit)) {
+		struct oval_entity *entity = oval_state_content_get_entity(oval_state_content_iterator_next(cit));
+		const char *name = entity != NULL ? oval_entity_get_name(entity) : NULL;
+
+		for (size_t i = 0; name != NULL && i < OVAL_COSTLY_ENTS; ++i) {
+			if (strcmp(name, _oval_probe_costly_ents[i].name) == 0)
+				refs |= 1U << i;
+		}
+	}
+	oval_state_content_iterator_free(cit);
+
+	return refs;
+}
+
+static void _oval_probe_hint_ents_add(struct oval_string_map *map, const char *oid, unsigned int refs)
+{
+	unsigned int *cell = oval_string_map_get_value(map, oid);
+
+	if (cell == NULL) {
+		cell = oscap_talloc(unsigned int);
+		*cell = 0;
+		oval_string_map_put(map, oid, cell);
+	}
+	*cell |= refs;
+}
+
+/* Mark the objects whose items can be used by anything else than a test */
+static void _oval_probe_hint_ents_all(struct oval_string_map *map, struct oval_string_map *objs, struct oval_object *self)
+{
+	struct oval_iterator *it = oval_string_map_values(objs);
+
+	while (oval_collection_iterator_has_more(it)) {
+		struct oval_object *object = oval_collection_iterator_next(it);
+
+		if (object != self)
+			_oval_probe_hint_ents_add(map, oval_object_get_id(object), OVAL_COSTLY_ALL);
+	}
+	oval_collection_iterator_free(it);
+}
+
+/*
+ * Find out which of the costly entities are referenced by the states of the
+ * tests of each object. The items of the objects referenced by variables and
+ * by sets can be compared with any state, all the entities are collected
+ * for them. So they are for the objects which aren't used by any test.
+ */
+static struct oval_string_map *_oval_probe_hint_ents_new(struct oval_definition_model *model)
+{
+	struct oval_string_map *map = oval_string_map_new();
+	struct oval_test_iterator *test_it = oval_definition_model_get_tests(model);
+
+	while (oval_test_iterator_has_more(test_it)) {
+		struct oval_test *test = oval_test_iterator_next(test_it);
+		struct oval_object *object = oval_test_get_object(test);
+		unsigned int refs = 0;
+
+		if (object == NULL)
+			continue;
+
+		struct oval_state_iterator *ste_it = oval_test_get_states(test);
+		while (oval_state_iterator_has_more(ste_it))
+			refs |= _oval_probe_hint_state_ents(oval_state_iterator_next(ste_it));
+		oval_state_iterator_free(ste_it);
+
+		/* the filters of the object are evaluated by the probe */
+		struct oval_object_content_iterator *cit = oval_object_get_object_contents(object);
+		while (oval_object_content_iterator_has_more(cit)) {
+			struct oval_object_content *content = oval_object_content_iterator_next(cit);
+
+			if (oval_object_content_get_type(content) == OVAL_OBJECTCONTENT_FILTER)
+				refs |= _oval_probe_hint_state_ents(oval_filter_get_state(oval_object_content_get_filter(content)));
+		}
+		oval_object_content_iterator_free(cit);
+
+		_oval_probe_hint_ents_add(map, oval_object_get_id(object), refs);
+	}
+	oval_test_iterator_free(test_it);
+
+	struct oval_object_iterator *obj_it = oval_definition_model_get_objects(model);
+	while (oval_object_iterator_has_more(obj_it)) {
+		struct oval_object *object = oval_object_iterator_next(obj_it);
+		struct oval_string_map *vars = oval_string_map_new();
+		struct oval_string_map *objs = oval_string_map_new();
+
+		oval_obj_collect_refs(object, vars, objs);
+		_oval_probe_hint_ents_all(map, objs, object);
+		oval_string_map_free(vars, NULL);
+		oval_string_map_free(objs, NULL);
+	}
+	oval_object_iterator_free(obj_it);
+
+	struct oval_state_iterator *ste_it = oval_definition_model_get_states(model);
+	while (oval_state_iterator_has_more(ste_it)) {
+		struct oval_state *state = oval_state_iterator_next(ste_it);
+		struct oval_string_map *vars = oval_string_map_new();
+		struct oval_string_map *objs = oval_string_map_new();
+
+		oval_ste_collect_refs(state, vars, objs);
+		_oval_probe_hint_ents_all(map, objs, NULL);
+		oval_string_map_free(vars, NULL);
+		oval_string_map_free(objs, NULL);
+	}
+	oval_state_iterator_free(ste_it);
+
+	return map;
+}
+
+char *oval_probe_hint_skip_ents(oval_probe_session_t *sess, struct oval_object *object)
+{
+	struct oval_definition_model *model;
+	unsigned int *refs;
+	char *skip = NULL;
+	size_t len = 0;
+
+	if (sess == NULL || sess->sys_model == NULL)
+		return NULL;
+
+	model = oval_syschar_model_get_definition_model(sess->sys_model);
+	if (model == NULL)
+		return NULL;
+
+	if (sess->hint_model != model) {
+		if (sess->hint_ents != NULL)
+			oval_string_map_free(sess->hint_ents, oscap_free);
+		sess->hint_ents  = _oval_probe_hint_ents_new(model);
+		sess->hint_model = model;
+	}
+
+	refs = oval_string_map_get_value(sess->hint_ents, oval_object_get_id(object));
+	if (refs == NULL)
+		return NULL;
+
+	for (size_t i = 0; i < OVAL_COSTLY_ENTS; ++i) {
+		const char *name = _oval_probe_costly_ents[i].name;
+		size_t name_len = strlen(name);
+
+		if (_oval_probe_costly_ents[i].type != (int)oval_object_get_subtype(object) || (*refs & (1U << i)))
+			continue;
+
+		skip = oscap_realloc(skip, len + name_len + 2);
+		if (len > 0)
+			skip[len++] = ' ';
+		memcpy(skip + len, name, name_len + 1);
+		len += name_len;
+	}
+
+	if (skip != NULL)
+		dI("Object '%s' skips the entities '%s'.", oval_object_get_id(object), skip);
+
+	return skip;
+}
@@ -32,6 +32,8 @@
 #ifndef OVAL_PROBE_IMPL_H
 #define OVAL_PROBE_IMPL_H
 
+#include <pthread.h>
+#include <stdbool.h>
 #include <seap-types.h>
 #include "oval_definitions_impl.h"
 #include "oval_agent_api_impl.h"
@@ -57,6 +59,85 @@ OSCAP_HIDDEN_START;
 
 int oval_probe_query_test(oval_probe_session_t *sess, struct oval_test *test);
 
+/**
+ * Get the maximum number of requests pipelined to a single probe
+ * (OSCAP_PROBE_ASYNC_WINDOW environment variable). Zero means that
+ * the asynchronous dispatch is disabled.
+ */
+size_t oval_probe_session_get_async_window(oval_probe_session_t *sess);
+
+/**
+ * Query the objects using pipelined requests. All the objects of the same
+ * subtype are sent to their probe in a window of outstanding requests and
+ * the callback is called for each object as its reply arrives. Objects that
+ * can't be pipelined (already queried ones, objects without an external probe)
+ * are reported to the callback right away and are left for @ref oval_probe_query_object.
+ * Returning nonzero from the callback stops the dispatch.
+ * @return 0 on success; -1 if the dispatch failed (objects that weren't
+ *         collected are left with SYSCHAR_FLAG_UNKNOWN)
+ */
+int oval_probe_query_objects_async(oval_probe_session_t *psess, struct oval_object **objv, size_t objc,
+				   int (*cb)(struct oval_object *, void *), void *arg);
+
+/**
+ * An object which is being collected by one of the synchronized sessions.
+ */
+struct oval_probe_busy {
+	const char *oid;
+	oval_probe_session_t *sess;
+	struct oval_probe_busy *next;
+};
+
+/**
+ * Synchronization of probe sessions which collect objects into the same
+ * system characteristics model from several threads. Each thread uses its
+ * own probe session (i.e. its own set of probes) which is bound to the thread
+ * using @ref oval_probe_sync_bind. The shared parts of the models (the maps
+ * of syschars, items, result definitions and tests) are accessed only with
+ * the lock held. A query takes the lock and releases it while waiting for
+ * a reply from a probe.
+ */
+struct oval_probe_sync {
+	pthread_mutex_t lock;
+	pthread_cond_t  done;  /**< broadcast when a collection of an object finishes */
+	pthread_key_t   key;   /**< probe session bound to the calling thread */
+	struct oval_probe_busy *busy; /**< objects being collected */
+};
+
+int  oval_probe_sync_init(struct oval_probe_sync *sync);
+void oval_probe_sync_destroy(struct oval_probe_sync *sync);
+
+/**
+ * Make the session a member of the synchronized group. Queries which are
+ * done through a member session from a thread bound to another member
+ * session are redirected to the bound session. Use NULL to leave the group.
+ */
+void oval_probe_session_set_sync(oval_probe_session_t *sess, struct oval_probe_sync *sync);
+
+/**
+ * Bind a member session to the calling thread.
+ */
+int oval_probe_sync_bind(struct oval_probe_sync *sync, oval_probe_session_t *sess);
+
+/**
+ * Get the session bound to the calling thread if the session is a member
+ * of a synchronized group, the session itself otherwise.
+ */
+oval_probe_session_t *oval_probe_sync_session(oval_probe_session_t *sess);
+
+/**
+ * Acquire/release the lock of the group the session belongs to on behalf of
+ * the session bound to the calling thread. Does nothing if the session is
+ * NULL or isn't synchronized. Preserves errno.
+ */
+void oval_probe_sync_enter(oval_probe_session_t *sess);
+void oval_probe_sync_leave(oval_probe_session_t *sess);
+
+/**
+ * Check whether the calling thread holds the lock of the group.
+ */
+bool oval_probe_sync_held(oval_probe_session_t *sess);
+
 OSCAP_HIDDEN_END;
 
 extern probe_ncache_t *OSCAP_GSYM(ncache);
@@ -72,5 +153,13 @@ oval_subtype_t oval_str_to_subtype(const char *str);
 
 int oval_probe_hint_definition(oval_probe_session_t *sess, struct oval_definition *definition, int variable_instance_hint);
 
+/**
+ * Get the item entities which the probe doesn't have to collect for the
+ * object because they are costly and no state used with the object
+ * references them.
+ * @returns the space separated names to be freed by the caller or NULL
+ */
+char *oval_probe_hint_skip_ents(oval_probe_session_t *sess, struct oval_object *object);
+
 #endif /* OVAL_PROBE_IMPL_H */
 /// @}
@@ -48,6 +48,7 @@
 #include "oval_probe_impl.h"
 #include "oval_probe_ext.h"
 #include "oval_probe_meta.h"
+#include "adt/oval_string_map_impl.h"
 
 #if defined(OSCAP_THREAD_SAFE)
 #include <pthread.h>
@@ -126,6 +127,10 @@ static void oval_probe_session_init(oval_probe_session_t *sess, struct oval_sysc
         sess->ph = oval_phtbl_new();
         sess->sys_model = model;
         sess->flg = 0;
+        sess->sync = NULL;
+        sess->sync_held = false;
+        sess->hint_model = NULL;
+        sess->hint_ents  = NULL;
         sess->pext = oval_pext_new();
         sess->pext->model    = &sess->sys_model;
         sess->pext->sess_ptr = sess;
@@ -164,6 +169,9 @@ static void oval_probe_session_free(oval_probe_session_t *sess)
 
 	oval_phtbl_free(sess->ph);
 	oval_pext_free(sess->pext);
+
+	if (sess->hint_ents != NULL)
+		oval_string_map_free(sess->hint_ents, oscap_free);
 }
 
 void oval_probe_session_reinit(oval_probe_session_t *sess, struct oval_syschar_model *model)
@@ -221,6 +229,89 @@ int oval_probe_session_sethandler(oval_probe_session_t *sess, oval_subtype_t typ
         return(-1);
 }
 
+int oval_probe_sync_init(struct oval_probe_sync *sync)
+{
+	if ((errno = pthread_mutex_init(&sync->lock, NULL)) != 0) {
+		dE("Can't initialize the sync mutex: %u, %s", errno, strerror(errno));
+		return (-1);
+	}
+
+	if ((errno = pthread_key_create(&sync->key, NULL)) != 0) {
+		dE("Can't create the sync key: %u, %s", errno, strerror(errno));
+		pthread_mutex_destroy(&sync->lock);
+		return (-1);
+	}
+
+	pthread_cond_init(&sync->done, NULL);
+	sync->busy = NULL;
+
+	return (0);
+}
+
+void oval_probe_sync_destroy(struct oval_probe_sync *sync)
+{
+	pthread_key_delete(sync->key);
+	pthread_cond_destroy(&sync->done);
+	pthread_mutex_destroy(&sync->lock);
+}
+
+void oval_probe_session_set_sync(oval_probe_session_t *sess, struct oval_probe_sync *sync)
+{
+	sess->sync = sync;
+}
+
+int oval_probe_sync_bind(struct oval_probe_sync *sync, oval_probe_session_t *sess)
+{
+	if ((errno = pthread_setspecific(sync->key, sess)) != 0) {
+		dE("Can't bind the session to the thread: %u, %s", errno, strerror(errno));
+		return (-1);
+	}
+
+	return (0);
+}
+
+oval_probe_session_t *oval_probe_sync_session(oval_probe_session_t *sess)
+{
+	oval_probe_session_t *bound;
+
+	if (sess->sync == NULL)
+		return (sess);
+
+	bound = pthread_getspecific(sess->sync->key);
+
+	return (bound != NULL ? bound : sess);
+}
+
+void oval_probe_sync_enter(oval_probe_session_t *sess)
+{
+	if (sess != NULL && sess->sync != NULL) {
+		sess = oval_probe_sync_session(sess);
+		protect_errno {
+			pthread_mutex_lock(&sess->sync->lock);
+		}
+		sess->sync_held = true;
+	}
+}
+
+void oval_probe_sync_leave(oval_probe_session_t *sess)
+{
+	if (sess != NULL && sess->sync != NULL) {
+		sess = oval_probe_sync_session(sess);
+		sess->sync_held = false;
+		protect_errno {
+			pthread_mutex_unlock(&sess->sync->lock);
+		}
+	}
+}
+
+bool oval_probe_sync_held(oval_probe_session_t *sess)
+{
+	if (sess == NULL || sess->sync == NULL)
+		return (false);
+
+	return (oval_probe_sync_session(sess)->sync_held);
+}
+
 struct oval_syschar_model *oval_probe_session_getmodel(oval_probe_session_t *sess)
 {
 	if (sess == NULL) {
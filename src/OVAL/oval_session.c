@@ -78,6 +78,8 @@ struct oval_session {
 	bool full_validation;
 	bool fetch_remote_resources;
 	download_progress_calllback_t progress;
+	unsigned int jobs;
+	bool results_stream;
 };
 
 struct oval_session *oval_session_new(const char *filename)
@@ -101,6 +103,7 @@ struct oval_session *oval_session_new(const char *filename)
 	}
 
 	session->export_sys_chars = true;
+	session->jobs = 1;
 
 	dI("Created a new OVAL session from input file '%s'.", filename);
 	return session;
@@ -375,7 +378,7 @@ int oval_session_evaluate(struct oval_session *session, char *probe_root, agent_
 		return 1;
 	}
 
-	oval_agent_eval_system(session->sess, fn, arg);
+	oval_agent_eval_system_parallel(session->sess, session->jobs, fn, arg);
 	if (oscap_err()) {
 		return 1;
 	}
@@ -405,6 +408,15 @@ int oval_session_export(struct oval_session *session)
 			goto cleanup;
 	}
 
+	/* Stream OVAL Results straight to the file if nothing else needs them */
+	if (session->res_model && session->export.results && session->results_stream &&
+			!session->export.report && !(session->validation && session->full_validation)) {
+		oval_results_model_set_export_system_characteristics(session->res_model, session->export_sys_chars);
+		if (oval_results_model_export_stream(session->res_model, dir_model, session->export.results) != 0)
+			ret = 1;
+		goto cleanup;
+	}
+
 	/* Get OVAL Results if evaluation or analyse has been done and apply
 	 * directives to them */
 	if (session->res_model && (session->export.results || session->export.report)) {
@@ -464,6 +476,20 @@ void oval_session_set_remote_resources(struct oval_session *session, bool allowe
 	session->progress = callback;
 }
 
+void oval_session_set_jobs(struct oval_session *session, unsigned int jobs)
+{
+	__attribute__nonnull__(session);
+
+	session->jobs = jobs;
+}
+
+void oval_session_set_results_stream(struct oval_session *session, bool stream)
+{
+	__attribute__nonnull__(session);
+
+	session->results_stream = stream;
+}
+
 void oval_session_free(struct oval_session *session)
 {
 	if (session == NULL)
@@ -421,6 +421,7 @@ int oval_object_to_sexp(void *sess, const char *typestr, struct oval_syschar *sy
 	const char *obj_over;
 	char obj_name[128];
 	const char *obj_id;
+	char *skip_ents;
 
 	object = oval_syschar_get_object(syschar);
 
@@ -446,6 +447,14 @@ int oval_object_to_sexp(void *sess, const char *typestr, struct oval_syschar *sy
 	SEXP_free_r(&sm1);
 	SEXP_free(obj_attr);
 
+	/* costly entities which no state used with the object needs */
+	skip_ents = oval_probe_hint_skip_ents(sess, object);
+	if (skip_ents != NULL) {
+		probe_item_attr_add(obj_sexp, "skip_ents", SEXP_string_new_r(&sm0, skip_ents, strlen(skip_ents)));
+		SEXP_free_r(&sm0);
+		oscap_free(skip_ents);
+	}
+
 	/*
 	 * Object content
 	 */
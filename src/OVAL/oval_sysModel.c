@@ -43,6 +43,7 @@
 #include "adt/oval_smc_iterator_impl.h"
 #include "oval_system_characteristics_impl.h"
 #include "oval_probe_impl.h"
+#include "oval_xml_stream.h"
 #include "common/util.h"
 #include "common/debug_priv.h"
 #include "common/_error.h"
@@ -366,9 +367,13 @@ xmlNode *oval_syschar_model_to_dom(struct oval_syschar_model * syschar_model, xm
 		syschars = oval_syschar_iterator_new(resolved_smc);
 	}
 
+	/* In a streamed export, collected objects and items are created only
+	 * while the document is being written */
+	bool stream = oval_xml_stream_enabled(doc);
 	struct oval_string_map *sysitem_map = oval_string_map_new();
 	if (oval_syschar_iterator_has_more(syschars)) {
 		xmlNode *tag_objects = xmlNewTextChild(root_node, ns_syschar, BAD_CAST "collected_objects", NULL);
+		struct oval_collection *objects = stream ? oval_collection_new() : NULL;
 
 		while (oval_syschar_iterator_has_more(syschars)) {
 			struct oval_syschar *syschar = oval_syschar_iterator_next(syschars);
@@ -376,7 +381,10 @@ xmlNode *oval_syschar_model_to_dom(struct oval_syschar_model * syschar_model, xm
 			if (oval_syschar_get_flag(syschar) == SYSCHAR_FLAG_UNKNOWN /* Skip unneeded syschars */
 			    || oval_object_get_base_obj(object)) /* Skip internal objects */
 				continue;
-			oval_syschar_to_dom(syschar, doc, tag_objects);
+			if (stream)
+				oval_collection_add(objects, syschar);
+			else
+				oval_syschar_to_dom(syschar, doc, tag_objects);
 			struct oval_sysitem_iterator *sysitems = oval_syschar_get_sysitem(syschar);
 			while (oval_sysitem_iterator_has_more(sysitems)) {
 				struct oval_sysitem *sysitem = oval_sysitem_iterator_next(sysitems);
@@ -384,6 +392,8 @@ xmlNode *oval_syschar_model_to_dom(struct oval_syschar_model * syschar_model, xm
 			}
 			oval_sysitem_iterator_free(sysitems);
 		}
+		if (stream)
+			oval_xml_stream_defer(doc, tag_objects, objects, (oval_xml_stream_to_dom_func) oval_syschar_to_dom);
 	}
 	oval_smc_free0(resolved_smc);
 	oval_syschar_iterator_free(syschars);
@@ -391,11 +401,17 @@ xmlNode *oval_syschar_model_to_dom(struct oval_syschar_model * syschar_model, xm
 	struct oval_iterator *sysitems = oval_string_map_values(sysitem_map);
 	if (oval_collection_iterator_has_more(sysitems)) {
 		xmlNode *tag_items = xmlNewTextChild(root_node, ns_syschar, BAD_CAST "system_data", NULL);
+		struct oval_collection *items = stream ? oval_collection_new() : NULL;
 		while (oval_collection_iterator_has_more(sysitems)) {
 			struct oval_sysitem *sysitem = (struct oval_sysitem *)
 			    oval_collection_iterator_next(sysitems);
-			oval_sysitem_to_dom(sysitem, doc, tag_items);
+			if (stream)
+				oval_collection_add(items, sysitem);
+			else
+				oval_sysitem_to_dom(sysitem, doc, tag_items);
 		}
+		if (stream)
+			oval_xml_stream_defer(doc, tag_items, items, (oval_xml_stream_to_dom_func) oval_sysitem_to_dom);
 	}
 	oval_collection_iterator_free(sysitems);
 	oval_string_map_free(sysitem_map, NULL);
@@ -420,3 +436,20 @@ int oval_syschar_model_export(struct oval_syschar_model *model, const char *file
 	return oscap_xml_save_filename_free(file, doc);
 }
 
+int oval_syschar_model_export_stream(struct oval_syschar_model *model, const char *file)
+{
+
+	__attribute__nonnull__(model);
+
+	LIBXML_TEST_VERSION;
+
+	xmlDocPtr doc = oval_xml_stream_doc_new();
+	if (doc == NULL) {
+		oscap_setxmlerr(xmlGetLastError());
+		return -1;
+	}
+
+	oval_syschar_model_to_dom(model, doc, NULL, NULL, NULL, true);
+	return oval_xml_stream_save_free(doc, file);
+}
+
@@ -0,0 +1,303 @@
+/**
+ * @file oval_xml_stream.c
+ * \brief Streaming export of OVAL documents
+ *
+ * The deferred children of an element are represented in the document by
+ * a single marker comment. The document is saved through an output buffer
+ * which passes everything through, except for the markers. Every marker
+ * is replaced by the children it stands for, each of them created under
+ * the element, written with the indentation the element would give it and
+ * freed right away.
+ */
+
+/*
+ * Copyright 2016 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <libxml/xmlsave.h>
+#include <libxml/xmlIO.h>
+#include <libxml/globals.h>
+
+#include "oval_xml_stream.h"
+#include "common/util.h"
+#include "common/debug_priv.h"
+#include "common/_error.h"
+
+#define OVAL_XML_STREAM_MARK "oscap-stream-"
+#define OVAL_XML_STREAM_HOLD 32	/* longest marker we look for */
+#define OVAL_XML_STREAM_GZIP 6	/* zlib compression level */
+
+struct oval_xml_stream_deferred {
+	xmlNode *parent;
+	struct oval_collection *items;
+	oval_xml_stream_to_dom_func to_dom;
+};
+
+struct oval_xml_stream {
+	xmlDoc *doc;
+	xmlOutputBuffer *out;				///< the real output
+	struct oval_xml_stream_deferred *deferred;
+	unsigned int count;
+	char held[OVAL_XML_STREAM_HOLD];		///< possible beginning of a marker
+	size_t held_len;
+	bool failed;
+};
+
+xmlDoc *oval_xml_stream_doc_new(void)
+{
+	xmlDoc *doc = xmlNewDoc(BAD_CAST "1.0");
+	if (doc == NULL)
+		return NULL;
+
+	doc->_private = oscap_calloc(1, sizeof(struct oval_xml_stream));
+	return doc;
+}
+
+bool oval_xml_stream_enabled(xmlDoc *doc)
+{
+	return doc != NULL && doc->_private != NULL;
+}
+
+void oval_xml_stream_defer(xmlDoc *doc, xmlNode *parent, struct oval_collection *items, oval_xml_stream_to_dom_func to_dom)
+{
+	struct oval_xml_stream *stream = doc->_private;
+	char mark[OVAL_XML_STREAM_HOLD];
+
+	if (oval_collection_is_empty(items)) {
+		/* an empty element, nothing to defer */
+		oval_collection_free(items);
+		return;
+	}
+
+	stream->deferred = oscap_realloc(stream->deferred, (stream->count + 1) * sizeof(struct oval_xml_stream_deferred));
+	stream->deferred[stream->count].parent = parent;
+	stream->deferred[stream->count].items = items;
+	stream->deferred[stream->count].to_dom = to_dom;
+
+	snprintf(mark, sizeof(mark), OVAL_XML_STREAM_MARK "%u", stream->count++);
+	xmlAddChild(parent, xmlNewComment(BAD_CAST mark));
+}
+
+static void oval_xml_stream_out(struct oval_xml_stream *stream, const char *buffer, size_t len)
+{
+	if (len > 0 && xmlOutputBufferWrite(stream->out, len, buffer) < 0)
+		stream->failed = true;
+}
+
+static void oval_xml_stream_indent(struct oval_xml_stream *stream, int level)
+{
+	const char *indent = (const char *) xmlTreeIndentString;
+	size_t indent_len = strlen(indent);
+
+	/* libxml2 doesn't indent deeper than 60 characters */
+	if (indent_len > 0 && level > 60 / (int) indent_len)
+		level = 60 / indent_len;
+	while (level-- > 0)
+		oval_xml_stream_out(stream, indent, indent_len);
+}
+
+static void oval_xml_stream_emit(struct oval_xml_stream *stream, unsigned int index)
+{
+	if (index >= stream->count) {
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Unknown stream marker: %u.", index);
+		stream->failed = true;
+		return;
+	}
+
+	struct oval_xml_stream_deferred *deferred = &stream->deferred[index];
+	int level = 0;
+
+	for (xmlNode *node = deferred->parent; node != NULL && node->type == XML_ELEMENT_NODE; node = node->parent)
+		level++;
+
+	bool first = true;
+	struct oval_iterator *items = oval_collection_iterator(deferred->items);
+	while (oval_collection_iterator_has_more(items) && !stream->failed) {
+		void *item = oval_collection_iterator_next(items);
+
+		if (!first) {
+			oval_xml_stream_out(stream, "\n", 1);
+			oval_xml_stream_indent(stream, level);
+		}
+		first = false;
+
+		(*deferred->to_dom) (item, stream->doc, deferred->parent);
+		xmlNode *node = deferred->parent->last;
+		xmlNodeDumpOutput(stream->out, stream->doc, node, level, 1, "UTF-8");
+		xmlUnlinkNode(node);
+		xmlFreeNode(node);
+		if (stream->out->error != 0)
+			stream->failed = true;
+	}
+	oval_collection_iterator_free(items);
+}
+
+/* Add one character to a possible marker, the first character ('<') is already held. */
+static void oval_xml_stream_feed(struct oval_xml_stream *stream, char c)
+{
+	static const char prefix[] = "<!--" OVAL_XML_STREAM_MARK;
+	const size_t prefix_len = sizeof(prefix) - 1;
+	size_t n = stream->held_len;
+	bool match = false, done = false;
+
+	if (n < prefix_len) {
+		match = (c == prefix[n]);
+	} else {
+		size_t tail = n - prefix_len, digits = 0;
+
+		while (digits < tail && isdigit((unsigned char) stream->held[prefix_len + digits]))
+			digits++;
+
+		if (isdigit((unsigned char) c))
+			match = (digits == tail && n < sizeof(stream->held) - 4);
+		else if (c == '-')
+			match = (digits > 0 && tail - digits < 2);
+		else if (c == '>')
+			match = done = (digits > 0 && tail - digits == 2);
+	}
+
+	if (done) {
+		stream->held[n] = '\0';
+		stream->held_len = 0;
+		oval_xml_stream_emit(stream, strtoul(stream->held + prefix_len, NULL, 10));
+	} else if (match) {
+		stream->held[stream->held_len++] = c;
+	} else {
+		/* not a marker, the held characters can't start another one */
+		oval_xml_stream_out(stream, stream->held, stream->held_len);
+		stream->held_len = 0;
+		if (c == '<')
+			stream->held[stream->held_len++] = c;
+		else
+			oval_xml_stream_out(stream, &c, 1);
+	}
+}
+
+static int oval_xml_stream_write(void *context, const char *buffer, int len)
+{
+	struct oval_xml_stream *stream = context;
+	const char *end = buffer + len;
+
+	while (buffer < end && !stream->failed) {
+		if (stream->held_len > 0) {
+			oval_xml_stream_feed(stream, *buffer++);
+			continue;
+		}
+
+		const char *lt = memchr(buffer, '<', end - buffer);
+		const char *stop = (lt != NULL) ? lt : end;
+
+		oval_xml_stream_out(stream, buffer, stop - buffer);
+		buffer = stop;
+		if (lt != NULL) {
+			stream->held[stream->held_len++] = '<';
+			buffer++;
+		}
+	}
+
+	return stream->failed ? -1 : len;
+}
+
+static int oval_xml_stream_close(void *context)
+{
+	struct oval_xml_stream *stream = context;
+
+	oval_xml_stream_out(stream, stream->held, stream->held_len);
+	stream->held_len = 0;
+
+	if (xmlOutputBufferClose(stream->out) < 0)
+		stream->failed = true;
+	stream->out = NULL;
+
+	return stream->failed ? -1 : 0;
+}
+
+static bool oval_xml_stream_is_gzip(const char *filename)
+{
+	size_t len = strlen(filename);
+	return len > 3 && strcmp(filename + len - 3, ".gz") == 0;
+}
+
+int oval_xml_stream_save_free(xmlDoc *doc, const char *filename)
+{
+	struct oval_xml_stream *stream = doc->_private;
+	xmlOutputBuffer *buff;
+	int fd = -1;
+	int xmlCode = -1;
+
+	if (strcmp(filename, "-") == 0) {
+		stream->out = xmlOutputBufferCreateFile(stdout, NULL);
+	}
+	else if (oval_xml_stream_is_gzip(filename)) {
+		stream->out = xmlOutputBufferCreateFilename(filename, NULL, OVAL_XML_STREAM_GZIP);
+	}
+	else {
+		fd = open(filename, O_CREAT|O_TRUNC|O_WRONLY,
+				S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH|S_IWOTH);
+		if (fd < 0) {
+			oscap_seterr(OSCAP_EFAMILY_GLIBC, "%s '%s'", strerror(errno), filename);
+			goto cleanup;
+		}
+		stream->out = xmlOutputBufferCreateFd(fd, NULL);
+	}
+	if (stream->out == NULL) {
+		oscap_setxmlerr(xmlGetLastError());
+		dW("Can't create the output buffer for '%s'.", filename);
+		goto cleanup;
+	}
+
+	stream->doc = doc;
+	buff = xmlOutputBufferCreateIO(oval_xml_stream_write, oval_xml_stream_close, stream, NULL);
+	if (buff == NULL) {
+		xmlOutputBufferClose(stream->out);
+		oscap_setxmlerr(xmlGetLastError());
+		goto cleanup;
+	}
+
+	xmlCode = xmlSaveFormatFileTo(buff, doc, "UTF-8", 1);
+	if (stream->failed)
+		xmlCode = -1;
+	if (xmlCode <= 0) {
+		if (!oscap_err())
+			oscap_setxmlerr(xmlGetLastError());
+		dW("No bytes exported: xmlCode: %d.", xmlCode);
+	}
+
+cleanup:
+	if (fd >= 0)
+		close(fd);
+	for (unsigned int i = 0; i < stream->count; i++)
+		oval_collection_free(stream->deferred[i].items);
+	oscap_free(stream->deferred);
+	oscap_free(stream);
+	doc->_private = NULL;
+	xmlFreeDoc(doc);
+
+	return (xmlCode >= 1) ? 1 : -1;
+}
@@ -0,0 +1,76 @@
+/**
+ * @file oval_xml_stream.h
+ * @brief Streaming export of OVAL documents
+ *
+ * A streamed document is built as usual by the *_to_dom functions, except
+ * for the elements which can grow with the scanned system (collected
+ * objects and items). Those are only recorded in the document and each of
+ * them is created, written out and freed again while the document is
+ * being saved, so the complete DOM never exists in memory. The output is
+ * identical to saving the complete document.
+ */
+/*
+ * Copyright 2016 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef OVAL_XML_STREAM_H
+#define OVAL_XML_STREAM_H
+
+#include <stdbool.h>
+#include <libxml/tree.h>
+#include "adt/oval_collection_impl.h"
+#include "common/util.h"
+
+OSCAP_HIDDEN_START;
+
+/**
+ * Function creating the element of one item under the given parent.
+ */
+typedef void (*oval_xml_stream_to_dom_func) (void *item, xmlDoc *doc, xmlNode *parent);
+
+/**
+ * Create a new document for a streamed export.
+ */
+xmlDoc *oval_xml_stream_doc_new(void);
+
+/**
+ * Check whether the document was created by \ref oval_xml_stream_doc_new.
+ */
+bool oval_xml_stream_enabled(xmlDoc *doc);
+
+/**
+ * Defer creation of the children of an element to the time the document
+ * is saved. The document has to be a streamed one.
+ * @param doc the document
+ * @param parent the (empty) element
+ * @param items the items in document order, the stream takes ownership
+ *              of the collection (not of the items)
+ * @param to_dom function creating the element of one item
+ */
+void oval_xml_stream_defer(xmlDoc *doc, xmlNode *parent, struct oval_collection *items, oval_xml_stream_to_dom_func to_dom);
+
+/**
+ * Save a streamed document and free it. The file is written the same way
+ * as by oscap_xml_save_filename, "-" stands for the standard output and
+ * file names ending with ".gz" are compressed.
+ * @return 1 on success, -1 on failure
+ */
+int oval_xml_stream_save_free(xmlDoc *doc, const char *filename);
+
+OSCAP_HIDDEN_END;
+
+#endif /* OVAL_XML_STREAM_H */
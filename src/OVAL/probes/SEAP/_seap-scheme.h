@@ -45,6 +45,7 @@ typedef struct {
         int     (*sch_close)    (SEAP_desc_t *, uint32_t);
         ssize_t (*sch_sendsexp) (SEAP_desc_t *, SEXP_t *, uint32_t);
         int     (*sch_select)   (SEAP_desc_t *, int, uint16_t, uint32_t);
+        int     (*sch_getfd)    (SEAP_desc_t *, int);
 } SEAP_schemefn_t;
 
 extern const SEAP_schemefn_t __schtbl[];
@@ -57,6 +58,7 @@ extern const SEAP_schemefn_t __schtbl[];
 #define SCH_CLOSE(idx, ...)    __schtbl[idx].sch_close (__VA_ARGS__)
 #define SCH_SENDSEXP(idx, ...) __schtbl[idx].sch_sendsexp (__VA_ARGS__)
 #define SCH_SELECT(idx, ...)   __schtbl[idx].sch_select (__VA_ARGS__)
+#define SCH_GETFD(idx, ...)    __schtbl[idx].sch_getfd (__VA_ARGS__)
 
 #define SEAP_IO_EVREAD  0x01
 #define SEAP_IO_EVWRITE 0x02
@@ -0,0 +1,43 @@
+/*
+ * Copyright 2016 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#pragma once
+#ifndef _SEXP_ARENA_H
+#define _SEXP_ARENA_H
+
+#include <stddef.h>
+#include "public/sexp-arena.h"
+#include "../../../common/util.h"
+
+OSCAP_HIDDEN_START;
+
+/*
+ * Allocate memory from the arena of the calling thread. Returns NULL if
+ * the thread doesn't use an arena or if the size is too big for it, the
+ * caller allocates the memory from the heap then.
+ */
+void *SEXP_arena_alloc (size_t size, size_t align);
+
+/*
+ * Free memory returned by SEXP_arena_alloc, from any thread.
+ */
+void SEXP_arena_free (void *ptr);
+
+OSCAP_HIDDEN_END;
+
+#endif /* _SEXP_ARENA_H */
@@ -41,6 +41,23 @@ struct SEXP_ostate {
         size_t        *s_pos;   /* S-exp position */
 };
 
+/*
+ * Binary encoding of S-expressions. Each value starts with a one byte
+ * tag. Numbers and lengths follow in the host byte order, the binary
+ * encoding is used only between processes on the same machine.
+ */
+#define SEXP_BIN_LIST_BEG '(' /* values follow until SEXP_BIN_LIST_END */
+#define SEXP_BIN_LIST_END ')'
+#define SEXP_BIN_STRING   's' /* uint32_t length + bytes */
+#define SEXP_BIN_INT      'i' /* int64_t */
+#define SEXP_BIN_UINT     'u' /* uint64_t */
+#define SEXP_BIN_DOUBLE   'f' /* double */
+#define SEXP_BIN_TRUE     'T'
+#define SEXP_BIN_FALSE    'F'
+#define SEXP_BIN_DATATYPE 't' /* uint8_t length + name, precedes the value */
+
+int SEXP_sbprintf_b (SEXP_t *s_exp, strbuf_t *sb);
+
 OSCAP_HIDDEN_END;
 
 #endif /* _SEXP_OUTPUT_H */
@@ -151,6 +151,13 @@ __PARSE_RT SEXP_parse_bool          (__PARSE_PT(dsc), bool val);
  */
 int SEXP_psetup_setpfunc(SEXP_psetup_t *psetup, int pfunctype, SEXP_pfunc_t *pfunc);
 
+/**
+ * Decode a single S-exp written by SEXP_sbprintf_b. The whole buffer has to
+ * be consumed by the S-exp.
+ * @return NULL and errno set to EILSEQ if the buffer doesn't hold a valid S-exp
+ */
+SEXP_t *SEXP_parse_b (const void *buf, size_t len);
+
 OSCAP_HIDDEN_END;
 
 #endif /* SEXP_PARSER_H */
@@ -44,6 +44,13 @@ typedef struct {
         size_t   size;
 } __attribute__ ((packed)) SEXP_valhdr_t;
 
+/*
+ * The highest bit of the reference counter marks values allocated
+ * from an arena (see _sexp-arena.h).
+ */
+#define SEXP_VALHDR_ARENA   UINT32_C(0x80000000)
+#define SEXP_VALHDR_REFS(h) ((h)->refs & ~SEXP_VALHDR_ARENA)
+
 typedef struct {
         uintptr_t      ptr;
         SEXP_valhdr_t *hdr;
@@ -57,6 +64,7 @@ typedef struct {
 #define SEXP_VALP_HDR(p) ((SEXP_valhdr_t *)(((uintptr_t)(p)) & SEXP_VALP_MASK))
 
 int       SEXP_val_new (SEXP_val_t *dst, size_t vmemsize, SEXP_valtype_t type);
+void      SEXP_val_free (SEXP_val_t *dsc);
 void      SEXP_val_dsc (SEXP_val_t *dst, uintptr_t ptr);
 uintptr_t SEXP_val_ptr (SEXP_val_t *dsc);
 
@@ -98,6 +106,11 @@ struct SEXP_val_lblk {
         SEXP_t    memb[];
 } __attribute__ ((packed));
 
+/* list blocks allocated from an arena, same as SEXP_VALHDR_ARENA */
+#define SEXP_LBLK_ARENA      UINT16_C(0x8000)
+#define SEXP_LBLK_REFS(l)    ((uint16_t)((l)->refs & ~SEXP_LBLK_ARENA))
+#define SEXP_LBLK_REFS_MAX   UINT16_C(0x7fff)
+
 size_t    SEXP_rawval_list_length (struct SEXP_val_list *list);
 uintptr_t SEXP_rawval_list_copy (uintptr_t s_valp);
 
@@ -33,6 +33,7 @@ extern "C" {
 #endif
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <sexp.h>
 #include <seap-types.h>
 #include <seap-message.h>
@@ -60,6 +61,21 @@ SEXP_t *SEAP_read  (SEAP_CTX_t *ctx, int sd);
 int     SEAP_write (SEAP_CTX_t *ctx, int sd, SEXP_t *sexp);
 int     SEAP_close (SEAP_CTX_t *ctx, int sd);
 
+/*
+ * Get the number of bytes sent and received through the descriptor
+ * since it was opened.
+ */
+int     SEAP_traffic (SEAP_CTX_t *ctx, int sd, uint64_t *sent, uint64_t *received);
+
+/**
+ * Wait until a message can be received from at least one of the descriptors.
+ * Doesn't wait if a message was already received and queued.
+ * @param ready set to true for the descriptors which can be read from
+ * @param timeout in milliseconds, -1 waits without a limit
+ * @return the number of ready descriptors, 0 on timeout or -1 on error
+ */
+int     SEAP_poll (SEAP_CTX_t *ctx, const int *sdv, bool *ready, size_t sdc, int timeout);
+
 int SEAP_openfd (SEAP_CTX_t *ctx, int fd, uint32_t flags);
 int SEAP_openfd2 (SEAP_CTX_t *ctx, int ifd, int ofd, uint32_t flags);
 
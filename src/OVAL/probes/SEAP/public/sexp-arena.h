@@ -0,0 +1,61 @@
+/*
+ * Copyright 2016 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SEXP_ARENA_H
+#define SEXP_ARENA_H
+
+#include "sexp-types.h"
+
+/**
+ * A region the S-exp values and list blocks created by a thread are
+ * allocated from. Freeing such a value only decrements a counter, the
+ * memory of the arena is freed at once when the arena was released and
+ * none of its values is referenced anymore. A value which outlives the
+ * arena (e.g. a cached one) keeps the whole arena allocated, such values
+ * should be copied out of the arena by SEXP_promote.
+ */
+typedef struct SEXP_arena SEXP_arena_t;
+
+/**
+ * Create a new arena.
+ */
+SEXP_arena_t *SEXP_arena_new (void);
+
+/**
+ * Allocate the S-exps created by the calling thread from the arena, or
+ * from the heap if the arena is NULL. An arena may be used by one thread
+ * at a time.
+ * @return the arena used by the thread so far
+ */
+SEXP_arena_t *SEXP_arena_enter (SEXP_arena_t *arena);
+
+/**
+ * Release the arena. The arena must not be used by any thread anymore,
+ * its memory is freed once none of its values is referenced.
+ */
+void SEXP_arena_release (SEXP_arena_t *arena);
+
+/**
+ * Get a new reference to an S-exp whose values don't live in any arena.
+ * The values allocated from an arena are copied to the heap, the other
+ * ones are shared.
+ */
+SEXP_t *SEXP_promote (const SEXP_t *s_exp);
+
+#endif /* SEXP_ARENA_H */
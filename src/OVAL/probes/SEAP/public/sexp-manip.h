@@ -616,6 +616,13 @@ SEXP_t *SEXP_build (const char *s_str, ...);
 
 size_t SEXP_sizeof (const SEXP_t *s_exp);
 
+/**
+ * Get the number of bytes taken by the S-exp values and list blocks which
+ * are allocated in the process. The counts of the threads are added up in
+ * batches, so the value lags behind by up to 64 KiB per thread.
+ */
+size_t SEXP_live_bytes (void);
+
 #if !defined(NDEBUG)
 # define SEXP_VALIDATE(s) __SEXP_VALIDATE(s, __FILE__, __LINE__, __PRETTY_FUNCTION__)
 # include <stdlib.h>
@@ -30,5 +30,6 @@
 #include <sexp-parser.h>
 #include <sexp-output.h>
 #include <sexp-ID.h>
+#include <sexp-arena.h>
 
 #endif /* SEXP_H */
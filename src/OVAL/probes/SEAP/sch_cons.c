@@ -100,3 +100,8 @@ int sch_cons_select (SEAP_desc_t *desc, int ev, uint16_t timeout, uint32_t flags
 {
         return (-1);
 }
+
+int sch_cons_getfd (SEAP_desc_t *desc, int ev)
+{
+        return (ev == SEAP_IO_EVREAD ? DATA(desc)->ifd : DATA(desc)->ofd);
+}
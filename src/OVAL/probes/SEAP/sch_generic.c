@@ -101,7 +101,7 @@ ssize_t sch_generic_sendsexp (SEAP_desc_t *desc, SEXP_t *sexp, uint32_t flags)
         ret = 0;
         sb  = strbuf_new (SEAP_STRBUF_MAX);
 
-        if (SEXP_sbprintf_t (sexp, sb) != 0)
+        if (SEAP_desc_sbprintf (desc, sexp, sb) != 0)
                 ret = -1;
         else
                 ret = strbuf_write (sb, DATA(desc->scheme_data)->ofd);
@@ -177,3 +177,8 @@ int sch_generic_select (SEAP_desc_t *desc, int ev, uint16_t timeout, uint32_t fl
         /* NOTREACHED */
         return (-1);
 }
+
+int sch_generic_getfd (SEAP_desc_t *desc, int ev)
+{
+        return (ev == SEAP_IO_EVREAD ? DATA(desc->scheme_data)->ifd : DATA(desc->scheme_data)->ofd);
+}
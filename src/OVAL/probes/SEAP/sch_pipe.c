@@ -324,7 +324,7 @@ ssize_t sch_pipe_sendsexp (SEAP_desc_t *desc, SEXP_t *sexp, uint32_t flags)
                 ret = 0;
                 sb  = strbuf_new (SEAP_STRBUF_MAX);
 
-                if (SEXP_sbprintf_t (sexp, sb) != 0)
+                if (SEAP_desc_sbprintf (desc, sexp, sb) != 0)
                         ret = -1;
                 else
                         ret = strbuf_write (sb, data->pfd);
@@ -437,3 +437,17 @@ int sch_pipe_select (SEAP_desc_t *desc, int ev, uint16_t timeout, uint32_t flags
 
         return (-1);
 }
+
+int sch_pipe_getfd (SEAP_desc_t *desc, int ev)
+{
+        sch_pipedata_t *data;
+
+        assume_d (desc != NULL, -1, errno = EFAULT;);
+
+        data = (sch_pipedata_t *)desc->scheme_data;
+
+        assume_r (data != NULL, -1, errno = EBADF;);
+
+        /* the same descriptor is used for both directions */
+        return (data->pfd);
+}
@@ -24,7 +24,11 @@
 #include <config.h>
 #endif
 
+#include <errno.h>
 #include <pthread.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
 
 #include "public/sm_alloc.h"
 #include "generic/bitmap.h"
@@ -32,6 +36,8 @@
 #include "_seap-scheme.h"
 #include "seap-descriptor.h"
 #include "_sexp-atomic.h"
+#include "_sexp-output.h"
+#include "generic/common.h"
 
 SEAP_desctable_t *SEAP_desctable_new (void)
 {
@@ -76,6 +82,13 @@ int SEAP_desc_add (SEAP_desctable_t *sd_table, SEXP_pstate_t *pstate,
 		sd_dsc->msg_queue = NULL;
 		sd_dsc->err_queue = rbt_i32_new();
 		sd_dsc->cmd_queue = NULL;
+		sd_dsc->ifmt = SEAP_DESC_FMT_UNKNOWN;
+		sd_dsc->ofmt = SEAP_DESC_FMT_UNKNOWN;
+		sd_dsc->ibuf = NULL;
+		sd_dsc->ibuf_len  = 0;
+		sd_dsc->ibuf_size = 0;
+		sd_dsc->ibytes = 0;
+		sd_dsc->obytes = 0;
 
 		SEAP_packetq_init(&sd_dsc->pck_queue);
 
@@ -134,6 +147,7 @@ void SEAP_desc_free(SEAP_desc_t *dsc)
         pthread_mutex_destroy(&(dsc->r_lock));
         pthread_mutex_destroy(&(dsc->w_lock));
 	rbt_i32_free_cb(dsc->err_queue, __SEAP_desc_errqueue_free_cb);
+        sm_free(dsc->ibuf);
         sm_free(dsc);
 }
 
@@ -168,6 +182,78 @@ SEAP_desc_t *SEAP_desc_get (SEAP_desctable_t *sd_table, int sd)
         return(dsc);
 }
 
+/*
+ * The binary encoding is disabled by a non-zero integer value of the
+ * SEAP_BINARY_DISABLE environment variable.
+ */
+static bool SEAP_binary_disabled (void)
+{
+        const char *str = getenv("SEAP_BINARY_DISABLE");
+        char *end;
+        long  val;
+
+        if (str == NULL)
+                return (false);
+
+        errno = 0;
+        val = strtol(str, &end, 10);
+
+        if (errno != 0 || end == str || *end != '\0') {
+                dW("Invalid value of SEAP_BINARY_DISABLE: \"%s\"", str);
+                return (false);
+        }
+
+        return (val != 0);
+}
+
+void SEAP_desc_offer_binary (SEAP_desc_t *dsc)
+{
+        if (SEAP_binary_disabled())
+                dsc->ofmt = SEAP_DESC_FMT_TEXT;
+        else
+                dsc->ofmt = SEAP_DESC_FMT_BINARY;
+}
+
+int SEAP_desc_sbprintf (SEAP_desc_t *dsc, SEXP_t *sexp, strbuf_t *sb)
+{
+        size_t   size;
+        uint32_t len;
+
+        if (dsc->ofmt == SEAP_DESC_FMT_UNKNOWN) {
+                /*
+                 * Nothing was sent yet. Answer in binary if the peer
+                 * offered it, use the text encoding otherwise.
+                 */
+                if (dsc->ifmt == SEAP_DESC_FMT_BINARY)
+                        dsc->ofmt = SEAP_DESC_FMT_BINARY;
+                else
+                        dsc->ofmt = SEAP_DESC_FMT_TEXT;
+        }
+
+        if (dsc->ofmt == SEAP_DESC_FMT_TEXT)
+                return SEXP_sbprintf_t(sexp, sb);
+
+        _A(strbuf_size(sb) == 0);
+
+        /* the length is filled in when the S-exp is written */
+        if (strbuf_add(sb, SEAP_BINFRAME_MAGIC "\0\0\0\0", SEAP_BINFRAME_HDRLEN) != 0)
+                return (-1);
+        if (SEXP_sbprintf_b(sexp, sb) != 0)
+                return (-1);
+
+        size = strbuf_size(sb) - SEAP_BINFRAME_HDRLEN;
+
+        if (size > SEAP_BINFRAME_MAXLEN) {
+                errno = EFBIG;
+                return (-1);
+        }
+
+        len = (uint32_t)size;
+        memcpy(sb->beg->data + SEAP_BINFRAME_MAGICLEN, &len, sizeof len);
+
+        return (0);
+}
+
 SEAP_msgid_t SEAP_desc_genmsgid (SEAP_desctable_t *sd_table, int sd)
 {
         SEAP_desc_t *dsc;
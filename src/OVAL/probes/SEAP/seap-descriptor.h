@@ -64,6 +64,14 @@ typedef struct {
         SEAP_cmdid_t   next_cid;
         SEAP_cmdtbl_t *cmd_c_table; /* Local SEAP commands */
         SEAP_cmdtbl_t *cmd_w_table; /* Waiting SEAP commands */
+
+        uint8_t        ifmt; /* Encoding of the received data (SEAP_DESC_FMT_*) */
+        uint8_t        ofmt; /* Encoding of the sent data */
+        uint8_t       *ibuf; /* Received binary frames which weren't decoded yet */
+        size_t         ibuf_len;
+        size_t         ibuf_size;
+        uint64_t       ibytes; /* Bytes received through the descriptor */
+        uint64_t       obytes; /* Bytes sent through the descriptor */
 } SEAP_desc_t;
 
 #define SEAP_DESC_FDIN  0x00000001
@@ -77,6 +85,34 @@ typedef struct {
 
 #define SEAP_DESCTBL_INITIALIZER { NULL, NULL }
 
+/*
+ * Encoding of the S-expressions sent through a descriptor. Each direction
+ * uses a single encoding for the whole life of the descriptor. The side
+ * which opens the connection starts to send binary frames right away
+ * (unless SEAP_BINARY_DISABLE is set to a non-zero integer), the other
+ * side detects the encoding from the first received bytes and answers
+ * using the binary encoding only if it was offered.
+ */
+#define SEAP_DESC_FMT_UNKNOWN 0
+#define SEAP_DESC_FMT_TEXT    1
+#define SEAP_DESC_FMT_BINARY  2
+#define SEAP_DESC_FMT_INVALID 3 /* an invalid frame was received, the descriptor can only be closed */
+
+/*
+ * A binary frame consists of a header and a S-exp encoded by SEXP_sbprintf_b.
+ * The header is the magic string followed by the length of the S-exp in
+ * bytes (uint32_t, host byte order). The first byte of the magic string
+ * can't start a S-exp in the text encoding.
+ */
+#define SEAP_BINFRAME_MAGIC    "\0SB\1"
+#define SEAP_BINFRAME_MAGICLEN 4
+#define SEAP_BINFRAME_HDRLEN   (SEAP_BINFRAME_MAGICLEN + sizeof (uint32_t))
+/*
+ * Longer frames are neither sent nor accepted, the length of a received
+ * frame is checked before the buffer for it is allocated.
+ */
+#define SEAP_BINFRAME_MAXLEN   (256 * 1024 * 1024)
+
 #define SEAP_BUFFER_SIZE 2*4096
 #define SEAP_MAX_OPENDESC 128
 #define SDTABLE_REALLOC_ADD 4
@@ -132,6 +168,18 @@ static inline int SEAP_desc_unlock (pthread_mutex_t *m)
 #define DESC_WLOCK(d)    SEAP_desc_lock (&((d)->w_lock))
 #define DESC_WUNLOCK(d)  SEAP_desc_unlock (&((d)->w_lock))
 
+/**
+ * Use the binary encoding for the data sent through the descriptor.
+ * Has to be called before anything is sent.
+ */
+void SEAP_desc_offer_binary (SEAP_desc_t *dsc);
+
+/**
+ * Write the S-exp into the buffer using the encoding negotiated for
+ * the descriptor. The descriptor's write lock has to be held.
+ */
+int SEAP_desc_sbprintf (SEAP_desc_t *dsc, SEXP_t *sexp, strbuf_t *sb);
+
 SEAP_msgid_t SEAP_desc_genmsgid (SEAP_desctable_t *sd_table, int sd);
 SEAP_cmdid_t SEAP_desc_gencmdid (SEAP_desctable_t *sd_table, int sd);
 
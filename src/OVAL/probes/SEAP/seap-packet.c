@@ -27,6 +27,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <inttypes.h>
 
 #include "generic/common.h"
 #include "public/sexp-manip.h"
@@ -171,7 +172,7 @@ static int SEAP_packet_sexp2msg (SEXP_t *sexp_msg, SEAP_msg_t *seap_msg)
 
                                 SEXP_free (attr_val);
                         } else {
-                                seap_msg->attrs[attr_i].name  = SEXP_string_subcstr (attr_name, 1, 0);
+                                seap_msg->attrs[attr_i].name  = SEXP_string_subcstr (attr_name, 1, SEXP_string_length (attr_name) - 1);
                                 seap_msg->attrs[attr_i].value = SEXP_list_nth (sexp_msg, msg_n + 1);
 
                                 if (seap_msg->attrs[attr_i].value == NULL) {
@@ -589,6 +590,121 @@ static SEXP_t *SEAP_packet2sexp (SEAP_packet_t *packet)
         return (sexp);
 }
 
+/*
+ * Receive binary frames. Called with the read lock held, the lock is released
+ * on return. All complete frames are decoded and returned in a list, an
+ * incomplete frame is kept in the descriptor's input buffer.
+ */
+static int SEAP_packet_recv_bin (SEAP_CTX_t *ctx, SEAP_desc_t *dsc, SEXP_t **sexp_buffer)
+{
+        SEXP_t  *list = NULL, *sexp;
+        size_t   off, need;
+        ssize_t  data_length;
+        uint32_t len;
+
+        for (;;) {
+                off  = 0;
+                need = SEAP_BINFRAME_HDRLEN;
+
+                while (dsc->ibuf_len - off >= SEAP_BINFRAME_HDRLEN) {
+                        if (memcmp(dsc->ibuf + off, SEAP_BINFRAME_MAGIC, SEAP_BINFRAME_MAGICLEN) != 0) {
+                                dI("FAIL: invalid binary frame header");
+                                goto invalid;
+                        }
+
+                        memcpy(&len, dsc->ibuf + off + SEAP_BINFRAME_MAGICLEN, sizeof len);
+
+                        if (len > SEAP_BINFRAME_MAXLEN) {
+                                dI("FAIL: binary frame too long, length: %"PRIu32, len);
+                                goto invalid;
+                        }
+
+                        if (dsc->ibuf_len - off - SEAP_BINFRAME_HDRLEN < len) {
+                                need = SEAP_BINFRAME_HDRLEN + len;
+                                break;
+                        }
+
+                        sexp = SEXP_parse_b(dsc->ibuf + off + SEAP_BINFRAME_HDRLEN, len);
+
+                        if (sexp == NULL) {
+                                dI("FAIL: invalid binary frame, length: %"PRIu32, len);
+                                goto invalid;
+                        }
+
+                        if (list == NULL)
+                                list = SEXP_list_new(NULL);
+
+                        SEXP_list_add(list, sexp);
+                        SEXP_free(sexp);
+
+                        off += SEAP_BINFRAME_HDRLEN + len;
+                }
+
+                if (off > 0) {
+                        memmove(dsc->ibuf, dsc->ibuf + off, dsc->ibuf_len - off);
+                        dsc->ibuf_len -= off;
+                }
+
+                if (list != NULL)
+                        break;
+
+                /* make room for the rest of the frame */
+                if (dsc->ibuf_size < need || dsc->ibuf_size - dsc->ibuf_len < SEAP_RECVBUF_SIZE) {
+                        dsc->ibuf_size = dsc->ibuf_len + (need > SEAP_RECVBUF_SIZE ? need : SEAP_RECVBUF_SIZE);
+                        dsc->ibuf = sm_realloc(dsc->ibuf, dsc->ibuf_size);
+                }
+
+                if (SCH_SELECT(dsc->scheme, dsc, SEAP_IO_EVREAD, ctx->recv_timeout, 0) != 0) {
+                        protect_errno {
+                                dI("FAIL: recv failed: dsc=%p, errno=%u, %s.",
+                                   dsc, errno, strerror (errno));
+                        }
+                        goto fail;
+                }
+
+                data_length = SCH_RECV(dsc->scheme, dsc, dsc->ibuf + dsc->ibuf_len, dsc->ibuf_size - dsc->ibuf_len, 0);
+
+                if (data_length > 0)
+                        dsc->ibytes += data_length;
+
+                if (data_length < 0) {
+                        protect_errno {
+                                dI("FAIL: recv failed: dsc=%p, errno=%u, %s.", dsc, errno, strerror (errno));
+                        }
+                        goto fail;
+                } else if (data_length == 0) {
+                        dI("zero bytes received -> EOF");
+                        errno = dsc->ibuf_len > 0 ? ENETRESET : ECONNABORTED;
+                        goto fail;
+                }
+
+                dsc->ibuf_len += data_length;
+        }
+
+        DESC_RUNLOCK(dsc);
+        *sexp_buffer = list;
+
+        return (0);
+invalid:
+        /*
+         * The stream can't be resynchronized, drop the buffered data and
+         * refuse further reads. The owner of the descriptor closes it when
+         * it gets ECONNABORTED.
+         */
+        sm_free(dsc->ibuf);
+        dsc->ibuf      = NULL;
+        dsc->ibuf_len  = 0;
+        dsc->ibuf_size = 0;
+        dsc->ifmt      = SEAP_DESC_FMT_INVALID;
+        errno = ECONNABORTED;
+fail:
+        protect_errno {
+                DESC_RUNLOCK(dsc);
+                SEXP_free(list);
+        }
+        return (-1);
+}
+
 int SEAP_packet_recv (SEAP_CTX_t *ctx, int sd, SEAP_packet_t **packet)
 {
         SEAP_desc_t *dsc;
@@ -617,6 +733,12 @@ int SEAP_packet_recv (SEAP_CTX_t *ctx, int sd, SEAP_packet_t **packet)
 	if (SEAP_packetq_get(&dsc->pck_queue, packet) != -1)
 		return (0);
 
+        /* don't wait for data which won't be read */
+        if (dsc->ifmt == SEAP_DESC_FMT_INVALID) {
+                errno = ECONNABORTED;
+                return (-1);
+        }
+
         /*
          * Event loop
          * The read mutex is not locked during the wait for an event.
@@ -664,6 +786,12 @@ eloop_start:
         }
 eloop_exit:
 
+        if (dsc->ifmt == SEAP_DESC_FMT_BINARY) {
+                if (SEAP_packet_recv_bin(ctx, dsc, &sexp_buffer) != 0)
+                        return (-1);
+                goto decode;
+        }
+
         /*
          * Receive loop
          * The read mutex is locked during execution of this loop and
@@ -685,6 +813,9 @@ eloop_exit:
                 data_buflen = SEAP_RECVBUF_SIZE;
                 data_length = SCH_RECV(dsc->scheme, dsc, data_buffer, data_buflen, 0);
 
+                if (data_length > 0)
+                        dsc->ibytes += data_length;
+
                 if (data_length < 0) {
                         protect_errno {
                                 dI("FAIL: recv failed: dsc=%p, errno=%u, %s.", dsc, errno, strerror (errno));
@@ -713,6 +844,25 @@ eloop_exit:
 
                 _A(data_length > 0);
 
+                if (dsc->ifmt == SEAP_DESC_FMT_UNKNOWN) {
+                        /* the first data received through the descriptor */
+                        if (memcmp(data_buffer, SEAP_BINFRAME_MAGIC, 1) == 0) {
+                                dI("Using the binary encoding: dsc=%p", dsc);
+                                dsc->ifmt      = SEAP_DESC_FMT_BINARY;
+                                dsc->ibuf      = data_buffer;
+                                dsc->ibuf_len  = data_length;
+                                dsc->ibuf_size = data_buflen;
+
+                                SEXP_psetup_free(psetup);
+
+                                if (SEAP_packet_recv_bin(ctx, dsc, &sexp_buffer) != 0)
+                                        return (-1);
+                                goto decode;
+                        }
+
+                        dsc->ifmt = SEAP_DESC_FMT_TEXT;
+                }
+
                 if (data_buflen != (size_t)(data_length)) {
                         data_buffer = sm_realloc (data_buffer, data_length);
 			data_buflen = data_length;
@@ -770,6 +920,7 @@ eloop_exit:
         }
 
         SEXP_psetup_free (psetup);
+decode:
 	SEXP_VALIDATE(sexp_buffer);
 	(*packet) = NULL;
 
@@ -972,15 +1123,19 @@ int SEAP_packet_send (SEAP_CTX_t *ctx, int sd, SEAP_packet_t *packet)
         }
 
         if (DESC_WLOCK (dsc)) {
-                ret = 0;
+                ssize_t sent;
 
-                if (SCH_SENDSEXP(dsc->scheme, dsc, packet_sexp, 0) < 0) {
+                ret  = 0;
+                sent = SCH_SENDSEXP(dsc->scheme, dsc, packet_sexp, 0);
+
+                if (sent < 0) {
                         ret = -1;
 
                         protect_errno {
                                 dI("FAIL: errno=%u, %s.", errno, strerror (errno));
                         }
-                }
+                } else
+                        dsc->obytes += sent;
 
                 DESC_WUNLOCK(dsc);
         }
@@ -36,22 +36,26 @@ const SEAP_schemefn_t __schtbl[] = {
           sch_cons_connect, sch_cons_openfd,
           sch_cons_openfd2, sch_cons_recv,
           sch_cons_send, sch_cons_close,
-          sch_cons_sendsexp, sch_cons_select },
+          sch_cons_sendsexp, sch_cons_select,
+          sch_cons_getfd },
         { "dummy",
           sch_dummy_connect, sch_dummy_openfd,
           sch_dummy_openfd2, sch_dummy_recv,
           sch_dummy_send, sch_dummy_close,
-          sch_dummy_sendsexp, sch_dummy_select },
+          sch_dummy_sendsexp, sch_dummy_select,
+          sch_dummy_getfd },
         { "generic",
           sch_generic_connect, sch_generic_openfd,
           sch_generic_openfd2, sch_generic_recv,
           sch_generic_send, sch_generic_close,
-          sch_generic_sendsexp, sch_generic_select },
+          sch_generic_sendsexp, sch_generic_select,
+          sch_generic_getfd },
         { "pipe",    /* This schem is used from libopenscap to talk to probes */
           sch_pipe_connect, sch_pipe_openfd,
           sch_pipe_openfd2, sch_pipe_recv,
           sch_pipe_send, sch_pipe_close,
-          sch_pipe_sendsexp, sch_pipe_select }
+          sch_pipe_sendsexp, sch_pipe_select,
+          sch_pipe_getfd }
 };
 
 #define SCHTBLSIZE ((sizeof __schtbl)/sizeof (SEAP_schemefn_t))
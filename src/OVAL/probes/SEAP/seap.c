@@ -30,6 +30,7 @@
 #include <ctype.h>
 #include <pthread.h>
 #include <errno.h>
+#include <poll.h>
 #include "common/assume.h"
 #include "public/seap.h"
 #include "public/sm_alloc.h"
@@ -134,6 +135,8 @@ int SEAP_connect (SEAP_CTX_t *ctx, const char *uri, uint32_t flags)
                 return (-1);
         }
 
+        SEAP_desc_offer_binary(dsc);
+
         return (sd);
 }
 
@@ -587,6 +590,90 @@ int SEAP_write (SEAP_CTX_t *ctx, int sd, SEXP_t *sexp)
         return (-1);
 }
 
+int SEAP_traffic (SEAP_CTX_t *ctx, int sd, uint64_t *sent, uint64_t *received)
+{
+        SEAP_desc_t *dsc;
+
+        _A(ctx != NULL);
+
+        dsc = SEAP_desc_get (ctx->sd_table, sd);
+
+        if (dsc == NULL) {
+                errno = EBADF;
+                return (-1);
+        }
+
+        if (sent != NULL)
+                *sent = dsc->obytes;
+        if (received != NULL)
+                *received = dsc->ibytes;
+
+        return (0);
+}
+
+int SEAP_poll (SEAP_CTX_t *ctx, const int *sdv, bool *ready, size_t sdc, int timeout)
+{
+        SEAP_desc_t   *dsc;
+        struct pollfd *pfd;
+        size_t i;
+        int    ret, n = 0;
+
+        _A(ctx != NULL);
+
+        pfd = sm_alloc (sizeof (struct pollfd) * sdc);
+
+        for (i = 0; i < sdc; ++i) {
+                ready[i] = false;
+                pfd[i].fd      = -1;
+                pfd[i].events  = POLLIN;
+                pfd[i].revents = 0;
+
+                dsc = SEAP_desc_get (ctx->sd_table, sdv[i]);
+
+                if (dsc == NULL) {
+                        sm_free (pfd);
+                        errno = EBADF;
+                        return (-1);
+                }
+
+                /*
+                 * Packets which were received together with an earlier one
+                 * are queued in the descriptor. A descriptor which can't be
+                 * polled is reported as ready, reading from it blocks.
+                 */
+                if (SEAP_packetq_count (&dsc->pck_queue) > 0
+                    || (pfd[i].fd = SCH_GETFD(dsc->scheme, dsc, SEAP_IO_EVREAD)) < 0) {
+                        ready[i] = true;
+                        ++n;
+                }
+        }
+
+        if (n > 0) {
+                sm_free (pfd);
+                return (n);
+        }
+
+        do {
+                ret = poll (pfd, sdc, timeout);
+        } while (ret < 0 && errno == EINTR);
+
+        if (ret > 0) {
+                for (i = 0; i < sdc; ++i) {
+                        if (pfd[i].revents != 0) {
+                                ready[i] = true;
+                                ++n;
+                        }
+                }
+                ret = n;
+        }
+
+        protect_errno {
+                sm_free (pfd);
+        }
+
+        return (ret);
+}
+
 int SEAP_close (SEAP_CTX_t *ctx, int sd)
 {
         SEAP_desc_t *dsc;
@@ -0,0 +1,321 @@
+/*
+ * Copyright 2016 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "_sexp-arena.h"
+#include "_sexp-atomic.h"
+#include "_sexp-types.h"
+#include "_sexp-value.h"
+#include "public/sexp-manip.h"
+#include "public/sm_alloc.h"
+
+/*
+ * The arena is a list of chunks, the memory is handed out from the last
+ * one. Chunks are aligned to their size so that the chunk (and the arena)
+ * of a value can be found from the address of the value.
+ */
+#define SEXP_ARENA_CHUNK   (64 * 1024)
+#define SEXP_ARENA_MAXSIZE (SEXP_ARENA_CHUNK / 16) /* bigger values go to the heap */
+
+struct SEXP_arena_chunk {
+        struct SEXP_arena_chunk *next;
+        SEXP_arena_t            *arena;
+};
+
+struct SEXP_arena {
+        volatile uint32_t        live;   /* allocated values + 1 until released */
+        struct SEXP_arena_chunk *chunks;
+        uint8_t                 *cur;
+        uint8_t                 *end;
+};
+
+static pthread_key_t  SEXP_arena_key;
+static pthread_once_t SEXP_arena_once = PTHREAD_ONCE_INIT;
+
+/* number of arenas which weren't freed yet, nothing to do if 0 */
+static volatile uint32_t SEXP_arena_count = 0;
+
+static void SEXP_arena_init (void)
+{
+        (void)pthread_key_create (&SEXP_arena_key, NULL);
+}
+
+SEXP_arena_t *SEXP_arena_new (void)
+{
+        SEXP_arena_t *arena;
+
+        pthread_once (&SEXP_arena_once, SEXP_arena_init);
+
+        arena = sm_talloc (SEXP_arena_t);
+        arena->live   = 1;
+        arena->chunks = NULL;
+        arena->cur    = NULL;
+        arena->end    = NULL;
+
+        SEXP_atomic_inc_u32 (&SEXP_arena_count);
+
+        return (arena);
+}
+
+SEXP_arena_t *SEXP_arena_enter (SEXP_arena_t *arena)
+{
+        SEXP_arena_t *prev;
+
+        pthread_once (&SEXP_arena_once, SEXP_arena_init);
+
+        prev = pthread_getspecific (SEXP_arena_key);
+        (void)pthread_setspecific (SEXP_arena_key, arena);
+
+        return (prev);
+}
+
+static void SEXP_arena_unref (SEXP_arena_t *arena)
+{
+        struct SEXP_arena_chunk *chunk, *next;
+
+        if (SEXP_atomic_dec_u32 (&arena->live) != 0)
+                return;
+
+        for (chunk = arena->chunks; chunk != NULL; chunk = next) {
+                next = chunk->next;
+                sm_free (chunk);
+        }
+
+        sm_free (arena);
+        SEXP_atomic_dec_u32 (&SEXP_arena_count);
+}
+
+void SEXP_arena_release (SEXP_arena_t *arena)
+{
+        if (arena != NULL)
+                SEXP_arena_unref (arena);
+}
+
+static uint8_t *SEXP_arena_align (uint8_t *p, size_t align)
+{
+        return ((uint8_t *)(((uintptr_t)p + (align - 1)) & ~(uintptr_t)(align - 1)));
+}
+
+void *SEXP_arena_alloc (size_t size, size_t align)
+{
+        SEXP_arena_t *arena;
+        uint8_t      *p;
+
+        if (SEXP_arena_count == 0 || size > SEXP_ARENA_MAXSIZE)
+                return (NULL);
+
+        arena = pthread_getspecific (SEXP_arena_key);
+
+        if (arena == NULL)
+                return (NULL);
+
+        p = SEXP_arena_align (arena->cur, align);
+
+        if (arena->cur == NULL || p + size > arena->end) {
+                struct SEXP_arena_chunk *chunk;
+
+                if (sm_memalign ((void **)(void *)&chunk, SEXP_ARENA_CHUNK, SEXP_ARENA_CHUNK) != 0)
+                        return (NULL);
+
+                chunk->next   = arena->chunks;
+                chunk->arena  = arena;
+                arena->chunks = chunk;
+                arena->cur    = (uint8_t *)(chunk + 1);
+                arena->end    = (uint8_t *)chunk + SEXP_ARENA_CHUNK;
+
+                p = SEXP_arena_align (arena->cur, align);
+        }
+
+        arena->cur = p + size;
+        SEXP_atomic_inc_u32 (&arena->live);
+
+        return (p);
+}
+
+void SEXP_arena_free (void *ptr)
+{
+        struct SEXP_arena_chunk *chunk;
+
+        chunk = (struct SEXP_arena_chunk *)((uintptr_t)ptr & ~(uintptr_t)(SEXP_ARENA_CHUNK - 1));
+        SEXP_arena_unref (chunk->arena);
+}
+
+/*
+ * Promotion
+ */
+static uintptr_t SEXP_rawval_promote (uintptr_t valp);
+
+/* Build list blocks holding the members, the references are taken over. */
+static uintptr_t SEXP_rawval_lblk_adopt (SEXP_t *memb, size_t count)
+{
+        uintptr_t head = 0, prev = 0;
+        size_t    i = 0;
+
+        while (i < count) {
+                struct SEXP_val_lblk *lblk;
+                uintptr_t lblkp;
+                uint8_t   sz = 0;
+
+                while (sz < 15 && ((size_t)1 << sz) < count - i)
+                        ++sz;
+
+                lblkp = SEXP_rawval_lblk_new (sz);
+                lblk  = SEXP_VALP_LBLK(lblkp);
+
+                while (lblk->real < (1 << sz) && i < count)
+                        lblk->memb[lblk->real++] = memb[i++];
+
+                if (prev == 0)
+                        head = lblkp;
+                else
+                        SEXP_VALP_LBLK(prev)->nxsz = (lblkp & SEXP_LBLKP_MASK) | (SEXP_VALP_LBLK(prev)->nxsz & SEXP_LBLKS_MASK);
+
+                prev = lblkp;
+        }
+
+        return (head);
+}
+
+static uintptr_t SEXP_rawval_list_promote (SEXP_val_t *v_dsc)
+{
+        struct SEXP_val_list *list;
+        struct SEXP_val_lblk *lblk;
+        SEXP_val_t v_dsc_c;
+        SEXP_t    *memb;
+        size_t     count, alloc;
+        uint16_t   skip;
+        bool       copy;
+
+        list  = SEXP_LCASTP(v_dsc->mem);
+        memb  = NULL;
+        count = alloc = 0;
+        skip  = list->offset;
+        copy  = (v_dsc->hdr->refs & SEXP_VALHDR_ARENA) != 0;
+
+        for (lblk = SEXP_VALP_LBLK(list->b_addr); lblk != NULL; lblk = SEXP_VALP_LBLK(lblk->nxsz)) {
+                if (lblk->refs & SEXP_LBLK_ARENA)
+                        copy = true;
+
+                for (uint16_t i = skip; i < lblk->real; ++i) {
+                        if (count == alloc) {
+                                alloc = alloc == 0 ? 8 : alloc * 2;
+                                memb  = sm_realloc (memb, sizeof (SEXP_t) * alloc);
+                        }
+
+                        memb[count] = lblk->memb[i];
+
+                        if (lblk->memb[i].s_valp != 0) {
+                                memb[count].s_valp = SEXP_rawval_promote (lblk->memb[i].s_valp);
+
+                                if (memb[count].s_valp != lblk->memb[i].s_valp)
+                                        copy = true;
+                        }
+
+                        ++count;
+                }
+
+                skip = 0;
+        }
+
+        if (!copy) {
+                /*
+                 * Nothing was copied, drop the references to the members
+                 * (the list still holds its own) and share the list.
+                 */
+                for (size_t i = 0; i < count; ++i) {
+                        if (memb[i].s_valp != 0)
+                                (void)SEXP_rawval_decref (memb[i].s_valp);
+                }
+
+                sm_free (memb);
+                return SEXP_rawval_incref (v_dsc->ptr);
+        }
+
+        if (SEXP_val_new (&v_dsc_c, sizeof (void *) + sizeof (uint16_t),
+                          SEXP_VALTYPE_LIST) != 0)
+        {
+                /* TODO: handle this */
+                abort ();
+        }
+
+        SEXP_LCASTP(v_dsc_c.mem)->b_addr = (void *)SEXP_rawval_lblk_adopt (memb, count);
+        SEXP_LCASTP(v_dsc_c.mem)->offset = 0;
+        sm_free (memb);
+
+        return (SEXP_val_ptr (&v_dsc_c));
+}
+
+/* Return a new reference to the value or to its copy on the heap. */
+static uintptr_t SEXP_rawval_promote (uintptr_t valp)
+{
+        SEXP_val_t v_dsc, v_dsc_c;
+
+        SEXP_val_dsc (&v_dsc, valp);
+
+        if (v_dsc.type == SEXP_VALTYPE_LIST)
+                return SEXP_rawval_list_promote (&v_dsc);
+
+        if (!(v_dsc.hdr->refs & SEXP_VALHDR_ARENA))
+                return SEXP_rawval_incref (valp);
+
+        if (SEXP_val_new (&v_dsc_c, v_dsc.hdr->size, v_dsc.type) != 0) {
+                /* TODO: handle this */
+                abort ();
+        }
+
+        memcpy (v_dsc_c.mem, v_dsc.mem, v_dsc.hdr->size);
+
+        return (SEXP_val_ptr (&v_dsc_c));
+}
+
+SEXP_t *SEXP_promote (const SEXP_t *s_exp)
+{
+        SEXP_arena_t *arena;
+        SEXP_t       *s_exp_r;
+
+        if (s_exp == NULL) {
+                errno = EFAULT;
+                return (NULL);
+        }
+
+        if (SEXP_arena_count == 0)
+                return SEXP_ref (s_exp);
+
+        SEXP_VALIDATE(s_exp);
+
+        /* the copies are allocated from the heap */
+        arena = SEXP_arena_enter (NULL);
+
+        s_exp_r = SEXP_new ();
+        s_exp_r->s_type = s_exp->s_type;
+        s_exp_r->s_valp = s_exp->s_valp != 0 ? SEXP_rawval_promote (s_exp->s_valp) : 0;
+
+        SEXP_arena_enter (arena);
+        SEXP_VALIDATE(s_exp_r);
+
+        return (s_exp_r);
+}
@@ -846,7 +846,6 @@ char *SEXP_string_subcstr (const SEXP_t *s_exp, size_t beg, size_t len)
                 s_len = len;
 
         if (s_len > 0) {
-                s_len = v_dsc.hdr->size / sizeof (char);
                 s_str = sm_alloc (sizeof (char) * (s_len + 1));
 
                 memcpy (s_str, ((char *) v_dsc.mem) + beg, sizeof (char) * s_len);
@@ -1092,7 +1091,7 @@ SEXP_t *SEXP_list_replace (SEXP_t *list, uint32_t n, const SEXP_t *n_val)
                 return (NULL);
         }
 
-        if (v_dsc.hdr->refs > 1) {
+        if (SEXP_VALHDR_REFS(v_dsc.hdr) > 1) {
 		uintptr_t uptr = SEXP_rawval_list_copy (list->s_valp);
 
 		if (SEXP_rawval_decref (list->s_valp)) {
@@ -1198,7 +1197,7 @@ SEXP_t *SEXP_list_add (SEXP_t *list, const SEXP_t *s_exp)
                 return (NULL);
         }
 
-        if (v_dsc.hdr->refs > 1) {
+        if (SEXP_VALHDR_REFS(v_dsc.hdr) > 1) {
                 /*
                  * Create a private copy of the value and
                  * decrement the reference counter in the
@@ -1286,19 +1285,24 @@ SEXP_t *SEXP_list_pop (SEXP_t *list)
 
         s_ref = SEXP_list_first (list);
 
-        if (v_dsc.hdr->refs > 1) {
+        if (SEXP_VALHDR_REFS(v_dsc.hdr) > 1) {
                 abort ();
         }
 
         lblk = SEXP_VALP_LBLK(SEXP_LCASTP(v_dsc.mem)->b_addr);
 
         if (lblk != NULL) {
+                /*
+                 * The block can be released only after all of its members
+                 * were popped. The list takes over the reference to the
+                 * next block.
+                 */
                 if (++SEXP_LCASTP(v_dsc.mem)->offset == lblk->real) {
                         SEXP_LCASTP(v_dsc.mem)->offset = 0;
                         SEXP_LCASTP(v_dsc.mem)->b_addr = SEXP_VALP_LBLK(lblk->nxsz);
-                }
 
-                SEXP_rawval_lblk_free1 ((uintptr_t)lblk, SEXP_free_lmemb);
+                        SEXP_rawval_lblk_free1 ((uintptr_t)lblk, SEXP_free_lmemb);
+                }
         }
 
 #if !defined(NDEBUG)
@@ -1638,16 +1642,16 @@ SEXP_t *SEXP_unref (SEXP_t *s_exp_o)
 
                         switch (v_dsc.type) {
                         case SEXP_VALTYPE_STRING:
-                                sm_free (v_dsc.hdr);
+                                SEXP_val_free (&v_dsc);
                                 break;
                         case SEXP_VALTYPE_NUMBER:
-                                sm_free (v_dsc.hdr);
+                                SEXP_val_free (&v_dsc);
                                 break;
                         case SEXP_VALTYPE_LIST:
                                 if (SEXP_LCASTP(v_dsc.mem)->b_addr != NULL)
                                         SEXP_rawval_lblk_free ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, SEXP_free_lmemb);
 
-                                sm_free (v_dsc.hdr);
+                                SEXP_val_free (&v_dsc);
                                 break;
                         default:
                                 abort ();
@@ -1683,7 +1687,7 @@ SEXP_t *SEXP_softref (SEXP_t *s_exp_o)
 
 	SEXP_val_dsc (&v_dsc, s_exp_r->s_valp);
 
-	if (v_dsc.hdr->refs > 1) {
+	if (SEXP_VALHDR_REFS(v_dsc.hdr) > 1) {
 		uintptr_t uptr = SEXP_rawval_copy(s_exp_r->s_valp);
 		if (SEXP_rawval_decref(s_exp_r->s_valp)) {
 			/* cannot happen -- refs > 1 */
@@ -1722,7 +1726,7 @@ uint32_t SEXP_refs (const SEXP_t *ref)
         SEXP_VALIDATE(ref);
         SEXP_val_dsc (&v_dsc, ref->s_valp);
 
-        return (v_dsc.hdr->refs);
+        return (SEXP_VALHDR_REFS(v_dsc.hdr));
 }
 
 bool SEXP_eq (const SEXP_t *a, const SEXP_t *b)
@@ -1833,16 +1837,16 @@ static void SEXP_free_lmemb (SEXP_t *s_exp)
                 if (SEXP_rawval_decref (s_exp->s_valp)) {
                         switch (v_dsc.type) {
                         case SEXP_VALTYPE_STRING:
-                                sm_free (v_dsc.hdr);
+                                SEXP_val_free (&v_dsc);
                                 break;
                         case SEXP_VALTYPE_NUMBER:
-                                sm_free (v_dsc.hdr);
+                                SEXP_val_free (&v_dsc);
                                 break;
                         case SEXP_VALTYPE_LIST:
                                 if (SEXP_LCASTP(v_dsc.mem)->b_addr != NULL)
                                         SEXP_rawval_lblk_free ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, SEXP_free_lmemb);
 
-                                sm_free (v_dsc.hdr);
+                                SEXP_val_free (&v_dsc);
                                 break;
                         default:
                                 abort ();
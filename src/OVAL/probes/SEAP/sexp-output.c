@@ -212,6 +212,108 @@ int SEXP_sbprintf_t (SEXP_t *s_exp, strbuf_t *sb)
         return (0);
 }
 
+int SEXP_sbprintf_b (SEXP_t *s_exp, strbuf_t *sb)
+{
+        SEXP_val_t v_dsc;
+        char buffer[1 + sizeof (uint64_t)];
+
+        if (SEXP_rawptr_mask(s_exp->s_type, SEXP_DATATYPEPTR_MASK) != NULL) {
+                const char *name;
+                size_t      len;
+
+                name = SEXP_datatype_name(s_exp->s_type);
+                len  = strlen (name);
+
+                if (len > UINT8_MAX) {
+                        errno = EINVAL;
+                        return (-1);
+                }
+
+                buffer[0] = SEXP_BIN_DATATYPE;
+                buffer[1] = (char)len;
+
+                if (strbuf_add (sb, buffer, 2) != 0 ||
+                    strbuf_add (sb, name, len) != 0)
+                        return (-1);
+        }
+
+        SEXP_val_dsc (&v_dsc, s_exp->s_valp);
+
+        switch (v_dsc.type) {
+        case SEXP_VALTYPE_NUMBER:
+        {
+                int64_t  i;
+                uint64_t u;
+                double   f;
+
+                switch (SEXP_NTYPEP(v_dsc.hdr->size, v_dsc.mem)) {
+                case SEXP_NUM_BOOL:
+                        buffer[0] = SEXP_NCASTP(b ,v_dsc.mem)->n ? SEXP_BIN_TRUE : SEXP_BIN_FALSE;
+                        return strbuf_add (sb, buffer, 1);
+                case SEXP_NUM_INT8:   i = SEXP_NCASTP(i8 ,v_dsc.mem)->n; goto signed_number;
+                case SEXP_NUM_INT16:  i = SEXP_NCASTP(i16,v_dsc.mem)->n; goto signed_number;
+                case SEXP_NUM_INT32:  i = SEXP_NCASTP(i32,v_dsc.mem)->n; goto signed_number;
+                case SEXP_NUM_INT64:  i = SEXP_NCASTP(i64,v_dsc.mem)->n;
+                signed_number:
+                        buffer[0] = SEXP_BIN_INT;
+                        memcpy (buffer + 1, &i, sizeof i);
+                        break;
+                case SEXP_NUM_UINT8:  u = SEXP_NCASTP(u8 ,v_dsc.mem)->n; goto unsigned_number;
+                case SEXP_NUM_UINT16: u = SEXP_NCASTP(u16,v_dsc.mem)->n; goto unsigned_number;
+                case SEXP_NUM_UINT32: u = SEXP_NCASTP(u32,v_dsc.mem)->n; goto unsigned_number;
+                case SEXP_NUM_UINT64: u = SEXP_NCASTP(u64,v_dsc.mem)->n;
+                unsigned_number:
+                        buffer[0] = SEXP_BIN_UINT;
+                        memcpy (buffer + 1, &u, sizeof u);
+                        break;
+                case SEXP_NUM_DOUBLE:
+                        f = SEXP_NCASTP(f,v_dsc.mem)->n;
+                        buffer[0] = SEXP_BIN_DOUBLE;
+                        memcpy (buffer + 1, &f, sizeof f);
+                        break;
+                default:
+                        abort ();
+                }
+
+                return strbuf_add (sb, buffer, sizeof buffer);
+        }
+        case SEXP_VALTYPE_STRING:
+        {
+                uint32_t len;
+
+                if (v_dsc.hdr->size / sizeof (char) > UINT32_MAX) {
+                        errno = EFBIG;
+                        return (-1);
+                }
+
+                len = (uint32_t)(v_dsc.hdr->size / sizeof (char));
+                buffer[0] = SEXP_BIN_STRING;
+                memcpy (buffer + 1, &len, sizeof len);
+
+                if (strbuf_add (sb, buffer, 1 + sizeof len) != 0)
+                        return (-1);
+
+                return strbuf_add (sb, (const char *)v_dsc.mem, len);
+        }
+        case SEXP_VALTYPE_LIST:
+                buffer[0] = SEXP_BIN_LIST_BEG;
+
+                if (strbuf_add (sb, buffer, 1) != 0)
+                        return (-1);
+                if (SEXP_rawval_lblk_cb ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, (int (*)(SEXP_t *, void *)) SEXP_sbprintf_b, (void *)sb,
+                                         SEXP_LCASTP(v_dsc.mem)->offset + 1) != 0)
+                        return (-1);
+
+                buffer[0] = SEXP_BIN_LIST_END;
+
+                return strbuf_add (sb, buffer, 1);
+        default:
+                abort ();
+        }
+
+        return (0);
+}
+
 typedef struct {
         size_t sz;
         FILE  *fp;
@@ -36,6 +36,7 @@
 #include "_sexp-types.h"
 #include "_sexp-manip.h"
 #include "_sexp-parser.h"
+#include "_sexp-output.h"
 #include "_sexp-datatype.h"
 #include "_sexp-value.h"
 #include "_sexp-rawptr.h"
@@ -119,7 +120,7 @@ void SEXP_pstate_free (SEXP_pstate_t *pstate)
                                 SEXP_val_t v_dsc;
 
                                 SEXP_val_dsc (&v_dsc, pstate->v_bool[i]);
-                                sm_free (v_dsc.hdr);
+                                SEXP_val_free (&v_dsc);
                         }
                 }
         }
@@ -1970,3 +1971,154 @@ bool SEXP_pstate_errorp(SEXP_pstate_t *pstate)
 		return (true);
 	}
 }
+
+/*
+ * Numbers are created using the same types as the text parser would use
+ * for their textual representation, so that both encodings give the same
+ * S-expressions.
+ */
+static SEXP_t *SEXP_parse_b_uint (uint64_t n)
+{
+        if (n > UINT16_MAX)
+                return (n > UINT32_MAX ? SEXP_number_newu_64 (n) : SEXP_number_newu_32 ((uint32_t)n));
+        else
+                return (n > UINT8_MAX ? SEXP_number_newu_16 ((uint16_t)n) : SEXP_number_newu_8 ((uint8_t)n));
+}
+
+static SEXP_t *SEXP_parse_b_int (int64_t n)
+{
+        if (n >= 0)
+                return SEXP_parse_b_uint ((uint64_t)n);
+        if (n < INT16_MIN)
+                return (n < INT32_MIN ? SEXP_number_newi_64 (n) : SEXP_number_newi_32 ((int32_t)n));
+        else
+                return (n < INT8_MIN ? SEXP_number_newi_16 ((int16_t)n) : SEXP_number_newi_8 ((int8_t)n));
+}
+
+/*
+ * Maximal nesting of lists, the parser recurses into each list. The
+ * S-exps sent between the library and the probes are nested much less.
+ */
+#define SEXP_BIN_DEPTH_MAX 256
+
+static SEXP_t *SEXP_parse_b_value (const uint8_t **bp, const uint8_t *be, unsigned int depth)
+{
+        const uint8_t *b = *bp;
+        SEXP_t *s_exp = NULL, *memb;
+        char     name[UINT8_MAX + 1];
+        size_t   name_len = 0;
+        uint32_t len;
+        uint64_t u;
+        int64_t  i;
+        double   f;
+
+        if (b < be && *b == SEXP_BIN_DATATYPE) {
+                if (be - b < 2 || (size_t)(be - b - 2) < b[1])
+                        goto invalid;
+
+                name_len = b[1];
+                memcpy (name, b + 2, name_len);
+                name[name_len] = '\0';
+                b += 2 + name_len;
+        }
+
+        if (b >= be)
+                goto invalid;
+
+        switch (*b++) {
+        case SEXP_BIN_LIST_BEG:
+                if (depth >= SEXP_BIN_DEPTH_MAX)
+                        goto invalid;
+
+                s_exp = SEXP_list_new (NULL);
+
+                while (b < be && *b != SEXP_BIN_LIST_END) {
+                        memb = SEXP_parse_b_value (&b, be, depth + 1);
+
+                        if (memb == NULL) {
+                                SEXP_free (s_exp);
+                                return (NULL);
+                        }
+
+                        SEXP_list_add (s_exp, memb);
+                        SEXP_free (memb);
+                }
+
+                if (b >= be)
+                        goto invalid;
+
+                ++b;
+                break;
+        case SEXP_BIN_STRING:
+                if ((size_t)(be - b) < sizeof len)
+                        goto invalid;
+
+                memcpy (&len, b, sizeof len);
+                b += sizeof len;
+
+                if ((size_t)(be - b) < len)
+                        goto invalid;
+
+                s_exp = SEXP_string_new (b, len);
+                b += len;
+                break;
+        case SEXP_BIN_INT:
+                if ((size_t)(be - b) < sizeof i)
+                        goto invalid;
+
+                memcpy (&i, b, sizeof i);
+                b += sizeof i;
+                s_exp = SEXP_parse_b_int (i);
+                break;
+        case SEXP_BIN_UINT:
+                if ((size_t)(be - b) < sizeof u)
+                        goto invalid;
+
+                memcpy (&u, b, sizeof u);
+                b += sizeof u;
+                s_exp = SEXP_parse_b_uint (u);
+                break;
+        case SEXP_BIN_DOUBLE:
+                if ((size_t)(be - b) < sizeof f)
+                        goto invalid;
+
+                memcpy (&f, b, sizeof f);
+                b += sizeof f;
+                s_exp = SEXP_number_newf (f);
+                break;
+        case SEXP_BIN_TRUE:
+                s_exp = SEXP_number_newb (true);
+                break;
+        case SEXP_BIN_FALSE:
+                s_exp = SEXP_number_newb (false);
+                break;
+        default:
+                goto invalid;
+        }
+
+        if (name_len > 0)
+                SEXP_datatype_set (s_exp, name);
+
+        *bp = b;
+        return (s_exp);
+invalid:
+        SEXP_free (s_exp);
+        errno = EILSEQ;
+        return (NULL);
+}
+
+SEXP_t *SEXP_parse_b (const void *buf, size_t len)
+{
+        const uint8_t *b = buf, *be = b + len;
+        SEXP_t *s_exp;
+
+        s_exp = SEXP_parse_b_value (&b, be, 0);
+
+        if (s_exp != NULL && b != be) {
+                SEXP_free (s_exp);
+                errno = EILSEQ;
+                return (NULL);
+        }
+
+        return (s_exp);
+}
@@ -25,28 +25,110 @@
 //#endif
 
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 
 #include "_sexp-atomic.h"
 #include "_sexp-value.h"
+#include "_sexp-arena.h"
 #include "public/sm_alloc.h"
 
+/*
+ * Every thread counts the bytes it allocated and freed and adds the
+ * difference to the process-wide count once it's larger than the batch,
+ * the allocations don't contend on a shared counter then.
+ */
+#define SEXP_LIVE_BATCH (64 * 1024)
+
+/* size of a list block with 2^sz members */
+#define SEXP_LBLK_SIZE(sz) (sizeof (uintptr_t) + (2 * sizeof (uint16_t)) + (sizeof (SEXP_t) * (1 << (sz))))
+
+static pthread_once_t  SEXP_live_once = PTHREAD_ONCE_INIT;
+static pthread_key_t   SEXP_live_key;
+static pthread_mutex_t SEXP_live_lock = PTHREAD_MUTEX_INITIALIZER;
+static int64_t         SEXP_live_total = 0;
+
+static void SEXP_live_add (int64_t delta)
+{
+        pthread_mutex_lock (&SEXP_live_lock);
+        SEXP_live_total += delta;
+        pthread_mutex_unlock (&SEXP_live_lock);
+}
+
+/* called when a thread exits */
+static void SEXP_live_flush (void *arg)
+{
+        int64_t *delta = (int64_t *)arg;
+
+        SEXP_live_add (*delta);
+        free (delta);
+}
+
+static void SEXP_live_init (void)
+{
+        (void)pthread_key_create (&SEXP_live_key, &SEXP_live_flush);
+}
+
+static void SEXP_live_account (int64_t size)
+{
+        int64_t *delta;
+
+        (void)pthread_once (&SEXP_live_once, &SEXP_live_init);
+        delta = pthread_getspecific (SEXP_live_key);
+
+        if (delta == NULL) {
+                delta = calloc (1, sizeof (int64_t));
+
+                if (delta == NULL || pthread_setspecific (SEXP_live_key, delta) != 0) {
+                        free (delta);
+                        SEXP_live_add (size);
+                        return;
+                }
+        }
+
+        *delta += size;
+
+        if (*delta > SEXP_LIVE_BATCH || *delta < -SEXP_LIVE_BATCH) {
+                SEXP_live_add (*delta);
+                *delta = 0;
+        }
+}
+
+size_t SEXP_live_bytes (void)
+{
+        int64_t total;
+
+        pthread_mutex_lock (&SEXP_live_lock);
+        total = SEXP_live_total;
+        pthread_mutex_unlock (&SEXP_live_lock);
+
+        return (total > 0 ? (size_t)total : 0);
+}
+
 int SEXP_val_new (SEXP_val_t *dst, size_t vmemsize, SEXP_type_t type)
 {
         void *s_val;
+        uint32_t refs = 1;
+
+        s_val = SEXP_arena_alloc (sizeof (SEXP_valhdr_t) + vmemsize, SEXP_VALP_ALIGN);
 
-        if (sm_memalign (&s_val, SEXP_VALP_ALIGN,
-                         sizeof (SEXP_valhdr_t) + vmemsize) != 0)
+        if (s_val != NULL)
+                refs |= SEXP_VALHDR_ARENA;
+        else if (sm_memalign (&s_val, SEXP_VALP_ALIGN,
+                              sizeof (SEXP_valhdr_t) + vmemsize) != 0)
         {
                 return (-1);
         }
 
         SEXP_val_dsc (dst, (uintptr_t) s_val);
 
-        dst->hdr->refs = 1;
+        dst->hdr->refs = refs;
         dst->hdr->size = vmemsize;
         dst->type      = type;
         dst->ptr       = SEXP_val_ptr (dst);
+
+        SEXP_live_account ((int64_t)(sizeof (SEXP_valhdr_t) + vmemsize));
 #if defined(SEAP_VERBOSE_DEBUG)
 	dD("new value: hdr->refs = %u, hdr->size = %zu, type = %hhu, ptr = %p",
 		dst->hdr->refs, dst->hdr->size, dst->type, (void *)dst->ptr);
@@ -54,6 +136,16 @@ int SEXP_val_new (SEXP_val_t *dst, size_t vmemsize, SEXP_type_t type)
         return (0);
 }
 
+void SEXP_val_free (SEXP_val_t *dsc)
+{
+        SEXP_live_account (-(int64_t)(sizeof (SEXP_valhdr_t) + dsc->hdr->size));
+
+        if (dsc->hdr->refs & SEXP_VALHDR_ARENA)
+                SEXP_arena_free (dsc->hdr);
+        else
+                sm_free (dsc->hdr);
+}
+
 void SEXP_val_dsc (SEXP_val_t *dst, uintptr_t ptr)
 {
         dst->ptr  = ptr;
@@ -84,7 +176,7 @@ uintptr_t SEXP_rawval_incref (uintptr_t valp)
  */
 int SEXP_rawval_decref (uintptr_t valp)
 {
-        return (SEXP_atomic_dec_u32 (&(SEXP_VALP_HDR(valp)->refs)) == 0);
+        return ((SEXP_atomic_dec_u32 (&(SEXP_VALP_HDR(valp)->refs)) & ~SEXP_VALHDR_ARENA) == 0);
 }
 
 SEXP_numtype_t SEXP_rawval_number_type (SEXP_val_t *dsc)
@@ -111,19 +203,26 @@ size_t SEXP_rawval_list_length (struct SEXP_val_list *list)
 uintptr_t SEXP_rawval_lblk_new (uint8_t sz)
 {
         struct SEXP_val_lblk *lblk;
+        size_t   size;
+        uint16_t refs = 1;
 
         _A(sz < 16);
 
-        if (sm_memalign ((void **)(void *)&lblk, SEXP_LBLK_ALIGN,
-                         sizeof (uintptr_t) + (2 * sizeof (uint16_t)) + (sizeof (SEXP_t) * (1 << sz))) != 0) {
+        size = SEXP_LBLK_SIZE(sz);
+        lblk = SEXP_arena_alloc (size, SEXP_LBLK_ALIGN);
+
+        if (lblk != NULL)
+                refs |= SEXP_LBLK_ARENA;
+        else if (sm_memalign ((void **)(void *)&lblk, SEXP_LBLK_ALIGN, size) != 0) {
                 /* TODO: handle this */
                 abort ();
                 return ((uintptr_t) NULL);
         }
 
         lblk->nxsz = ((uintptr_t)(NULL) & SEXP_LBLKP_MASK) | ((uintptr_t)sz & SEXP_LBLKS_MASK);
-        lblk->refs = 1;
+        lblk->refs = refs;
         lblk->real = 0;
+        SEXP_live_account ((int64_t)size);
 
         return ((uintptr_t)lblk);
 }
@@ -144,7 +243,7 @@ uintptr_t SEXP_rawval_lblk_incref (uintptr_t lblkp)
         for (;;) {
                 refs = lblk->refs;
 
-                if (refs < UINT16_MAX) {
+                if ((refs & ~SEXP_LBLK_ARENA) < SEXP_LBLK_REFS_MAX) {
                         if (SEXP_atomic_cas_u16 (&lblk->refs, refs, refs + 1))
                                 break;
                 } else
@@ -156,7 +255,7 @@ uintptr_t SEXP_rawval_lblk_incref (uintptr_t lblkp)
 
 int SEXP_rawval_lblk_decref (uintptr_t lblkp)
 {
-        return (SEXP_atomic_dec_u16 (&SEXP_VALP_LBLK(lblkp)->refs) == 0);
+        return ((SEXP_atomic_dec_u16 (&SEXP_VALP_LBLK(lblkp)->refs) & ~SEXP_LBLK_ARENA) == 0);
 }
 
 uintptr_t SEXP_rawval_lblk_fill (uintptr_t lblkp, SEXP_t *s_exp[], uint16_t s_exp_count)
@@ -198,7 +297,7 @@ uintptr_t SEXP_rawval_lblk_add (uintptr_t lblkp, const SEXP_t *s_exp)
                 lb_prev = 0;
 
                 do {
-                        if (lblk->refs < 2) {
+                        if (SEXP_LBLK_REFS(lblk) < 2) {
                                 lb_prev = (uintptr_t)lblk;
                                 lblk    = SEXP_VALP_LBLK(lblk->nxsz);
                         } else {
@@ -331,7 +430,7 @@ uintptr_t SEXP_rawval_lblk_replace (uintptr_t lblkp, uint32_t n, const SEXP_t *n
         lb_prev = 0;
 
         while (n > lblk->real) {
-                if (lblk->refs < 2) {
+                if (SEXP_LBLK_REFS(lblk) < 2) {
                         n      -= lblk->real;
                         lb_prev = (uintptr_t)lblk;
                         lblk    = SEXP_VALP_LBLK(lblk->nxsz);
@@ -516,6 +615,16 @@ uintptr_t SEXP_rawval_lblk_copy (uintptr_t lblkp, uint16_t n_skip)
         return (lb_head);
 }
 
+static void SEXP_rawval_lblk_release (struct SEXP_val_lblk *lblk)
+{
+        SEXP_live_account (-(int64_t)SEXP_LBLK_SIZE(lblk->nxsz & SEXP_LBLKS_MASK));
+
+        if (lblk->refs & SEXP_LBLK_ARENA)
+                SEXP_arena_free (lblk);
+        else
+                sm_free (lblk);
+}
+
 void SEXP_rawval_lblk_free (uintptr_t lblkp, void (*func) (SEXP_t *))
 {
         if (SEXP_rawval_lblk_decref (lblkp)) {
@@ -529,7 +638,7 @@ void SEXP_rawval_lblk_free (uintptr_t lblkp, void (*func) (SEXP_t *))
                         func (lblk->memb + lblk->real);
                 }
 
-                sm_free (lblk);
+                SEXP_rawval_lblk_release (lblk);
 
                 if (next != NULL)
                         SEXP_rawval_lblk_free ((uintptr_t)next, func);
@@ -550,7 +659,7 @@ void SEXP_rawval_lblk_free1 (uintptr_t lblkp, void (*func) (SEXP_t *))
                         func (lblk->memb + lblk->real);
                 }
 
-                sm_free (lblk);
+                SEXP_rawval_lblk_release (lblk);
         }
 
         return;
@@ -28,8 +28,10 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <assume.h>
 #include <errno.h>
+#include <alloc.h>
 
 #include "crapi.h"
 #include "digest.h"
@@ -64,6 +66,106 @@ int crapi_digest_fd (int fd, crapi_alg_t alg, void *dst, size_t *size)
         return (-1);
 }
 
+static int crapi_digest_ctbl_set (struct digest_ctbl_t *ctbl, crapi_alg_t alg)
+{
+        switch (alg) {
+        case CRAPI_DIGEST_MD5:
+                ctbl->init   = &crapi_md5_init;
+                ctbl->update = &crapi_md5_update;
+                ctbl->fini   = &crapi_md5_fini;
+                ctbl->free   = &crapi_md5_free;
+                break;
+        case CRAPI_DIGEST_SHA1:
+                ctbl->init   = &crapi_sha1_init;
+                ctbl->update = &crapi_sha1_update;
+                ctbl->fini   = &crapi_sha1_fini;
+                ctbl->free   = &crapi_sha1_free;
+                break;
+        case CRAPI_DIGEST_SHA224:
+                ctbl->init   = &crapi_sha224_init;
+                ctbl->update = &crapi_sha224_update;
+                ctbl->fini   = &crapi_sha224_fini;
+                ctbl->free   = &crapi_sha224_free;
+                break;
+        case CRAPI_DIGEST_SHA256:
+                ctbl->init   = &crapi_sha256_init;
+                ctbl->update = &crapi_sha256_update;
+                ctbl->fini   = &crapi_sha256_fini;
+                ctbl->free   = &crapi_sha256_free;
+                break;
+        case CRAPI_DIGEST_SHA384:
+                ctbl->init   = &crapi_sha384_init;
+                ctbl->update = &crapi_sha384_update;
+                ctbl->fini   = &crapi_sha384_fini;
+                ctbl->free   = &crapi_sha384_free;
+                break;
+        case CRAPI_DIGEST_SHA512:
+                ctbl->init   = &crapi_sha512_init;
+                ctbl->update = &crapi_sha512_update;
+                ctbl->fini   = &crapi_sha512_fini;
+                ctbl->free   = &crapi_sha512_free;
+                break;
+        case CRAPI_DIGEST_RMD160:
+                ctbl->init   = &crapi_rmd160_init;
+                ctbl->update = &crapi_rmd160_update;
+                ctbl->fini   = &crapi_rmd160_fini;
+                ctbl->free   = &crapi_rmd160_free;
+                break;
+        default:
+                return (-1);
+        }
+
+        return (0);
+}
+
+/*
+ * Feed the content of the file to all initialized contexts. The file
+ * is read only once, in large blocks.
+ */
+static int crapi_mdigest_run (int fd, int num, struct digest_ctbl_t *ctbl)
+{
+        register int i;
+        uint8_t *fd_buf;
+        ssize_t  ret;
+
+        fd_buf = oscap_alloc (CRAPI_MDIGEST_BUFSZ);
+
+#if defined(POSIX_FADV_SEQUENTIAL)
+        (void) posix_fadvise (fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+        for (;;) {
+                ret = read (fd, fd_buf, CRAPI_MDIGEST_BUFSZ);
+
+                if (ret == 0)
+                        break;
+                if (ret < 0) {
+                        if (errno == EINTR)
+                                continue;
+                        goto fail;
+                }
+
+                for (i = 0; i < num; ++i) {
+                        if (ctbl[i].ctx == NULL)
+                                continue;
+                        if (ctbl[i].update (ctbl[i].ctx, fd_buf, (size_t)ret) != 0)
+                                goto fail;
+                }
+        }
+
+        for (i = 0; i < num; ++i) {
+                if (ctbl[i].ctx == NULL)
+                        continue;
+                ctbl[i].fini (ctbl[i].ctx);
+                ctbl[i].ctx = NULL;
+        }
+
+        oscap_free (fd_buf);
+        return (0);
+fail:
+        oscap_free (fd_buf);
+        return (-1);
+}
+
 int crapi_mdigest_fd (int fd, int num, ... /* crapi_alg_t alg, void *dst, size_t *size, ...*/)
 {
         register int i;
@@ -74,9 +176,6 @@ int crapi_mdigest_fd (int fd, int num, ... /* crapi_alg_t alg, void *dst, size_t
         void       *dst;
         size_t     *size;
 
-        uint8_t fd_buf[CRAPI_IO_BUFSZ];
-        ssize_t ret;
-
         assume_r (num > 0, -1, errno = EINVAL;);
         assume_r (fd  > 0, -1, errno = EINVAL;);
 
@@ -90,50 +189,7 @@ int crapi_mdigest_fd (int fd, int num, ... /* crapi_alg_t alg, void *dst, size_t
                 dst  = va_arg (ap, void *);
                 size = va_arg (ap, size_t *);
 
-                switch (alg) {
-                case CRAPI_DIGEST_MD5:
-                        ctbl[i].init   = &crapi_md5_init;
-                        ctbl[i].update = &crapi_md5_update;
-                        ctbl[i].fini   = &crapi_md5_fini;
-                        ctbl[i].free   = &crapi_md5_free;
-                        break;
-                case CRAPI_DIGEST_SHA1:
-                        ctbl[i].init   = &crapi_sha1_init;
-                        ctbl[i].update = &crapi_sha1_update;
-                        ctbl[i].fini   = &crapi_sha1_fini;
-                        ctbl[i].free   = &crapi_sha1_free;
-                        break;
-                case CRAPI_DIGEST_SHA224:
-                        ctbl[i].init   = &crapi_sha224_init;
-                        ctbl[i].update = &crapi_sha224_update;
-                        ctbl[i].fini   = &crapi_sha224_fini;
-                        ctbl[i].free   = &crapi_sha224_free;
-                        break;
-                case CRAPI_DIGEST_SHA256:
-                        ctbl[i].init   = &crapi_sha256_init;
-                        ctbl[i].update = &crapi_sha256_update;
-                        ctbl[i].fini   = &crapi_sha256_fini;
-                        ctbl[i].free   = &crapi_sha256_free;
-                        break;
-                case CRAPI_DIGEST_SHA384:
-                        ctbl[i].init   = &crapi_sha384_init;
-                        ctbl[i].update = &crapi_sha384_update;
-                        ctbl[i].fini   = &crapi_sha384_fini;
-                        ctbl[i].free   = &crapi_sha384_free;
-                        break;
-                case CRAPI_DIGEST_SHA512:
-                        ctbl[i].init   = &crapi_sha512_init;
-                        ctbl[i].update = &crapi_sha512_update;
-                        ctbl[i].fini   = &crapi_sha512_fini;
-                        ctbl[i].free   = &crapi_sha512_free;
-                        break;
-                case CRAPI_DIGEST_RMD160:
-                        ctbl[i].init   = &crapi_rmd160_init;
-                        ctbl[i].update = &crapi_rmd160_update;
-                        ctbl[i].fini   = &crapi_rmd160_fini;
-                        ctbl[i].free   = &crapi_rmd160_free;
-                        break;
-                default:
+                if (crapi_digest_ctbl_set (&ctbl[i], alg) != 0) {
                         va_end (ap);
                         goto fail;
                 }
@@ -144,39 +200,39 @@ int crapi_mdigest_fd (int fd, int num, ... /* crapi_alg_t alg, void *dst, size_t
 
         va_end (ap);
 
-        while ((ret = read (fd, fd_buf, sizeof fd_buf)) == sizeof fd_buf) {
-#pragma omp parallel for
-                for (i = 0; i < num; ++i) {
-			if (ctbl[i].ctx == NULL)
-				continue;
-                        if (ctbl[i].update (ctbl[i].ctx, fd_buf, sizeof fd_buf) != 0) {
-                                goto fail;
-                        }
-                }
-        }
-
-        switch (ret) {
-        case 0:
-                break;
-        case -1:
+        if (crapi_mdigest_run (fd, num, ctbl) != 0)
                 goto fail;
-        default:
-                assume_r (ret > 0, -1, goto fail;);
 
-                for (i = 0; i < num; ++i) {
-			if (ctbl[i].ctx == NULL)
-				continue;
-                        if (ctbl[i].update (ctbl[i].ctx, fd_buf, (size_t)ret) != 0) {
-                                goto fail;
-                        }
-                }
-        }
+        return (0);
+fail:
+        for (i = 0; i < num; ++i)
+                if (ctbl[i].ctx != NULL)
+                        ctbl[i].free (ctbl[i].ctx);
+
+        return (-1);
+}
+
+int crapi_mdigest_fdv (int fd, int num, const crapi_alg_t *alg, void **dst, size_t **size)
+{
+        register int i;
+        struct digest_ctbl_t ctbl[num];
+
+        assume_r (num > 0, -1, errno = EINVAL;);
+        assume_r (fd  > 0, -1, errno = EINVAL;);
+
+        for (i = 0; i < num; ++i)
+                ctbl[i].ctx = NULL;
 
         for (i = 0; i < num; ++i) {
-		if (ctbl[i].ctx == NULL)
-			continue;
-                ctbl[i].fini (ctbl[i].ctx);
-	}
+                if (crapi_digest_ctbl_set (&ctbl[i], alg[i]) != 0)
+                        goto fail;
+
+                if ((ctbl[i].ctx = ctbl[i].init (dst[i], size[i])) == NULL)
+			*size[i] = 0;
+        }
+
+        if (crapi_mdigest_run (fd, num, ctbl) != 0)
+                goto fail;
 
         return (0);
 fail:
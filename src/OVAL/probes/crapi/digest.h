@@ -55,4 +55,10 @@ struct digest_ctbl_t {
 
 int crapi_mdigest_fd (int fd, int num, ... /*crapi_alg_t alg, void *dst, size_t *size, ...*/);
 
+/*
+ * Same as crapi_mdigest_fd(), but the algorithms and the destination
+ * buffers are passed in arrays of num elements.
+ */
+int crapi_mdigest_fdv (int fd, int num, const crapi_alg_t *alg, void **dst, size_t **size);
+
 #endif /* CRAPI_DIGEST_H */
@@ -0,0 +1,806 @@
+/**
+ * @file   fscache.c
+ * @brief  session cache of the file system metadata read by oval_fts
+ */
+
+/*
+ * Copyright 2016 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "fscache.h"
+#include "debug_priv.h"
+
+/*
+ * Default number of file system entries kept in the cache, can be changed
+ * using OSCAP_PROBE_FS_CACHE. A record of a directory counts as many entries
+ * as the directory has.
+ */
+#define FSCACHE_MAX_DEFAULT 100000
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
+#ifndef O_DIRECTORY
+#define O_DIRECTORY 0
+#endif
+
+/* fstatat(2) works with O_PATH and the directory doesn't have to be readable */
+#ifdef O_PATH
+#define FSCACHE_DIR_FLAGS (O_PATH | O_DIRECTORY | O_CLOEXEC)
+#else
+#define FSCACHE_DIR_FLAGS (O_RDONLY | O_DIRECTORY | O_CLOEXEC)
+#endif
+
+#define FSCACHE_LSTAT 0
+#define FSCACHE_STAT  1
+#define FSCACHE_DIR   2
+
+struct fscache_rec {
+	struct fscache_rec *next;
+	uint32_t hash;
+	uint8_t  type;
+	bool     cached;     /* false if the record didn't fit in the cache */
+	int      err;        /* errno of the call, 0 if it succeeded */
+	union {
+		struct stat st;
+		struct {
+			size_t count;
+			char  *names; /* NUL separated, in the order of readdir() */
+		} dir;
+	} u;
+	char key[];
+};
+
+static struct {
+	pthread_once_t  once;
+	pthread_mutex_t lock;
+	struct fscache_rec **bucket;
+	size_t size;     /* number of buckets */
+	size_t count;    /* number of records */
+	size_t entries;  /* number of entries of the records */
+	size_t max;      /* 0 = caching disabled */
+	size_t hits;
+	size_t misses;
+} fscache = {
+	.once = PTHREAD_ONCE_INIT,
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static void fscache_init(void)
+{
+	char *str, *end;
+	long  max;
+
+	fscache.max = FSCACHE_MAX_DEFAULT;
+	str = getenv("OSCAP_PROBE_FS_CACHE");
+
+	if (str == NULL)
+		return;
+
+	errno = 0;
+	max   = strtol(str, &end, 10);
+
+	if (errno != 0 || *end != '\0' || max < 0) {
+		dW("Invalid value of OSCAP_PROBE_FS_CACHE: \"%s\"", str);
+		return;
+	}
+
+	fscache.max = (size_t)max;
+}
+
+static uint32_t fscache_hash(uint8_t type, const char *key)
+{
+	uint32_t h = 2166136261u ^ type;
+
+	while (*key != '\0') {
+		h ^= (uint8_t)*key++;
+		h *= 16777619u;
+	}
+
+	return (h);
+}
+
+/* called with the lock held */
+static struct fscache_rec *fscache_find(uint8_t type, uint32_t hash, const char *key)
+{
+	struct fscache_rec *rec;
+
+	if (fscache.bucket == NULL)
+		return (NULL);
+
+	for (rec = fscache.bucket[hash % fscache.size]; rec != NULL; rec = rec->next) {
+		if (rec->hash == hash && rec->type == type && strcmp(rec->key, key) == 0)
+			return (rec);
+	}
+
+	return (NULL);
+}
+
+/* called with the lock held */
+static void fscache_grow(void)
+{
+	struct fscache_rec **bucket, *rec, *next;
+	size_t size, i;
+
+	size   = fscache.size == 0 ? 1024 : fscache.size * 2;
+	bucket = calloc(size, sizeof(struct fscache_rec *));
+
+	if (bucket == NULL)
+		return;
+
+	for (i = 0; i < fscache.size; ++i) {
+		for (rec = fscache.bucket[i]; rec != NULL; rec = next) {
+			next = rec->next;
+			rec->next = bucket[rec->hash % size];
+			bucket[rec->hash % size] = rec;
+		}
+	}
+
+	free(fscache.bucket);
+	fscache.bucket = bucket;
+	fscache.size   = size;
+}
+
+/*
+ * Put the record to the cache if there's space left. Returns the record
+ * which is cached under the key, it's not the new one if another thread
+ * added it in the meantime.
+ */
+static struct fscache_rec *fscache_add(struct fscache_rec *rec, size_t entries)
+{
+	struct fscache_rec *old;
+
+	rec->cached = false;
+
+	pthread_mutex_lock(&fscache.lock);
+
+	old = fscache_find(rec->type, rec->hash, rec->key);
+
+	if (old != NULL) {
+		pthread_mutex_unlock(&fscache.lock);
+		free(rec);
+		return (old);
+	}
+
+	if (fscache.entries + entries <= fscache.max) {
+		if (fscache.count >= fscache.size)
+			fscache_grow();
+
+		if (fscache.bucket != NULL) {
+			rec->next   = fscache.bucket[rec->hash % fscache.size];
+			rec->cached = true;
+			fscache.bucket[rec->hash % fscache.size] = rec;
+			fscache.count   += 1;
+			fscache.entries += entries;
+		}
+	}
+
+	pthread_mutex_unlock(&fscache.lock);
+
+	return (rec);
+}
+
+static void fscache_rec_release(struct fscache_rec *rec)
+{
+	if (rec != NULL && !rec->cached)
+		free(rec);
+}
+
+static struct fscache_rec *fscache_rec_new(uint8_t type, uint32_t hash, const char *key, size_t extra)
+{
+	struct fscache_rec *rec;
+	size_t keylen = strlen(key);
+
+	rec = malloc(sizeof(struct fscache_rec) + keylen + 1 + extra);
+
+	if (rec == NULL)
+		return (NULL);
+
+	memset(rec, 0, sizeof(struct fscache_rec));
+	rec->hash = hash;
+	rec->type = type;
+	memcpy(rec->key, key, keylen + 1);
+
+	return (rec);
+}
+
+/*
+ * Directory of the entries stat'ed by fscache_walk_build(). It's opened on
+ * the first miss and the entries are stat'ed relative to it, so that the
+ * kernel doesn't resolve the whole path of every entry.
+ */
+struct fscache_dir {
+	const char *path;
+	int fd;       /* -1 = not opened yet, -2 = can't be opened */
+};
+
+static int fscache_dir_lstat(struct fscache_dir *dir, const char *path, const char *name, struct stat *st)
+{
+	if (dir->fd == -1 && (dir->fd = open(dir->path, FSCACHE_DIR_FLAGS)) < 0)
+		dir->fd = -2;
+
+	if (dir->fd < 0)
+		return lstat(path, st);
+
+	return fstatat(dir->fd, name, st, AT_SYMLINK_NOFOLLOW);
+}
+
+static int fscache_getstat(uint8_t type, const char *path, struct fscache_dir *dir, const char *name,
+                           struct stat *st)
+{
+	struct fscache_rec *rec;
+	uint32_t hash;
+	int ret;
+
+	pthread_once(&fscache.once, fscache_init);
+	hash = fscache_hash(type, path);
+
+	pthread_mutex_lock(&fscache.lock);
+	rec = fscache_find(type, hash, path);
+
+	if (rec != NULL) {
+		++fscache.hits;
+
+		if (rec->err == 0)
+			memcpy(st, &rec->u.st, sizeof(struct stat));
+
+		ret = rec->err;
+		pthread_mutex_unlock(&fscache.lock);
+
+		if (ret != 0) {
+			errno = ret;
+			return (-1);
+		}
+
+		return (0);
+	}
+
+	++fscache.misses;
+	pthread_mutex_unlock(&fscache.lock);
+
+	if (type == FSCACHE_STAT)
+		ret = stat(path, st);
+	else if (dir != NULL)
+		ret = fscache_dir_lstat(dir, path, name, st);
+	else
+		ret = lstat(path, st);
+
+	if (fscache.max == 0)
+		return (ret);
+
+	rec = fscache_rec_new(type, hash, path, 0);
+
+	if (rec != NULL) {
+		int err = errno;
+
+		if (ret == 0)
+			memcpy(&rec->u.st, st, sizeof(struct stat));
+		else
+			rec->err = err;
+
+		fscache_rec_release(fscache_add(rec, 1));
+		errno = err;
+	}
+
+	return (ret);
+}
+
+int fscache_lstat(const char *path, struct stat *st)
+{
+	return fscache_getstat(FSCACHE_LSTAT, path, NULL, NULL, st);
+}
+
+/* Only symbolic links need another record, stat() and lstat() agree otherwise. */
+static int fscache_stat(const char *path, struct stat *st)
+{
+	if (fscache_lstat(path, st) != 0)
+		return (-1);
+
+	if (!S_ISLNK(st->st_mode))
+		return (0);
+
+	return fscache_getstat(FSCACHE_STAT, path, NULL, NULL, st);
+}
+
+/*
+ * Get the names in the directory. The record has to be released using
+ * fscache_rec_release(). Returns NULL and sets errno if the directory
+ * can't be opened.
+ */
+static struct fscache_rec *fscache_readdir(const char *path)
+{
+	struct fscache_rec *rec;
+	struct dirent *dp;
+	DIR *dirp;
+	char  *names = NULL, *tmp;
+	size_t count = 0, len = 0, size = 0, namelen;
+	uint32_t hash;
+	int err;
+
+	pthread_once(&fscache.once, fscache_init);
+	hash = fscache_hash(FSCACHE_DIR, path);
+
+	pthread_mutex_lock(&fscache.lock);
+	rec = fscache_find(FSCACHE_DIR, hash, path);
+
+	if (rec != NULL) {
+		++fscache.hits;
+		pthread_mutex_unlock(&fscache.lock);
+
+		if (rec->err != 0) {
+			errno = rec->err;
+			return (NULL);
+		}
+
+		return (rec);
+	}
+
+	++fscache.misses;
+	pthread_mutex_unlock(&fscache.lock);
+
+	dirp = opendir(path);
+
+	if (dirp == NULL) {
+		err = errno;
+
+		if (fscache.max != 0 && (rec = fscache_rec_new(FSCACHE_DIR, hash, path, 0)) != NULL) {
+			rec->err = err;
+			fscache_rec_release(fscache_add(rec, 1));
+		}
+
+		errno = err;
+		return (NULL);
+	}
+
+	while ((dp = readdir(dirp)) != NULL) {
+		if (dp->d_name[0] == '.' && (dp->d_name[1] == '\0' ||
+		    (dp->d_name[1] == '.' && dp->d_name[2] == '\0')))
+			continue;
+
+		namelen = strlen(dp->d_name);
+
+		if (len + namelen + 1 > size) {
+			size = size == 0 ? 1024 : size * 2;
+			while (len + namelen + 1 > size)
+				size *= 2;
+
+			tmp = realloc(names, size);
+
+			if (tmp == NULL)
+				break;
+
+			names = tmp;
+		}
+
+		memcpy(names + len, dp->d_name, namelen + 1);
+		len += namelen + 1;
+		++count;
+	}
+
+	closedir(dirp);
+
+	rec = fscache_rec_new(FSCACHE_DIR, hash, path, len);
+
+	if (rec == NULL) {
+		free(names);
+		errno = ENOMEM;
+		return (NULL);
+	}
+
+	rec->u.dir.count = count;
+	rec->u.dir.names = rec->key + strlen(path) + 1;
+
+	if (len > 0)
+		memcpy(rec->u.dir.names, names, len);
+
+	free(names);
+
+	if (fscache.max == 0)
+		return (rec);
+
+	return fscache_add(rec, 1 + count);
+}
+
+void fscache_stats(size_t *hits, size_t *misses)
+{
+	pthread_mutex_lock(&fscache.lock);
+	*hits   = fscache.hits;
+	*misses = fscache.misses;
+	pthread_mutex_unlock(&fscache.lock);
+}
+
+void fscache_free(void)
+{
+	struct fscache_rec *rec, *next;
+	size_t i;
+
+	pthread_mutex_lock(&fscache.lock);
+
+	for (i = 0; i < fscache.size; ++i) {
+		for (rec = fscache.bucket[i]; rec != NULL; rec = next) {
+			next = rec->next;
+			free(rec);
+		}
+	}
+
+	free(fscache.bucket);
+	fscache.bucket  = NULL;
+	fscache.size    = 0;
+	fscache.count   = 0;
+	fscache.entries = 0;
+
+	pthread_mutex_unlock(&fscache.lock);
+}
+
+/*
+ * Walker
+ */
+struct fscache_frame {
+	FSCACHE_ENT *dir;
+	FSCACHE_ENT *child;
+	size_t count;
+	size_t next;  /* index of the current child */
+	struct fscache_frame *up;
+};
+
+struct fscache_walk {
+	int options;
+	dev_t dev;     /* device of the root */
+	bool done;
+	FSCACHE_ENT *root;
+	FSCACHE_ENT *cur;
+	struct fscache_frame *top;
+};
+
+/*
+ * Same as fts_stat() of the fts implementations. Unless the link is
+ * followed, the entry is looked up relative to dir if it's not NULL.
+ */
+static unsigned short fscache_ent_stat(FSCACHE_ENT *ent, int follow, struct fscache_dir *dir)
+{
+	FSCACHE_ENT *t;
+
+	ent->fts_errno = 0;
+	ent->lstated   = 0;
+
+	if (follow) {
+		if (fscache_stat(ent->fts_path, &ent->st) != 0) {
+			int err = errno;
+
+			if (err == ENOENT && fscache_lstat(ent->fts_path, &ent->st) == 0) {
+				ent->lstated = 1;
+				errno = 0;
+				return (FTS_SLNONE);
+			}
+
+			ent->fts_errno = err;
+			goto err;
+		}
+	} else if (fscache_getstat(FSCACHE_LSTAT, ent->fts_path, dir, ent->fts_name, &ent->st) != 0) {
+		ent->fts_errno = errno;
+	err:
+		memset(&ent->st, 0, sizeof(struct stat));
+		return (FTS_NS);
+	}
+
+	ent->lstated = !follow;
+
+	if (S_ISDIR(ent->st.st_mode)) {
+		/* cycles are found by comparing with the directories above */
+		for (t = ent->parent; t != NULL; t = t->parent) {
+			if (t->st.st_ino == ent->st.st_ino && t->st.st_dev == ent->st.st_dev)
+				return (FTS_DC);
+		}
+
+		return (FTS_D);
+	}
+
+	if (S_ISLNK(ent->st.st_mode))
+		return (FTS_SL);
+	if (S_ISREG(ent->st.st_mode))
+		return (FTS_F);
+
+	return (FTS_DEFAULT);
+}
+
+static void fscache_frame_free(struct fscache_frame *frame)
+{
+	size_t i;
+
+	for (i = 0; i < frame->count; ++i)
+		free(frame->child[i].fts_path);
+
+	free(frame->child);
+	free(frame);
+}
+
+/*
+ * Read the children of the directory and push them on the stack. The
+ * directory becomes FTS_DNR if it can't be read and FTS_DP if it's empty,
+ * nothing is pushed then.
+ */
+static void fscache_walk_build(FSCACHE_WALK *walk, FSCACHE_ENT *dir)
+{
+	struct fscache_frame *frame;
+	struct fscache_rec *rec;
+	struct fscache_dir sdir = { dir->fts_path, -1 };
+	const char *name;
+	size_t base, namelen, i;
+
+	rec = fscache_readdir(dir->fts_path);
+
+	if (rec == NULL) {
+		dir->fts_info  = FTS_DNR;
+		dir->fts_errno = errno;
+		return;
+	}
+
+	if (rec->u.dir.count == 0) {
+		fscache_rec_release(rec);
+		dir->fts_info = FTS_DP;
+		return;
+	}
+
+	frame = malloc(sizeof(struct fscache_frame));
+	if (frame != NULL)
+		frame->child = calloc(rec->u.dir.count, sizeof(FSCACHE_ENT));
+
+	if (frame == NULL || frame->child == NULL) {
+		free(frame);
+		fscache_rec_release(rec);
+		dir->fts_info  = FTS_ERR;
+		dir->fts_errno = ENOMEM;
+		return;
+	}
+
+	frame->dir   = dir;
+	frame->count = 0;
+	frame->next  = 0;
+
+	/* don't double the slash of "/" or of a root given with a trailing one */
+	base = dir->fts_pathlen;
+	if (base > 0 && dir->fts_path[base - 1] == '/')
+		--base;
+
+	name = rec->u.dir.names;
+
+	for (i = 0; i < rec->u.dir.count; ++i, name += namelen + 1) {
+		FSCACHE_ENT *ent = frame->child + frame->count;
+
+		namelen = strlen(name);
+		ent->fts_path = malloc(base + 1 + namelen + 1);
+
+		if (ent->fts_path == NULL)
+			break;
+
+		memcpy(ent->fts_path, dir->fts_path, base);
+		ent->fts_path[base] = '/';
+		memcpy(ent->fts_path + base + 1, name, namelen + 1);
+
+		ent->fts_pathlen = base + 1 + namelen;
+		ent->fts_name    = ent->fts_path + base + 1;
+		ent->fts_namelen = namelen;
+		ent->fts_level   = dir->fts_level + 1;
+		ent->fts_statp   = &ent->st;
+		ent->instr       = FTS_NOINSTR;
+		ent->parent      = dir;
+		ent->fts_info    = fscache_ent_stat(ent, 0, &sdir);
+
+		++frame->count;
+	}
+
+	if (sdir.fd >= 0)
+		close(sdir.fd);
+
+	fscache_rec_release(rec);
+
+	if (frame->count == 0) {
+		fscache_frame_free(frame);
+		dir->fts_info  = FTS_ERR;
+		dir->fts_errno = ENOMEM;
+		return;
+	}
+
+	frame->up = walk->top;
+	walk->top = frame;
+}
+
+FSCACHE_WALK *fscache_walk_open(const char *path, int options)
+{
+	FSCACHE_WALK *walk;
+	FSCACHE_ENT  *root;
+	char *cp;
+
+	if (path == NULL || *path == '\0') {
+		errno = ENOENT;
+		return (NULL);
+	}
+
+	walk = calloc(1, sizeof(FSCACHE_WALK));
+	root = calloc(1, sizeof(FSCACHE_ENT));
+
+	if (walk == NULL || root == NULL || (root->fts_path = strdup(path)) == NULL) {
+		free(walk);
+		free(root);
+		errno = ENOMEM;
+		return (NULL);
+	}
+
+	root->fts_pathlen = strlen(path);
+	root->fts_level   = 0;
+	root->fts_statp   = &root->st;
+	root->instr       = FTS_NOINSTR;
+
+	/* the name of the root is its last component, like in fts_load() */
+	root->fts_name    = root->fts_path;
+	root->fts_namelen = root->fts_pathlen;
+
+	if ((cp = strrchr(root->fts_path, '/')) != NULL && (cp != root->fts_path || cp[1] != '\0')) {
+		root->fts_name    = cp + 1;
+		root->fts_namelen = strlen(cp + 1);
+	}
+
+	root->fts_info = fscache_ent_stat(root, options & FTS_COMFOLLOW, NULL);
+
+	if (root->fts_info == FTS_NS) {
+		errno = root->fts_errno;
+		free(root->fts_path);
+		free(root);
+		free(walk);
+		return (NULL);
+	}
+
+	walk->options = options;
+	walk->dev     = root->st.st_dev;
+	walk->root    = root;
+	errno = 0;
+
+	return (walk);
+}
+
+/* Move to the next sibling or to the post-order visit of the directory. */
+static FSCACHE_ENT *fscache_walk_next(FSCACHE_WALK *walk)
+{
+	struct fscache_frame *frame = walk->top;
+	FSCACHE_ENT *ent;
+
+	if (frame == NULL) {
+		walk->done = true;
+		walk->cur  = NULL;
+		return (NULL);
+	}
+
+	while (++frame->next < frame->count) {
+		ent = frame->child + frame->next;
+
+		if (ent->instr == FTS_SKIP)
+			continue;
+
+		if (ent->instr == FTS_FOLLOW) {
+			ent->fts_info = fscache_ent_stat(ent, 1, NULL);
+			ent->instr    = FTS_NOINSTR;
+		}
+
+		return (walk->cur = ent);
+	}
+
+	ent = frame->dir;
+	walk->top = frame->up;
+	fscache_frame_free(frame);
+
+	ent->fts_info = ent->fts_errno != 0 ? FTS_ERR : FTS_DP;
+
+	return (walk->cur = ent);
+}
+
+FSCACHE_ENT *fscache_walk_read(FSCACHE_WALK *walk)
+{
+	FSCACHE_ENT *ent;
+	int instr;
+
+	if (walk == NULL || walk->done)
+		return (NULL);
+
+	if (walk->cur == NULL)
+		return (walk->cur = walk->root);
+
+	ent   = walk->cur;
+	instr = ent->instr;
+	ent->instr = FTS_NOINSTR;
+
+	if (instr == FTS_AGAIN) {
+		ent->fts_info = fscache_ent_stat(ent, 0, NULL);
+		return (ent);
+	}
+
+	if (instr == FTS_FOLLOW && (ent->fts_info == FTS_SL || ent->fts_info == FTS_SLNONE)) {
+		ent->fts_info = fscache_ent_stat(ent, 1, NULL);
+		return (ent);
+	}
+
+	if (ent->fts_info == FTS_D) {
+		/* skipped or on another device, do the post-order visit */
+		if (instr == FTS_SKIP ||
+		    ((walk->options & FTS_XDEV) && ent->st.st_dev != walk->dev)) {
+			ent->fts_info = FTS_DP;
+			return (ent);
+		}
+
+		fscache_walk_build(walk, ent);
+
+		if (walk->top == NULL || walk->top->dir != ent)
+			return (ent);
+
+		return (walk->cur = walk->top->child);
+	}
+
+	return fscache_walk_next(walk);
+}
+
+int fscache_walk_set(FSCACHE_WALK *walk, FSCACHE_ENT *ent, int instr)
+{
+	(void)walk;
+
+	if (instr != FTS_AGAIN && instr != FTS_FOLLOW &&
+	    instr != FTS_NOINSTR && instr != FTS_SKIP) {
+		errno = EINVAL;
+		return (-1);
+	}
+
+	ent->instr = instr;
+
+	return (0);
+}
+
+const struct stat *fscache_ent_lstat(const FSCACHE_ENT *ent)
+{
+	return (ent->lstated ? &ent->st : NULL);
+}
+
+void fscache_walk_close(FSCACHE_WALK *walk)
+{
+	struct fscache_frame *frame;
+
+	if (walk == NULL)
+		return;
+
+	while ((frame = walk->top) != NULL) {
+		walk->top = frame->up;
+		fscache_frame_free(frame);
+	}
+
+	free(walk->root->fts_path);
+	free(walk->root);
+	free(walk);
+}
@@ -0,0 +1,109 @@
+/**
+ * @file   fscache.h
+ * @brief  session cache of the file system metadata read by oval_fts
+ *
+ * The results of lstat(2), stat(2) and of reading directories are kept for
+ * the lifetime of the probe, i.e. for one OVAL session, so that objects
+ * walking the same trees don't read them again. The walker implements the
+ * subset of fts(3) used by oval_fts on top of the cache.
+ */
+
+/*
+ * Copyright 2016 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FSCACHE_H
+#define FSCACHE_H
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#if defined(__SVR4) && defined(__sun)
+#include "fts_sun.h"
+#else
+#include <fts.h>
+#endif
+
+/*
+ * An entry of the walk. The public fields have the meaning of the FTSENT
+ * fields of the same name, fts_info is one of the FTS_* values.
+ */
+typedef struct fscache_ent {
+	char *fts_path;
+	int fts_pathlen;
+	char *fts_name;
+	int fts_namelen;
+	short fts_level;
+	unsigned short fts_info;
+	int fts_errno;
+	struct stat *fts_statp;
+
+	/* private */
+	struct stat st;
+	int instr;
+	int lstated;  /* st is the lstat() of fts_path */
+	struct fscache_ent *parent;
+} FSCACHE_ENT;
+
+typedef struct fscache_walk FSCACHE_WALK;
+
+/**
+ * Start a walk of the tree rooted at path, like fts_open().
+ * @param options FTS_COMFOLLOW and FTS_XDEV are supported, the walk is
+ *                always physical and it never changes the directory
+ * @return the walk or NULL with errno set if the root can't be stat'ed
+ */
+FSCACHE_WALK *fscache_walk_open(const char *path, int options);
+
+/**
+ * Get the next entry of the walk, like fts_read(). The entry stays valid
+ * until the post-order visit of its parent directory.
+ */
+FSCACHE_ENT *fscache_walk_read(FSCACHE_WALK *walk);
+
+/**
+ * Set FTS_AGAIN, FTS_FOLLOW, FTS_SKIP or FTS_NOINSTR for the next read of
+ * the entry, like fts_set().
+ */
+int fscache_walk_set(FSCACHE_WALK *walk, FSCACHE_ENT *ent, int instr);
+
+void fscache_walk_close(FSCACHE_WALK *walk);
+
+/**
+ * Get the lstat(2) of the entry read by the walk.
+ * @return NULL if the entry was stat'ed following a link or not at all
+ */
+const struct stat *fscache_ent_lstat(const FSCACHE_ENT *ent);
+
+/**
+ * lstat(2) served from the cache.
+ */
+int fscache_lstat(const char *path, struct stat *st);
+
+/**
+ * Get the number of lookups served from the cache and of those which
+ * had to ask the file system.
+ */
+void fscache_stats(size_t *hits, size_t *misses);
+
+/**
+ * Drop the content of the cache.
+ */
+void fscache_free(void);
+
+#endif /* FSCACHE_H */
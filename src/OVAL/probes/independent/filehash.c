@@ -53,7 +53,8 @@
 
 #define FILE_SEPARATOR '/'
 
-static pthread_mutex_t __filehash_probe_mutex;
+/* returned by probe_init() once the crypto API is initialized */
+static int __filehash_probe_ready;
 
 static int mem2hex (uint8_t *mem, size_t mlen, char *str, size_t slen)
 {
@@ -188,33 +189,10 @@ void *probe_init (void)
         if (crapi_init (NULL) != 0)
                 return (NULL);
 
-        /*
-         * Initialize mutex.
-         */
-        switch (pthread_mutex_init (&__filehash_probe_mutex, NULL)) {
-        case 0:
-                return ((void *)&__filehash_probe_mutex);
-        default:
-                dI("Can't initialize mutex: errno=%u, %s.", errno, strerror (errno));
-        }
-
-
-        return (NULL);
-}
-
-void probe_fini (void *arg)
-{
-        _A((void *)arg == (void *)&__filehash_probe_mutex);
-
-        /*
-         * Destroy mutex.
-         */
-        (void) pthread_mutex_destroy (&__filehash_probe_mutex);
-
-        return;
+        return ((void *)&__filehash_probe_ready);
 }
 
-int probe_main (probe_ctx *ctx, void *mutex)
+int probe_main (probe_ctx *ctx, void *arg)
 {
         SEXP_t *path, *filename, *behaviors, *filepath, *probe_in;
 
@@ -222,11 +200,11 @@ int probe_main (probe_ctx *ctx, void *mutex)
 	OVAL_FTSENT *ofts_ent;
 	oval_schema_version_t over;
 
-        if (mutex == NULL) {
+        if (arg == NULL) {
 		return (PROBE_EINIT);
         }
 
-        _A(mutex == &__filehash_probe_mutex);
+        _A(arg == &__filehash_probe_ready);
 
         probe_in  = probe_ctx_getobject(ctx);
 
@@ -248,20 +226,6 @@ int probe_main (probe_ctx *ctx, void *mutex)
 
 	probe_filebehaviors_canonicalize(&behaviors);
 
-        switch (pthread_mutex_lock (&__filehash_probe_mutex)) {
-        case 0:
-                break;
-        default:
-                dI("Can't lock mutex(%p): %u, %s.", &__filehash_probe_mutex, errno, strerror (errno));
-
-		SEXP_free (behaviors);
-		SEXP_free (path);
-		SEXP_free (filename);
-		SEXP_free (filepath);
-
-		return (PROBE_EFATAL);
-        }
-
 	if ((ofts = oval_fts_open(path, filename, filepath, behaviors, probe_ctx_getresult(ctx))) != NULL) {
 		while ((ofts_ent = oval_fts_read(ofts)) != NULL) {
 			filehash_cb(ofts_ent->path, ofts_ent->file, ctx, over);
@@ -276,14 +240,5 @@ int probe_main (probe_ctx *ctx, void *mutex)
         SEXP_free (filename);
         SEXP_free (filepath);
 
-        switch (pthread_mutex_unlock (&__filehash_probe_mutex)) {
-        case 0:
-                break;
-        default:
-                dI("Can't unlock mutex(%p): %u, %s.", &__filehash_probe_mutex, errno, strerror (errno));
-
-		return (PROBE_EFATAL);
-        }
-
 	return 0;
 }
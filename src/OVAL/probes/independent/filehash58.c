@@ -45,18 +45,23 @@
 #include <limits.h>
 #include <pthread.h>
 #include <errno.h>
+#include <unistd.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <crapi/crapi.h>
 #include <probe/probe.h>
 #include <probe/option.h>
 
 #include "common/debug_priv.h"
+#include "common/alloc.h"
 #include "oval_fts.h"
 #include "util.h"
 #include "probe/entcmp.h"
 
 #define FILE_SEPARATOR '/'
 
-static pthread_mutex_t __filehash58_probe_mutex;
+/* returned by probe_init() once the crypto API is initialized */
+static int __filehash58_probe_ready;
 
 #define CRAPI_INVALID -1
 
@@ -103,14 +108,203 @@ static int mem2hex (uint8_t *mem, size_t mlen, char *str, size_t slen)
 	return (0);
 }
 
-static int filehash58_cb (const char *p, const char *f, const char *h, probe_ctx *ctx)
+#define FILEHASH58_ALG_MAX   6  /* number of entries in CRAPI_ALG_MAP */
+#define FILEHASH58_THR_MAX   8  /* maximum number of hashing threads */
+#define FILEHASH58_QUEUE_MUL 4  /* number of queued files per hashing thread */
+
+/*
+ * The set of hash types requested by the object. It doesn't depend
+ * on the file, so it is evaluated only once per object.
+ */
+struct filehash58_algs {
+	int          cnt;
+	crapi_alg_t  alg[FILEHASH58_ALG_MAX];
+	const char  *name[FILEHASH58_ALG_MAX];
+	size_t       size[FILEHASH58_ALG_MAX];
+};
+
+struct filehash58_job {
+	char   *path;
+	char   *file;
+	char    filepath[PATH_MAX+1];
+	bool    done;
+	int     err;  /* errno of a failed open(), 0 otherwise */
+	int     ret;  /* return value of crapi_mdigest_fdv() */
+	uint8_t hash[FILEHASH58_ALG_MAX][64];
+	size_t  hash_len[FILEHASH58_ALG_MAX];
+};
+
+/*
+ * Files found by oval_fts_read() are hashed by a small pool of threads.
+ * Every file is read only once, all requested hash types are computed
+ * in a single pass. The items are collected by the probe thread in the
+ * order in which the files were found, so the result doesn't depend on
+ * the scheduling of the hashing threads.
+ */
+struct filehash58_queue {
+	pthread_mutex_t mutex;
+	pthread_cond_t  work;  /* a job was queued or the queue is closing */
+	pthread_cond_t  done;  /* a job was finished */
+
+	const struct filehash58_algs *algs;
+
+	struct filehash58_job *job;
+	size_t  size;
+	size_t  head; /* the oldest job which wasn't collected yet */
+	size_t  next; /* the next job to be hashed */
+	size_t  tail; /* the next free slot */
+	bool    closing;
+
+	pthread_t thr[FILEHASH58_THR_MAX];
+	int       thr_cnt;
+	int       thr_max;
+	int       idle; /* threads waiting for a job */
+};
+
+static void filehash58_hash(const struct filehash58_algs *algs, struct filehash58_job *job)
+{
+	void   *dst[FILEHASH58_ALG_MAX];
+	size_t *len[FILEHASH58_ALG_MAX];
+	int fd, i;
+
+	fd = open (job->filepath, O_RDONLY);
+
+	if (fd < 0) {
+		job->err = errno;
+		return;
+	}
+
+	for (i = 0; i < algs->cnt; ++i) {
+		job->hash_len[i] = algs->size[i];
+		dst[i] = job->hash[i];
+		len[i] = &job->hash_len[i];
+	}
+
+	job->err = 0;
+	job->ret = crapi_mdigest_fdv (fd, algs->cnt, algs->alg, dst, len);
+
+	close (fd);
+}
+
+static void *filehash58_worker(void *arg)
+{
+	struct filehash58_queue *q = (struct filehash58_queue *)arg;
+	struct filehash58_job   *job;
+
+	pthread_mutex_lock (&q->mutex);
+
+	for (;;) {
+		while (q->next == q->tail && !q->closing) {
+			++q->idle;
+			pthread_cond_wait (&q->work, &q->mutex);
+			--q->idle;
+		}
+
+		if (q->next == q->tail)
+			break;
+
+		job = q->job + (q->next++ % q->size);
+		pthread_mutex_unlock (&q->mutex);
+
+		filehash58_hash (q->algs, job);
+
+		pthread_mutex_lock (&q->mutex);
+		job->done = true;
+		pthread_cond_broadcast (&q->done);
+	}
+
+	pthread_mutex_unlock (&q->mutex);
+
+	return (NULL);
+}
+
+static void filehash58_collect(probe_ctx *ctx, const struct filehash58_algs *algs, struct filehash58_job *job)
 {
 	SEXP_t *itm;
+	char    hash_str[2051];
+	int     i;
+
+	for (i = 0; i < algs->cnt; ++i) {
+		if (job->err != 0) {
+			itm = probe_item_create (OVAL_INDEPENDENT_FILE_HASH58, NULL,
+						"filepath", OVAL_DATATYPE_STRING, job->filepath,
+						"path",     OVAL_DATATYPE_STRING, job->path,
+						"filename", OVAL_DATATYPE_STRING, job->file,
+						"hash_type",OVAL_DATATYPE_STRING, algs->name[i],
+						NULL);
+			probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR,
+				"Can't open \"%s\": errno=%d, %s.", job->filepath, job->err, strerror (job->err));
+			probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
+		} else if (job->ret != 0) {
+			dI("Can't compute the hash values of \"%s\".", job->filepath);
+			return;
+		} else {
+			hash_str[0] = '\0';
+			mem2hex (job->hash[i], job->hash_len[i], hash_str, sizeof hash_str);
+
+			/*
+			 * Create and add the item
+			 */
+			itm = probe_item_create(OVAL_INDEPENDENT_FILE_HASH58, NULL,
+						"filepath", OVAL_DATATYPE_STRING, job->filepath,
+						"path",     OVAL_DATATYPE_STRING, job->path,
+						"filename", OVAL_DATATYPE_STRING, job->file,
+						"hash_type",OVAL_DATATYPE_STRING, algs->name[i],
+						"hash",     OVAL_DATATYPE_STRING, hash_str,
+						NULL);
+
+			if (job->hash_len[i] == 0) {
+				probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR,
+						   "Unable to compute %s hash value of \"%s\".", algs->name[i], job->filepath);
+				probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
+			}
+		}
 
-	char   pbuf[PATH_MAX+1];
-	size_t plen, flen;
+		probe_item_collect(ctx, itm);
+	}
+}
+
+static void filehash58_queue_init(struct filehash58_queue *q, const struct filehash58_algs *algs)
+{
+	long ncpu;
+
+	memset (q, 0, sizeof *q);
+
+	ncpu = sysconf (_SC_NPROCESSORS_ONLN);
+	q->thr_max = ncpu < 1 ? 1 : (ncpu > FILEHASH58_THR_MAX ? FILEHASH58_THR_MAX : (int)ncpu);
+	q->size = q->thr_max * FILEHASH58_QUEUE_MUL;
+	q->job  = oscap_alloc (sizeof (struct filehash58_job) * q->size);
+	q->algs = algs;
+
+	pthread_mutex_init (&q->mutex, NULL);
+	pthread_cond_init (&q->work, NULL);
+	pthread_cond_init (&q->done, NULL);
+}
 
-	int fd;
+/*
+ * Collect the oldest job. Has to be called with the mutex locked.
+ */
+static void filehash58_queue_pop(struct filehash58_queue *q, probe_ctx *ctx)
+{
+	struct filehash58_job *job = q->job + (q->head % q->size);
+
+	while (!job->done)
+		pthread_cond_wait (&q->done, &q->mutex);
+
+	++q->head;
+	pthread_mutex_unlock (&q->mutex);
+
+	filehash58_collect (ctx, q->algs, job);
+	oscap_free (job->path);
+	oscap_free (job->file);
+
+	pthread_mutex_lock (&q->mutex);
+}
+
+static int filehash58_queue_push(struct filehash58_queue *q, probe_ctx *ctx, const char *p, const char *f)
+{
+	struct filehash58_job *job;
+	size_t plen, flen;
 
 	if (f == NULL)
 		return (0);
@@ -124,78 +318,71 @@ static int filehash58_cb (const char *p, const char *f, const char *h, probe_ctx
 	if (plen + flen + 1 > PATH_MAX)
 		return (-1);
 
-	memcpy (pbuf, p, sizeof (char) * plen);
+	pthread_mutex_lock (&q->mutex);
+
+	if (q->tail - q->head == q->size)
+		filehash58_queue_pop (q, ctx);
+
+	job = q->job + (q->tail % q->size);
+
+	memcpy (job->filepath, p, sizeof (char) * plen);
 
 	if (p[plen - 1] != FILE_SEPARATOR) {
-		pbuf[plen] = FILE_SEPARATOR;
+		job->filepath[plen] = FILE_SEPARATOR;
 		++plen;
 	}
 
-	memcpy (pbuf + plen, f, sizeof (char) * flen);
-	pbuf[plen+flen] = '\0';
+	memcpy (job->filepath + plen, f, sizeof (char) * flen);
+	job->filepath[plen+flen] = '\0';
+
+	job->path = oscap_strdup (p);
+	job->file = oscap_strdup (f);
+	job->done = false;
+	job->err  = 0;
+	job->ret  = 0;
+
+	++q->tail;
+
+	/* start another thread if there's no idle one to take the job */
+	if (q->thr_cnt < q->thr_max && q->tail - q->next > (size_t)q->idle) {
+		if (pthread_create (&q->thr[q->thr_cnt], NULL, &filehash58_worker, q) == 0)
+			++q->thr_cnt;
+		else if (q->thr_cnt == 0) {
+			/* hash the file in this thread */
+			++q->next;
+			pthread_mutex_unlock (&q->mutex);
+			filehash58_hash (q->algs, job);
+			pthread_mutex_lock (&q->mutex);
+			job->done = true;
+		}
+	}
 
-	/*
-	 * Open the file
-	 */
-	fd = open (pbuf, O_RDONLY);
+	pthread_cond_signal (&q->work);
+	pthread_mutex_unlock (&q->mutex);
 
-	if (fd < 0) {
-		strerror_r (errno, pbuf, PATH_MAX);
-		pbuf[PATH_MAX] = '\0';
-
-		itm = probe_item_create (OVAL_INDEPENDENT_FILE_HASH58, NULL,
-					"filepath", OVAL_DATATYPE_STRING, pbuf,
-					"path",     OVAL_DATATYPE_STRING, p,
-					"filename", OVAL_DATATYPE_STRING, f,
-					"hash_type",OVAL_DATATYPE_STRING, h,
-					NULL);
-		probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR,
-			"Can't open \"%s\": errno=%d, %s.", pbuf, errno, strerror (errno));
-		probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
-	} else {
-		uint8_t hash_dst[1025];
-		size_t  hash_dstlen = sizeof hash_dst;
-		char    hash_str[2051];
-
-		crapi_alg_t hash_type;
-
-		hash_type = oscap_string_to_enum(CRAPI_ALG_MAP, h);
-		hash_dstlen = oscap_string_to_enum(CRAPI_ALG_MAP_SIZE, h);
-
-		/*
-		 * Compute hash value
-		 */
-		if (crapi_mdigest_fd (fd, 1, hash_type, hash_dst, &hash_dstlen) != 0) {
-			close (fd);
-			return (-1);
-		}
+	return (0);
+}
 
-		close (fd);
+static void filehash58_queue_fini(struct filehash58_queue *q, probe_ctx *ctx)
+{
+	int i;
 
-		hash_str[0] = '\0';
-		mem2hex (hash_dst, hash_dstlen, hash_str, sizeof hash_str);
+	pthread_mutex_lock (&q->mutex);
 
-		/*
-		 * Create and add the item
-		 */
-		itm = probe_item_create(OVAL_INDEPENDENT_FILE_HASH58, NULL,
-					"filepath", OVAL_DATATYPE_STRING, pbuf,
-					"path",     OVAL_DATATYPE_STRING, p,
-					"filename", OVAL_DATATYPE_STRING, f,
-					"hash_type",OVAL_DATATYPE_STRING, h,
-					"hash",     OVAL_DATATYPE_STRING, hash_str,
-					NULL);
+	while (q->head != q->tail)
+		filehash58_queue_pop (q, ctx);
 
-		if (hash_dstlen == 0) {
-			probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR,
-					   "Unable to compute %s hash value of \"%s\".", h, pbuf);
-			probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
-		}
-	}
+	q->closing = true;
+	pthread_cond_broadcast (&q->work);
+	pthread_mutex_unlock (&q->mutex);
 
-	probe_item_collect(ctx, itm);
+	for (i = 0; i < q->thr_cnt; ++i)
+		pthread_join (q->thr[i], NULL);
 
-	return (0);
+	pthread_mutex_destroy (&q->mutex);
+	pthread_cond_destroy (&q->work);
+	pthread_cond_destroy (&q->done);
+	oscap_free (q->job);
 }
 
 void *probe_init (void)
@@ -208,46 +395,27 @@ void *probe_init (void)
 	if (crapi_init (NULL) != 0)
 		return (NULL);
 
-	/*
-	 * Initialize mutex.
-	 */
-	switch (pthread_mutex_init (&__filehash58_probe_mutex, NULL)) {
-	case 0:
-		return ((void *)&__filehash58_probe_mutex);
-	default:
-		dI("Can't initialize mutex: errno=%u, %s.", errno, strerror (errno));
-	}
-
-	return (NULL);
-}
-
-void probe_fini (void *arg)
-{
-	_A((void *)arg == (void *)&__filehash58_probe_mutex);
-
-	/*
-	 * Destroy mutex.
-	 */
-	(void) pthread_mutex_destroy (&__filehash58_probe_mutex);
-
-	return;
+	return ((void *)&__filehash58_probe_ready);
 }
 
-int probe_main(probe_ctx *ctx, void *mutex)
+int probe_main(probe_ctx *ctx, void *arg)
 {
 	SEXP_t *probe_in;
 	SEXP_t *path, *filename, *behaviors, *filepath, *hash_type;
 	char hash_type_str[128];
 	int err = 0;
+	const struct oscap_string_map *alg_p;
+	struct filehash58_algs  algs;
+	struct filehash58_queue queue;
 
 	OVAL_FTS    *ofts;
 	OVAL_FTSENT *ofts_ent;
 
-	if (mutex == NULL) {
+	if (arg == NULL) {
 		return (PROBE_EINIT);
 	}
 
-	_A(mutex == &__filehash58_probe_mutex);
+	_A(arg == &__filehash58_probe_ready);
 
 	probe_in  = probe_ctx_getobject(ctx);
 
@@ -271,32 +439,32 @@ int probe_main(probe_ctx *ctx, void *mutex)
 
 	probe_filebehaviors_canonicalize(&behaviors);
 
-	switch (pthread_mutex_lock (&__filehash58_probe_mutex)) {
-	case 0:
-		break;
-	default:
-		dI("Can't lock mutex(%p): %u, %s.", &__filehash58_probe_mutex, errno, strerror (errno));
+	/* find hash types to compare with entity, think "not satisfy" */
+	algs.cnt = 0;
 
-		err = PROBE_EFATAL;
-		goto cleanup;
+	for (alg_p = CRAPI_ALG_MAP; alg_p->value != CRAPI_INVALID; ++alg_p) {
+		SEXP_t *crapi_hash_type_sexp = SEXP_string_new(alg_p->string, strlen(alg_p->string));
+
+		if (probe_entobj_cmp(hash_type, crapi_hash_type_sexp) == OVAL_RESULT_TRUE) {
+			algs.alg[algs.cnt]  = alg_p->value;
+			algs.name[algs.cnt] = alg_p->string;
+			algs.size[algs.cnt] = oscap_string_to_enum(CRAPI_ALG_MAP_SIZE, alg_p->string);
+			++algs.cnt;
+		}
+
+		SEXP_free(crapi_hash_type_sexp);
 	}
 
-	if ((ofts = oval_fts_open(path, filename, filepath, behaviors, probe_ctx_getresult(ctx))) != NULL) {
+	if (algs.cnt > 0 &&
+	    (ofts = oval_fts_open(path, filename, filepath, behaviors, probe_ctx_getresult(ctx))) != NULL) {
+		filehash58_queue_init(&queue, &algs);
+
 		while ((ofts_ent = oval_fts_read(ofts)) != NULL) {
-			/* find hash types to compare with entity, think "not satisfy" */
-			const struct oscap_string_map *p = CRAPI_ALG_MAP;
-			while (p->value != CRAPI_INVALID) {
-				SEXP_t *crapi_hash_type_sexp = SEXP_string_new(p->string, strlen(p->string));
-				if (probe_entobj_cmp(hash_type, crapi_hash_type_sexp) == OVAL_RESULT_TRUE) {
-					filehash58_cb(ofts_ent->path, ofts_ent->file, p->string, ctx);
-				}
-
-				SEXP_free(crapi_hash_type_sexp);
-				p++;
-			}
+			filehash58_queue_push(&queue, ctx, ofts_ent->path, ofts_ent->file);
 			oval_ftsent_free(ofts_ent);
 		}
 
+		filehash58_queue_fini(&queue, ctx);
 		oval_fts_close(ofts);
 	}
 
@@ -307,14 +475,5 @@ cleanup:
 	SEXP_free (filepath);
         SEXP_free (hash_type);
 
-	switch (pthread_mutex_unlock (&__filehash58_probe_mutex)) {
-	case 0:
-		break;
-	default:
-		dI("Can't unlock mutex(%p): %u, %s.", &__filehash58_probe_mutex, errno, strerror (errno));
-
-		err = PROBE_EFATAL;
-	}
-
 	return err;
 }
@@ -58,119 +58,103 @@
 #include <alloc.h>
 #include "common/assume.h"
 #include "common/debug_priv.h"
+#include "common/util.h"
 
 #define FILE_SEPARATOR '/'
 
 oval_schema_version_t over;
 
-#if defined USE_REGEX_PCRE
-static int get_substrings(char *str, int *ofs, pcre *re, int want_substrs, char ***substrings) {
-	int i, ret, rc;
-	int ovector[60], ovector_len = sizeof (ovector) / sizeof (ovector[0]);
-	char **substrs;
+/*
+ * The matched substrings are returned as pairs of offsets into the
+ * searched buffer (-1 for groups which didn't participate in the match)
+ * so that the text doesn't have to be copied before the item is built.
+ */
+#define TFC54_MAX_SUBSTRS 20
 
-	// todo: max match count check
+#if defined USE_REGEX_PCRE
+static int get_substrings(const char *str, size_t len, int *ofs, pcre *re, pcre_extra *extra, int *spans) {
+	int i, rc, exec_opts = 0;
+	int ovector[3 * TFC54_MAX_SUBSTRS], ovector_len = sizeof (ovector) / sizeof (ovector[0]);
 
 	for (i = 0; i < ovector_len; ++i)
 		ovector[i] = -1;
 
 #if defined(__SVR4) && defined(__sun)
-	rc = pcre_exec(re, NULL, str, strlen(str), *ofs, PCRE_NO_UTF8_CHECK, ovector, ovector_len);
+	exec_opts |= PCRE_NO_UTF8_CHECK;
 #else
-	rc = pcre_exec(re, NULL, str, strlen(str), *ofs, 0, ovector, ovector_len);
+	/*
+	 * pcre_exec() validates the whole subject on every call, which makes
+	 * searching a buffer with many matches quadratic. The buffer doesn't
+	 * change, so check it only on the first call.
+	 */
+	if (*ofs > 0)
+		exec_opts |= PCRE_NO_UTF8_CHECK;
 #endif
+	rc = pcre_exec(re, extra, str, (int)len, *ofs, exec_opts, ovector, ovector_len);
 
 	if (rc < -1) {
-		dE("Function pcre_exec() failed to match a regular expression with return code %d on string '%s'.", rc, str);
+		dE("Function pcre_exec() failed to match a regular expression with return code %d at offset %d.", rc, *ofs);
 		return rc;
 	} else if (rc == -1) {
 		/* no match */
 		return 0;
 	}
 
-	*ofs = (*ofs == ovector[1]) ? ovector[1] + 1 : ovector[1];
+	if (*ofs == ovector[1]) {
+		/* empty match, skip to the next character */
+		*ofs = ovector[1] + 1;
 
-	if (!want_substrs) {
-		/* just report successful match */
-		return 1;
-	}
+		while ((size_t)*ofs < len && (str[*ofs] & 0xc0) == 0x80)
+			++(*ofs);
+	} else
+		*ofs = ovector[1];
 
-	ret = 0;
 	if (rc == 0) {
 		/* vector too small */
 		// todo: report partial results
-		rc = ovector_len / 3;
-	}
-
-	substrs = oscap_alloc(rc * sizeof (char *));
-	for (i = 0; i < rc; ++i) {
-		int len;
-		char *buf;
-
-		if (ovector[2 * i] == -1)
-			continue;
-		len = ovector[2 * i + 1] - ovector[2 * i];
-		buf = oscap_alloc(len + 1);
-		memcpy(buf, str + ovector[2 * i], len);
-		buf[len] = '\0';
-		substrs[ret] = buf;
-		++ret;
+		rc = TFC54_MAX_SUBSTRS;
 	}
 
-	*substrings = substrs;
+	memcpy(spans, ovector, 2 * rc * sizeof(int));
 
-	return ret;
+	return rc;
 }
 #elif defined USE_REGEX_POSIX
-static int get_substrings(char *str, int *ofs, regex_t *re, int want_substrs, char ***substrings) {
-	int i, ret, rc;
-	regmatch_t pmatch[40];
+static int get_substrings(const char *str, size_t len, int *ofs, regex_t *re, int *spans) {
+	int i;
+	regmatch_t pmatch[TFC54_MAX_SUBSTRS];
 	int pmatch_len = sizeof (pmatch) / sizeof (pmatch[0]);
-	char **substrs;
 
-	rc = regexec(re, str + *ofs, pmatch_len, pmatch, 0);
-	if (rc == REG_NOMATCH) {
+	(void)len;
+
+	if (regexec(re, str + *ofs, pmatch_len, pmatch, 0) == REG_NOMATCH) {
 		/* no match */
 		return 0;
 	}
 
-	*ofs += (0 == pmatch[0].rm_eo) ? 1 : pmatch[0].rm_eo;
-
-	if (!want_substrs) {
-		/* just report successful match */
-		return 1;
-	}
-
-	ret = 0;
-	substrs = oscap_alloc(pmatch_len * sizeof (char *));
+	/* the offsets are relative to the start of the searched string */
 	for (i = 0; i < pmatch_len; ++i) {
-		int len;
-		char *buf;
-
-		if (pmatch[i].rm_so == -1)
-			continue;
-		len = pmatch[i].rm_eo - pmatch[i].rm_so;
-		buf = oscap_alloc(len + 1);
-		memcpy(buf, str + pmatch[i].rm_so, len);
-		buf[len] = '\0';
-		substrs[ret] = buf;
-		++ret;
+		if (pmatch[i].rm_so == -1) {
+			spans[2 * i] = spans[2 * i + 1] = -1;
+		} else {
+			spans[2 * i]     = *ofs + pmatch[i].rm_so;
+			spans[2 * i + 1] = *ofs + pmatch[i].rm_eo;
+		}
 	}
 
-	*substrings = substrs;
+	*ofs += (0 == pmatch[0].rm_eo) ? 1 : pmatch[0].rm_eo;
 
-	return ret;
+	return pmatch_len;
 }
 #endif
 
 static SEXP_t *create_item(const char *path, const char *filename, char *pattern,
-			   int instance, char **substrs, int substr_cnt)
+			   int instance, const char *buf, const int *spans, int span_cnt)
 {
 	int i;
 	SEXP_t *item;
 	SEXP_t *r0;
-	SEXP_t *se_instance, *se_filepath;
-	char *text;
+	SEXP_t *se_instance, *se_filepath, *se_text;
 
         if (strlen(path) + strlen(filename) + 1 > PATH_MAX) {
                 dE("path+filename too long");
@@ -178,10 +162,9 @@ static SEXP_t *create_item(const char *path, const char *filename, char *pattern
         }
 
 	if (oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.4)) < 0) {
-		pattern = text = NULL;
+		pattern = NULL;
 		se_instance = NULL;
 	} else {
-		text = substrs[0];
 		se_instance = SEXP_number_newu_64((int64_t) instance);
 	}
 	if (oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.6)) < 0) {
@@ -190,6 +173,8 @@ static SEXP_t *create_item(const char *path, const char *filename, char *pattern
 		se_filepath = SEXP_string_newf("%s%c%s", path, FILE_SEPARATOR, filename);
 	}
 
+	se_text = SEXP_string_new(buf + spans[0], spans[1] - spans[0]);
+
         item = probe_item_create(OVAL_INDEPENDENT_TEXT_FILE_CONTENT, NULL,
                                  "filepath", OVAL_DATATYPE_SEXP, se_filepath,
                                  "path",     OVAL_DATATYPE_STRING, path,
@@ -197,11 +182,18 @@ static SEXP_t *create_item(const char *path, const char *filename, char *pattern
                                  "pattern",  OVAL_DATATYPE_STRING, pattern,
                                  "instance", OVAL_DATATYPE_SEXP, se_instance,
                                  "line",     OVAL_DATATYPE_STRING, pattern,
-                                 "text",     OVAL_DATATYPE_STRING, substrs[0],
+                                 "text",     OVAL_DATATYPE_SEXP, se_text,
                                  NULL);
 
-	for (i = 1; i < substr_cnt; ++i) {
-                probe_item_ent_add (item, "subexpression", NULL, r0 = SEXP_string_new (substrs[i], strlen (substrs[i])));
+	SEXP_free(se_text);
+	SEXP_free(se_instance);
+	SEXP_free(se_filepath);
+
+	for (i = 1; i < span_cnt; ++i) {
+		if (spans[2 * i] == -1)
+			continue;
+                probe_item_ent_add (item, "subexpression", NULL,
+				    r0 = SEXP_string_new (buf + spans[2 * i], spans[2 * i + 1] - spans[2 * i]));
                 SEXP_free (r0);
 	}
 
@@ -215,16 +207,82 @@ struct pfdata {
         probe_ctx *ctx;
 #if defined USE_REGEX_PCRE
 	pcre *compiled_regex;
+	pcre_extra *regex_extra;
 #elif defined USE_REGEX_POSIX
 	regex_t *compiled_regex;
 #endif
 };
 
+#define TFC54_READ_CHUNK (64 * 1024)
+#define TFC54_READ_PROBE 256
+
+/*
+ * Read the whole file into a NUL-terminated buffer. The size reported by
+ * stat() is used to read a regular file at once, files which don't report
+ * their size (e.g. in /proc) or which grow while being read are read in
+ * chunks of increasing size. When the buffer is full, the end of the file
+ * is checked with a small read so that the buffer isn't grown in vain.
+ */
+static char *read_file(int fd, const struct stat *st, size_t *len)
+{
+	char   *buf, probe[TFC54_READ_PROBE];
+	size_t  buf_size, buf_used = 0;
+	ssize_t ret;
+
+	buf_size = st->st_size > 0 ? (size_t)st->st_size + 1 : TFC54_READ_CHUNK;
+	buf = oscap_alloc(buf_size);
+
+	for (;;) {
+		if (buf_used == buf_size - 1) {
+			ret = read(fd, probe, sizeof probe);
+
+			if (ret == -1) {
+				if (errno == EINTR)
+					continue;
+				break;
+			}
+			if (ret == 0)
+				break;
+
+			buf_size += buf_size < TFC54_READ_CHUNK ? TFC54_READ_CHUNK : buf_size;
+			buf = oscap_realloc(buf, buf_size);
+			memcpy(buf + buf_used, probe, ret);
+			buf_used += ret;
+			continue;
+		}
+
+		ret = read(fd, buf + buf_used, buf_size - buf_used - 1);
+
+		if (ret == -1) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		if (ret == 0)
+			break;
+
+		buf_used += ret;
+	}
+
+	if (ret == -1) {
+		protect_errno {
+			oscap_free(buf);
+		}
+		return (NULL);
+	}
+
+	buf[buf_used] = '\0';
+	*len = buf_used;
+
+	return (buf);
+}
+
 static int process_file(const char *path, const char *file, void *arg)
 {
 	struct pfdata *pfd = (struct pfdata *) arg;
-	int ret = 0, path_len, file_len, cur_inst = 0, fd = -1, substr_cnt,
-		buf_size = 0, buf_used = 0, ofs = 0, buf_inc = 4096;
+	int ret = 0, path_len, file_len, cur_inst = 0, fd = -1, substr_cnt, ofs = 0;
+	int spans[2 * TFC54_MAX_SUBSTRS];
+	size_t buf_len = 0;
 	char *whole_path = NULL, *buf = NULL;
 	SEXP_t *next_inst = NULL;
 	struct stat st;
@@ -271,29 +329,30 @@ static int process_file(const char *path, const char *file, void *arg)
 		goto cleanup;
 	}
 
-	do {
-		buf_size += buf_inc;
-		buf = oscap_realloc(buf, buf_size);
-		ret = read(fd, buf + buf_used, buf_inc);
-		if (ret == -1) {
-			SEXP_t *msg;
+	buf = read_file(fd, &st, &buf_len);
+	if (buf == NULL) {
+		SEXP_t *msg;
 
-			msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "read(): '%s' %s.", whole_path, strerror(errno));
-			probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
-			SEXP_free(msg);
-			probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
-			ret = -2;
-			goto cleanup;
-		}
-		buf_used += ret;
-	} while (ret == buf_inc);
+		msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "read(): '%s' %s.", whole_path, strerror(errno));
+		probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
+		SEXP_free(msg);
+		probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
+		ret = -2;
+		goto cleanup;
+	}
 
-	if (buf_used == buf_size)
-		buf = realloc(buf, ++buf_size);
-	buf[buf_used++] = '\0';
+	if (buf_len > INT_MAX) {
+		SEXP_t *msg;
+
+		msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "File '%s' is too large.", whole_path);
+		probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
+		SEXP_free(msg);
+		probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
+		ret = -2;
+		goto cleanup;
+	}
 
 	do {
-		char **substrs;
 		int want_instance;
 
 		next_inst = SEXP_number_newi_32(cur_inst + 1);
@@ -304,7 +363,11 @@ static int process_file(const char *path, const char *file, void *arg)
 			want_instance = 0;
 
 		SEXP_free(next_inst);
-		substr_cnt = get_substrings(buf, &ofs, pfd->compiled_regex, want_instance, &substrs);
+#if defined USE_REGEX_PCRE
+		substr_cnt = get_substrings(buf, buf_len, &ofs, pfd->compiled_regex, pfd->regex_extra, spans);
+#elif defined USE_REGEX_POSIX
+		substr_cnt = get_substrings(buf, buf_len, &ofs, pfd->compiled_regex, spans);
+#endif
 
 		if (substr_cnt < 0) {
 			SEXP_t *msg;
@@ -322,20 +385,15 @@ static int process_file(const char *path, const char *file, void *arg)
 			++cur_inst;
 
 			if (want_instance) {
-				int k;
 				SEXP_t *item;
 
 				item = create_item(path, file, pfd->pattern,
-						   cur_inst, substrs, substr_cnt);
+						   cur_inst, buf, spans, substr_cnt);
 
                                 probe_item_collect(pfd->ctx, item);
-
-				for (k = 0; k < substr_cnt; ++k)
-					oscap_free(substrs[k]);
-				oscap_free(substrs);
 			}
 		}
-	} while (substr_cnt > 0 && ofs < buf_used);
+	} while (substr_cnt > 0 && (size_t)ofs <= buf_len);
 
  cleanup:
 	if (fd != -1)
@@ -463,6 +521,11 @@ int probe_main(probe_ctx *ctx, void *arg)
 		probe_cobj_set_flag(probe_ctx_getresult(pfd.ctx), SYSCHAR_FLAG_ERROR);
 		goto cleanup;
 	}
+
+	/* the same pattern is usually matched many times in many files */
+	pfd.regex_extra = pcre_study(pfd.compiled_regex, 0, &error);
+	if (pfd.regex_extra == NULL && error != NULL)
+		dW("pcre_study() '%s' %s.", pfd.pattern, error);
 #elif defined USE_REGEX_POSIX
 	pfd.re_opts = REG_EXTENDED | REG_NEWLINE;
 	r0 = probe_ent_getattrval(bh_ent, "ignore_case");
@@ -505,6 +568,8 @@ int probe_main(probe_ctx *ctx, void *arg)
 	if (pfd.pattern != NULL)
 		oscap_free(pfd.pattern);
 #if defined USE_REGEX_PCRE
+	if (pfd.regex_extra != NULL)
+		pcre_free_study(pfd.regex_extra);
 	if (pfd.compiled_regex != NULL)
 		pcre_free(pfd.compiled_regex);
 #elif defined USE_REGEX_POSIX
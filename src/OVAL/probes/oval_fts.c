@@ -27,7 +27,9 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <limits.h>
@@ -43,20 +45,81 @@
 #include "debug_priv.h"
 #include "oval_fts.h"
 #if defined(__SVR4) && defined(__sun)
-#include "fts_sun.h"
 #include <sys/mntent.h>
 #include <libzonecfg.h>
 #include <sys/avl.h>
-#else
-#include <fts.h>
 #endif
 
 #undef OSCAP_FTS_DEBUG
 
+/*
+ * Number of trees the workers of the probe may walk at the same time, set
+ * by OSCAP_PROBE_FS_WALKS. 0 means that only the number of the workers
+ * limits the walks.
+ */
+static pthread_once_t  __walk_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t __walk_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  __walk_done = PTHREAD_COND_INITIALIZER;
+static unsigned int    __walk_max  = 0;
+static unsigned int    __walk_cnt  = 0;
+
+static void walk_limit_init(void)
+{
+#if defined(__SVR4) && defined(__sun)
+	/* the list of the zone paths is shared by the walks */
+	__walk_max = 1;
+#else
+	char *str, *end;
+	long  max;
+
+	str = getenv("OSCAP_PROBE_FS_WALKS");
+
+	if (str == NULL)
+		return;
+
+	errno = 0;
+	max   = strtol(str, &end, 10);
+
+	if (errno != 0 || *end != '\0' || max < 0 || max > UINT_MAX) {
+		dW("Invalid value of OSCAP_PROBE_FS_WALKS: \"%s\"", str);
+		return;
+	}
+
+	__walk_max = (unsigned int)max;
+#endif
+}
+
+static void walk_acquire(void)
+{
+	pthread_once(&__walk_once, walk_limit_init);
+
+	if (__walk_max == 0)
+		return;
+
+	pthread_mutex_lock(&__walk_lock);
+	while (__walk_cnt >= __walk_max)
+		pthread_cond_wait(&__walk_done, &__walk_lock);
+	++__walk_cnt;
+	pthread_mutex_unlock(&__walk_lock);
+}
+
+static void walk_release(void)
+{
+	if (__walk_max == 0)
+		return;
+
+	pthread_mutex_lock(&__walk_lock);
+	--__walk_cnt;
+	pthread_cond_signal(&__walk_done);
+	pthread_mutex_unlock(&__walk_lock);
+}
+
 static OVAL_FTS *OVAL_FTS_new()
 {
 	OVAL_FTS *ofts;
 
+	walk_acquire();
+
 	ofts = oscap_talloc(OVAL_FTS);
 	memset(ofts, 0, sizeof(*ofts));
 
@@ -70,11 +133,12 @@ static OVAL_FTS *OVAL_FTS_new()
 static void OVAL_FTS_free(OVAL_FTS *ofts)
 {
 	if (ofts->ofts_match_path_fts != NULL)
-		fts_close(ofts->ofts_match_path_fts);
+		fscache_walk_close(ofts->ofts_match_path_fts);
 	if (ofts->ofts_recurse_path_fts != NULL)
-		fts_close(ofts->ofts_recurse_path_fts);
+		fscache_walk_close(ofts->ofts_recurse_path_fts);
 
 	oscap_free(ofts);
+	walk_release();
 	return;
 }
 
@@ -93,13 +157,19 @@ static int pathlen_from_ftse(int fts_pathlen, int fts_namelen)
 	return pathlen;
 }
 
-static OVAL_FTSENT *OVAL_FTSENT_new(OVAL_FTS *ofts, FTSENT *fts_ent)
+static OVAL_FTSENT *OVAL_FTSENT_new(OVAL_FTS *ofts, FSCACHE_ENT *fts_ent)
 {
 	OVAL_FTSENT *ofts_ent;
+	const struct stat *st;
 
 	ofts_ent = oscap_talloc(OVAL_FTSENT);
 
 	ofts_ent->fts_info = fts_ent->fts_info;
+	st = fscache_ent_lstat(fts_ent);
+	ofts_ent->st_valid = st != NULL;
+	if (st != NULL)
+		ofts_ent->st = *st;
+
 	if (ofts->ofts_sfilename || ofts->ofts_sfilepath) {
 		ofts_ent->path_len = pathlen_from_ftse(fts_ent->fts_pathlen, fts_ent->fts_namelen);
 		ofts_ent->path = oscap_alloc(ofts_ent->path_len + 1);
@@ -808,7 +878,7 @@ OVAL_FTS *oval_fts_open(SEXP_t *path, SEXP_t *filename, SEXP_t *filepath, SEXP_t
 
 	/* Fail if the provided path doensn't actually exist. Symlinks
 	   without targets are accepted. */
-	if (lstat(paths[0], &st) == -1) {
+	if (fscache_lstat(paths[0], &st) == -1) {
 		if (errno) {
 			dE("lstat() failed: errno: %d, '%s'.",
 			   errno, strerror(errno));
@@ -820,14 +890,10 @@ OVAL_FTS *oval_fts_open(SEXP_t *path, SEXP_t *filename, SEXP_t *filepath, SEXP_t
 	dI("Opening file '%s'.", paths[0]);
 
 	ofts = OVAL_FTS_new();
-	/* reset errno as fts_open() doesn't do it itself. */
-	errno = 0;
-	ofts->ofts_match_path_fts = fts_open((char * const *) paths, mtc_fts_options, NULL);
+	ofts->ofts_match_path_fts = fscache_walk_open(paths[0], mtc_fts_options);
 	free((void *) paths[0]);
-	/* fts_open() doesn't return NULL for all errors (e.g. nonexistent paths),
-	   so check errno to detect it. Far from being perfect. */
-	if (ofts->ofts_match_path_fts == NULL || errno != 0) {
-		dE("fts_open() failed, errno: %d \"%s\".", errno, strerror(errno));
+	if (ofts->ofts_match_path_fts == NULL) {
+		dE("fscache_walk_open() failed, errno: %d \"%s\".", errno, strerror(errno));
 		OVAL_FTS_free(ofts);
 		return (NULL);
 	}
@@ -848,22 +914,18 @@ OVAL_FTS *oval_fts_open(SEXP_t *path, SEXP_t *filename, SEXP_t *filepath, SEXP_t
 		ofts->localdevs = fsdev_init(NULL, 0);
 		if (ofts->localdevs == NULL) {
 			dE("fsdev_init() failed.");
-			/* One dummy read to get rid of an uninitialized
-			 * value in the FTS data before calling
-			 * fts_close() on it. */
-			fts_read(ofts->ofts_match_path_fts);
 			oval_fts_close(ofts);
 			return (NULL);
 		}
 #endif
 	} else if (filesystem == OVAL_RECURSE_FS_DEFINED) {
 		/* store the device id for future comparison */
-		FTSENT *fts_ent;
+		FSCACHE_ENT *fts_ent;
 
-		fts_ent = fts_read(ofts->ofts_match_path_fts);
+		fts_ent = fscache_walk_read(ofts->ofts_match_path_fts);
 		if (fts_ent != NULL) {
 			ofts->ofts_recurse_path_devid = fts_ent->fts_statp->st_dev;
-			fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_AGAIN);
+			fscache_walk_set(ofts->ofts_match_path_fts, fts_ent, FTS_AGAIN);
 		}
 	}
 
@@ -893,7 +955,7 @@ OVAL_FTS *oval_fts_open(SEXP_t *path, SEXP_t *filename, SEXP_t *filepath, SEXP_t
 	return (ofts);
 }
 
-static inline int _oval_fts_is_local(OVAL_FTS *ofts, FTSENT *fts_ent) {
+static inline int _oval_fts_is_local(OVAL_FTS *ofts, FSCACHE_ENT *fts_ent) {
 # if defined (__SVR4) && defined(__sun)
 	/* pseudo filesystems will be skipped */
 	/* don't recurse into remote fs if local is specified */
@@ -912,15 +974,15 @@ static inline int _oval_fts_is_local(OVAL_FTS *ofts, FTSENT *fts_ent) {
 }
 
 /* find the first matching path or filepath */
-static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
+static FSCACHE_ENT *oval_fts_read_match_path(OVAL_FTS *ofts)
 {
-	FTSENT *fts_ent = NULL;
+	FSCACHE_ENT *fts_ent = NULL;
 	SEXP_t *stmp;
 	oval_result_t ores;
 
 	/* iterate until a match is found or all elements have been traversed */
 	for (;;) {
-		fts_ent = fts_read(ofts->ofts_match_path_fts);
+		fts_ent = fscache_walk_read(ofts->ofts_match_path_fts);
 		if (fts_ent == NULL)
 			return NULL;
 		switch (fts_ent->fts_info) {
@@ -928,7 +990,7 @@ static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
 			continue;
 		case FTS_DC:
 			dW("Filesystem tree cycle detected at '%s'.", fts_ent->fts_path);
-			fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
+			fscache_walk_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
 			continue;
 		}
 
@@ -943,19 +1005,19 @@ static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
 #if defined(OSCAP_FTS_DEBUG)
 			dI("Only the target of a symlink gets reported, skipping '%s'.", fts_ent->fts_path, fts_ent->fts_name);
 #endif
-			fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_FOLLOW);
+			fscache_walk_set(ofts->ofts_match_path_fts, fts_ent, FTS_FOLLOW);
 			continue;
 		}
 		if (_oval_fts_is_local(ofts, fts_ent)) {
 			dI("Don't recurse into non-local filesystems, skipping '%s'.", fts_ent->fts_path);
-			fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+			fscache_walk_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 			continue;
 		}
 		/* don't recurse beyond the initial filesystem */
 		if (ofts->filesystem == OVAL_RECURSE_FS_DEFINED
 		    && (fts_ent->fts_info == FTS_D || fts_ent->fts_info == FTS_SL)
 		    && ofts->ofts_recurse_path_devid != fts_ent->fts_statp->st_dev) {
-			fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+			fscache_walk_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 			continue;
 		}
 
@@ -970,7 +1032,7 @@ static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
 				switch (ret) {
 				case PCRE_ERROR_NOMATCH:
 					dD("Partial match optimization: PCRE_ERROR_NOMATCH, skipping.");
-					fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
+					fscache_walk_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
 					continue;
 				case PCRE_ERROR_PARTIAL:
 					dD("Partial match optimization: PCRE_ERROR_PARTIAL, continuing.");
@@ -1009,16 +1071,16 @@ static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
 	    ofts->ofts_sfilename == NULL &&
 	    ofts->ofts_sfilepath == NULL)
 	{
-		fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
+		fscache_walk_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
 	}
 
 	return fts_ent;
 }
 
 /* find the first matching file or directory */
-static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
+static FSCACHE_ENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 {
-	FTSENT *out_fts_ent = NULL;
+	FSCACHE_ENT *out_fts_ent = NULL;
 	/* the condition below is correct because ofts_sfilepath is NULL here */
 	bool collect_dirs = (ofts->ofts_sfilename == NULL);
 
@@ -1036,41 +1098,32 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 
 		/* initialize separate fts for recursion */
 		if (ofts->ofts_recurse_path_fts == NULL) {
-			char * const paths[2] = { ofts->ofts_match_path_fts_ent->fts_path, NULL };
+			const char *path = ofts->ofts_match_path_fts_ent->fts_path;
 
 #if defined(OSCAP_FTS_DEBUG)
-			dI("fts_open args: path: \"%s\", options: %d.",
-				paths[0], ofts->ofts_recurse_path_fts_opts);
+			dI("fscache_walk_open args: path: \"%s\", options: %d.",
+				path, ofts->ofts_recurse_path_fts_opts);
 #endif
-			/* reset errno as fts_open() doesn't do it itself. */
-			errno = 0;
-			ofts->ofts_recurse_path_fts = fts_open(paths,
-				ofts->ofts_recurse_path_fts_opts, NULL);
-			/* fts_open() doesn't return NULL for all errors
-			   (e.g. nonexistent paths), so check errno to detect it.
-			   Far from being perfect. */
-			if (ofts->ofts_recurse_path_fts == NULL || errno != 0) {
-				dE("fts_open() failed, errno: %d \"%s\".",
+			ofts->ofts_recurse_path_fts = fscache_walk_open(path,
+				ofts->ofts_recurse_path_fts_opts);
+			if (ofts->ofts_recurse_path_fts == NULL) {
+				dE("fscache_walk_open() failed, errno: %d \"%s\".",
 					errno, strerror(errno));
 #if !defined(OSCAP_FTS_DEBUG)
-				dE("fts_open args: path: \"%s\", options: %d.",
-					paths[0], ofts->ofts_recurse_path_fts_opts);
+				dE("fscache_walk_open args: path: \"%s\", options: %d.",
+					path, ofts->ofts_recurse_path_fts_opts);
 #endif
-				if (ofts->ofts_recurse_path_fts != NULL) {
-					fts_close(ofts->ofts_recurse_path_fts);
-					ofts->ofts_recurse_path_fts = NULL;
-				}
 				return (NULL);
 			}
 		}
 
 		/* iterate until a match is found or all elements have been traversed */
 		while (out_fts_ent == NULL) {
-			FTSENT *fts_ent;
+			FSCACHE_ENT *fts_ent;
 
-			fts_ent = fts_read(ofts->ofts_recurse_path_fts);
+			fts_ent = fscache_walk_read(ofts->ofts_recurse_path_fts);
 			if (fts_ent == NULL) {
-				fts_close(ofts->ofts_recurse_path_fts);
+				fscache_walk_close(ofts->ofts_recurse_path_fts);
 				ofts->ofts_recurse_path_fts = NULL;
 
 				return NULL;
@@ -1081,7 +1134,7 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 				continue;
 			case FTS_DC:
 				dW("Filesystem tree cycle detected at '%s'.", fts_ent->fts_path);
-				fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+				fscache_walk_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 				continue;
 			}
 
@@ -1124,7 +1177,7 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 				/* limit recursion depth */
 				if (ofts->direction == OVAL_RECURSE_DIRECTION_NONE
 				    || (ofts->max_depth != -1 && fts_ent->fts_level > ofts->max_depth)) {
-					fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+					fscache_walk_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 					continue;
 				}
 
@@ -1132,30 +1185,30 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 				switch (fts_ent->fts_info) {
 				case FTS_D:
 					if (!(ofts->recurse & OVAL_RECURSE_DIRS)) {
-						fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+						fscache_walk_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 						continue;
 					}
 					break;
 				case FTS_SL:
 					if (!(ofts->recurse & OVAL_RECURSE_SYMLINKS)) {
-						fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+						fscache_walk_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 						continue;
 					}
-					fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_FOLLOW);
+					fscache_walk_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_FOLLOW);
 					break;
 				default:
 					continue;
 				}
 			}
 			if (_oval_fts_is_local(ofts, fts_ent)) {
-				fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+				fscache_walk_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 				continue;
 			}
 			/* don't recurse beyond the initial filesystem */
 			if (ofts->filesystem == OVAL_RECURSE_FS_DEFINED
 			    && (fts_ent->fts_info == FTS_D || fts_ent->fts_info == FTS_SL)
 			    && ofts->ofts_recurse_path_devid != fts_ent->fts_statp->st_dev) {
-				fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+				fscache_walk_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 				continue;
 			}
 		}
@@ -1171,39 +1224,30 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 		while (ofts->max_depth == -1 || ofts->ofts_recurse_path_curdepth <= ofts->max_depth) {
 			/* initialize separate fts for recursion */
 			if (ofts->ofts_recurse_path_fts == NULL) {
-				char * const paths[2] = { ofts->ofts_recurse_path_curpth, NULL };
+				const char *path = ofts->ofts_recurse_path_curpth;
 
 #if defined(OSCAP_FTS_DEBUG)
-				dI("fts_open args: path: \"%s\", options: %d.",
-					paths[0], ofts->ofts_recurse_path_fts_opts);
+				dI("fscache_walk_open args: path: \"%s\", options: %d.",
+					path, ofts->ofts_recurse_path_fts_opts);
 #endif
-				/* reset errno as fts_open() doesn't do it itself. */
-				errno = 0;
-				/* fts_open() doesn't return NULL for all errors
-				   (e.g. nonexistent paths), so check errno to
-				   detect it. Far from being perfect. */
-				ofts->ofts_recurse_path_fts = fts_open(paths,
-					ofts->ofts_recurse_path_fts_opts, NULL);
-				if (ofts->ofts_recurse_path_fts == NULL || errno != 0) {
-					dE("fts_open() failed, errno: %d \"%s\".",
+				ofts->ofts_recurse_path_fts = fscache_walk_open(path,
+					ofts->ofts_recurse_path_fts_opts);
+				if (ofts->ofts_recurse_path_fts == NULL) {
+					dE("fscache_walk_open() failed, errno: %d \"%s\".",
 						errno, strerror(errno));
 #if !defined(OSCAP_FTS_DEBUG)
-					dE("fts_open args: path: \"%s\", options: %d.",
-						paths[0], ofts->ofts_recurse_path_fts_opts);
+					dE("fscache_walk_open args: path: \"%s\", options: %d.",
+						path, ofts->ofts_recurse_path_fts_opts);
 #endif
-					if (ofts->ofts_recurse_path_fts != NULL) {
-						fts_close(ofts->ofts_recurse_path_fts);
-						ofts->ofts_recurse_path_fts = NULL;
-					}
 					return (NULL);
 				}
 			}
 
 			/* iterate until a match is found or all elements have been traversed */
 			while (out_fts_ent == NULL) {
-				FTSENT *fts_ent;
+				FSCACHE_ENT *fts_ent;
 
-				fts_ent = fts_read(ofts->ofts_recurse_path_fts);
+				fts_ent = fscache_walk_read(ofts->ofts_recurse_path_fts);
 				if (fts_ent == NULL)
 					break;
 
@@ -1237,7 +1281,7 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 					/* only fts root is collected */
 					if (fts_ent->fts_level == 0 && fts_ent->fts_info == FTS_D) {
 						out_fts_ent = fts_ent;
-						fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+						fscache_walk_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 						break;
 					}
 				} else {
@@ -1252,16 +1296,16 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 				}
 
 				if (fts_ent->fts_info == FTS_SL)
-					fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_FOLLOW);
+					fscache_walk_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_FOLLOW);
 				/* limit recursion only to fts root */
 				else if (fts_ent->fts_level > 0)
-					fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+					fscache_walk_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 			}
 
 			if (out_fts_ent != NULL)
 				break;
 
-			fts_close(ofts->ofts_recurse_path_fts);
+			fscache_walk_close(ofts->ofts_recurse_path_fts);
 			ofts->ofts_recurse_path_fts = NULL;
 
 			if (!strcmp(ofts->ofts_recurse_path_curpth, "/"))
@@ -1284,7 +1328,7 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 
 OVAL_FTSENT *oval_fts_read(OVAL_FTS *ofts)
 {
-	FTSENT *fts_ent;
+	FSCACHE_ENT *fts_ent;
 
 #if defined(OSCAP_FTS_DEBUG)
 	dI("ofts: %p.", ofts);
@@ -1345,10 +1389,10 @@ int oval_fts_close(OVAL_FTS *ofts)
 
 	fsdev_free(ofts->localdevs);
 
-	OVAL_FTS_free(ofts);
 #if defined(__SVR4) && defined(__sun)
 	free_zones_path_list();
 #endif
+	OVAL_FTS_free(ofts);
 
 	return (0);
 }
@@ -23,13 +23,9 @@
 #define OVAL_FTS_H
 
 #include <sexp.h>
-#if defined(__SVR4) && defined(__sun)
-#include "fts_sun.h"
-#else
-#include <fts.h>
-#endif
 #include <pcre.h>
 #include "fsdev.h"
+#include "fscache.h"
 
 #define ENT_GET_AREF(ent, dst, attr_name, mandatory)			\
 	do {								\
@@ -66,10 +62,10 @@
 
 typedef struct {
 	/* oval_fts_read_match_path() state */
-	FTS *ofts_match_path_fts;
-	FTSENT *ofts_match_path_fts_ent;
+	FSCACHE_WALK *ofts_match_path_fts;
+	FSCACHE_ENT *ofts_match_path_fts_ent;
 	/* oval_fts_read_recurse_path() state */
-	FTS *ofts_recurse_path_fts;
+	FSCACHE_WALK *ofts_recurse_path_fts;
 	int ofts_recurse_path_fts_opts;
 	int ofts_recurse_path_curdepth;
 	char *ofts_recurse_path_pthcpy;
@@ -114,6 +110,8 @@ typedef struct {
 	char *path;
 	size_t path_len;
 	unsigned int fts_info;
+	int st_valid;       /* st holds the lstat() of the entry read by the walk */
+	struct stat st;
 } OVAL_FTSENT;
 
 /*
@@ -106,7 +106,7 @@ SEXP_t *probe_item_new(const char *name, SEXP_t * attrs)
 
         /*
          * Allocate space for the ID which will be generated
-         * in the icache worker
+         * when the item is added to the item cache
          */
 	sid  = SEXP_string_new("", 0);
 	attr = probe_attr_creat("id", sid, NULL);
@@ -1779,4 +1779,34 @@ SEXP_t *probe_obj_getmask(SEXP_t *obj)
     return (mask);
 }
 
+bool probe_obj_skipent(const SEXP_t *obj, const char *name)
+{
+	SEXP_t *skip;
+	char   *names, *tok, *save = NULL;
+	bool    ret = false;
+
+	skip = probe_obj_getattrval(obj, "skip_ents");
+
+	if (skip == NULL)
+		return (false);
+
+	names = SEXP_string_cstr(skip);
+	SEXP_free(skip);
+
+	if (names == NULL)
+		return (false);
+
+	/* the names are separated by spaces */
+	for (tok = strtok_r(names, " ", &save); tok != NULL; tok = strtok_r(NULL, " ", &save)) {
+		if (strcmp(tok, name) == 0) {
+			ret = true;
+			break;
+		}
+	}
+
+	oscap_free(names);
+
+	return (ret);
+}
+
 /// @}
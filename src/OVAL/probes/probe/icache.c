@@ -30,24 +30,24 @@
 #include <string.h>
 #include <inttypes.h>
 #include <stdlib.h>
+#include <unistd.h>
 
-#include "../SEAP/generic/rbt/rbt.h"
 #include "probe-api.h"
 #include "common/debug_priv.h"
-#include "common/memusage.h"
 #include "common/alloc.h"
 #include "common/assume.h"
 
 #include "probe.h"
 #include "icache.h"
+#include "memcheck.h"
 
 static volatile uint32_t next_ID = 0;
 
-#if !defined(HAVE_ATOMIC_FUNCTIONS)
+#if !defined(HAVE_ATOMIC_BUILTINS)
 pthread_mutex_t next_ID_mutex = PTHREAD_MUTEX_INITIALIZER;
 #endif
 
-static void probe_icache_item_setID(SEXP_t *item, SEXP_ID_t item_ID)
+static void probe_icache_item_setID(probe_icache_t *cache, SEXP_t *item)
 {
         SEXP_t  *name_ref, *prev_id;
         SEXP_t   uniq_id;
@@ -58,8 +58,8 @@ static void probe_icache_item_setID(SEXP_t *item, SEXP_ID_t item_ID)
         assume_d(item != NULL, /* void */);
         assume_d(SEXP_listp(item), /* void */);
 
-#if defined(HAVE_ATOMIC_FUNCTIONS)
-        local_id = __sync_fetch_and_add(&next_ID, 1);
+#if defined(HAVE_ATOMIC_BUILTINS)
+        local_id = __sync_add_and_fetch(&next_ID, 1);
 #else
         if (pthread_mutex_lock(&next_ID_mutex) != 0) {
                 dE("Can't lock the next_ID_mutex: %u, %s", errno, strerror(errno));
@@ -73,7 +73,7 @@ static void probe_icache_item_setID(SEXP_t *item, SEXP_ID_t item_ID)
                 abort();
         }
 #endif
-        SEXP_string_newf_r(&uniq_id, "1%05u%u", getpid(), local_id);
+        SEXP_string_newf_r(&uniq_id, "1%05u%u", cache->pid, local_id);
 
         name_ref = SEXP_listref_first(item);
         prev_id  = SEXP_list_replace(name_ref, 3, &uniq_id);
@@ -85,417 +85,204 @@ static void probe_icache_item_setID(SEXP_t *item, SEXP_ID_t item_ID)
         return;
 }
 
-static int icache_lookup(rbt_t *tree, int64_t item_id, probe_iqpair_t *pair) {
-
-	probe_citem_t *cached = NULL;
-
-	if (rbt_i64_get(tree, item_id, (void**)&cached) != 0) {
-		return -1;
-	}
-
-	/*
-	* Maybe a cache HIT
-	*/
-	dI("cache HIT #1");
-
-	register uint16_t i;
-	for (i = 0; i < cached->count; ++i) {
-		SEXP_t rest1;
-		SEXP_t* rest_r1 = SEXP_list_rest_r(&rest1, pair->p.item);
-
-		SEXP_t rest2;
-		SEXP_t* rest_r2 = SEXP_list_rest_r(&rest2, cached->item[i]);
-
-		if (SEXP_deepcmp(rest_r1, rest_r2)) {
-			SEXP_free_r(&rest1);
-			SEXP_free_r(&rest2);
-			break;
-		}
-
-		SEXP_free_r(&rest1);
-		SEXP_free_r(&rest2);
-	}
-
-	if (i == cached->count) {
-		/*
-		* Cache MISS
-		*/
-		dI("cache MISS");
-
-		cached->item = oscap_realloc(cached->item, sizeof(SEXP_t *) * ++cached->count);
-		cached->item[cached->count - 1] = pair->p.item;
-
-		/* Assign an unique item ID */
-		probe_icache_item_setID(pair->p.item, item_id);
-	} else {
-		/*
-		* Cache HIT
-		*/
-		dI("cache HIT #2 -> real HIT");
-		SEXP_free(pair->p.item);
-		pair->p.item = cached->item[i];
-	}
-	return 0;
-}
-
-static void icache_add_to_tree(rbt_t *tree, int64_t item_id, probe_iqpair_t *pair) {
-
-	probe_citem_t *cached = oscap_talloc(probe_citem_t);
-	cached->item = oscap_talloc(SEXP_t *);
-	cached->item[0] = pair->p.item;
-	cached->count = 1;
-
-	/* Assign an unique item ID */
-	probe_icache_item_setID(pair->p.item, item_id);
-
-	if (rbt_i64_add(tree, (int64_t)item_id, (void **)cached, NULL) != 0) {
-		dE("Can't add item (k=%"PRIi64" to the cache (%p)", item_id, tree);
+/*
+ * The cached items outlive the request they were collected by, copy them
+ * out of the request arena so that the arena can be freed.
+ */
+static SEXP_t *probe_icache_item_promote(SEXP_t *item)
+{
+        SEXP_t *promoted;
 
-		oscap_free(cached->item);
-		oscap_free(cached);
+        promoted = SEXP_promote(item);
+        SEXP_free(item);
 
-		/* now what? */
-		abort();
-	}
+        return (promoted);
 }
 
-static void *probe_icache_worker(void *arg)
+static probe_icache_ent_t *icache_shard_find(probe_icache_shard_t *shard, SEXP_ID_t item_id)
 {
-        probe_icache_t *cache = (probe_icache_t *)(arg);
-        probe_iqpair_t *pair, pair_mem;
-        SEXP_ID_t       item_ID;
-
-        assume_d(cache != NULL, NULL);
+        probe_icache_ent_t *ent;
 
-#if defined(HAVE_PTHREAD_SETNAME_NP)
-	pthread_setname_np(pthread_self(), "icache_worker");
-#endif
-
-        if (pthread_mutex_lock(&cache->queue_mutex) != 0) {
-                dE("An error ocured while locking the queue mutex: %u, %s",
-                   errno, strerror(errno));
+        if (shard->size == 0)
                 return (NULL);
-        }
 
-	pair = &pair_mem;
-        dD("icache worker ready");
-
-        switch (errno = pthread_barrier_wait(&OSCAP_GSYM(th_barrier)))
-        {
-        case 0:
-        case PTHREAD_BARRIER_SERIAL_THREAD:
-	        break;
-        default:
-	        dE("pthread_barrier_wait: %d, %s.",
-	           errno, strerror(errno));
-	        pthread_mutex_unlock(&cache->queue_mutex);
-	        return (NULL);
+        for (ent = shard->bucket[(item_id / PROBE_ICACHE_SHARDS) % shard->size]; ent != NULL; ent = ent->next) {
+                if (ent->id == item_id)
+                        return (ent);
         }
 
-        while(pthread_cond_wait(&cache->queue_notempty, &cache->queue_mutex) == 0) {
-                assume_d(cache->queue_cnt > 0, NULL);
-        do {
-                dI("Extracting item from the cache queue: cnt=%"PRIu16", beg=%"PRIu16"", cache->queue_cnt, cache->queue_beg);
-                /*
-                 * Extract an item from the queue and update queue beg, end & cnt
-                 */
-                pair_mem = cache->queue[cache->queue_beg];
-#ifndef NDEBUG
-		memset(cache->queue + cache->queue_beg, 0, sizeof(probe_iqpair_t));
-#endif
-                --cache->queue_cnt;
-		++cache->queue_beg;
-
-		if (cache->queue_beg == cache->queue_max)
-			cache->queue_beg = 0;
-
-		assume_d(cache->queue_cnt == 0 ?
-			 cache->queue_end == cache->queue_beg :
-			 cache->queue_end != cache->queue_beg, NULL);
-
-
-                dD("Signaling `notfull'");
+        return (NULL);
+}
 
-                if (pthread_cond_signal(&cache->queue_notfull) != 0) {
-                        dE("An error ocured while signaling the `notfull' condition: %u, %s",
-                           errno, strerror(errno));
-                        abort();
-                }
-                /*
-                 * Release the mutex
-                 */
-                if (pthread_mutex_unlock(&cache->queue_mutex) != 0) {
-                        dE("An error ocured while unlocking the queue mutex: %u, %s",
-                           errno, strerror(errno));
-                        abort();
+static void icache_shard_grow(probe_icache_shard_t *shard)
+{
+        probe_icache_ent_t **bucket, *ent, *next;
+        size_t size, i, b;
+
+        size   = shard->size == 0 ? 64 : shard->size * 2;
+        bucket = oscap_calloc(size, sizeof(probe_icache_ent_t *));
+
+        for (i = 0; i < shard->size; ++i) {
+                for (ent = shard->bucket[i]; ent != NULL; ent = next) {
+                        next = ent->next;
+                        b = (ent->id / PROBE_ICACHE_SHARDS) % size;
+                        ent->next = bucket[b];
+                        bucket[b] = ent;
                 }
+        }
 
-                if (pair->cobj == NULL) {
-                        /*
-                         * Handle NOP case (synchronization)
-                         */
-                        assume_d(pair->p.cond != NULL, NULL);
+        oscap_free(shard->bucket);
+        shard->bucket = bucket;
+        shard->size   = size;
+}
 
-                        dD("Handling NOP");
+/*
+ * Items with the same hash are compared without their IDs, the
+ * first one equal to the new item is returned. NULL if there's none.
+ */
+static SEXP_t *icache_citem_match(probe_citem_t *cached, SEXP_t *item)
+{
+	size_t i;
 
-                        if (pthread_cond_signal(pair->p.cond) != 0) {
-                                dE("An error ocured while signaling NOP condition: %u, %s",
-                                   errno, strerror(errno));
-                                abort();
-                        }
-                } else {
-
-                        dD("Handling cache request");
-
-                        /*
-                         * Compute item ID
-                         */
-			dD("pair address: %"PRIu64, (uint64_t) pair);
-			dD("item address: %"PRIu64, (uint64_t) pair->p.item);
-                        item_ID = SEXP_ID_v(pair->p.item);
-                        dD("item ID=%"PRIu64"", item_ID);
-
-                        if (icache_lookup(cache->tree, item_ID, pair) != 0) {
-                                /*
-                                 * Cache MISS
-                                 */
-                                dI("cache MISS");
-                                icache_add_to_tree(cache->tree, item_ID, pair);
-                        }
+	for (i = 0; i < cached->count; ++i) {
+		SEXP_t rest1;
+		SEXP_t* rest_r1 = SEXP_list_rest_r(&rest1, item);
 
-                        if (probe_cobj_add_item(pair->cobj, pair->p.item) != 0) {
-                            dW("An error ocured while adding the item to the collected object");
-                        }
-                }
+		SEXP_t rest2;
+		SEXP_t* rest_r2 = SEXP_list_rest_r(&rest2, cached->item[i]);
 
-                if (pthread_mutex_lock(&cache->queue_mutex) != 0) {
-                        dE("An error ocured while re-locking the queue mutex: %u, %s",
-                           errno, strerror(errno));
-                        abort();
-                }
+		if (SEXP_deepcmp(rest_r1, rest_r2)) {
+			SEXP_free_r(&rest1);
+			SEXP_free_r(&rest2);
+			return (cached->item[i]);
+		}
 
-                } while (cache->queue_cnt > 0);
-        }
+		SEXP_free_r(&rest1);
+		SEXP_free_r(&rest2);
+	}
 
-        return (NULL);
+	return (NULL);
 }
 
 probe_icache_t *probe_icache_new(void)
 {
         probe_icache_t *cache;
+        int i;
 
         cache = oscap_talloc(probe_icache_t);
-        cache->tree = rbt_i64_new();
-
-        if (pthread_mutex_init(&cache->queue_mutex, NULL) != 0) {
-                dE("Can't initialize icache mutex: %u, %s", errno, strerror(errno));
-                goto fail;
-        }
-
-        cache->queue_beg = 0;
-        cache->queue_end = 0;
-        cache->queue_cnt = 0;
-        cache->queue_max = PROBE_IQUEUE_CAPACITY;
+        memset(cache, 0, sizeof(probe_icache_t));
+        cache->pid = getpid();
 
-        if (pthread_cond_init(&cache->queue_notempty, NULL) != 0) {
-                dE("Can't initialize icache queue condition variable (notempty): %u, %s",
-                   errno, strerror(errno));
-                goto fail;
-        }
-
-        if (pthread_cond_init(&cache->queue_notfull, NULL) != 0) {
-                dE("Can't initialize icache queue condition variable (notfull): %u, %s",
-                   errno, strerror(errno));
-                goto fail;
-        }
-
-        if (pthread_create(&cache->thid, NULL,
-                           probe_icache_worker, (void *)cache) != 0)
-        {
-                dE("Can't start the icache worker: %u, %s", errno, strerror(errno));
-                goto fail;
+        for (i = 0; i < PROBE_ICACHE_SHARDS; ++i) {
+                if (pthread_mutex_init(&cache->shard[i].lock, NULL) != 0) {
+                        dE("Can't initialize icache mutex: %u, %s", errno, strerror(errno));
+                        goto fail;
+                }
         }
 
         return (cache);
 fail:
-        if (cache->tree != NULL)
-                rbt_i64_free(cache->tree);
+        while (--i >= 0)
+                pthread_mutex_destroy(&cache->shard[i].lock);
 
-        pthread_mutex_destroy(&cache->queue_mutex);
-        pthread_cond_destroy(&cache->queue_notempty);
         oscap_free(cache);
 
         return (NULL);
 }
 
-static int __probe_icache_add_nolock(probe_icache_t *cache, SEXP_t *cobj, SEXP_t *item, pthread_cond_t *cond)
-{
-        assume_d((cond == NULL) ^ (item == NULL), -1);
-retry:
-        if (cache->queue_cnt < cache->queue_max) {
-                cache->queue[cache->queue_end].cobj = cobj;
-
-                if (item != NULL) {
-			assume_d(cobj != NULL, -1);
-                        cache->queue[cache->queue_end].p.item = item;
-                } else {
-			assume_d(item == NULL && cobj == NULL, -1);
-                        cache->queue[cache->queue_end].p.cond = cond;
-		}
-
-                ++cache->queue_cnt;
-		++cache->queue_end;
-
-                if (cache->queue_end == cache->queue_max)
-                        cache->queue_end = 0;
-        } else {
-                /*
-                 * The queue is full, we have to wait
-                 */
-                if (pthread_cond_wait(&cache->queue_notfull, &cache->queue_mutex) == 0)
-                        goto retry;
-                else {
-                        dE("An error ocured while waiting for the `notfull' queue condition: %u, %s",
-                           errno, strerror(errno));
-                        return (-1);
-                }
-        }
-
-        return (0);
-}
-
+/*
+ * Find the item in the cache or insert it there and assign it an unique
+ * ID. The cached item is then added to the collected object by the calling
+ * thread.
+ */
 int probe_icache_add(probe_icache_t *cache, SEXP_t *cobj, SEXP_t *item)
 {
-        int ret;
+        probe_icache_shard_t *shard;
+        probe_icache_ent_t   *ent;
+        SEXP_t   *cached;
+        SEXP_ID_t item_ID;
 
         if (cache == NULL || cobj == NULL || item == NULL)
                 return (-1); /* XXX: EFAULT */
 
-        if (pthread_mutex_lock(&cache->queue_mutex) != 0) {
-                dE("An error ocured while locking the queue mutex: %u, %s",
-                   errno, strerror(errno));
-                return (-1);
-        }
-
-        ret = __probe_icache_add_nolock(cache, cobj, item, NULL);
-
-        if (pthread_cond_signal(&cache->queue_notempty) != 0) {
-                dE("An error ocured while signaling the `notempty' condition: %u, %s",
-                   errno, strerror(errno));
-                return (-1);
-        }
-
-        if (pthread_mutex_unlock(&cache->queue_mutex) != 0) {
-                dE("An error ocured while unlocking the queue mutex: %u, %s",
-                   errno, strerror(errno));
-                abort();
-        }
-
-        if (ret != 0)
-                return (-1);
-
-        return (0);
-}
-
-int probe_icache_nop(probe_icache_t *cache)
-{
-        pthread_cond_t cond;
-
-        dD("NOP");
+        /*
+         * Compute item ID
+         */
+        item_ID = SEXP_ID_v(item);
+        shard   = cache->shard + (item_ID % PROBE_ICACHE_SHARDS);
+        dD("item ID=%"PRIu64"", item_ID);
 
-        if (pthread_mutex_lock(&cache->queue_mutex) != 0) {
-                dE("An error ocured while locking the queue mutex: %u, %s",
+        if (pthread_mutex_lock(&shard->lock) != 0) {
+                dE("An error ocured while locking the icache shard: %u, %s",
                    errno, strerror(errno));
                 return (-1);
         }
 
-        if (pthread_cond_init(&cond, NULL) != 0) {
-                dE("Can't initialize icache queue condition variable (NOP): %u, %s",
-                   errno, strerror(errno));
-                return (-1);
-        }
+        ent    = icache_shard_find(shard, item_ID);
+        cached = ent != NULL ? icache_citem_match(&ent->citem, item) : NULL;
 
-        if (__probe_icache_add_nolock(cache, NULL, NULL, &cond) != 0) {
-                if (pthread_mutex_unlock(&cache->queue_mutex) != 0) {
-                        dE("An error ocured while unlocking the queue mutex: %u, %s",
-                           errno, strerror(errno));
-                        abort();
+        if (cached != NULL) {
+                /*
+                 * Cache HIT
+                 */
+                dI("cache HIT");
+                ++shard->hits;
+                SEXP_free(item);
+                item = cached;
+        } else {
+                /*
+                 * Cache MISS
+                 */
+                dI("cache MISS");
+                ++shard->misses;
+
+                if (ent == NULL) {
+                        if (shard->count >= shard->size)
+                                icache_shard_grow(shard);
+
+                        ent = oscap_talloc(probe_icache_ent_t);
+                        ent->id = item_ID;
+                        ent->citem.item  = NULL;
+                        ent->citem.count = 0;
+                        ent->next = shard->bucket[(item_ID / PROBE_ICACHE_SHARDS) % shard->size];
+                        shard->bucket[(item_ID / PROBE_ICACHE_SHARDS) % shard->size] = ent;
+                        ++shard->count;
                 }
 
-                pthread_cond_destroy(&cond);
-                return (-1);
-        }
-
-        dD("Signaling `notempty'");
+                item = probe_icache_item_promote(item);
+                ent->citem.item = oscap_realloc(ent->citem.item, sizeof(SEXP_t *) * ++ent->citem.count);
+                ent->citem.item[ent->citem.count - 1] = item;
 
-        if (pthread_cond_signal(&cache->queue_notempty) != 0) {
-                dE("An error ocured while signaling the `notempty' condition: %u, %s",
-                   errno, strerror(errno));
-
-                pthread_cond_destroy(&cond);
-                return (-1);
+                /* Assign an unique item ID */
+                probe_icache_item_setID(cache, item);
         }
 
-        dD("Waiting for icache worker to handle the NOP");
-
-        if (pthread_cond_wait(&cond, &cache->queue_mutex) != 0) {
-                dE("An error ocured while waiting for the `NOP' queue condition: %u, %s",
-                   errno, strerror(errno));
-                return (-1);
-        }
-
-        dD("Sync");
-
-        if (pthread_mutex_unlock(&cache->queue_mutex) != 0) {
-                dE("An error ocured while unlocking the queue mutex: %u, %s",
+        if (pthread_mutex_unlock(&shard->lock) != 0) {
+                dE("An error ocured while unlocking the icache shard: %u, %s",
                    errno, strerror(errno));
                 abort();
         }
 
-        pthread_cond_destroy(&cond);
+        if (probe_cobj_add_item(cobj, item) != 0) {
+                dW("An error ocured while adding the item to the collected object");
+        }
 
         return (0);
 }
 
-#define PROBE_RESULT_MEMCHECK_CTRESHOLD  32768  /* item count */
-#define PROBE_RESULT_MEMCHECK_MINFREEMEM 512    /* MiB */
-#define PROBE_RESULT_MEMCHECK_MAXRATIO   0.8   /* max. memory usage ratio - used/total */
-
-/**
- * Returns 0 if the memory constraints are not reached. Otherwise, 1 is returned.
- * In case of an error, -1 is returned.
- */
-static int probe_cobj_memcheck(size_t item_cnt)
+void probe_icache_stats(probe_icache_t *cache, size_t *hits, size_t *misses)
 {
-	if (item_cnt > PROBE_RESULT_MEMCHECK_CTRESHOLD) {
-		struct proc_memusage mu_proc;
-		struct sys_memusage  mu_sys;
-		double c_ratio;
-
-		if (oscap_proc_memusage (&mu_proc) != 0)
-			return (-1);
-
-		if (oscap_sys_memusage (&mu_sys) != 0)
-			return (-1);
+        int i;
 
-		c_ratio = (double)mu_proc.mu_rss/(double)(mu_sys.mu_total);
+        *hits   = 0;
+        *misses = 0;
 
-		if (c_ratio > PROBE_RESULT_MEMCHECK_MAXRATIO) {
-			dW("Memory usage ratio limit reached! limit=%f, current=%f",
-			   PROBE_RESULT_MEMCHECK_MAXRATIO, c_ratio);
-			errno = ENOMEM;
-			return (1);
-		}
-
-		if ((mu_sys.mu_realfree / 1024) < PROBE_RESULT_MEMCHECK_MINFREEMEM) {
-			dW("Minimum free memory limit reached! limit=%zu, current=%zu",
-			   PROBE_RESULT_MEMCHECK_MINFREEMEM, mu_sys.mu_realfree / 1024);
-			errno = ENOMEM;
-			return (1);
-		}
-	}
-
-	return (0);
+        for (i = 0; i < PROBE_ICACHE_SHARDS; ++i) {
+                pthread_mutex_lock(&cache->shard[i].lock);
+                *hits   += cache->shard[i].hits;
+                *misses += cache->shard[i].misses;
+                pthread_mutex_unlock(&cache->shard[i].lock);
+        }
 }
 
 /**
@@ -511,7 +298,7 @@ static int probe_cobj_memcheck(size_t item_cnt)
  *-1 ... unexpected/internal error
  *
  * The caller must not free the item, it's freed automatically
- * by this function or by the icache worker thread.
+ * by this function.
  */
 int probe_item_collect(struct probe_ctx *ctx, SEXP_t *item)
 {
@@ -526,7 +313,7 @@ int probe_item_collect(struct probe_ctx *ctx, SEXP_t *item)
 	cobj_itemcnt = SEXP_list_length(cobj_content);
 	SEXP_free(cobj_content);
 
-	if (probe_cobj_memcheck(cobj_itemcnt) != 0) {
+	if (probe_memcheck(cobj_itemcnt) != 0) {
 
 		/*
 		 * Don't set the message again if the collected object is
@@ -534,12 +321,6 @@ int probe_item_collect(struct probe_ctx *ctx, SEXP_t *item)
 		 */
 		if (probe_cobj_get_flag(ctx->probe_out) != SYSCHAR_FLAG_INCOMPLETE) {
 			SEXP_t *msg;
-			/*
-			 * Sync with the icache thread before modifying the
-			 * collected object.
-			 */
-			if (probe_icache_nop(ctx->icache) != 0)
-				return -1;
 
 			msg = probe_msg_creat(OVAL_MESSAGE_LEVEL_WARNING,
 			                      "Object is incomplete due to memory constraints.");
@@ -567,30 +348,37 @@ int probe_item_collect(struct probe_ctx *ctx, SEXP_t *item)
         return (0);
 }
 
-static void probe_icache_free_node(struct rbt_i64_node *n)
+static void probe_icache_free_ent(probe_icache_ent_t *ent)
 {
-        probe_citem_t *ci = (probe_citem_t *)n->data;
+        probe_citem_t *ci = &ent->citem;
 
 	for ( ; ci->count > 0 ; --ci->count ) {
 		SEXP_free(ci->item[ci->count - 1]);
 	}
 
         oscap_free(ci->item);
-        oscap_free(ci);
+        oscap_free(ent);
         return;
 }
 
 void probe_icache_free(probe_icache_t *cache)
 {
-        void *ret = NULL;
+        probe_icache_ent_t *ent, *next;
+        size_t b;
+        int i;
+
+        for (i = 0; i < PROBE_ICACHE_SHARDS; ++i) {
+                for (b = 0; b < cache->shard[i].size; ++b) {
+                        for (ent = cache->shard[i].bucket[b]; ent != NULL; ent = next) {
+                                next = ent->next;
+                                probe_icache_free_ent(ent);
+                        }
+                }
 
-        pthread_cancel(cache->thid);
-        pthread_join(cache->thid, &ret);
-        pthread_mutex_destroy(&cache->queue_mutex);
-        pthread_cond_destroy(&cache->queue_notempty);
-        pthread_cond_destroy(&cache->queue_notfull);
+                oscap_free(cache->shard[i].bucket);
+                pthread_mutex_destroy(&cache->shard[i].lock);
+        }
 
-        rbt_i64_free_cb(cache->tree, &probe_icache_free_node);
         oscap_free(cache);
         return;
 }
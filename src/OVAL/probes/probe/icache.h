@@ -23,44 +23,49 @@
 #define ICACHE_H
 
 #include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/types.h>
 #include <sexp.h>
-#include "../SEAP/generic/rbt/rbt.h"
 
-#ifndef PROBE_IQUEUE_CAPACITY
-#define PROBE_IQUEUE_CAPACITY 1024
+/*
+ * The items are spread over the shards by their hash (SEXP_ID_v()), every
+ * shard is a hash table with its own lock. The threads collecting items
+ * look them up and insert them directly, so they only contend when their
+ * items fall into the same shard.
+ */
+#ifndef PROBE_ICACHE_SHARDS
+#define PROBE_ICACHE_SHARDS 64
 #endif
 
 typedef struct {
-        SEXP_t *cobj;
-        union {
-                SEXP_t         *item;
-                pthread_cond_t *cond;
-        } p;
-} probe_iqpair_t;
-
-typedef struct {
-        rbt_t    *tree; /* XXX: rewrite to extensible or linear hashing */
-        pthread_t thid;
+        SEXP_t **item;
+        size_t   count;
+} probe_citem_t;
 
-        pthread_mutex_t queue_mutex;
-        pthread_cond_t  queue_notempty;
-        pthread_cond_t  queue_notfull;
+typedef struct probe_icache_ent {
+        struct probe_icache_ent *next;
+        SEXP_ID_t      id;
+        probe_citem_t  citem; /* items with the same hash */
+} probe_icache_ent_t;
 
-        probe_iqpair_t  queue[PROBE_IQUEUE_CAPACITY];
-        uint16_t        queue_beg;
-        uint16_t        queue_end;
-        uint16_t        queue_cnt;
-        uint16_t        queue_max;
-} probe_icache_t;
+typedef struct {
+        pthread_mutex_t      lock;
+        probe_icache_ent_t **bucket;
+        size_t               size;  /* number of buckets */
+        size_t               count; /* number of entries */
+        size_t               hits;
+        size_t               misses;
+} probe_icache_shard_t;
 
 typedef struct {
-        SEXP_t  **item;
-        uint16_t  count;
-} probe_citem_t;
+        pid_t                pid;
+        probe_icache_shard_t shard[PROBE_ICACHE_SHARDS];
+} probe_icache_t;
 
 probe_icache_t *probe_icache_new(void);
 int probe_icache_add(probe_icache_t *cache, SEXP_t *cobj, SEXP_t *item);
-int probe_icache_nop(probe_icache_t *cache);
+void probe_icache_stats(probe_icache_t *cache, size_t *hits, size_t *misses);
 void probe_icache_free(probe_icache_t *cache);
 
 #endif /* ICACHE_H */
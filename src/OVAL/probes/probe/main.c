@@ -27,6 +27,7 @@
 # endif
 #endif
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <signal.h>
 #include <pthread.h>
@@ -38,7 +39,11 @@
 #include "ncache.h"
 #include "rcache.h"
 #include "icache.h"
+#include "memcheck.h"
 #include "worker.h"
+#include "workpool.h"
+#include "../../results/oval_cmp_regex_impl.h"
+#include "../fscache.h"
 #include "signal_handler.h"
 #include "input_handler.h"
 #include "probe-api.h"
@@ -80,6 +85,10 @@ static SEXP_t *probe_reset(SEXP_t *arg0, void *arg1)
         probe->rcache = probe_rcache_new();
         probe->ncache = probe_ncache_new();
 
+	/* the file system might have changed since the probe was started */
+	fscache_free();
+	probe_invalidate(probe->probe_arg);
+
         return(NULL);
 }
 
@@ -161,6 +170,50 @@ static int probe_opthandler_offlinemode(int option, int op, va_list args)
 	return 0;
 }
 
+/*
+ * Number of worker threads allowed to run concurrently. Defaults to the
+ * number of online CPUs, can be overridden using OSCAP_PROBE_THREADS.
+ */
+static uint32_t probe_workpool_size(uint32_t max_threads)
+{
+	char *str, *end;
+	long  size;
+
+	str = getenv("OSCAP_PROBE_THREADS");
+
+	if (str != NULL) {
+		errno = 0;
+		size  = strtol(str, &end, 10);
+
+		if (errno != 0 || *end != '\0' || size <= 0) {
+			dW("Invalid value of OSCAP_PROBE_THREADS: \"%s\"", str);
+			size = 0;
+		}
+	} else
+		size = 0;
+
+	if (size == 0) {
+		size = sysconf(_SC_NPROCESSORS_ONLN);
+
+		if (size <= 0)
+			size = 1;
+	}
+
+	return ((uint32_t)size > max_threads ? max_threads : (uint32_t)size);
+}
+
+/*
+ * Allocate the S-exps created while handling a request from an arena which
+ * is released with the request. Enabled by setting OSCAP_PROBE_ARENA to a
+ * non-zero value.
+ */
+static bool probe_arena_enabled(void)
+{
+	char *str = getenv("OSCAP_PROBE_ARENA");
+
+	return (str != NULL && *str != '\0' && strcmp(str, "0") != 0);
+}
+
 // Dummy pthread routine
 static void * dummy_routine(void *dummy_param)
 {
@@ -192,7 +245,6 @@ int main(int argc, char *argv[])
 	if ((errno = pthread_barrier_init(&OSCAP_GSYM(th_barrier), NULL,
 	                                  1 + // signal thread
 	                                  1 + // input thread
-	                                  1 + // icache thread
 	                                  0)) != 0)
 	{
 		fail(errno, "pthread_barrier_init", __LINE__ - 6);
@@ -238,6 +290,19 @@ int main(int argc, char *argv[])
 	probe.ncache = probe_ncache_new();
         probe.icache = probe_icache_new();
 
+	/*
+	 * Initialize the worker pool, threads are started on demand
+	 */
+	probe.max_threads = PROBE_WORKER_DEFAULT_MAX_THREADS;
+	probe.max_chdepth = PROBE_WORKER_DEFAULT_MAX_CHDEPTH;
+	probe.workpool    = probe_workpool_new(probe_workpool_size(probe.max_threads), probe.max_threads,
+	                                       PROBE_WORKPOOL_QUEUE_CAPACITY, &probe_pwpair_free);
+
+	if (probe.workpool == NULL)
+		fail(errno, "probe_workpool_new", __LINE__ - 4);
+
+	probe.arena = probe_arena_enabled();
+
         OSCAP_GSYM(ncache) = probe.ncache;
 
 	/*
@@ -352,8 +417,38 @@ int main(int argc, char *argv[])
 	/*
 	 * Cleanup
 	 */
+	probe_workpool_free(probe.workpool);
         probe_fini(probe.probe_arg);
 
+	{
+		size_t it_hits, it_misses;
+
+		probe_icache_stats(probe.icache, &it_hits, &it_misses);
+		dI("Item cache: %zu hit(s), %zu miss(es).", it_hits, it_misses);
+	}
+
+	{
+		size_t mc_checks, mc_samples;
+
+		probe_memcheck_stats(&mc_checks, &mc_samples);
+		dI("Memory checks: %zu, /proc samples: %zu.", mc_checks, mc_samples);
+	}
+
+	{
+		size_t re_hits, re_misses;
+
+		oval_regex_cache_stats(&re_hits, &re_misses);
+		dI("Regex cache: %zu hit(s), %zu miss(es).", re_hits, re_misses);
+	}
+
+	{
+		size_t fs_hits, fs_misses;
+
+		fscache_stats(&fs_hits, &fs_misses);
+		dI("File system cache: %zu hit(s), %zu miss(es).", fs_hits, fs_misses);
+		fscache_free();
+	}
+
 	probe_ncache_free(probe.ncache);
 	probe_rcache_free(probe.rcache);
         probe_icache_free(probe.icache);
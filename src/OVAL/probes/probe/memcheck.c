@@ -0,0 +1,218 @@
+/**
+ * @file   memcheck.c
+ * @brief  memory budget of the collected objects
+ */
+
+/*
+ * Copyright 2016 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sexp.h>
+
+#include "common/debug_priv.h"
+#include "common/memusage.h"
+#include "memcheck.h"
+
+#define PROBE_RESULT_MEMCHECK_CTRESHOLD  32768  /* item count */
+#define PROBE_RESULT_MEMCHECK_MINFREEMEM 512    /* MiB */
+#define PROBE_RESULT_MEMCHECK_MAXRATIO   0.8   /* max. memory usage ratio - used/total */
+
+/* /proc is sampled once this time passed and this many items were checked */
+#define PROBE_MEMCHECK_INTERVAL_DEFAULT  250    /* ms */
+#define PROBE_MEMCHECK_ITEMS_DEFAULT     1024
+
+static struct {
+	pthread_once_t  once;
+	pthread_mutex_t lock;
+
+	uint64_t interval;  /* ms */
+	size_t   items;
+	size_t   limit;     /* kB, OSCAP_PROBE_MEMORY_LIMIT, 0 = none */
+
+	bool     sampled;
+	int      sample_ret;
+	uint64_t sample_time;
+	size_t   sample_items; /* items checked since the sample */
+	size_t   sample_live;  /* SEXP_live_bytes() at the sample */
+	size_t   rss;          /* kB */
+	size_t   total;        /* kB, the cgroup limit if it's lower than the RAM */
+	size_t   avail;        /* kB */
+
+	size_t   checks;
+	size_t   samples;
+} memcheck = {
+	.once = PTHREAD_ONCE_INIT,
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static size_t memcheck_getenv(const char *name, size_t defval)
+{
+	char *str, *end;
+	long  val;
+
+	str = getenv(name);
+
+	if (str == NULL)
+		return (defval);
+
+	errno = 0;
+	val   = strtol(str, &end, 10);
+
+	if (errno != 0 || *end != '\0' || val < 0) {
+		dW("Invalid value of %s: \"%s\"", name, str);
+		return (defval);
+	}
+
+	return ((size_t)val);
+}
+
+static void memcheck_init(void)
+{
+	memcheck.interval = memcheck_getenv("OSCAP_PROBE_MEMCHECK_INTERVAL", PROBE_MEMCHECK_INTERVAL_DEFAULT);
+	memcheck.items    = memcheck_getenv("OSCAP_PROBE_MEMCHECK_ITEMS", PROBE_MEMCHECK_ITEMS_DEFAULT);
+	memcheck.limit    = memcheck_getenv("OSCAP_PROBE_MEMORY_LIMIT", 0) * 1024;
+}
+
+static uint64_t memcheck_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ((uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000);
+}
+
+/* called with the lock held */
+static int memcheck_sample(uint64_t now)
+{
+	struct proc_memusage   mu_proc;
+	struct sys_memusage    mu_sys;
+	struct cgroup_memusage mu_cg;
+
+	++memcheck.samples;
+	memcheck.sampled      = true;
+	memcheck.sample_time  = now;
+	memcheck.sample_items = 0;
+	memcheck.sample_live  = SEXP_live_bytes();
+
+	if (oscap_proc_memusage(&mu_proc) != 0)
+		return (-1);
+
+	if (oscap_sys_memusage(&mu_sys) != 0 || mu_sys.mu_total == 0)
+		return (-1);
+
+	memcheck.rss   = mu_proc.mu_rss;
+	memcheck.total = mu_sys.mu_total;
+	memcheck.avail = mu_sys.mu_realfree;
+
+	/* in a container, the limit of its cgroup applies before the RAM runs out */
+	if (oscap_cgroup_memusage(&mu_cg) == 0 && mu_cg.mu_limit != 0) {
+		size_t cg_used, cg_free;
+
+		cg_used = mu_cg.mu_current > mu_cg.mu_file ? mu_cg.mu_current - mu_cg.mu_file : 0;
+		cg_free = mu_cg.mu_limit > cg_used ? mu_cg.mu_limit - cg_used : 0;
+
+		if (mu_cg.mu_limit < memcheck.total)
+			memcheck.total = mu_cg.mu_limit;
+		if (cg_free < memcheck.avail)
+			memcheck.avail = cg_free;
+	}
+
+	return (0);
+}
+
+int probe_memcheck(size_t item_cnt)
+{
+	size_t   live, grow, rss, avail, minfree;
+	uint64_t now;
+	int      ret;
+
+	if (item_cnt <= PROBE_RESULT_MEMCHECK_CTRESHOLD)
+		return (0);
+
+	pthread_once(&memcheck.once, &memcheck_init);
+	now = memcheck_now();
+
+	pthread_mutex_lock(&memcheck.lock);
+	++memcheck.checks;
+	++memcheck.sample_items;
+
+	if (!memcheck.sampled ||
+	    (now - memcheck.sample_time >= memcheck.interval &&
+	     memcheck.sample_items >= memcheck.items))
+	{
+		memcheck.sample_ret = memcheck_sample(now);
+	}
+
+	ret = memcheck.sample_ret;
+
+	if (ret != 0) {
+		pthread_mutex_unlock(&memcheck.lock);
+		return (-1);
+	}
+
+	/* the S-exps allocated since the sample are added to the usage */
+	live  = SEXP_live_bytes();
+	grow  = live > memcheck.sample_live ? (live - memcheck.sample_live) / 1024 : 0;
+	rss   = memcheck.rss + grow;
+	avail = memcheck.avail > grow ? memcheck.avail - grow : 0;
+
+	/* don't require more free memory than a small container has */
+	minfree = PROBE_RESULT_MEMCHECK_MINFREEMEM * 1024;
+	if (minfree > memcheck.total / 8)
+		minfree = memcheck.total / 8;
+
+	if ((double)rss / (double)memcheck.total > PROBE_RESULT_MEMCHECK_MAXRATIO) {
+		dW("Memory usage ratio limit reached! limit=%f, current=%f",
+		   PROBE_RESULT_MEMCHECK_MAXRATIO, (double)rss / (double)memcheck.total);
+		ret = 1;
+	} else if (avail < minfree) {
+		dW("Minimum free memory limit reached! limit=%zu, current=%zu",
+		   minfree / 1024, avail / 1024);
+		ret = 1;
+	} else if (memcheck.limit != 0 && rss > memcheck.limit) {
+		dW("Memory limit of the probe reached! limit=%zu, current=%zu",
+		   memcheck.limit / 1024, rss / 1024);
+		ret = 1;
+	}
+
+	pthread_mutex_unlock(&memcheck.lock);
+
+	if (ret != 0)
+		errno = ENOMEM;
+
+	return (ret);
+}
+
+void probe_memcheck_stats(size_t *checks, size_t *samples)
+{
+	pthread_mutex_lock(&memcheck.lock);
+	*checks  = memcheck.checks;
+	*samples = memcheck.samples;
+	pthread_mutex_unlock(&memcheck.lock);
+}
@@ -0,0 +1,48 @@
+/**
+ * @file   memcheck.h
+ * @brief  memory budget of the collected objects
+ *
+ * The memory usage of the probe and of the system is read from /proc (and
+ * from the cgroup v2 memory controller) at most once per sampling interval.
+ * Between the samples it's estimated from the number of bytes taken by the
+ * S-exps, which the S-exp allocator counts.
+ */
+
+/*
+ * Copyright 2016 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PROBE_MEMCHECK_H
+#define PROBE_MEMCHECK_H
+
+#include <stddef.h>
+
+/**
+ * Check whether another item can be added to a collected object which
+ * already has item_cnt items.
+ * @return 0 if the memory constraints are not reached, 1 if they are (errno
+ *         is set to ENOMEM) and -1 if the memory usage can't be read
+ */
+int probe_memcheck(size_t item_cnt);
+
+/**
+ * Get the number of checks and of the /proc samples they needed.
+ */
+void probe_memcheck_stats(size_t *checks, size_t *samples);
+
+#endif /* PROBE_MEMCHECK_H */
@@ -125,11 +125,15 @@ static int probe_ncache_cmp2 (const SEXP_t **a, const SEXP_t **b)
 SEXP_t *probe_ncache_add (probe_ncache_t *cache, const char *name)
 {
         SEXP_t *ref;
+        SEXP_arena_t *arena;
 
         assume_d (cache != NULL, NULL);
         assume_d (name  != NULL, NULL);
 
-        ref = SEXP_string_new (name, strlen (name));
+        /* the names are cached for the whole life of the probe */
+        arena = SEXP_arena_enter (NULL);
+        ref   = SEXP_string_new (name, strlen (name));
+        SEXP_arena_enter (arena);
 
         if (ref == NULL)
                 return (NULL);
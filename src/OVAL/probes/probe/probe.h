@@ -25,6 +25,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdarg.h>
 #include <pthread.h>
@@ -32,6 +33,7 @@
 #include "ncache.h"
 #include "rcache.h"
 #include "icache.h"
+#include "workpool.h"
 #include "probe-common.h"
 #include "option.h"
 #include "common/util.h"
@@ -56,6 +58,9 @@ typedef struct {
         uint32_t  max_threads;
         uint32_t  max_chdepth;
 
+        probe_workpool_t *workpool; /**< worker threads */
+        bool              arena;    /**< allocate the S-exps of each request from an arena */
+
 	probe_rcache_t *rcache; /**< probe result cache */
 	probe_ncache_t *ncache; /**< probe name cache */
         probe_icache_t *icache; /**< probe item cache */
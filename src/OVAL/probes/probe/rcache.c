@@ -66,7 +66,7 @@ int probe_rcache_sexp_add(probe_rcache_t *cache, const SEXP_t *id, SEXP_t *item)
 	assume_d(item  != NULL, -1);
 
         k = SEXP_string_cstr(id);
-        r = SEXP_ref(item);
+        r = SEXP_promote(item); /* the cached result outlives the request arena */
 
         if (rbt_str_add(cache->tree, k, (void *)r) != 0) {
                 SEXP_free(r);
@@ -46,6 +46,7 @@ void *probe_worker_runfn(void *arg)
 
 	SEXP_t *probe_res, *obj, *oid;
 	int     probe_ret;
+	SEXP_arena_t *arena, *arena_prev;
 
 #if defined(HAVE_PTHREAD_SETNAME_NP)
 	pthread_setname_np(pthread_self(), "probe_worker");
@@ -53,7 +54,10 @@ void *probe_worker_runfn(void *arg)
 	dD("handling SEAP message ID %u", pair->pth->sid);
 	//
 	probe_ret = -1;
-	probe_res = pair->pth->msg_handler(pair->probe, pair->pth->msg, &probe_ret);
+	arena      = pair->probe->arena ? SEXP_arena_new() : NULL;
+	arena_prev = SEXP_arena_enter(arena);
+	probe_res  = pair->pth->msg_handler(pair->probe, pair->pth->msg, &probe_ret);
+	SEXP_arena_enter(arena_prev);
 	//
 	dD("handler result = %p, return code = %d", probe_res, probe_ret);
 
@@ -68,6 +72,7 @@ void *probe_worker_runfn(void *arg)
 
                 SEAP_msg_free(pair->pth->msg);
                 SEXP_free(probe_res);
+                SEXP_arena_release(arena);
                 oscap_free(pair);
 
                 return (NULL);
@@ -130,13 +135,25 @@ void *probe_worker_runfn(void *arg)
 	}
 
         SEAP_msg_free(pair->pth->msg);
+        SEXP_arena_release(arena);
         oscap_free(pair->pth);
 	oscap_free(pair);
-	pthread_detach(pthread_self());
 
 	return (NULL);
 }
 
+void probe_pwpair_free(void *arg)
+{
+	probe_pwpair_t *pair = (probe_pwpair_t *)arg;
+
+	if (rbt_i32_del(pair->probe->workers, pair->pth->sid, NULL) != 0)
+		dW("rbt_i32_del: failed to remove worker (ID=%u)", pair->pth->sid);
+
+	SEAP_msg_free(pair->pth->msg);
+	oscap_free(pair->pth);
+	oscap_free(pair);
+}
+
 probe_worker_t *probe_worker_new(void)
 {
 	probe_worker_t *pth = oscap_talloc(probe_worker_t);
@@ -322,7 +339,9 @@ static SEXP_t *probe_ste_fetch(probe_t *probe, SEXP_t *id_list)
 	if (i_len == 0)
 		return SEXP_list_new(NULL);
 
+	probe_workpool_block(probe->workpool);
 	res = SEAP_cmd_exec(probe->SEAP_ctx, probe->sd, 0, PROBECMD_STE_FETCH, id_list, SEAP_CMDTYPE_SYNC, NULL, NULL);
+	probe_workpool_unblock(probe->workpool);
 
 	r_len = SEXP_list_length(res);
 
@@ -358,7 +377,7 @@ static SEXP_t *probe_ste_fetch(probe_t *probe, SEXP_t *id_list)
  * Evaluate an OVAL object identified by its id. Using a remote
  * synchronous SEAP command, this function executes evaluation of an
  * OVAL object which results weren't found in the probe cache. This
- * indirectly spawns a new thread in the probe process which evaluates
+ * indirectly queues a new request in the probe process which evaluates
  * the object and stores the result in the probe cache. That result is
  * not send to the library because it doesn't know how to handle
  * it. Instead, the result is fetched by this function from the cache
@@ -370,7 +389,13 @@ static SEXP_t *probe_obj_eval(probe_t *probe, SEXP_t *id)
 {
 	SEXP_t *res, *rid;
 
+	/*
+	 * The evaluation may end up in this probe again. Let the worker pool
+	 * know that this thread doesn't occupy a slot while it waits.
+	 */
+	probe_workpool_block(probe->workpool);
 	res = SEAP_cmd_exec(probe->SEAP_ctx, probe->sd, 0, PROBECMD_OBJ_EVAL, id, SEAP_CMDTYPE_SYNC, NULL, NULL);
+	probe_workpool_unblock(probe->workpool);
 
 	rid = SEXP_list_first(res);
 	assume_r(SEXP_string_cmp(id, rid) == 0, NULL);
@@ -952,11 +977,6 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
 			*ret = probe_main(&pctx, probe->probe_arg);
 			pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, &__unused_oldstate);
 
-                        /*
-                         * Synchronize
-                         */
-                        probe_icache_nop(probe->icache);
-
 			probe_cobj_compute_flag(probe_out);
 		} else {
 			/*
@@ -989,11 +1009,6 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
                                  */
 				*ret = probe_main(&pctx, probe->probe_arg);
 
-                                /*
-                                 * Synchronize
-                                 */
-                                probe_icache_nop(probe->icache);
-
 				probe_cobj_compute_flag(cobj);
 				r0 = probe_out;
 				probe_out = probe_set_combine(r0, cobj, OVAL_SET_OPERATION_UNION);
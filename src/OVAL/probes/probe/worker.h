@@ -49,6 +49,7 @@ typedef struct {
 
 probe_worker_t *probe_worker_new(void);
 void *probe_worker_runfn(void *arg);
+void probe_pwpair_free(void *arg);
 SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret);
 
 #endif /* WORKER_H */
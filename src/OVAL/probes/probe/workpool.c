@@ -0,0 +1,394 @@
+/*
+ * Copyright 2016 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <time.h>
+
+#include "common/debug_priv.h"
+#include "common/alloc.h"
+#include "common/assume.h"
+
+#include "workpool.h"
+
+static uint64_t probe_workpool_time(void)
+{
+#if defined(HAVE_CLOCK_GETTIME)
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+		return ((uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000);
+#endif
+	return (0);
+}
+
+static void probe_workpool_lock(probe_workpool_t *pool)
+{
+	if ((errno = pthread_mutex_lock(&pool->mutex)) != 0) {
+		dE("An error ocured while locking the pool mutex: %u, %s",
+		   errno, strerror(errno));
+		abort();
+	}
+}
+
+static void probe_workpool_unlock(probe_workpool_t *pool)
+{
+	if ((errno = pthread_mutex_unlock(&pool->mutex)) != 0) {
+		dE("An error ocured while unlocking the pool mutex: %u, %s",
+		   errno, strerror(errno));
+		abort();
+	}
+}
+
+static void *probe_workpool_thread(void *arg)
+{
+	probe_workthr_t  *thr  = (probe_workthr_t *)arg;
+	probe_workpool_t *pool = thr->pool;
+	probe_workreq_t  *req;
+	uint64_t tm_beg, tm_run;
+	int cstate;
+
+	/*
+	 * The thread may be canceled only while it executes a request,
+	 * i.e. never while holding the pool mutex.
+	 */
+	pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &cstate);
+	probe_workpool_lock(pool);
+
+	for (;;) {
+		while (!pool->shutdown &&
+		       (pool->queue_cnt == 0 || pool->running >= pool->size))
+		{
+			++pool->idle;
+			pthread_cond_wait(&pool->notempty, &pool->mutex);
+			--pool->idle;
+		}
+
+		if (pool->shutdown)
+			break;
+
+		req = pool->queue_beg;
+		pool->queue_beg = req->next;
+
+		if (pool->queue_beg == NULL)
+			pool->queue_end = NULL;
+
+		--pool->queue_cnt;
+		++pool->running;
+		thr->busy = true;
+
+		tm_beg = probe_workpool_time();
+
+		if (tm_beg - req->tm_queued > pool->stats.wait_max)
+			pool->stats.wait_max = tm_beg - req->tm_queued;
+
+		pool->stats.wait_time += tm_beg - req->tm_queued;
+
+		pthread_cond_signal(&pool->notfull);
+		probe_workpool_unlock(pool);
+
+		pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &cstate);
+		(void)req->func(req->arg);
+		pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &cstate);
+
+		oscap_free(req);
+		tm_run = probe_workpool_time() - tm_beg;
+
+		probe_workpool_lock(pool);
+
+		--pool->running;
+		thr->busy = false;
+
+		++pool->stats.completed;
+		pool->stats.run_time += tm_run;
+
+		if (tm_run > pool->stats.run_max)
+			pool->stats.run_max = tm_run;
+	}
+
+	probe_workpool_unlock(pool);
+
+	return (NULL);
+}
+
+/*
+ * Start a new thread if there are requests nobody is going to pick up
+ * and the limits allow it. Has to be called with the mutex locked.
+ */
+static int probe_workpool_spawn(probe_workpool_t *pool)
+{
+	probe_workthr_t *thr;
+
+	if (pool->queue_cnt <= pool->idle ||
+	    pool->running >= pool->size ||
+	    pool->thr_cnt >= pool->thr_max)
+		return (0);
+
+	thr = pool->thr + pool->thr_cnt;
+	thr->pool = pool;
+	thr->busy = false;
+
+	if ((errno = pthread_create(&thr->tid, NULL, &probe_workpool_thread, thr)) != 0) {
+		dE("Cannot start a new worker thread: %d, %s.", errno, strerror(errno));
+		return (-1);
+	}
+
+	++pool->thr_cnt;
+
+	if (pool->thr_cnt > pool->stats.thr_peak)
+		pool->stats.thr_peak = pool->thr_cnt;
+
+	dD("Started worker thread #%"PRIu32" (running=%"PRIu32", blocked=%"PRIu32", queued=%"PRIu32")",
+	   pool->thr_cnt, pool->running, pool->blocked, pool->queue_cnt);
+
+	return (0);
+}
+
+probe_workpool_t *probe_workpool_new(uint32_t size, uint32_t thr_max, uint32_t queue_max, void (*dtor)(void *))
+{
+	probe_workpool_t *pool;
+
+	assume_d(size > 0, NULL);
+	assume_d(queue_max > 0, NULL);
+
+	if (thr_max < size)
+		thr_max = size;
+
+	pool = oscap_talloc(probe_workpool_t);
+	memset(pool, 0, sizeof(probe_workpool_t));
+
+	if (pthread_mutex_init(&pool->mutex, NULL) != 0) {
+		dE("Can't initialize pool mutex: %u, %s", errno, strerror(errno));
+		oscap_free(pool);
+		return (NULL);
+	}
+
+	pthread_cond_init(&pool->notempty, NULL);
+	pthread_cond_init(&pool->notfull, NULL);
+
+	pool->queue_max = queue_max;
+	pool->thr       = oscap_alloc(sizeof(probe_workthr_t) * thr_max);
+	pool->thr_max   = thr_max;
+	pool->size      = size;
+	pool->dtor      = dtor;
+
+	dI("Worker pool: size=%"PRIu32", thr_max=%"PRIu32", queue_max=%"PRIu32,
+	   size, thr_max, queue_max);
+
+	return (pool);
+}
+
+int probe_workpool_submit(probe_workpool_t *pool, void *(*func)(void *), void *arg)
+{
+	probe_workreq_t *req;
+
+	req = oscap_talloc(probe_workreq_t);
+	req->func = func;
+	req->arg  = arg;
+	req->next = NULL;
+
+	probe_workpool_lock(pool);
+
+	/*
+	 * Back-pressure: don't read new requests from the library while the
+	 * queue is full and there's a worker which will eventually take a
+	 * request from it.
+	 */
+	if (pool->queue_cnt >= pool->queue_max && pool->thr_cnt > pool->blocked) {
+		++pool->stats.stalls;
+
+		do {
+			pthread_cond_wait(&pool->notfull, &pool->mutex);
+		} while (!pool->shutdown &&
+			 pool->queue_cnt >= pool->queue_max &&
+			 pool->thr_cnt > pool->blocked);
+	}
+
+	if (pool->shutdown) {
+		probe_workpool_unlock(pool);
+		oscap_free(req);
+		errno = ECANCELED;
+
+		return (-1);
+	}
+
+	req->tm_queued = probe_workpool_time();
+
+	if (pool->queue_end == NULL)
+		pool->queue_beg = req;
+	else
+		pool->queue_end->next = req;
+
+	pool->queue_end = req;
+	++pool->queue_cnt;
+	++pool->stats.submitted;
+
+	if (pool->queue_cnt > pool->stats.queue_peak)
+		pool->stats.queue_peak = pool->queue_cnt;
+
+	pthread_cond_signal(&pool->notempty);
+
+	if (probe_workpool_spawn(pool) != 0 && pool->thr_cnt == 0) {
+		/*
+		 * There's no thread which would handle the request. Nothing
+		 * was taken from the queue yet, so the request is its only
+		 * member.
+		 */
+		pool->queue_beg = pool->queue_end = NULL;
+		pool->queue_cnt = 0;
+		--pool->stats.submitted;
+
+		probe_workpool_unlock(pool);
+		oscap_free(req);
+		errno = EAGAIN;
+
+		return (-1);
+	}
+
+	probe_workpool_unlock(pool);
+
+	return (0);
+}
+
+void probe_workpool_block(probe_workpool_t *pool)
+{
+	probe_workpool_lock(pool);
+
+	--pool->running;
+	++pool->blocked;
+
+	/*
+	 * Let another worker take over the slot so that the request which
+	 * this one waits for can be handled.
+	 */
+	pthread_cond_signal(&pool->notempty);
+	pthread_cond_broadcast(&pool->notfull);
+	(void)probe_workpool_spawn(pool);
+
+	probe_workpool_unlock(pool);
+}
+
+void probe_workpool_unblock(probe_workpool_t *pool)
+{
+	probe_workpool_lock(pool);
+
+	--pool->blocked;
+	++pool->running;
+
+	probe_workpool_unlock(pool);
+}
+
+void probe_workpool_stats(probe_workpool_t *pool, probe_workpool_stats_t *stats)
+{
+	probe_workpool_lock(pool);
+	memcpy(stats, &pool->stats, sizeof(probe_workpool_stats_t));
+	probe_workpool_unlock(pool);
+}
+
+void probe_workpool_shutdown(probe_workpool_t *pool)
+{
+	uint32_t i, thr_cnt;
+
+	probe_workpool_lock(pool);
+
+	pool->shutdown = true;
+	pthread_cond_broadcast(&pool->notempty);
+	pthread_cond_broadcast(&pool->notfull);
+
+	for (i = 0; i < pool->thr_cnt; ++i)
+		if (pool->thr[i].busy)
+			pthread_cancel(pool->thr[i].tid);
+
+	thr_cnt = pool->thr_cnt;
+	pool->thr_cnt = 0;
+
+	probe_workpool_unlock(pool);
+
+	/*
+	 * Wait till all threads are canceled (they may temporarily disable
+	 * cancelability), but at most 60 seconds per thread.
+	 */
+	for (i = 0; i < thr_cnt; ++i) {
+#if defined(HAVE_PTHREAD_TIMEDJOIN_NP) && defined(HAVE_CLOCK_GETTIME)
+		struct timespec j_tm;
+
+		if (clock_gettime(CLOCK_REALTIME, &j_tm) == -1) {
+			dE("clock_gettime(CLOCK_REALTIME): %d, %s.", errno, strerror(errno));
+			continue;
+		}
+
+		j_tm.tv_sec += 60;
+
+		if ((errno = pthread_timedjoin_np(pool->thr[i].tid, NULL, &j_tm)) != 0) {
+			dE("pthread_timedjoin_np: %d, %s.", errno, strerror(errno));
+			/*
+			 * The request handled by the thread is leaked. We are shutting
+			 * down the whole probe anyway.
+			 */
+			continue;
+		}
+#else
+		if ((errno = pthread_join(pool->thr[i].tid, NULL)) != 0) {
+			dE("pthread_join: %d, %s.", errno, strerror(errno));
+			continue;
+		}
+#endif
+	}
+}
+
+void probe_workpool_free(probe_workpool_t *pool)
+{
+	probe_workreq_t *req;
+
+	if (pool == NULL)
+		return;
+
+	probe_workpool_shutdown(pool);
+
+	dI("Worker pool stats: submitted=%"PRIu64", completed=%"PRIu64", queue_peak=%"PRIu32", "
+	   "thr_peak=%"PRIu32", stalls=%"PRIu64", wait_time=%"PRIu64"us (max %"PRIu64"us), "
+	   "run_time=%"PRIu64"us (max %"PRIu64"us)",
+	   pool->stats.submitted, pool->stats.completed, pool->stats.queue_peak,
+	   pool->stats.thr_peak, pool->stats.stalls, pool->stats.wait_time, pool->stats.wait_max,
+	   pool->stats.run_time, pool->stats.run_max);
+
+	while (pool->queue_beg != NULL) {
+		req = pool->queue_beg;
+		pool->queue_beg = req->next;
+
+		if (pool->dtor != NULL)
+			pool->dtor(req->arg);
+
+		oscap_free(req);
+	}
+
+	pthread_mutex_destroy(&pool->mutex);
+	pthread_cond_destroy(&pool->notempty);
+	pthread_cond_destroy(&pool->notfull);
+
+	oscap_free(pool->thr);
+	oscap_free(pool);
+}
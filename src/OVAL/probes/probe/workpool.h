@@ -0,0 +1,133 @@
+/*
+ * Copyright 2016 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef WORKPOOL_H
+#define WORKPOOL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#ifndef PROBE_WORKPOOL_QUEUE_CAPACITY
+# define PROBE_WORKPOOL_QUEUE_CAPACITY 128 /**< maximum number of requests waiting for a worker */
+#endif
+
+typedef struct probe_workreq probe_workreq_t;
+
+struct probe_workreq {
+	void *(*func)(void *); /**< request handler */
+	void  *arg;            /**< handler argument */
+	uint64_t tm_queued;    /**< time when the request was queued (usec) */
+	probe_workreq_t *next;
+};
+
+typedef struct {
+	struct probe_workpool *pool;
+	pthread_t tid;
+	bool      busy; /**< the thread is executing a request */
+} probe_workthr_t;
+
+typedef struct {
+	uint64_t submitted;  /**< number of accepted requests */
+	uint64_t completed;  /**< number of finished requests */
+	uint32_t queue_peak; /**< the highest observed queue depth */
+	uint32_t thr_peak;   /**< the highest number of threads, including compensating ones */
+	uint64_t stalls;     /**< how many times the submitter had to wait for a free queue slot */
+	uint64_t wait_time;  /**< total time spent by requests in the queue (usec) */
+	uint64_t wait_max;   /**< the longest time spent by a request in the queue (usec) */
+	uint64_t run_time;   /**< total time spent executing requests (usec) */
+	uint64_t run_max;    /**< the longest request execution time (usec) */
+} probe_workpool_stats_t;
+
+/**
+ * A fixed size pool of worker threads fed from a bounded FIFO queue.
+ *
+ * Threads are started on demand until the pool reaches its size and
+ * are kept around for the following requests. A worker that waits for
+ * the library (see probe_workpool_block()) does not count against the
+ * size. Otherwise a chain of nested object evaluations could exhaust
+ * the pool and deadlock the probe. The number of threads never exceeds
+ * thr_max.
+ */
+typedef struct probe_workpool {
+	pthread_mutex_t mutex;
+	pthread_cond_t  notempty;
+	pthread_cond_t  notfull;
+
+	probe_workreq_t *queue_beg;
+	probe_workreq_t *queue_end;
+	uint32_t         queue_cnt;
+	uint32_t         queue_max;
+
+	probe_workthr_t *thr;     /**< thread slots */
+	uint32_t         thr_cnt; /**< number of started threads */
+	uint32_t         thr_max; /**< hard limit on the number of threads */
+	uint32_t         size;    /**< number of threads allowed to run concurrently */
+	uint32_t         idle;    /**< threads waiting for a request */
+	uint32_t         running; /**< threads executing a request */
+	uint32_t         blocked; /**< threads waiting for the library */
+	bool             shutdown;
+
+	void (*dtor)(void *); /**< destructor of arguments of unprocessed requests */
+
+	probe_workpool_stats_t stats;
+} probe_workpool_t;
+
+/**
+ * Create a new worker pool.
+ * @param size number of threads executing requests concurrently
+ * @param thr_max hard limit on the number of threads
+ * @param queue_max queue capacity
+ * @param dtor function used to discard arguments of requests which weren't processed
+ */
+probe_workpool_t *probe_workpool_new(uint32_t size, uint32_t thr_max, uint32_t queue_max, void (*dtor)(void *));
+
+/**
+ * Queue a request. If the queue is full, wait until a worker takes a request
+ * from it. The wait is skipped when all workers wait for the library because
+ * the caller might be the one who is supposed to deliver the data they wait for.
+ * @retval 0 on success
+ * @retval -1 on failure or after shutdown, the request wasn't queued
+ */
+int probe_workpool_submit(probe_workpool_t *pool, void *(*func)(void *), void *arg);
+
+/**
+ * Mark the calling worker as waiting for the library. Has to be paired
+ * with probe_workpool_unblock().
+ */
+void probe_workpool_block(probe_workpool_t *pool);
+void probe_workpool_unblock(probe_workpool_t *pool);
+
+/**
+ * Get a snapshot of the pool statistics.
+ */
+void probe_workpool_stats(probe_workpool_t *pool, probe_workpool_stats_t *stats);
+
+/**
+ * Stop accepting requests, wake up idle workers and cancel the busy
+ * ones. Wait until all threads exit, but at most 60 seconds per thread.
+ */
+void probe_workpool_shutdown(probe_workpool_t *pool);
+
+/**
+ * Shut down the pool (if not done already), discard unprocessed
+ * requests and free the pool.
+ */
+void probe_workpool_free(probe_workpool_t *pool);
+
+#endif /* WORKPOOL_H */
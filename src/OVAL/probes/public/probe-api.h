@@ -473,6 +473,7 @@ void probe_offline_mode(void);
 void probe_preload(void);
 void *probe_init(void) __attribute__ ((unused));
 void probe_fini(void *) __attribute__ ((unused));
+void probe_invalidate(void *) __attribute__ ((unused));
 
 typedef struct probe_ctx probe_ctx;
 
@@ -581,4 +582,13 @@ oval_schema_version_t probe_obj_get_platform_schema_version(const SEXP_t *obj);
  */
 SEXP_t *probe_obj_getmask(SEXP_t *obj);
 
+/**
+ * Check whether an entity of the items doesn't have to be collected because
+ * no state used with the object references it. The probe should report such
+ * an entity with the "not collected" status.
+ * @param obj the queried object
+ * @param name the name of the item entity
+ */
+bool probe_obj_skipent(const SEXP_t *obj, const char *name);
+
 /// @}
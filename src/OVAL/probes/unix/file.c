@@ -84,12 +84,9 @@
 # error "Sorry, your OS isn't supported."
 #endif
 
-oval_schema_version_t over;
-
 static SEXP_t *gr_true   = NULL, *gr_false  = NULL, *gr_t_reg  = NULL;
 static SEXP_t *gr_t_dir  = NULL, *gr_t_lnk  = NULL, *gr_t_blk  = NULL;
 static SEXP_t *gr_t_fifo = NULL, *gr_t_sock = NULL, *gr_t_char = NULL;
-static SEXP_t  gr_lastpath;
 #if defined(OS_SOLARIS)
 static SEXP_t *gr_t_door = NULL, *gr_t_port = NULL;
 #endif
@@ -115,15 +112,55 @@ static SEXP_t *se_filetype (mode_t mode)
         return (NULL);
 }
 
+/*
+ * The items are filled in from a template: the names of the entities are
+ * created once and the entities which can have only a few values (the
+ * permission bits and has_extended_acl) are built in probe_init() and
+ * shared by all the items.
+ */
+#define FILE_MODE_ENTS 12
+
+static const struct {
+	const char *name;
+	mode_t      bit;
+} file_mode_ents[FILE_MODE_ENTS] = {
+	{ "suid",   S_ISUID }, { "sgid",   S_ISGID }, { "sticky", S_ISVTX },
+	{ "uread",  S_IRUSR }, { "uwrite", S_IWUSR }, { "uexec",  S_IXUSR },
+	{ "gread",  S_IRGRP }, { "gwrite", S_IWGRP }, { "gexec",  S_IXGRP },
+	{ "oread",  S_IROTH }, { "owrite", S_IWOTH }, { "oexec",  S_IXOTH }
+};
+
+#define FILE_ACL_FALSE          0
+#define FILE_ACL_TRUE           1
+#define FILE_ACL_DOES_NOT_EXIST 2 /* it can't be determined */
+#define FILE_ACL_NOT_COLLECTED  3 /* no state references it */
+
+static struct {
+	SEXP_t *item, *id, *noid; /* file_item :id "" */
+	SEXP_t *filepath, *path, *filename, *type, *group_id, *user_id;
+	SEXP_t *a_time, *c_time, *m_time, *size;
+	SEXP_t *mode[FILE_MODE_ENTS][2];
+	SEXP_t *acl[4];
+} tmpl;
+
 struct cbargs {
         probe_ctx *ctx;
 	int     error;
+	oval_schema_version_t over;
+	bool    acl;      /* collect has_extended_acl */
+	SEXP_t  lastpath; /* path of the previous item, shared by the items in a directory */
 };
 
 static rbt_t   *g_ID_cache     = NULL;
 static uint32_t g_ID_cache_max = 0; /* 0 = unlimited */
 
-static SEXP_t *ID_cache_get(int32_t id)
+/*
+ * The cache is shared by all the workers. The tree locks every call and
+ * the nodes aren't removed until probe_fini(), so a reference can be taken
+ * from a node outside of the lock. When two workers miss the same ID, the
+ * second insert fails and the value of the first one is used.
+ */
+static SEXP_t *ID_cache_get(int32_t id, oval_schema_version_t over)
 {
 	SEXP_t *s_id = NULL, *s_id2 = NULL;
 
@@ -150,10 +187,12 @@ static SEXP_t *ID_cache_get(int32_t id)
 	return (s_id);
 }
 
-static void ID_cache_init(uint32_t max)
+static rbt_t *ID_cache_init(uint32_t max)
 {
 	g_ID_cache_max = max;
 	g_ID_cache     = rbt_i32_new();
+
+	return (g_ID_cache);
 }
 
 static void ID_cache_free_cb(rbt_i32_node_t *n)
@@ -168,7 +207,7 @@ static void ID_cache_free(void)
 	g_ID_cache_max = 0;
 }
 
-static SEXP_t *get_atime(struct stat *st, SEXP_t *sexp)
+static SEXP_t *get_atime(struct stat *st, SEXP_t *sexp, oval_schema_version_t over)
 {
 	uint64_t t = (
 #if defined(OS_FREEBSD)
@@ -189,7 +228,7 @@ static SEXP_t *get_atime(struct stat *st, SEXP_t *sexp)
 	}
 }
 
-static SEXP_t *get_ctime(struct stat *st, SEXP_t *sexp)
+static SEXP_t *get_ctime(struct stat *st, SEXP_t *sexp, oval_schema_version_t over)
 {
 	uint64_t t = (
 #if defined(OS_FREEBSD)
@@ -210,7 +249,7 @@ static SEXP_t *get_ctime(struct stat *st, SEXP_t *sexp)
 	}
 }
 
-static SEXP_t *get_mtime(struct stat *st, SEXP_t *sexp)
+static SEXP_t *get_mtime(struct stat *st, SEXP_t *sexp, oval_schema_version_t over)
 {
 	uint64_t t = (
 #if defined(OS_FREEBSD)
@@ -249,25 +288,81 @@ static SEXP_t *get_size(struct stat *st, SEXP_t *sexp)
 #endif
 }
 
-#define MODEP(statp, bit) ((statp)->st_mode & (bit) ? gr_true : gr_false)
-
-static SEXP_t *has_extended_acl(const char *path)
+static int has_extended_acl(const char *path)
 {
 #if defined(HAVE_ACL_EXTENDED_FILE)
 	int has_acl = acl_extended_file(path);
 	if (has_acl == -1) {
 		dW("Getting extended ACL for file '%s' has failed, %s", path, strerror(errno));
-		return NULL;
+		return FILE_ACL_DOES_NOT_EXIST;
 	}
-	return (has_acl == 1) ? gr_true : gr_false;
+	return (has_acl == 1) ? FILE_ACL_TRUE : FILE_ACL_FALSE;
 #elif defined(OS_SOLARIS)
-	return acl_trivial(path) ? gr_true : gr_false;
+	return acl_trivial(path) ? FILE_ACL_TRUE : FILE_ACL_FALSE;
 #else
-	return NULL;
+	return FILE_ACL_DOES_NOT_EXIST;
 #endif
 }
 
-static int file_cb (const char *p, const char *f, void *ptr)
+#define FILE_ITEM_ENTS (10 + FILE_MODE_ENTS + 1)
+
+static SEXP_t *file_item_new(struct cbargs *args, const char *f, const char *st_path, struct stat *st)
+{
+	SEXP_t  head, ents[10], vals[6], *memb[FILE_ITEM_ENTS], *item;
+	SEXP_t *se_usr_id, *se_grp_id;
+	size_t  e = 0, v = 0, m = 0, i;
+
+	se_usr_id = ID_cache_get(st->st_uid, args->over);
+	se_grp_id = st->st_gid != st->st_uid ? ID_cache_get(st->st_gid, args->over) : SEXP_ref(se_usr_id);
+
+	if (oval_schema_version_cmp(args->over, OVAL_SCHEMA_VERSION(5.6)) >= 0 && f != NULL) {
+		SEXP_string_new_r(&vals[v], st_path, strlen(st_path));
+		memb[m++] = SEXP_list_new_r(&ents[e++], tmpl.filepath, &vals[v++], NULL);
+	}
+
+	memb[m++] = SEXP_list_new_r(&ents[e++], tmpl.path, &args->lastpath, NULL);
+
+	if (f == NULL)
+		f = "";
+
+	SEXP_string_new_r(&vals[v], f, strlen(f));
+	memb[m++] = SEXP_list_new_r(&ents[e++], tmpl.filename, &vals[v++], NULL);
+	memb[m++] = SEXP_list_new_r(&ents[e++], tmpl.type, se_filetype(st->st_mode), NULL);
+	memb[m++] = SEXP_list_new_r(&ents[e++], tmpl.group_id, se_grp_id, NULL);
+	memb[m++] = SEXP_list_new_r(&ents[e++], tmpl.user_id, se_usr_id, NULL);
+	memb[m++] = SEXP_list_new_r(&ents[e++], tmpl.a_time, get_atime(st, &vals[v++], args->over), NULL);
+	memb[m++] = SEXP_list_new_r(&ents[e++], tmpl.c_time, get_ctime(st, &vals[v++], args->over), NULL);
+	memb[m++] = SEXP_list_new_r(&ents[e++], tmpl.m_time, get_mtime(st, &vals[v++], args->over), NULL);
+	memb[m++] = SEXP_list_new_r(&ents[e++], tmpl.size, get_size(st, &vals[v++]), NULL);
+
+	for (i = 0; i < FILE_MODE_ENTS; ++i)
+		memb[m++] = tmpl.mode[i][(st->st_mode & file_mode_ents[i].bit) != 0];
+
+	if (oval_schema_version_cmp(args->over, OVAL_SCHEMA_VERSION(5.7)) < 0)
+		memb[m++] = tmpl.acl[FILE_ACL_DOES_NOT_EXIST];
+	else
+		memb[m++] = tmpl.acl[args->acl ? has_extended_acl(st_path) : FILE_ACL_NOT_COLLECTED];
+
+	/* the ID is set when the item is added to the item cache */
+	item = SEXP_list_new(SEXP_list_new_r(&head, tmpl.item, tmpl.id, tmpl.noid, NULL), NULL);
+
+	for (i = 0; i < m; ++i)
+		SEXP_list_add(item, memb[i]);
+
+	SEXP_free_r(&head);
+
+	while (e > 0)
+		SEXP_free_r(&ents[--e]);
+	while (v > 0)
+		SEXP_free_r(&vals[--v]);
+
+	SEXP_free(se_grp_id);
+	SEXP_free(se_usr_id);
+
+	return (item);
+}
+
+static int file_cb (const char *p, const char *f, struct stat *statp, void *ptr)
 {
         char path_buffer[PATH_MAX];
         SEXP_t *item;
@@ -282,90 +377,33 @@ static int file_cb (const char *p, const char *f, void *ptr)
 		st_path = path_buffer;
 	}
 
-        if (lstat (st_path, &st) == -1) {
+	/* the walk usually stat'ed the entry already */
+        if (statp == NULL && fscache_lstat (st_path, statp = &st) == -1) {
                 dI("lstat failed when processing %s: errno=%u, %s.", st_path, errno, strerror (errno));
 		return strncmp(st_path, "/proc", 4) == 0 ? 0 : -1;
-        } else {
-                SEXP_t *se_usr_id, *se_grp_id;
-                SEXP_t  se_atime_mem, se_ctime_mem, se_mtime_mem, se_size_mem;
-		SEXP_t *se_filepath, *se_acl;
-
-		if (oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.6)) < 0
-		    || f == NULL) {
-			se_filepath = NULL;
-		} else {
-			se_filepath = SEXP_string_newf("%s", st_path);
-		}
-
-		se_usr_id = ID_cache_get(st.st_uid);
-		se_grp_id = st.st_gid != st.st_uid ? ID_cache_get(st.st_gid) : SEXP_ref(se_usr_id);
-
-		if (!SEXP_emptyp(&gr_lastpath)) {
-			if (SEXP_strcmp(&gr_lastpath, p) != 0) {
-				SEXP_free_r(&gr_lastpath);
-				SEXP_string_new_r(&gr_lastpath, p, strlen(p));
-			}
-		} else
-			SEXP_string_new_r(&gr_lastpath, p, strlen(p));
+        }
 
-		if (oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.7)) < 0) {
-			se_acl = NULL;
-		} else {
-			se_acl = has_extended_acl(st_path);
+	if (!SEXP_emptyp(&args->lastpath)) {
+		if (SEXP_strcmp(&args->lastpath, p) != 0) {
+			SEXP_free_r(&args->lastpath);
+			SEXP_string_new_r(&args->lastpath, p, strlen(p));
 		}
+	} else
+		SEXP_string_new_r(&args->lastpath, p, strlen(p));
 
-                item = probe_item_create(OVAL_UNIX_FILE, NULL,
-                                         "filepath", OVAL_DATATYPE_SEXP, se_filepath,
-                                         "path",     OVAL_DATATYPE_SEXP,  &gr_lastpath,
-                                         "filename", OVAL_DATATYPE_STRING, f == NULL ? "" : f,
-                                         "type",     OVAL_DATATYPE_SEXP, se_filetype(st.st_mode),
-                                         "group_id", OVAL_DATATYPE_SEXP, se_grp_id,
-                                         "user_id",  OVAL_DATATYPE_SEXP, se_usr_id,
-                                         "a_time",   OVAL_DATATYPE_SEXP, get_atime(&st, &se_atime_mem),
-                                         "c_time",   OVAL_DATATYPE_SEXP, get_ctime(&st, &se_ctime_mem),
-                                         "m_time",   OVAL_DATATYPE_SEXP, get_mtime(&st, &se_mtime_mem),
-                                         "size",     OVAL_DATATYPE_SEXP, get_size(&st, &se_size_mem),
-                                         "suid",     OVAL_DATATYPE_SEXP, MODEP(&st, S_ISUID),
-                                         "sgid",     OVAL_DATATYPE_SEXP, MODEP(&st, S_ISGID),
-                                         "sticky",   OVAL_DATATYPE_SEXP, MODEP(&st, S_ISVTX),
-                                         "uread",    OVAL_DATATYPE_SEXP, MODEP(&st, S_IRUSR),
-                                         "uwrite",   OVAL_DATATYPE_SEXP, MODEP(&st, S_IWUSR),
-                                         "uexec",    OVAL_DATATYPE_SEXP, MODEP(&st, S_IXUSR),
-                                         "gread",    OVAL_DATATYPE_SEXP, MODEP(&st, S_IRGRP),
-                                         "gwrite",   OVAL_DATATYPE_SEXP, MODEP(&st, S_IWGRP),
-                                         "gexec",    OVAL_DATATYPE_SEXP, MODEP(&st, S_IXGRP),
-                                         "oread",    OVAL_DATATYPE_SEXP, MODEP(&st, S_IROTH),
-                                         "owrite",   OVAL_DATATYPE_SEXP, MODEP(&st, S_IWOTH),
-                                         "oexec",    OVAL_DATATYPE_SEXP, MODEP(&st, S_IXOTH),
-					 "has_extended_acl", OVAL_DATATYPE_SEXP, se_acl,
-                                         NULL);
-		if (se_acl == NULL) {
-			probe_item_ent_add(item, "has_extended_acl", NULL, gr_true);
-			probe_itement_setstatus(item, "has_extended_acl", 1, SYSCHAR_STATUS_DOES_NOT_EXIST);
-		}
+	item = file_item_new(args, f, st_path, statp);
 
-                SEXP_free(se_grp_id);
-                SEXP_free(se_usr_id);
-		SEXP_free(se_filepath);
-                SEXP_free_r(&se_atime_mem);
-                SEXP_free_r(&se_ctime_mem);
-                SEXP_free_r(&se_mtime_mem);
-                SEXP_free_r(&se_size_mem);
-
-		/*
-		 * Stop collecting if we hit the memory usage limit
-		 * (return code == 2)
-		 */
-                return probe_item_collect(args->ctx, item) == 2 ? 1 : 0;
-        }
-
-        return (0);
+	/*
+	 * Stop collecting if we hit the memory usage limit
+	 * (return code == 2)
+	 */
+        return probe_item_collect(args->ctx, item) == 2 ? 1 : 0;
 }
 
-static pthread_mutex_t __file_probe_mutex;
-
 void *probe_init (void)
 {
+	size_t i;
+
 	probe_setoption(PROBEOPT_OFFLINE_MODE_SUPPORTED, PROBE_OFFLINE_CHROOT);
         /*
          * Initialize true/false global reference.
@@ -402,32 +440,50 @@ void *probe_init (void)
         gr_t_port = SEXP_string_new (STRLEN_PAIR(STR_PORT));
 #endif
 
-	SEXP_init(&gr_lastpath);
-
 	/*
-	 * Initialize ID cache
+	 * Initialize the item template
 	 */
-	ID_cache_init(10000);
+	tmpl.item     = SEXP_string_new (STRLEN_PAIR("file_item"));
+	tmpl.id       = SEXP_string_new (STRLEN_PAIR(":id"));
+	tmpl.noid     = SEXP_string_new ("", 0);
+	tmpl.filepath = SEXP_string_new (STRLEN_PAIR("filepath"));
+	tmpl.path     = SEXP_string_new (STRLEN_PAIR("path"));
+	tmpl.filename = SEXP_string_new (STRLEN_PAIR("filename"));
+	tmpl.type     = SEXP_string_new (STRLEN_PAIR("type"));
+	tmpl.group_id = SEXP_string_new (STRLEN_PAIR("group_id"));
+	tmpl.user_id  = SEXP_string_new (STRLEN_PAIR("user_id"));
+	tmpl.a_time   = SEXP_string_new (STRLEN_PAIR("a_time"));
+	tmpl.c_time   = SEXP_string_new (STRLEN_PAIR("c_time"));
+	tmpl.m_time   = SEXP_string_new (STRLEN_PAIR("m_time"));
+	tmpl.size     = SEXP_string_new (STRLEN_PAIR("size"));
+
+	for (i = 0; i < FILE_MODE_ENTS; ++i) {
+		tmpl.mode[i][0] = probe_ent_creat1 (file_mode_ents[i].name, NULL, gr_false);
+		tmpl.mode[i][1] = probe_ent_creat1 (file_mode_ents[i].name, NULL, gr_true);
+	}
+
+	tmpl.acl[FILE_ACL_FALSE]          = probe_ent_creat1 ("has_extended_acl", NULL, gr_false);
+	tmpl.acl[FILE_ACL_TRUE]           = probe_ent_creat1 ("has_extended_acl", NULL, gr_true);
+	tmpl.acl[FILE_ACL_DOES_NOT_EXIST] = probe_ent_creat1 ("has_extended_acl", NULL, gr_true);
+	tmpl.acl[FILE_ACL_NOT_COLLECTED]  = probe_ent_creat1 ("has_extended_acl", NULL, gr_true);
+	probe_ent_setstatus (tmpl.acl[FILE_ACL_DOES_NOT_EXIST], SYSCHAR_STATUS_DOES_NOT_EXIST);
+	probe_ent_setstatus (tmpl.acl[FILE_ACL_NOT_COLLECTED], SYSCHAR_STATUS_NOT_COLLECTED);
 
-        /*
-         * Initialize mutex.
-         */
-        switch (pthread_mutex_init (&__file_probe_mutex, NULL)) {
-        case 0:
-                return ((void *)&__file_probe_mutex);
-        default:
-                dI("Can't initialize mutex: errno=%u, %s.", errno, strerror (errno));
-        }
 #if 0
 	probe_setoption(PROBEOPT_VARREF_HANDLING, false, "path");
 	probe_setoption(PROBEOPT_VARREF_HANDLING, false, "filename");
 #endif
-        return (NULL);
+	/*
+	 * Initialize ID cache
+	 */
+	return ((void *)ID_cache_init(10000));
 }
 
 void probe_fini (void *arg)
 {
-        _A((void *)arg == (void *)&__file_probe_mutex);
+	size_t i;
+
+        _A((void *)arg == (void *)g_ID_cache);
 
         /*
          * Release global reference.
@@ -437,23 +493,27 @@ void probe_fini (void *arg)
                     gr_t_fifo, gr_t_sock, gr_t_char,
                     NULL);
 
-	if (!SEXP_emptyp(&gr_lastpath))
-		SEXP_free_r(&gr_lastpath);
+	SEXP_vfree (tmpl.item, tmpl.id, tmpl.noid,
+	            tmpl.filepath, tmpl.path, tmpl.filename,
+	            tmpl.type, tmpl.group_id, tmpl.user_id,
+	            tmpl.a_time, tmpl.c_time, tmpl.m_time, tmpl.size,
+	            NULL);
+
+	for (i = 0; i < FILE_MODE_ENTS; ++i)
+		SEXP_vfree (tmpl.mode[i][0], tmpl.mode[i][1], NULL);
+
+	for (i = 0; i < sizeof tmpl.acl / sizeof tmpl.acl[0]; ++i)
+		SEXP_free (tmpl.acl[i]);
 
 	/*
 	 * Free ID cache
 	 */
 	ID_cache_free();
 
-        /*
-         * Destroy mutex.
-         */
-        (void) pthread_mutex_destroy (&__file_probe_mutex);
-
         return;
 }
 
-int probe_main (probe_ctx *ctx, void *mutex)
+int probe_main (probe_ctx *ctx, void *cache)
 {
         SEXP_t *path, *filename, *behaviors, *filepath, *probe_in;
 	int err;
@@ -461,15 +521,14 @@ int probe_main (probe_ctx *ctx, void *mutex)
 	OVAL_FTS    *ofts;
 	OVAL_FTSENT *ofts_ent;
 
-        if (mutex == NULL) {
+        if (cache == NULL) {
                 return PROBE_EINIT;
 	}
 
-        _A(mutex == &__file_probe_mutex);
+        _A(cache == g_ID_cache);
 
         probe_in  = probe_ctx_getobject(ctx);
 
-	over = probe_obj_get_platform_schema_version(probe_in);
         path      = probe_obj_getent (probe_in, "path",      1);
         filename  = probe_obj_getent (probe_in, "filename",  1);
         behaviors = probe_obj_getent (probe_in, "behaviors", 1);
@@ -487,26 +546,16 @@ int probe_main (probe_ctx *ctx, void *mutex)
 
 	probe_filebehaviors_canonicalize(&behaviors);
 
-        switch (pthread_mutex_lock (&__file_probe_mutex)) {
-        case 0:
-                break;
-        default:
-                dI("Can't lock mutex(%p): %u, %s.", &__file_probe_mutex, errno, strerror (errno));
-
-		SEXP_free(path);
-		SEXP_free(filename);
-		SEXP_free(filepath);
-		SEXP_free(behaviors);
-
-                return PROBE_EFATAL;
-        }
-
         cbargs.ctx     = ctx;
 	cbargs.error   = 0;
+	cbargs.over    = probe_obj_get_platform_schema_version(probe_in);
+	cbargs.acl     = !probe_obj_skipent(probe_in, "has_extended_acl");
+	SEXP_init(&cbargs.lastpath);
 
 	if ((ofts = oval_fts_open(path, filename, filepath, behaviors, probe_ctx_getresult(ctx))) != NULL) {
 		while ((ofts_ent = oval_fts_read(ofts)) != NULL) {
-			if (file_cb(ofts_ent->path, ofts_ent->file, &cbargs) != 0) {
+			if (file_cb(ofts_ent->path, ofts_ent->file,
+				    ofts_ent->st_valid ? &ofts_ent->st : NULL, &cbargs) != 0) {
 				oval_ftsent_free(ofts_ent);
 				break;
 			}
@@ -522,14 +571,8 @@ int probe_main (probe_ctx *ctx, void *mutex)
 	SEXP_free(filepath);
 	SEXP_free(behaviors);
 
-        switch (pthread_mutex_unlock (&__file_probe_mutex)) {
-        case 0:
-                break;
-        default:
-                dI("Can't unlock mutex(%p): %u, %s.", &__file_probe_mutex, errno, strerror (errno));
-
-                return PROBE_EFATAL;
-        }
+	if (!SEXP_emptyp(&cbargs.lastpath))
+		SEXP_free_r(&cbargs.lastpath);
 
         return err;
 }
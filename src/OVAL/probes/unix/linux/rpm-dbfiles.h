@@ -0,0 +1,44 @@
+/*
+ * Copyright 2016 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#ifndef __RPM_DBFILES__
+#define __RPM_DBFILES__
+
+#include <stddef.h>
+#include "common/util.h"
+
+OSCAP_HIDDEN_START;
+
+/*
+ * Files of the supported rpmdb backends (Berkeley DB, NDB, SQLite).
+ * Any transaction modifies at least one of them. The list doesn't depend
+ * on librpm, the probe cache of the library uses it too. NULL terminated.
+ */
+extern const char *rpm_dbfiles[];
+
+/*
+ * Default locations of the database, rpm >= 4.16 keeps it in
+ * /usr/lib/sysimage/rpm and /var/lib/rpm may be a symlink to it.
+ * NULL terminated.
+ */
+extern const char *rpm_dbpaths[];
+
+OSCAP_HIDDEN_END;
+
+#endif /* __RPM_DBFILES__ */
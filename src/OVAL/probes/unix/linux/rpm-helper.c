@@ -24,6 +24,15 @@
 #include <config.h>
 #endif
 
+#include <stdlib.h>
+#include <string.h>
+#include <regex.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <alloc.h>
+#include "rpm-dbfiles.h"
+
 #ifdef HAVE_RPM46
 int rpmErrorCb (rpmlogRec rec, rpmlogCallbackData data)
 {
@@ -39,3 +48,202 @@ void rpmLibsPreload()
 	const char* rcfiles = "";
 	rpmReadConfigFiles(rcfiles, NULL);
 }
+
+static uint64_t rpm_dbstamp(rpmts ts)
+{
+	const char *root;
+	char *dbpath, *path;
+	struct stat st;
+	uint64_t stamp = 14695981039346656037ULL;
+	int i;
+
+	root   = rpmtsRootDir(ts);
+	dbpath = rpmExpand("%{_dbpath}", NULL);
+
+	for (i = 0; rpm_dbfiles[i] != NULL; ++i) {
+		path = oscap_sprintf("%s/%s/%s", root != NULL ? root : "", dbpath, rpm_dbfiles[i]);
+
+		if (stat(path, &st) == 0) {
+			stamp = (stamp ^ (uint64_t)st.st_ino) * 1099511628211ULL;
+			stamp = (stamp ^ (uint64_t)st.st_size) * 1099511628211ULL;
+			stamp = (stamp ^ (uint64_t)st.st_mtime) * 1099511628211ULL;
+			stamp = (stamp ^ (uint64_t)st.st_mtim.tv_nsec) * 1099511628211ULL;
+		} else
+			stamp = (stamp ^ (uint64_t)i) * 1099511628211ULL;
+
+		oscap_free(path);
+	}
+
+	free(dbpath);
+
+	return (stamp);
+}
+
+static unsigned int rpm_pkgindex_hash(const char *name, unsigned int size)
+{
+	unsigned int h = 0;
+	const unsigned char *p;
+
+	for (p = (const unsigned char *)name; *p != '\0'; ++p)
+		h = (97 * h) + *p;
+
+	return (h % size);
+}
+
+static void rpm_pkgindex_clear(rpm_pkgindex_t *idx)
+{
+	unsigned int i;
+
+	for (i = 0; i < idx->pkg_cnt; ++i) {
+		if (idx->pkg[i].data != NULL && idx->data_free != NULL)
+			idx->data_free(idx->pkg[i].data);
+		free(idx->pkg[i].name);
+	}
+
+	oscap_free(idx->pkg);
+	oscap_free(idx->bucket);
+
+	idx->pkg     = NULL;
+	idx->pkg_cnt = 0;
+	idx->bucket  = NULL;
+	idx->bucket_cnt = 0;
+	idx->valid   = false;
+}
+
+static int rpm_pkgindex_build(rpm_pkgindex_t *idx, rpmts ts)
+{
+	rpmdbMatchIterator match;
+	Header pkgh;
+	errmsg_t rpmerr;
+	unsigned int i, h, pkg_max = 0;
+	char *name;
+
+	match = rpmtsInitIterator(ts, RPMDBI_PACKAGES, NULL, 0);
+
+	if (match != NULL) {
+		while ((pkgh = rpmdbNextIterator(match)) != NULL) {
+			name = headerFormat(pkgh, "%{NAME}", &rpmerr);
+
+			if (name == NULL)
+				continue;
+
+			if (idx->pkg_cnt == pkg_max) {
+				pkg_max  = pkg_max > 0 ? 2 * pkg_max : 1024;
+				idx->pkg = oscap_realloc(idx->pkg, sizeof(rpm_pkgindex_entry_t) * pkg_max);
+			}
+
+			idx->pkg[idx->pkg_cnt].name     = name;
+			idx->pkg[idx->pkg_cnt].instance = rpmdbGetIteratorOffset(match);
+			idx->pkg[idx->pkg_cnt].data     = NULL;
+			idx->pkg[idx->pkg_cnt].next     = -1;
+			++idx->pkg_cnt;
+		}
+
+		match = rpmdbFreeIterator(match);
+	}
+
+	idx->bucket_cnt = 2 * idx->pkg_cnt + 1;
+	idx->bucket     = oscap_alloc(sizeof(int) * idx->bucket_cnt);
+
+	for (i = 0; i < idx->bucket_cnt; ++i)
+		idx->bucket[i] = -1;
+
+	/* insert in reverse order so that the chains keep the rpmdb order */
+	for (i = idx->pkg_cnt; i > 0; --i) {
+		h = rpm_pkgindex_hash(idx->pkg[i - 1].name, idx->bucket_cnt);
+		idx->pkg[i - 1].next = idx->bucket[h];
+		idx->bucket[h] = i - 1;
+	}
+
+	idx->valid = true;
+	dI("rpmdb package index: %u packages", idx->pkg_cnt);
+
+	return (0);
+}
+
+int rpm_pkgindex_sync(rpm_pkgindex_t *idx, rpmts ts)
+{
+	uint64_t stamp;
+
+	stamp = rpm_dbstamp(ts);
+
+	if (idx->valid) {
+		if (idx->stamp == stamp)
+			return (0);
+
+		dI("rpmdb was modified, rebuilding the package index");
+		rpm_pkgindex_clear(idx);
+		/* make sure the next iterator doesn't see stale data */
+		rpmtsCloseDB(ts);
+	}
+
+	if (rpm_pkgindex_build(idx, ts) != 0) {
+		rpm_pkgindex_clear(idx);
+		return (-1);
+	}
+
+	idx->stamp = stamp;
+
+	return (0);
+}
+
+int rpm_pkgindex_select(rpm_pkgindex_t *idx, const char *name, oval_operation_t op, rpm_pkgindex_entry_t ***result)
+{
+	rpm_pkgindex_entry_t **sel;
+	regex_t re;
+	unsigned int i;
+	int e, cnt = 0;
+
+	*result = NULL;
+
+	if (!idx->valid || idx->pkg_cnt == 0)
+		return (0);
+
+	sel = oscap_alloc(sizeof(rpm_pkgindex_entry_t *) * idx->pkg_cnt);
+
+	switch (op) {
+	case OVAL_OPERATION_EQUALS:
+		for (e = idx->bucket[rpm_pkgindex_hash(name, idx->bucket_cnt)]; e != -1; e = idx->pkg[e].next)
+			if (strcmp(idx->pkg[e].name, name) == 0)
+				sel[cnt++] = idx->pkg + e;
+		break;
+	case OVAL_OPERATION_NOT_EQUAL:
+		for (i = 0; i < idx->pkg_cnt; ++i)
+			sel[cnt++] = idx->pkg + i;
+		break;
+	case OVAL_OPERATION_PATTERN_MATCH:
+		/* the same semantics as RPMMIRE_REGEX */
+		if (regcomp(&re, name, REG_EXTENDED | REG_NOSUB) != 0) {
+			dE("regcomp(%s) failed.", name);
+			oscap_free(sel);
+			return (-1);
+		}
+
+		for (i = 0; i < idx->pkg_cnt; ++i)
+			if (regexec(&re, idx->pkg[i].name, 0, NULL, 0) == 0)
+				sel[cnt++] = idx->pkg + i;
+
+		regfree(&re);
+		break;
+	default:
+		oscap_free(sel);
+		return (-1);
+	}
+
+	if (cnt == 0)
+		oscap_free(sel);
+	else
+		*result = sel;
+
+	return (cnt);
+}
+
+rpmdbMatchIterator rpm_pkgindex_iterator(rpmts ts, unsigned int instance)
+{
+	return rpmtsInitIterator(ts, RPMDBI_PACKAGES, &instance, sizeof(instance));
+}
+
+void rpm_pkgindex_free(rpm_pkgindex_t *idx)
+{
+	rpm_pkgindex_clear(idx);
+}
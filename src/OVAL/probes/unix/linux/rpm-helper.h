@@ -33,13 +33,39 @@
 #include <rpm/header.h>
 
 #include <pthread.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <oval_definitions.h>
 #include "common/util.h"
 #include "common/debug_priv.h"
 #include "pthread.h"
 
+typedef struct {
+	char        *name;     /**< package name */
+	unsigned int instance; /**< rpmdb record number of the package header */
+	void        *data;     /**< probe specific data attached to the package, see rpm_pkgindex_t.data_free */
+	int          next;     /**< next entry in the same hash bucket, -1 terminates the chain */
+} rpm_pkgindex_entry_t;
+
+/**
+ * Snapshot of the package names in rpmdb. It is built on first use and
+ * reused by all objects until rpmdb changes, so that looking up a package
+ * doesn't require iterating over all headers in the database.
+ */
+typedef struct {
+	rpm_pkgindex_entry_t *pkg;        /**< all packages, in rpmdb order */
+	unsigned int          pkg_cnt;
+	int                  *bucket;     /**< name hash -> first entry */
+	unsigned int          bucket_cnt;
+	uint64_t              stamp;      /**< state of the rpmdb files when the index was built */
+	bool                  valid;
+	void (*data_free)(void *);        /**< destructor of rpm_pkgindex_entry_t.data */
+} rpm_pkgindex_t;
+
 struct rpm_probe_global {
 	rpmts rpmts;
 	pthread_mutex_t mutex;
+	rpm_pkgindex_t pkgindex;
 };
 
 #ifndef HAVE_HEADERFORMAT
@@ -93,4 +119,34 @@ int rpmErrorCb (rpmlogRec rec, rpmlogCallbackData data);
  */
 void rpmLibsPreload(void);
 
+/**
+ * Build the package index or rebuild it if rpmdb was modified since
+ * the last call. Has to be called with the rpm mutex locked.
+ * @return 0 on success, -1 on failure
+ */
+int rpm_pkgindex_sync(rpm_pkgindex_t *idx, rpmts ts);
+
+/**
+ * Select packages from the index by name.
+ * @param name package name or a POSIX extended regular expression
+ * @param op OVAL_OPERATION_EQUALS, OVAL_OPERATION_NOT_EQUAL (all packages
+ *        are returned and have to be filtered by the caller, as before)
+ *        or OVAL_OPERATION_PATTERN_MATCH
+ * @param result array of pointers to the index entries, has to be freed
+ *        by the caller. The entries are valid until the next call to
+ *        rpm_pkgindex_sync().
+ * @return number of selected packages, -1 on failure
+ */
+int rpm_pkgindex_select(rpm_pkgindex_t *idx, const char *name, oval_operation_t op, rpm_pkgindex_entry_t ***result);
+
+/**
+ * Get an iterator over the single header stored in the given rpmdb record.
+ */
+rpmdbMatchIterator rpm_pkgindex_iterator(rpmts ts, unsigned int instance);
+
+/**
+ * Free the index content.
+ */
+void rpm_pkgindex_free(rpm_pkgindex_t *idx);
+
 #endif
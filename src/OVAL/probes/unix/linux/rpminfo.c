@@ -87,6 +87,7 @@ struct rpminfo_rep {
         char *evr;
         char *signature_keyid;
 	char extended_name[1024];
+	unsigned int instance; /**< rpmdb record number of the header */
 };
 
 #define RPMINFO_LOCK	RPM_MUTEX_LOCK(&g_rpm.mutex)
@@ -162,66 +163,53 @@ static void pkgh2rep (Header h, struct rpminfo_rep *r)
         oscap_free (str);
 }
 
+static void rpminfo_rep_free (void *ptr)
+{
+        __rpminfo_rep_free ((struct rpminfo_rep *)ptr);
+        oscap_free (ptr);
+}
+
+static void rpminfo_rep_copy (struct rpminfo_rep *dst, const struct rpminfo_rep *src)
+{
+        dst->name    = oscap_strdup (src->name);
+        dst->arch    = oscap_strdup (src->arch);
+        dst->epoch   = oscap_strdup (src->epoch);
+        dst->release = oscap_strdup (src->release);
+        dst->version = oscap_strdup (src->version);
+        dst->evr     = oscap_strdup (src->evr);
+        dst->signature_keyid = oscap_strdup (src->signature_keyid);
+        dst->instance = src->instance;
+        memcpy (dst->extended_name, src->extended_name, sizeof dst->extended_name);
+}
+
 /*
  * req - Structure containing the name of the package.
  * rep - Pointer to rpminfo_rep structure pointer. An
  *       array of rpminfo_rep structures will be allocated
  *       here.
  *
+ * The packages are looked up in the package index and the
+ * rpminfo_rep structure of each package is cached in the
+ * index, so that rpmdb is accessed only the first time a
+ * package is reported.
+ *
  * The return value on error is -1. Otherwise the number of
  * rpminfo_rep structures allocated in *rep is returned.
  */
 static int get_rpminfo (struct rpminfo_req *req, struct rpminfo_rep **rep)
 {
+	rpm_pkgindex_entry_t **pkg = NULL;
 	rpmdbMatchIterator match;
 	Header pkgh;
-	int ret = 0, i;
+	struct rpminfo_rep *cached;
+	int ret = 0, i, cnt;
 
         RPMINFO_LOCK;
 
-        ret = -1;
-
         switch (req->op) {
         case OVAL_OPERATION_EQUALS:
-                match = rpmtsInitIterator (g_rpm.rpmts, RPMTAG_NAME, (const void *)req->name, 0);
-
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
-
-                ret = rpmdbGetIteratorCount (match);
-
-                break;
 	case OVAL_OPERATION_NOT_EQUAL:
-                match = rpmtsInitIterator (g_rpm.rpmts, RPMDBI_PACKAGES, NULL, 0);
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
-
-                if (rpmdbSetIteratorRE (match, RPMTAG_NAME, RPMMIRE_GLOB, "*") != 0)
-                {
-                        ret = -1;
-                        goto ret;
-                }
-
-                break;
         case OVAL_OPERATION_PATTERN_MATCH:
-                match = rpmtsInitIterator (g_rpm.rpmts, RPMDBI_PACKAGES, NULL, 0);
-
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
-
-                if (rpmdbSetIteratorRE (match, RPMTAG_NAME, RPMMIRE_REGEX,
-                                        (const char *)req->name) != 0)
-                {
-                        ret = -1;
-                        goto ret;
-                }
-
                 break;
         default:
                 /* not supported */
@@ -229,35 +217,52 @@ static int get_rpminfo (struct rpminfo_req *req, struct rpminfo_rep **rep)
                 goto ret;
         }
 
-        if (ret != -1) {
-                /*
-                 * We can allocate all memory needed now because we know the number
-                 * of results.
-                 */
-                (*rep) = oscap_realloc (*rep, sizeof (struct rpminfo_rep) * ret);
-
-                for (i = 0; i < ret; ++i) {
-                        pkgh = rpmdbNextIterator (match);
-
-                        if (pkgh != NULL)
-                                pkgh2rep (pkgh, (*rep) + i);
-                        else {
-                                /* XXX: emit warning */
-                                break;
+        if (rpm_pkgindex_sync (&g_rpm.pkgindex, g_rpm.rpmts) != 0) {
+                ret = -1;
+                goto ret;
+        }
+
+        cnt = rpm_pkgindex_select (&g_rpm.pkgindex, req->name, req->op, &pkg);
+
+        if (cnt <= 0) {
+                ret = cnt;
+                goto ret;
+        }
+
+        (*rep) = oscap_realloc (*rep, sizeof (struct rpminfo_rep) * cnt);
+
+        for (i = 0; i < cnt; ++i) {
+                cached = (struct rpminfo_rep *)pkg[i]->data;
+
+                if (cached == NULL) {
+                        match = rpm_pkgindex_iterator (g_rpm.rpmts, pkg[i]->instance);
+                        pkgh  = match != NULL ? rpmdbNextIterator (match) : NULL;
+
+                        if (pkgh == NULL) {
+                                dW("Header #%u of package \"%s\" not found.", pkg[i]->instance, pkg[i]->name);
+                                if (match != NULL)
+                                        rpmdbFreeIterator (match);
+                                continue;
                         }
-                }
-        } else {
-                ret = 0;
 
-                while ((pkgh = rpmdbNextIterator (match)) != NULL) {
-                        (*rep) = oscap_realloc (*rep, sizeof (struct rpminfo_rep) * ++ret);
-                        assume_r (*rep != NULL, -1);
-                        pkgh2rep (pkgh, (*rep) + (ret - 1));
+                        cached = oscap_talloc (struct rpminfo_rep);
+                        pkgh2rep (pkgh, cached);
+                        cached->instance = pkg[i]->instance;
+                        pkg[i]->data = cached;
+
+                        match = rpmdbFreeIterator (match);
                 }
+
+                rpminfo_rep_copy ((*rep) + ret, cached);
+                ++ret;
         }
 
-	match = rpmdbFreeIterator (match);
+        if (ret == 0) {
+                oscap_free (*rep);
+                *rep = NULL;
+        }
 ret:
+        oscap_free (pkg);
         RPMINFO_UNLOCK;
         return (ret);
 }
@@ -281,6 +286,7 @@ void *probe_init (void)
         }
 
         g_rpm.rpmts = rpmtsCreate();
+        g_rpm.pkgindex.data_free = &rpminfo_rep_free;
         pthread_mutex_init (&(g_rpm.mutex), NULL);
 
 	if (regcomp(&g_keyid_regex, g_keyid_regex_string, REG_EXTENDED) != 0) {
@@ -295,6 +301,7 @@ void probe_fini (void *ptr)
 {
         struct rpm_probe_global *r = (struct rpm_probe_global *)ptr;
 
+        rpm_pkgindex_free(&r->pkgindex);
         rpmtsFree(r->rpmts);
 	rpmFreeCrypto();
         rpmFreeRpmrc();
@@ -314,8 +321,15 @@ static int collect_rpm_files(SEXP_t *item, const struct rpminfo_rep *rep) {
 	rpmTag tag[2] = { RPMTAG_BASENAMES, RPMTAG_DIRNAMES };
 	int i, ret = 0;
 
-	ts = rpmtsInitIterator(g_rpm.rpmts, RPMDBI_PACKAGES, NULL, 0);
+	RPMINFO_LOCK;
+
+	/*
+	 * The header is read directly from its rpmdb record. The tag filters
+	 * make sure that it still belongs to the same package.
+	 */
+	ts = rpm_pkgindex_iterator(g_rpm.rpmts, rep->instance);
 	if (ts == NULL) {
+		RPMINFO_UNLOCK;
 		return -1;
 	}
 
@@ -366,6 +380,7 @@ static int collect_rpm_files(SEXP_t *item, const struct rpminfo_rep *rep) {
 	}
 cleanup:
 	ts = rpmdbFreeIterator(ts);
+	RPMINFO_UNLOCK;
 	return ret;
 }
 
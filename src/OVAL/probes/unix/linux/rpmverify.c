@@ -74,6 +74,67 @@ static struct rpm_probe_global g_rpm;
 #define RPMVERIFY_LOCK   RPM_MUTEX_LOCK(&g_rpm.mutex)
 #define RPMVERIFY_UNLOCK RPM_MUTEX_UNLOCK(&g_rpm.mutex)
 
+static void rpmverify_collect_pkg(probe_ctx *ctx, Header pkgh,
+                                  SEXP_t *name_ent, SEXP_t *filepath_ent,
+                                  uint64_t flags, rpmVerifyAttrs omit,
+                                  void (*callback)(probe_ctx *, struct rpmverify_res *))
+{
+        rpmfi  fi;
+	rpmTag tag[2] = { RPMTAG_BASENAMES, RPMTAG_DIRNAMES };
+        struct rpmverify_res res;
+        errmsg_t rpmerr;
+	int i;
+	SEXP_t *name_sexp;
+
+        res.name = headerFormat(pkgh, "%{NAME}", &rpmerr);
+
+	name_sexp = SEXP_string_newf("%s", res.name);
+	if (probe_entobj_cmp(name_ent, name_sexp) != OVAL_RESULT_TRUE) {
+		SEXP_free(name_sexp);
+		free(res.name);
+		return;
+	}
+	SEXP_free(name_sexp);
+
+        /*
+         * Inspect package files & directories
+         */
+	for (i = 0; i < 2; ++i) {
+	  fi = rpmfiNew(g_rpm.rpmts, pkgh, tag[i], 1);
+
+	  while (rpmfiNext(fi) != -1) {
+	    SEXP_t *filepath_sexp;
+
+	    res.fflags = rpmfiFFlags(fi);
+	    res.oflags = omit;
+
+	    if (((res.fflags & RPMFILE_CONFIG) && (flags & RPMVERIFY_SKIP_CONFIG)) ||
+		((res.fflags & RPMFILE_GHOST)  && (flags & RPMVERIFY_SKIP_GHOST)))
+	      continue;
+
+	    res.file   = strdup(rpmfiFN(fi));
+
+	    filepath_sexp = SEXP_string_newf("%s", res.file);
+	    if (probe_entobj_cmp(filepath_ent, filepath_sexp) != OVAL_RESULT_TRUE) {
+	      SEXP_free(filepath_sexp);
+	      oscap_free(res.file);
+	      continue;
+	    }
+	    SEXP_free(filepath_sexp);
+
+	    if (rpmVerifyFile(g_rpm.rpmts, fi, &res.vflags, omit) != 0)
+	      res.vflags = RPMVERIFY_FAILURES;
+
+	    callback(ctx, &res);
+	    free(res.file);
+	  }
+
+	  rpmfiFree(fi);
+	}
+
+	free(res.name);
+}
+
 static int rpmverify_collect(probe_ctx *ctx,
                              const char *name, oval_operation_t name_op,
                              const char *file, oval_operation_t file_op,
@@ -85,7 +146,8 @@ static int rpmverify_collect(probe_ctx *ctx,
         rpmVerifyAttrs omit = (rpmVerifyAttrs)(flags & RPMVERIFY_RPMATTRMASK);
 	Header pkgh;
         pcre *re = NULL;
-	int  ret = -1;
+	rpm_pkgindex_entry_t **pkg = NULL;
+	int  ret = -1, i, cnt;
 
         /* pre-compile regex if needed */
         if (file_op == OVAL_OPERATION_PATTERN_MATCH) {
@@ -130,21 +192,32 @@ static int rpmverify_collect(probe_ctx *ctx,
 
                 break;
         case OVAL_OPERATION_PATTERN_MATCH:
-                match = rpmtsInitIterator (g_rpm.rpmts, RPMDBI_PACKAGES, NULL, 0);
-
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
-
-                if (rpmdbSetIteratorRE (match, RPMTAG_NAME, RPMMIRE_REGEX,
-                                        (const char *)name) != 0)
+                /*
+                 * Match the names in the package index and read only
+                 * the headers of the matching packages.
+                 */
+                if (rpm_pkgindex_sync (&g_rpm.pkgindex, g_rpm.rpmts) != 0 ||
+                    (cnt = rpm_pkgindex_select (&g_rpm.pkgindex, name, name_op, &pkg)) < 0)
                 {
                         ret = -1;
                         goto ret;
                 }
 
-                break;
+                for (i = 0; i < cnt; ++i) {
+                        match = rpm_pkgindex_iterator (g_rpm.rpmts, pkg[i]->instance);
+
+                        if (match == NULL)
+                                continue;
+
+                        while ((pkgh = rpmdbNextIterator (match)) != NULL)
+                                rpmverify_collect_pkg(ctx, pkgh, name_ent, filepath_ent, flags, omit, callback);
+
+                        match = rpmdbFreeIterator (match);
+                }
+
+                oscap_free(pkg);
+                ret = 0;
+                goto ret;
         default:
                 /* not supported */
                 dE("package name: operation not supported");
@@ -155,59 +228,8 @@ static int rpmverify_collect(probe_ctx *ctx,
 	assume_d(RPMTAG_BASENAMES != 0, -1);
 	assume_d(RPMTAG_DIRNAMES  != 0, -1);
 
-        while ((pkgh = rpmdbNextIterator (match)) != NULL) {
-                rpmfi  fi;
-		rpmTag tag[2] = { RPMTAG_BASENAMES, RPMTAG_DIRNAMES };
-                struct rpmverify_res res;
-                errmsg_t rpmerr;
-		int i;
-		SEXP_t *name_sexp;
-
-                res.name = headerFormat(pkgh, "%{NAME}", &rpmerr);
-
-		name_sexp = SEXP_string_newf("%s", res.name);
-		if (probe_entobj_cmp(name_ent, name_sexp) != OVAL_RESULT_TRUE) {
-			SEXP_free(name_sexp);
-			continue;
-		}
-		SEXP_free(name_sexp);
-
-                /*
-                 * Inspect package files & directories
-                 */
-		for (i = 0; i < 2; ++i) {
-		  fi = rpmfiNew(g_rpm.rpmts, pkgh, tag[i], 1);
-
-		  while (rpmfiNext(fi) != -1) {
-		    SEXP_t *filepath_sexp;
-
-		    res.fflags = rpmfiFFlags(fi);
-		    res.oflags = omit;
-
-		    if (((res.fflags & RPMFILE_CONFIG) && (flags & RPMVERIFY_SKIP_CONFIG)) ||
-			((res.fflags & RPMFILE_GHOST)  && (flags & RPMVERIFY_SKIP_GHOST)))
-		      continue;
-
-		    res.file   = strdup(rpmfiFN(fi));
-
-		    filepath_sexp = SEXP_string_newf("%s", res.file);
-		    if (probe_entobj_cmp(filepath_ent, filepath_sexp) != OVAL_RESULT_TRUE) {
-		      SEXP_free(filepath_sexp);
-		      oscap_free(res.file);
-		      continue;
-		    }
-		    SEXP_free(filepath_sexp);
-
-		    if (rpmVerifyFile(g_rpm.rpmts, fi, &res.vflags, omit) != 0)
-		      res.vflags = RPMVERIFY_FAILURES;
-
-		    callback(ctx, &res);
-		    free(res.file);
-		  }
-
-		  rpmfiFree(fi);
-		}
-	}
+        while ((pkgh = rpmdbNextIterator (match)) != NULL)
+                rpmverify_collect_pkg(ctx, pkgh, name_ent, filepath_ent, flags, omit, callback);
 
 	match = rpmdbFreeIterator (match);
         ret   = 0;
@@ -246,6 +268,7 @@ void probe_fini (void *ptr)
 {
         struct rpm_probe_global *r = (struct rpm_probe_global *)ptr;
 
+        rpm_pkgindex_free(&r->pkgindex);
         rpmtsFree(r->rpmts);
 	rpmFreeCrypto();
         rpmFreeRpmrc();
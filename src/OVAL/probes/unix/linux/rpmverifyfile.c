@@ -126,17 +126,139 @@ static int adjust_filter(rpmdbMatchIterator iterator, SEXP_t *ent, rpmTag rpm_ta
 	return ret;
 }
 
+/*
+ * Verify the files of a single package.
+ * Returns 0 to continue with the next package, 1 if the collection
+ * should be stopped and -1 on error.
+ */
+static int rpmverify_collect_pkg(probe_ctx *ctx, Header pkgh,
+				 const char *file, oval_operation_t file_op, pcre *re,
+				 SEXP_t *name_ent, SEXP_t *epoch_ent, SEXP_t *version_ent, SEXP_t *release_ent, SEXP_t *arch_ent,
+				 uint64_t flags, rpmVerifyAttrs omit,
+				 int (*callback)(probe_ctx *, struct rpmverify_res *))
+{
+	SEXP_t *ent;
+	rpmfi  fi;
+	rpmTag tag[2] = { RPMTAG_BASENAMES, RPMTAG_DIRNAMES };
+	struct rpmverify_res res;
+	errmsg_t rpmerr;
+	int i, ret = 0;
+
+#define COMPARE_ENT(XXX) \
+	if (XXX ## _ent != NULL) { \
+		ent = probe_entval_from_cstr( \
+			probe_ent_getdatatype(XXX ## _ent), res.XXX, strlen(res.XXX) \
+		); \
+		if (ent != NULL && probe_entobj_cmp(XXX ## _ent, ent) != OVAL_RESULT_TRUE) { \
+			SEXP_free(ent); \
+			return (0); \
+		} \
+		SEXP_free(ent); \
+	}
+
+	res.name = headerFormat(pkgh, "%{NAME}", &rpmerr);
+	COMPARE_ENT(name);
+
+	res.epoch = headerFormat(pkgh, "%{EPOCH}", &rpmerr);
+	COMPARE_ENT(epoch);
+
+	res.version = headerFormat(pkgh, "%{VERSION}", &rpmerr);
+	COMPARE_ENT(version);
+	res.release = headerFormat(pkgh, "%{RELEASE}", &rpmerr);
+	COMPARE_ENT(release);
+	res.arch = headerFormat(pkgh, "%{ARCH}", &rpmerr);
+	COMPARE_ENT(arch);
+#undef COMPARE_ENT
+	snprintf(res.extended_name, 1024, "%s-%s:%s-%s.%s", res.name,
+		oscap_streq(res.epoch, "(none)") ? "0" : res.epoch,
+		res.version, res.release, res.arch);
+
+	/*
+	 * Inspect package files & directories
+	 */
+	for (i = 0; i < 2; ++i) {
+	  fi = rpmfiNew(g_rpm.rpmts, pkgh, tag[i], 1);
+
+	  while (rpmfiNext(fi) != -1) {
+			res.file = oscap_strdup(rpmfiFN(fi));
+	    res.fflags = rpmfiFFlags(fi);
+	    res.oflags = omit;
+
+	    if (((res.fflags & RPMFILE_CONFIG) && (flags & RPMVERIFY_SKIP_CONFIG)) ||
+				((res.fflags & RPMFILE_GHOST)  && (flags & RPMVERIFY_SKIP_GHOST))) {
+				oscap_free(res.file);
+				continue;
+			}
+
+	    switch(file_op) {
+	    case OVAL_OPERATION_EQUALS:
+				if (strcmp(res.file, file) != 0) {
+					oscap_free(res.file);
+					continue;
+				}
+	      break;
+	    case OVAL_OPERATION_NOT_EQUAL:
+				if (strcmp(res.file, file) == 0) {
+					oscap_free(res.file);
+					continue;
+				}
+	      break;
+	    case OVAL_OPERATION_PATTERN_MATCH:
+	      ret = pcre_exec(re, NULL, res.file, strlen(res.file), 0, 0, NULL, 0);
+
+	      switch(ret) {
+	      case 0: /* match */
+		break;
+	      case -1:
+		/* mismatch */
+		oscap_free(res.file);
+		continue;
+	      default:
+		dE("pcre_exec() failed!");
+		oscap_free(res.file);
+		rpmfiFree(fi);
+		return (-1);
+	      }
+	      break;
+	    default:
+	      /* unsupported operation */
+	      dE("Operation \"%d\" on `filepath' not supported", file_op);
+				oscap_free(res.file);
+				rpmfiFree(fi);
+	      return (-1);
+	    }
+
+	    if (rpmVerifyFile(g_rpm.rpmts, fi, &res.vflags, omit) != 0)
+	      res.vflags = RPMVERIFY_FAILURES;
+
+	    if (callback(ctx, &res) != 0) {
+				oscap_free(res.file);
+				rpmfiFree(fi);
+		    return (1);
+	    }
+			oscap_free(res.file);
+	  }
+
+	  rpmfiFree(fi);
+	}
+
+	return (0);
+}
+
 static int rpmverify_collect(probe_ctx *ctx,
 			     const char *file, oval_operation_t file_op,
 			     SEXP_t *name_ent, SEXP_t *epoch_ent, SEXP_t *version_ent, SEXP_t *release_ent, SEXP_t *arch_ent,
 			     uint64_t flags,
 			     int (*callback)(probe_ctx *, struct rpmverify_res *))
 {
-	rpmdbMatchIterator match;
+	rpmdbMatchIterator match = NULL;
 	rpmVerifyAttrs omit = (rpmVerifyAttrs)(flags & RPMVERIFY_RPMATTRMASK);
 	Header pkgh;
 	pcre *re = NULL;
-	int  ret = -1;
+	rpm_pkgindex_entry_t **pkg = NULL;
+	oval_operation_t name_op;
+	char name[1024];
+	int  ret = -1, i, cnt = 0;
 
 	/* pre-compile regex if needed */
 	if (file_op == OVAL_OPERATION_PATTERN_MATCH) {
@@ -153,150 +275,85 @@ static int rpmverify_collect(probe_ctx *ctx,
 
 	RPMVERIFY_LOCK;
 
-	match = rpmtsInitIterator (g_rpm.rpmts, RPMDBI_PACKAGES, NULL, 0);
-	if (match == NULL) {
-		ret = 0;
-		goto ret;
-	}
-
-	if ((ret = adjust_filter(match, name_ent, RPMTAG_NAME)) == -1) {
-		dE("can't adjust filter with name");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, epoch_ent, RPMTAG_EPOCH)) == -1) {
-		dE("can't adjust filter with epoch");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, version_ent, RPMTAG_VERSION)) == -1) {
-		dE("can't adjust filter with version");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, release_ent, RPMTAG_RELEASE)) == -1) {
-		dE("can't adjust filter with version");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, arch_ent, RPMTAG_ARCH)) == -1) {
-		dE("can't adjust filter with version");
-		goto ret;
-	}
-
 	assume_d(RPMTAG_BASENAMES != 0, -1);
 	assume_d(RPMTAG_DIRNAMES  != 0, -1);
 
-	while ((pkgh = rpmdbNextIterator (match)) != NULL) {
-		SEXP_t *ent;
-		rpmfi  fi;
-		rpmTag tag[2] = { RPMTAG_BASENAMES, RPMTAG_DIRNAMES };
-		struct rpmverify_res res;
-		errmsg_t rpmerr;
-		int i;
+	/*
+	 * If the package name is restricted, get the matching packages from
+	 * the package index instead of reading all headers from rpmdb.
+	 */
+	name_op = name_ent != NULL ?
+		probe_ent_getoperation(name_ent, OVAL_OPERATION_EQUALS) : OVAL_OPERATION_UNKNOWN;
 
-		/*
-+SEXP_t *probe_ent_from_cstr(const char *name, oval_datatype_t type,
-+                            const char *value, size_t vallen)
-		 */
+	if (name_op == OVAL_OPERATION_EQUALS || name_op == OVAL_OPERATION_PATTERN_MATCH) {
+		PROBE_ENT_STRVAL(name_ent, name, sizeof name, /* void */, strcpy(name, ""););
 
-#define COMPARE_ENT(XXX) \
-		if (XXX ## _ent != NULL) { \
-			ent = probe_entval_from_cstr( \
-				probe_ent_getdatatype(XXX ## _ent), res.XXX, strlen(res.XXX) \
-			); \
-			if (ent != NULL && probe_entobj_cmp(XXX ## _ent, ent) != OVAL_RESULT_TRUE) { \
-				SEXP_free(ent); \
-				continue; \
-			} \
-			SEXP_free(ent); \
+		if (rpm_pkgindex_sync(&g_rpm.pkgindex, g_rpm.rpmts) != 0 ||
+		    (cnt = rpm_pkgindex_select(&g_rpm.pkgindex, name, name_op, &pkg)) < 0)
+		{
+			dE("can't select packages from the package index");
+			ret = -1;
+			goto ret;
 		}
+	} else
+		cnt = -1;
 
-		res.name = headerFormat(pkgh, "%{NAME}", &rpmerr);
-		COMPARE_ENT(name);
-
-		res.epoch = headerFormat(pkgh, "%{EPOCH}", &rpmerr);
-		COMPARE_ENT(epoch);
-
-		res.version = headerFormat(pkgh, "%{VERSION}", &rpmerr);
-		COMPARE_ENT(version);
-		res.release = headerFormat(pkgh, "%{RELEASE}", &rpmerr);
-		COMPARE_ENT(release);
-		res.arch = headerFormat(pkgh, "%{ARCH}", &rpmerr);
-		COMPARE_ENT(arch);
-		snprintf(res.extended_name, 1024, "%s-%s:%s-%s.%s", res.name,
-			oscap_streq(res.epoch, "(none)") ? "0" : res.epoch,
-			res.version, res.release, res.arch);
-
-		/*
-		 * Inspect package files & directories
-		 */
-		for (i = 0; i < 2; ++i) {
-		  fi = rpmfiNew(g_rpm.rpmts, pkgh, tag[i], 1);
-
-		  while (rpmfiNext(fi) != -1) {
-				res.file = oscap_strdup(rpmfiFN(fi));
-		    res.fflags = rpmfiFFlags(fi);
-		    res.oflags = omit;
-
-		    if (((res.fflags & RPMFILE_CONFIG) && (flags & RPMVERIFY_SKIP_CONFIG)) ||
-					((res.fflags & RPMFILE_GHOST)  && (flags & RPMVERIFY_SKIP_GHOST))) {
-					oscap_free(res.file);
-					continue;
-				}
+	ret = 0;
 
-		    switch(file_op) {
-		    case OVAL_OPERATION_EQUALS:
-					if (strcmp(res.file, file) != 0) {
-						oscap_free(res.file);
-						continue;
-					}
-		      break;
-		    case OVAL_OPERATION_NOT_EQUAL:
-					if (strcmp(res.file, file) == 0) {
-						oscap_free(res.file);
-						continue;
-					}
-		      break;
-		    case OVAL_OPERATION_PATTERN_MATCH:
-		      ret = pcre_exec(re, NULL, res.file, strlen(res.file), 0, 0, NULL, 0);
-
-		      switch(ret) {
-		      case 0: /* match */
-			break;
-		      case -1:
-			/* mismatch */
-			oscap_free(res.file);
+	for (i = 0; cnt < 0 || i < cnt; ++i) {
+		if (cnt < 0)
+			match = rpmtsInitIterator (g_rpm.rpmts, RPMDBI_PACKAGES, NULL, 0);
+		else
+			match = rpm_pkgindex_iterator (g_rpm.rpmts, pkg[i]->instance);
+
+		if (match == NULL) {
+			if (cnt < 0)
+				break;
 			continue;
-		      default:
-			dE("pcre_exec() failed!");
-			ret = -1;
-			oscap_free(res.file);
+		}
+
+		if ((ret = adjust_filter(match, name_ent, RPMTAG_NAME)) == -1) {
+			dE("can't adjust filter with name");
 			goto ret;
-		      }
-		      break;
-		    default:
-		      /* unsupported operation */
-		      dE("Operation \"%d\" on `filepath' not supported", file_op);
-		      ret = -1;
-					oscap_free(res.file);
-		      goto ret;
-		    }
+		}
+		if ((ret = adjust_filter(match, epoch_ent, RPMTAG_EPOCH)) == -1) {
+			dE("can't adjust filter with epoch");
+			goto ret;
+		}
+		if ((ret = adjust_filter(match, version_ent, RPMTAG_VERSION)) == -1) {
+			dE("can't adjust filter with version");
+			goto ret;
+		}
+		if ((ret = adjust_filter(match, release_ent, RPMTAG_RELEASE)) == -1) {
+			dE("can't adjust filter with version");
+			goto ret;
+		}
+		if ((ret = adjust_filter(match, arch_ent, RPMTAG_ARCH)) == -1) {
+			dE("can't adjust filter with version");
+			goto ret;
+		}
 
-		    if (rpmVerifyFile(g_rpm.rpmts, fi, &res.vflags, omit) != 0)
-		      res.vflags = RPMVERIFY_FAILURES;
+		while ((pkgh = rpmdbNextIterator (match)) != NULL) {
+			ret = rpmverify_collect_pkg(ctx, pkgh, file, file_op, re,
+						    name_ent, epoch_ent, version_ent, release_ent, arch_ent,
+						    flags, omit, callback);
+			if (ret != 0)
+				break;
+		}
 
-		    if (callback(ctx, &res) != 0) {
-			    ret = 0;
-					oscap_free(res.file);
-			    goto ret;
-		    }
-			oscap_free(res.file);
-		  }
+		match = rpmdbFreeIterator (match);
 
-		  rpmfiFree(fi);
-		}
+		if (ret != 0 || cnt < 0)
+			break;
 	}
 
-	match = rpmdbFreeIterator (match);
-	ret   = 0;
+	/* stopping the collection isn't an error */
+	if (ret == 1)
+		ret = 0;
 ret:
+	if (match != NULL)
+		rpmdbFreeIterator (match);
+	oscap_free(pkg);
 	if (re != NULL)
 		pcre_free(re);
 
@@ -330,6 +387,7 @@ void probe_fini (void *ptr)
 {
 	struct rpm_probe_global *r = (struct rpm_probe_global *)ptr;
 
+	rpm_pkgindex_free(&r->pkgindex);
 	rpmtsFree(r->rpmts);
 	rpmFreeCrypto();
 	rpmFreeRpmrc();
@@ -58,6 +58,7 @@
 #include "probe/entcmp.h"
 #include "alloc.h"
 #include "common/debug_priv.h"
+#include "process58-snapshot.h"
 
 oval_schema_version_t over;
 
@@ -104,63 +105,6 @@ static void report_finding(struct result_info *res, probe_ctx *ctx)
 
 #if defined(__linux__)
 
-unsigned long ticks, boot;
-
-static void get_boot_time(void)
-{
-	char buf[100];
-	FILE *sf;
-	int line;
-
-	boot = 0;
-	sf = fopen("/proc/stat", "rt");
-	if (sf == NULL)
-		return;
-
-	line = 0;
-	__fsetlocking(sf, FSETLOCKING_BYCALLER);
-	while (fgets(buf, sizeof(buf), sf)) {
-		if (line == 0) {
-			line++;
-			continue;
-		}
-		if (memcmp(buf, "btime", 5) == 0) {
-			sscanf(buf, "btime %lu", &boot);
-			break;
-		}
-	}
-	fclose(sf);
-}
-
-static int get_uids(int pid, struct result_info *r)
-{
-	char buf[100];
-	FILE *sf;
-
-	r->ruid = -1;
-	r->user_id = -1;
-
-	snprintf(buf, sizeof(buf), "/proc/%d/status", pid);
-	sf = fopen(buf, "rt");
-	if (sf) {
-		int line = 0;
-		__fsetlocking(sf, FSETLOCKING_BYCALLER);
-		while (fgets(buf, sizeof(buf), sf)) {
-			if (line == 0) {
-				line++;
-				continue;
-			}
-			if (memcmp(buf, "Uid:", 4) == 0) {
-				sscanf(buf, "Uid: %d %d", &r->ruid, &r->user_id);
-				break;
-			}
-		}
-		fclose(sf);
-	}
-
-	return 0;
-}
-
 static char *convert_time(unsigned long long t, char *tbuf, int tb_size)
 {
 	unsigned d,h,m,s;
@@ -179,77 +123,34 @@ static char *convert_time(unsigned long long t, char *tbuf, int tb_size)
 	return tbuf;
 }
 
-static int read_process(SEXP_t *cmd_ent, probe_ctx *ctx)
+static int read_process(SEXP_t *cmd_ent, probe_ctx *ctx, struct proc_snapshot *snap)
 {
-	int err = 1;
-	DIR *d;
-	struct dirent *ent;
+	struct proc_entry *entries;
+	size_t count;
+	unsigned long ticks, boot;
 
-	d = opendir("/proc");
-	if (d == NULL)
-		return err;
+	entries = proc_snapshot_entries(snap, &count);
+	if (entries == NULL)
+		return 1;
 
 	// Get the time tick hertz
-	ticks = (unsigned long)sysconf(_SC_CLK_TCK);
-	get_boot_time();
-
-	// Scan the directories
-	while (( ent = readdir(d) )) {
-		int fd, len;
-		char buf[256];
-		char *tmp, cmd[16], state, tty_dev[128];
-		int pid, ppid, pgrp, session, tty_nr, tpgid;
-		unsigned flags, sched_policy;
-		unsigned long minflt, cminflt, majflt, cmajflt, uutime, ustime;
-		long cutime, cstime, priority, cnice, nthreads, itrealvalue;
-		unsigned long long start;
+	ticks = proc_snapshot_ticks(snap);
+	boot = proc_snapshot_boot(snap);
+
+	// Scan the processes
+	for (size_t i = 0; i < count; ++i) {
+		struct proc_entry *e = entries + i;
+		const char *cmd = e->stat.comm;
+		char tty_dev[128];
+		int pid = e->pid;
+		unsigned sched_policy;
 		SEXP_t *cmd_sexp;
 
-		// Skip non-process dir entries
-		if(*ent->d_name<'0' || *ent->d_name>'9')
-			continue;
-		errno = 0;
-		pid = strtol(ent->d_name, NULL, 10);
-		if (errno || pid == 2) // skip err & kthreads
-			continue;
-
-		// Parse up the stat file for the proc
-		snprintf(buf, 32, "/proc/%d/stat", pid);
-		fd = open(buf, O_RDONLY, 0);
-		if (fd < 0)
-			continue;
-		len = read(fd, buf, sizeof buf - 1);
-		close(fd);
-		if (len < 40)
-			continue;
-		buf[len] = 0;
-		tmp = strrchr(buf, ')');
-		if (tmp)
-			*tmp = 0;
-		else
-			continue;
-		memset(cmd, 0, sizeof(cmd));
-		sscanf(buf, "%d (%15c", &ppid, cmd);
-		sscanf(tmp+2,	"%c %d %d %d %d %d "
-				"%u %lu %lu %lu %lu "
-				"%lu %lu %lu %ld %ld "
-				"%ld %ld %ld %llu",
-			&state, &ppid, &pgrp, &session, &tty_nr, &tpgid,
-			&flags, &minflt, &cminflt, &majflt, &cmajflt,
-			&uutime, &ustime, &cutime, &cstime, &priority,
-			&cnice, &nthreads, &itrealvalue, &start
-		);
-
-		// Skip kthreads
-		if (ppid == 2)
-			continue;
-
-		err = 0; // If we get this far, no permission problems
 		dI("Have command: %s", cmd);
 		cmd_sexp = SEXP_string_newf("%s", cmd);
 		if (probe_entobj_cmp(cmd_ent, cmd_sexp) == OVAL_RESULT_TRUE) {
 			struct result_info r;
-			unsigned long t = uutime/ticks + ustime/ticks;
+			unsigned long t = e->stat.utime/ticks + e->stat.stime/ticks;
 			char tbuf[32], sbuf[32];
 			int tday,tyear;
 			time_t s_time;
@@ -286,7 +187,7 @@ static int read_process(SEXP_t *cmd_ent, probe_ctx *ctx)
 			now = localtime(&s_time);
 			tyear = now->tm_year;
 			tday = now->tm_yday;
-			s_time = boot + (start / ticks);
+			s_time = boot + (e->stat.start / ticks);
 			proc = localtime(&s_time);
 
 			// Select format based on how long we've been running
@@ -305,21 +206,44 @@ static int read_process(SEXP_t *cmd_ent, probe_ctx *ctx)
 			r.command = cmd;
 			r.exec_time = convert_time(t, tbuf, sizeof(tbuf));
 			r.pid = pid;
-			r.ppid = ppid;
-			r.priority = priority;
+			r.ppid = e->stat.ppid;
+			r.priority = e->stat.priority;
 			r.start_time = sbuf;
 
-                        dev_to_tty(tty_dev, sizeof(tty_dev), (dev_t) tty_nr, pid, ABBREV_DEV);
+                        dev_to_tty(tty_dev, sizeof(tty_dev), (dev_t) e->stat.tty_nr, pid, ABBREV_DEV);
                         r.tty = tty_dev;
 
-			get_uids(pid, &r);
+			proc_entry_uids(snap, e);
+			r.ruid = e->ruid;
+			r.user_id = e->user_id;
 			report_finding(&r, ctx);
 		}
 		SEXP_free(cmd_sexp);
 	}
-        closedir(d);
 
-	return err;
+	return 0;
+}
+
+/*
+ * The process table is read once and shared by all objects evaluated by
+ * the probe.
+ */
+void *probe_init(void)
+{
+	return proc_snapshot_new();
+}
+
+void probe_fini(void *arg)
+{
+	proc_snapshot_free(arg);
+}
+
+/*
+ * The processes may have changed since the probes were reset.
+ */
+void probe_invalidate(void *arg)
+{
+	proc_snapshot_reset(arg);
 }
 
 int probe_main(probe_ctx *ctx, void *arg)
@@ -331,7 +255,7 @@ int probe_main(probe_ctx *ctx, void *arg)
 		return PROBE_ENOVAL;
 	}
 
-	if (read_process(ent, ctx)) {
+	if (arg == NULL || read_process(ent, ctx, arg)) {
 		SEXP_free(ent);
 		return PROBE_EACCESS;
 	}
@@ -0,0 +1,392 @@
+/**
+ * @file   process58-snapshot.c
+ * @brief  snapshot of the process table shared by the process probes
+ */
+
+/*
+ * Copyright 2016 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#if defined(__linux__)
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "process58-snapshot.h"
+#include "common/debug_priv.h"
+
+#define PROC_LOADED_CMDLINE 0x01
+#define PROC_LOADED_UIDS    0x02
+
+struct proc_snapshot {
+	pthread_mutex_t lock;
+	int proc_fd;                /* /proc, the files are opened relative to it */
+	int taken;                  /* the process table was read */
+	unsigned long ticks;
+	unsigned long boot;
+	struct proc_entry *entry;
+	size_t count;
+};
+
+struct proc_snapshot *proc_snapshot_new(void)
+{
+	struct proc_snapshot *snap;
+
+	snap = calloc(1, sizeof(struct proc_snapshot));
+	if (snap == NULL)
+		return NULL;
+
+	if (pthread_mutex_init(&snap->lock, NULL) != 0) {
+		free(snap);
+		return NULL;
+	}
+
+	snap->proc_fd = -1;
+
+	return snap;
+}
+
+void proc_snapshot_free(struct proc_snapshot *snap)
+{
+	if (snap == NULL)
+		return;
+
+	for (size_t i = 0; i < snap->count; ++i)
+		free(snap->entry[i].cmdline);
+
+	free(snap->entry);
+
+	if (snap->proc_fd >= 0)
+		close(snap->proc_fd);
+
+	pthread_mutex_destroy(&snap->lock);
+	free(snap);
+}
+
+void proc_snapshot_reset(struct proc_snapshot *snap)
+{
+	if (snap == NULL)
+		return;
+
+	pthread_mutex_lock(&snap->lock);
+
+	for (size_t i = 0; i < snap->count; ++i)
+		free(snap->entry[i].cmdline);
+
+	free(snap->entry);
+	snap->entry = NULL;
+	snap->count = 0;
+
+	if (snap->proc_fd >= 0)
+		close(snap->proc_fd);
+
+	snap->proc_fd = -1;
+	snap->taken = 0;
+
+	pthread_mutex_unlock(&snap->lock);
+}
+
+/*
+ * Read a file relative to /proc into the buffer and terminate it.
+ * Returns the number of bytes read or -1.
+ */
+static ssize_t proc_read_at(int proc_fd, const char *path, char *buf, size_t size)
+{
+	ssize_t len, ret;
+	int fd;
+
+	fd = openat(proc_fd, path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return -1;
+
+	len = 0;
+	while ((size_t)len < size - 1) {
+		ret = read(fd, buf + len, size - 1 - len);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			close(fd);
+			return -1;
+		}
+		if (ret == 0)
+			break;
+		len += ret;
+	}
+
+	close(fd);
+	buf[len] = '\0';
+
+	return len;
+}
+
+static void proc_read_boot(struct proc_snapshot *snap)
+{
+	char buf[8192], *btime;
+
+	snap->boot = 0;
+
+	if (proc_read_at(snap->proc_fd, "stat", buf, sizeof(buf)) < 0)
+		return;
+
+	btime = strstr(buf, "\nbtime ");
+	if (btime != NULL)
+		sscanf(btime, "\nbtime %lu", &snap->boot);
+}
+
+/* Parse /proc/<pid>/stat, returns -1 if the file isn't usable */
+static int proc_parse_stat(char *buf, ssize_t len, struct proc_stat *st)
+{
+	char *tmp;
+	int pgrp, tpgid;
+	unsigned flags;
+	unsigned long minflt, cminflt, majflt, cmajflt;
+	long cutime, cstime, cnice, nthreads, itrealvalue;
+
+	if (len < 40)
+		return -1;
+
+	tmp = strrchr(buf, ')');
+	if (tmp == NULL)
+		return -1;
+	*tmp = '\0';
+
+	memset(st->comm, 0, sizeof(st->comm));
+	sscanf(buf, "%d (%15c", &st->ppid, st->comm);
+	if (sscanf(tmp + 2, "%c %d %d %d %d %d "
+			    "%u %lu %lu %lu %lu "
+			    "%lu %lu %ld %ld %ld "
+			    "%ld %ld %ld %llu",
+		   &st->state, &st->ppid, &pgrp, &st->session, &st->tty_nr, &tpgid,
+		   &flags, &minflt, &cminflt, &majflt, &cmajflt,
+		   &st->utime, &st->stime, &cutime, &cstime, &st->priority,
+		   &cnice, &nthreads, &itrealvalue, &st->start) < 20)
+		return -1;
+
+	return 0;
+}
+
+static int proc_snapshot_take(struct proc_snapshot *snap)
+{
+	DIR *d;
+	struct dirent *ent;
+	size_t alloc = 0;
+	int fd;
+
+	snap->proc_fd = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (snap->proc_fd < 0)
+		return -1;
+
+	fd = dup(snap->proc_fd);
+	if (fd < 0)
+		return -1;
+
+	d = fdopendir(fd);
+	if (d == NULL) {
+		close(fd);
+		return -1;
+	}
+
+	snap->ticks = (unsigned long)sysconf(_SC_CLK_TCK);
+	proc_read_boot(snap);
+
+	while ((ent = readdir(d)) != NULL) {
+		char path[32], buf[1024];
+		struct proc_entry *e;
+		ssize_t len;
+		long pid;
+
+		// Skip non-process dir entries
+		if (*ent->d_name < '0' || *ent->d_name > '9')
+			continue;
+		errno = 0;
+		pid = strtol(ent->d_name, NULL, 10);
+		if (errno || pid == 2) // skip err & kthreads
+			continue;
+
+		snprintf(path, sizeof(path), "%ld/stat", pid);
+		len = proc_read_at(snap->proc_fd, path, buf, sizeof(buf));
+
+		if (snap->count == alloc) {
+			alloc = alloc == 0 ? 512 : alloc * 2;
+			e = realloc(snap->entry, alloc * sizeof(struct proc_entry));
+			if (e == NULL)
+				break;
+			snap->entry = e;
+		}
+
+		e = snap->entry + snap->count;
+		memset(e, 0, sizeof(*e));
+
+		if (proc_parse_stat(buf, len, &e->stat) != 0)
+			continue;
+
+		// Skip kthreads
+		if (e->stat.ppid == 2)
+			continue;
+
+		e->pid = (int)pid;
+		++snap->count;
+	}
+
+	closedir(d);
+	dI("Process table snapshot: %zu processes", snap->count);
+
+	return 0;
+}
+
+struct proc_entry *proc_snapshot_entries(struct proc_snapshot *snap, size_t *count)
+{
+	int ret = 0;
+
+	pthread_mutex_lock(&snap->lock);
+	if (!snap->taken) {
+		ret = proc_snapshot_take(snap);
+		snap->taken = 1;
+	}
+	pthread_mutex_unlock(&snap->lock);
+
+	if (ret != 0 || snap->count == 0) {
+		*count = 0;
+		return NULL;
+	}
+
+	*count = snap->count;
+	return snap->entry;
+}
+
+unsigned long proc_snapshot_ticks(struct proc_snapshot *snap)
+{
+	return snap->ticks;
+}
+
+unsigned long proc_snapshot_boot(struct proc_snapshot *snap)
+{
+	return snap->boot;
+}
+
+static char *proc_read_cmdline(int proc_fd, int pid)
+{
+	char path[32], *buf, *tmp;
+	size_t size, length;
+	ssize_t ret;
+	int fd;
+
+	snprintf(path, sizeof(path), "%d/cmdline", pid);
+	fd = openat(proc_fd, path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return NULL;
+
+	size = 4096;
+	length = 0;
+	buf = malloc(size);
+
+	while (buf != NULL) {
+		ret = read(fd, buf + length, size - length - 1);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			break;
+		length += ret;
+		if (length == size - 1) {
+			size *= 2;
+			tmp = realloc(buf, size);
+			if (tmp == NULL)
+				break;
+			buf = tmp;
+		}
+	}
+
+	close(fd);
+
+	if (buf == NULL || length == 0) { // empty file
+		free(buf);
+		return NULL;
+	}
+
+	// Skip multiple trailing zeros
+	while (length > 1 && buf[length - 1] == '\0')
+		--length;
+	buf[length] = '\0';
+
+	// Program and args are separated by '\0'
+	// Replace them with spaces ' '
+	for (size_t i = 0; i < length; ++i) {
+		if (buf[i] == '\0' || buf[i] == '\n')
+			buf[i] = ' ';
+		else if (!isprint((unsigned char)buf[i])) // "ps" replace non-printable characters with '.' (LC_ALL=C)
+			buf[i] = '.';
+	}
+
+	return buf;
+}
+
+const char *proc_entry_cmdline(struct proc_snapshot *snap, struct proc_entry *entry)
+{
+	pthread_mutex_lock(&snap->lock);
+	if (!(entry->loaded & PROC_LOADED_CMDLINE)) {
+		entry->cmdline = proc_read_cmdline(snap->proc_fd, entry->pid);
+		entry->loaded |= PROC_LOADED_CMDLINE;
+	}
+	pthread_mutex_unlock(&snap->lock);
+
+	return entry->cmdline;
+}
+
+void proc_entry_uids(struct proc_snapshot *snap, struct proc_entry *entry)
+{
+	char path[32], buf[4096], *uid;
+
+	pthread_mutex_lock(&snap->lock);
+	if (entry->loaded & PROC_LOADED_UIDS) {
+		pthread_mutex_unlock(&snap->lock);
+		return;
+	}
+
+	entry->ruid = -1;
+	entry->user_id = -1;
+	entry->loginuid = -1;
+
+	snprintf(path, sizeof(path), "%d/status", entry->pid);
+	if (proc_read_at(snap->proc_fd, path, buf, sizeof(buf)) > 0) {
+		uid = strstr(buf, "\nUid:");
+		if (uid != NULL)
+			sscanf(uid, "\nUid: %d %d", &entry->ruid, &entry->user_id);
+	}
+
+	snprintf(path, sizeof(path), "%d/loginuid", entry->pid);
+	if (proc_read_at(snap->proc_fd, path, buf, sizeof(buf)) > 0) {
+		if (sscanf(buf, "%u", &entry->loginuid) < 1)
+			dW("sscanf failed from /proc/%s", path);
+	}
+
+	entry->loaded |= PROC_LOADED_UIDS;
+	pthread_mutex_unlock(&snap->lock);
+}
+
+#endif /* __linux__ */
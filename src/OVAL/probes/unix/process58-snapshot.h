@@ -0,0 +1,106 @@
+/**
+ * @file   process58-snapshot.h
+ * @brief  snapshot of the process table shared by the process probes
+ *
+ * The process table is read from /proc once per probe and every object
+ * is evaluated against the same snapshot. Only the stat file is read for
+ * every process while the snapshot is taken; the command line, the uids
+ * and the loginuid are read the first time they are asked for.
+ */
+
+/*
+ * Copyright 2016 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PROCESS58_SNAPSHOT_H
+#define PROCESS58_SNAPSHOT_H
+
+#include <stddef.h>
+
+/* Fields of /proc/<pid>/stat used by the probes */
+struct proc_stat {
+	char comm[16];
+	char state;
+	int ppid;
+	int session;
+	int tty_nr;
+	unsigned long utime;
+	unsigned long stime;
+	long priority;
+	unsigned long long start;
+};
+
+struct proc_entry {
+	int pid;
+	struct proc_stat stat;
+
+	/* read on demand, see proc_entry_cmdline() and proc_entry_uids() */
+	unsigned loaded;
+	char *cmdline;
+	int ruid;
+	int user_id;
+	unsigned loginuid;
+};
+
+struct proc_snapshot;
+
+/**
+ * Create an empty snapshot, the process table is read by the first
+ * proc_snapshot_entries() call.
+ */
+struct proc_snapshot *proc_snapshot_new(void);
+
+void proc_snapshot_free(struct proc_snapshot *snap);
+
+/**
+ * Drop the process table, it is read again by the next
+ * proc_snapshot_entries() call.
+ */
+void proc_snapshot_reset(struct proc_snapshot *snap);
+
+/**
+ * Get the processes of the snapshot, kernel threads are left out.
+ * @param count number of the returned entries
+ * @return the entries or NULL if /proc couldn't be read
+ */
+struct proc_entry *proc_snapshot_entries(struct proc_snapshot *snap, size_t *count);
+
+/**
+ * Clock ticks per second the times in struct proc_stat are measured in.
+ */
+unsigned long proc_snapshot_ticks(struct proc_snapshot *snap);
+
+/**
+ * Boot time of the system in seconds since the epoch.
+ */
+unsigned long proc_snapshot_boot(struct proc_snapshot *snap);
+
+/**
+ * Get the command line of the process with the arguments separated by
+ * spaces and the non-printable characters replaced by '.', like ps does.
+ * @return the command line or NULL if it's empty or can't be read
+ */
+const char *proc_entry_cmdline(struct proc_snapshot *snap, struct proc_entry *entry);
+
+/**
+ * Read the real and the effective user ID and the loginuid of the process
+ * into the entry. The values which can't be read are set to -1.
+ */
+void proc_entry_uids(struct proc_snapshot *snap, struct proc_entry *entry);
+
+#endif
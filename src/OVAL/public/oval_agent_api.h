@@ -108,6 +108,17 @@ typedef int (*agent_reporter)(const struct oval_result_definition * res_def, voi
  */
 int oval_agent_eval_system(oval_agent_session_t * ag_sess, agent_reporter cb, void *arg);
 
+/**
+ * Probe and evaluate all definitions from the content using several threads.
+ * Definitions which don't share any tests, objects, variables or extended
+ * definitions are evaluated concurrently, each thread uses its own set of probes.
+ * The callback is called from the calling thread in document order, just like
+ * in @ref oval_agent_eval_system.
+ * @param jobs maximum number of threads; 0 or 1 is the same as @ref oval_agent_eval_system
+ * @return 0 on success; -1 error; 1 warning
+ */
+int oval_agent_eval_system_parallel(oval_agent_session_t *ag_sess, unsigned int jobs, agent_reporter cb, void *arg);
+
 /**
  * Get a result model from agent session
  */
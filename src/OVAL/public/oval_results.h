@@ -171,6 +171,20 @@ void oval_results_model_free(struct oval_results_model *model);
  */
 int oval_results_model_export(struct oval_results_model *, struct oval_directives_model *, const char *file);
 
+/**
+ * Export OVAL results into file without building the whole document in
+ * memory. The collected objects and items of the system characteristics
+ * are written one by one, the output is the same as the one of
+ * \ref oval_results_model_export. File names ending with ".gz" are
+ * compressed.
+ * @param results_model The OVAL Results Model to export
+ * @param directives_model The Directives Model to amend the export
+ * @param file filename, "-" for the standard output
+ * @returns 0 on success, -1 on failure
+ * @memberof oval_results_model
+ */
+int oval_results_model_export_stream(struct oval_results_model *results_model, struct oval_directives_model *directives_model, const char *file);
+
 /**
  * Export OVAL results into oscap_source
  * @param results_model The OVAL Results Model to export
@@ -242,6 +242,29 @@ void oval_session_set_export_system_characteristics(struct oval_session *session
  */
 void oval_session_set_remote_resources(struct oval_session *session, bool allowed, download_progress_calllback_t callback);
 
+/**
+ * Set the number of threads used by \ref oval_session_evaluate. Definitions
+ * which don't depend on each other are then evaluated concurrently, see
+ * \ref oval_agent_eval_system_parallel.
+ *
+ * @memberof oval_session
+ * @param session an \ref oval_session
+ * @param jobs number of threads (defaults to 1)
+ */
+void oval_session_set_jobs(struct oval_session *session, unsigned int jobs);
+
+/**
+ * Set streaming export of OVAL Results. The results file is then written
+ * by \ref oval_results_model_export_stream instead of building the whole
+ * document in memory first. The document is still built when an HTML
+ * report is requested or the results are validated, because both need it.
+ *
+ * @memberof oval_session
+ * @param session an \ref oval_session
+ * @param stream true to stream the results (defaults to false)
+ */
+void oval_session_set_results_stream(struct oval_session *session, bool stream);
+
 /**
  * Destructor of an \ref oval_session.
  * @memberof oval_session
@@ -229,6 +229,15 @@ struct oval_syschar_model *oval_syschar_model_clone(struct oval_syschar_model *)
  * @memberof oval_syschar_model
  */
 int oval_syschar_model_export(struct oval_syschar_model *, const char *file);
+/**
+ * Export system characteristics into file without building the whole
+ * document in memory. The collected objects and items are written one by
+ * one, the output is the same as the one of \ref oval_syschar_model_export.
+ * File names ending with ".gz" are compressed.
+ * @memberof oval_syschar_model
+ * @return 1 on success, -1 on failure
+ */
+int oval_syschar_model_export_stream(struct oval_syschar_model *, const char *file);
 /**
  * Free memory allocated to a specified syschar model.
  * @param model the specified syschar model
@@ -37,6 +37,7 @@
 #include "common/_error.h"
 #include "common/debug_priv.h"
 #include "oval_cmp_basic_impl.h"
+#include "oval_cmp_regex_impl.h"
 
 oval_result_t oval_boolean_cmp(const bool state, const bool syschar, oval_operation_t operation)
 {
@@ -128,19 +129,19 @@ static oval_result_t strregcomp(const char *pattern, const char *test_str)
 {
 	int ret;
 	oval_result_t result = OVAL_RESULT_ERROR;
-#if defined USE_REGEX_PCRE
-	pcre *re;
-	const char *err;
-	int errofs;
+	struct oval_regex *re;
+	const char *err = NULL;
+	int errofs = -1;
 
-	re = pcre_compile(pattern, PCRE_UTF8, &err, &errofs, NULL);
+#if defined USE_REGEX_PCRE
+	re = oval_regex_acquire(pattern, PCRE_UTF8, &err, &errofs);
 	if (re == NULL) {
 		dE("Unable to compile regex pattern, "
 			       "pcre_compile() returned error (offset: %d): '%s'.\n", errofs, err);
 		return OVAL_RESULT_ERROR;
 	}
 
-	ret = pcre_exec(re, NULL, test_str, strlen(test_str), 0, 0, NULL, 0);
+	ret = pcre_exec(re->re, re->extra, test_str, strlen(test_str), 0, 0, NULL, 0);
 	if (ret > -1 ) {
 		result = OVAL_RESULT_TRUE;
 	} else if (ret == -1) {
@@ -150,19 +151,15 @@ static oval_result_t strregcomp(const char *pattern, const char *test_str)
 			       "pcre_exec() returned error: %d.\n", ret);
 		result = OVAL_RESULT_ERROR;
 	}
-
-	pcre_free(re);
 #elif defined USE_REGEX_POSIX
-	regex_t re;
-
-	ret = regcomp(&re, pattern, REG_EXTENDED);
-	if (ret != 0) {
+	re = oval_regex_acquire(pattern, REG_EXTENDED, &err, &errofs);
+	if (re == NULL) {
 		dE("Unable to compile regex pattern, "
-			       "regcomp() returned error: %d.\n", ret);
+			       "regcomp() returned error: %d.\n", errofs);
 		return OVAL_RESULT_ERROR;
 	}
 
-	ret = regexec(&re, test_str, 0, NULL, 0);
+	ret = regexec(&re->re, test_str, 0, NULL, 0);
 	if (ret == 0) {
 		result = OVAL_RESULT_TRUE;
 	} else if (ret == REG_NOMATCH) {
@@ -171,9 +168,9 @@ static oval_result_t strregcomp(const char *pattern, const char *test_str)
 		dE("Unable to match regex pattern: %d.", ret);
 		result = OVAL_RESULT_ERROR;
 	}
-
-	regfree(&re);
 #endif
+	oval_regex_release(re);
+
 	return result;
 }
 
@@ -0,0 +1,283 @@
+/*
+ * Copyright 2016 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Process-wide cache of compiled regular expressions. State and entity
+ * comparisons usually match the same pattern against a large number of
+ * items, so the pattern is compiled (and studied) only once.
+ *
+ * Entries are kept in a hash table keyed by the pattern and the compile
+ * options and in a LRU list. When the cache grows over its limit, the
+ * least recently used entries which aren't referenced are freed.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/alloc.h"
+#include "common/debug_priv.h"
+#include "common/util.h"
+#include "oval_cmp_regex_impl.h"
+
+#define OVAL_REGEX_HSIZE 509
+
+struct oval_regex_bucket {
+	struct oval_regex        *regex;
+	struct oval_regex_bucket *next;
+};
+
+static pthread_mutex_t oval_regex_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct oval_regex_bucket *oval_regex_table[OVAL_REGEX_HSIZE];
+static struct oval_regex *oval_regex_lru_head = NULL;
+static struct oval_regex *oval_regex_lru_tail = NULL;
+static size_t oval_regex_count  = 0;
+static size_t oval_regex_hits   = 0;
+static size_t oval_regex_misses = 0;
+
+static unsigned int oval_regex_hash(const char *key)
+{
+	unsigned int h = 0;
+	const unsigned char *p;
+
+	for (p = (const unsigned char *)key; *p != '\0'; ++p)
+		h = (97 * h) + *p;
+
+	return (h % OVAL_REGEX_HSIZE);
+}
+
+static struct oval_regex *oval_regex_compile(const char *pattern, int options, const char **err, int *errofs)
+{
+	struct oval_regex *regex;
+#if defined USE_REGEX_PCRE
+	const char *study_err = NULL;
+	const char *_err;
+	int _errofs;
+
+	regex = oscap_talloc(struct oval_regex);
+	regex->re = pcre_compile(pattern, options, &_err, &_errofs, NULL);
+
+	if (regex->re == NULL) {
+		if (err != NULL)
+			*err = _err;
+		if (errofs != NULL)
+			*errofs = _errofs;
+		oscap_free(regex);
+		return (NULL);
+	}
+
+	regex->extra = pcre_study(regex->re, 0, &study_err);
+
+	if (study_err != NULL)
+		dW("pcre_study() failed for pattern '%s': %s", pattern, study_err);
+#elif defined USE_REGEX_POSIX
+	int ret;
+
+	regex = oscap_talloc(struct oval_regex);
+
+	if ((ret = regcomp(&regex->re, pattern, options)) != 0) {
+		if (err != NULL)
+			*err = "regcomp() failed";
+		if (errofs != NULL)
+			*errofs = ret;
+		oscap_free(regex);
+		return (NULL);
+	}
+#endif
+	regex->key  = NULL;
+	regex->refs = 0;
+	regex->lru_prev = NULL;
+	regex->lru_next = NULL;
+
+	return (regex);
+}
+
+static void oval_regex_free(struct oval_regex *regex)
+{
+#if defined USE_REGEX_PCRE
+	if (regex->extra != NULL)
+		pcre_free_study(regex->extra);
+	pcre_free(regex->re);
+#elif defined USE_REGEX_POSIX
+	regfree(&regex->re);
+#endif
+	oscap_free(regex->key);
+	oscap_free(regex);
+}
+
+static struct oval_regex *oval_regex_lookup(const char *key, unsigned int h)
+{
+	struct oval_regex_bucket *b;
+
+	for (b = oval_regex_table[h]; b != NULL; b = b->next)
+		if (strcmp(b->regex->key, key) == 0)
+			return (b->regex);
+
+	return (NULL);
+}
+
+static void oval_regex_lru_unlink(struct oval_regex *regex)
+{
+	if (regex->lru_prev != NULL)
+		regex->lru_prev->lru_next = regex->lru_next;
+	else
+		oval_regex_lru_head = regex->lru_next;
+
+	if (regex->lru_next != NULL)
+		regex->lru_next->lru_prev = regex->lru_prev;
+	else
+		oval_regex_lru_tail = regex->lru_prev;
+
+	regex->lru_prev = regex->lru_next = NULL;
+}
+
+static void oval_regex_lru_push(struct oval_regex *regex)
+{
+	regex->lru_prev = NULL;
+	regex->lru_next = oval_regex_lru_head;
+
+	if (oval_regex_lru_head != NULL)
+		oval_regex_lru_head->lru_prev = regex;
+	else
+		oval_regex_lru_tail = regex;
+
+	oval_regex_lru_head = regex;
+}
+
+static void oval_regex_evict(void)
+{
+	struct oval_regex *regex, *prev;
+	struct oval_regex_bucket **bp, *b;
+
+	for (regex = oval_regex_lru_tail;
+	     regex != NULL && oval_regex_count > OVAL_REGEX_CACHE_SIZE; regex = prev)
+	{
+		prev = regex->lru_prev;
+
+		if (regex->refs > 0)
+			continue;
+
+		for (bp = oval_regex_table + oval_regex_hash(regex->key); *bp != NULL; bp = &(*bp)->next) {
+			if ((*bp)->regex == regex) {
+				b   = *bp;
+				*bp = b->next;
+				oscap_free(b);
+				break;
+			}
+		}
+
+		oval_regex_lru_unlink(regex);
+		oval_regex_free(regex);
+		--oval_regex_count;
+	}
+}
+
+struct oval_regex *oval_regex_acquire(const char *pattern, int options, const char **err, int *errofs)
+{
+	struct oval_regex *regex, *other;
+	struct oval_regex_bucket *b;
+	unsigned int h;
+	char *key;
+
+	key = oscap_sprintf("%x:%s", (unsigned int)options, pattern);
+	h   = oval_regex_hash(key);
+
+	pthread_mutex_lock(&oval_regex_mutex);
+	regex = oval_regex_lookup(key, h);
+
+	if (regex != NULL) {
+		++oval_regex_hits;
+		++regex->refs;
+		oval_regex_lru_unlink(regex);
+		oval_regex_lru_push(regex);
+		pthread_mutex_unlock(&oval_regex_mutex);
+
+		oscap_free(key);
+		return (regex);
+	}
+
+	++oval_regex_misses;
+	pthread_mutex_unlock(&oval_regex_mutex);
+
+	/* compile without holding the lock */
+	regex = oval_regex_compile(pattern, options, err, errofs);
+
+	if (regex == NULL) {
+		oscap_free(key);
+		return (NULL);
+	}
+
+	regex->key  = key;
+	regex->refs = 1;
+
+	pthread_mutex_lock(&oval_regex_mutex);
+	other = oval_regex_lookup(key, h);
+
+	if (other != NULL) {
+		/* another thread was faster */
+		++other->refs;
+		pthread_mutex_unlock(&oval_regex_mutex);
+
+		oval_regex_free(regex);
+		return (other);
+	}
+
+	b = oscap_talloc(struct oval_regex_bucket);
+	b->regex = regex;
+	b->next  = oval_regex_table[h];
+	oval_regex_table[h] = b;
+
+	oval_regex_lru_push(regex);
+	++oval_regex_count;
+	oval_regex_evict();
+
+	pthread_mutex_unlock(&oval_regex_mutex);
+
+	return (regex);
+}
+
+void oval_regex_release(struct oval_regex *regex)
+{
+	if (regex == NULL)
+		return;
+
+	pthread_mutex_lock(&oval_regex_mutex);
+	--regex->refs;
+
+	if (oval_regex_count > OVAL_REGEX_CACHE_SIZE)
+		oval_regex_evict();
+
+	pthread_mutex_unlock(&oval_regex_mutex);
+}
+
+void oval_regex_cache_stats(size_t *hits, size_t *misses)
+{
+	pthread_mutex_lock(&oval_regex_mutex);
+
+	if (hits != NULL)
+		*hits = oval_regex_hits;
+	if (misses != NULL)
+		*misses = oval_regex_misses;
+
+	pthread_mutex_unlock(&oval_regex_mutex);
+}
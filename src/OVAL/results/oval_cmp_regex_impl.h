@@ -0,0 +1,80 @@
+/*
+ * Copyright 2016 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef OSCAP_OVAL_CMP_REGEX_IMPL_H_
+#define OSCAP_OVAL_CMP_REGEX_IMPL_H_
+
+#include <stddef.h>
+#if defined USE_REGEX_PCRE
+#include <pcre.h>
+#elif defined USE_REGEX_POSIX
+#include <regex.h>
+#endif
+
+#include "../common/util.h"
+
+OSCAP_HIDDEN_START;
+
+#ifndef OVAL_REGEX_CACHE_SIZE
+# define OVAL_REGEX_CACHE_SIZE 256 /**< maximum number of unused compiled patterns kept in the cache */
+#endif
+
+/**
+ * A compiled regular expression shared through the process-wide regex cache.
+ * The compiled pattern is read-only and may be used by several threads at once.
+ */
+struct oval_regex {
+#if defined USE_REGEX_PCRE
+	pcre       *re;
+	pcre_extra *extra; /**< result of pcre_study(), may be NULL */
+#elif defined USE_REGEX_POSIX
+	regex_t     re;
+#endif
+	char   *key;
+	int     refs;
+	struct oval_regex *lru_prev;
+	struct oval_regex *lru_next;
+};
+
+/**
+ * Get a compiled pattern from the cache. The pattern is compiled and
+ * added to the cache if it's not there yet. The returned object has to be
+ * released using oval_regex_release().
+ * @param pattern the regular expression
+ * @param options pcre_compile() options or regcomp() flags, depending on
+ *        the regex library in use
+ * @param err error message if the compilation fails, may be NULL
+ * @param errofs offset of the error in the pattern, may be NULL
+ * @return NULL if the pattern can't be compiled
+ */
+struct oval_regex *oval_regex_acquire(const char *pattern, int options, const char **err, int *errofs);
+
+/**
+ * Release a compiled pattern returned by oval_regex_acquire().
+ */
+void oval_regex_release(struct oval_regex *regex);
+
+/**
+ * Get the cache hit and miss counters.
+ */
+void oval_regex_cache_stats(size_t *hits, size_t *misses);
+
+OSCAP_HIDDEN_END;
+
+#endif
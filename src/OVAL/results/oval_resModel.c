@@ -43,6 +43,7 @@
 #include "oval_probe_impl.h"
 #include "results/oval_results_impl.h"
 #include "oval_directives_impl.h"
+#include "oval_xml_stream.h"
 
 #include "common/util.h"
 #include "common/debug_priv.h"
@@ -322,6 +323,22 @@ int oval_results_model_export(struct oval_results_model *results_model,
 	return ret;
 }
 
+int oval_results_model_export_stream(struct oval_results_model *results_model,
+				     struct oval_directives_model *directives_model,
+				     const char *file)
+{
+	__attribute__nonnull__(results_model);
+
+	xmlDocPtr doc = oval_xml_stream_doc_new();
+	if (doc == NULL) {
+		oscap_setxmlerr(xmlGetLastError());
+		return -1;
+	}
+
+	oval_results_to_dom(results_model, directives_model, doc, NULL);
+	return oval_xml_stream_save_free(doc, file) == 1 ? 0 : -1;
+}
+
 int oval_results_model_parse(xmlTextReaderPtr reader, struct oval_parser_context *context) {
         int depth = xmlTextReaderDepth(reader);
         int ret = 0;
@@ -42,6 +42,7 @@
 #include "public/oval_agent_api.h"
 #include "common/util.h"
 #include "common/debug_priv.h"
+#include "common/timing_priv.h"
 
 typedef struct oval_result_definition {
 	struct oval_definition *definition;
@@ -154,9 +155,18 @@ oval_result_t oval_result_definition_eval(struct oval_result_definition * defini
 	if (definition->result == OVAL_RESULT_NOT_EVALUATED) {
 		struct oval_result_criteria_node *criteria = oval_result_definition_get_criteria(definition);
 		if (criteria != NULL) {
+			double start = 0, collecting = 0;
+			if (oscap_timing_enabled()) {
+				start = oscap_timing_now();
+				collecting = oscap_timing_collecting();
+			}
 			dIndent(1);
 			definition->result = oval_result_criteria_node_eval(criteria);
 			dIndent(-1);
+			if (oscap_timing_enabled()) {
+				double wall = oscap_timing_now() - start;
+				oscap_timing_definition(id, wall, wall - (oscap_timing_collecting() - collecting));
+			}
 		}
 	}
 
@@ -598,6 +598,15 @@ static oval_result_t eval_item(struct oval_syschar_model *syschar_model, struct
 	return OVAL_RESULT_ERROR;
 }
 
+/*
+ * The syschar model is shared by the threads of a parallel evaluation, its
+ * maps are accessed with the lock of the probe sessions held.
+ */
+static struct oval_probe_session *_oval_result_system_probe_session(struct oval_result_system *sys)
+{
+	return oval_results_model_get_probe_session(oval_result_system_get_results_model(sys));
+}
+
 #define ITEMMAP (struct oval_string_map    *)args[2]
 #define TEST    (struct oval_result_test   *)args[1]
 #define SYSTEM  (struct oval_result_system *)args[0]
@@ -767,6 +776,7 @@ _oval_result_test_evaluate_items(struct oval_test *test, struct oval_syschar *sy
 
 	exists_cnt = error_cnt = 0;
 	test_id = oval_test_get_id(test);
+	oval_probe_sync_enter(_oval_result_system_probe_session(SYSTEM));
 	collected_items_itr = oval_syschar_get_sysitem(syschar_object);
 	while (oval_sysitem_iterator_has_more(collected_items_itr)) {
 		struct oval_sysitem *item;
@@ -778,6 +788,7 @@ _oval_result_test_evaluate_items(struct oval_test *test, struct oval_syschar *sy
 		if (item == NULL) {
 			oscap_seterr(OSCAP_EFAMILY_OVAL, "Iterator returned null.");
 			oval_sysitem_iterator_free(collected_items_itr);
+			oval_probe_sync_leave(_oval_result_system_probe_session(SYSTEM));
 			return OVAL_RESULT_ERROR;
 		}
 
@@ -793,6 +804,7 @@ _oval_result_test_evaluate_items(struct oval_test *test, struct oval_syschar *sy
 		_oval_test_item_consumer(ritem, args);
 	}
 	oval_sysitem_iterator_free(collected_items_itr);
+	oval_probe_sync_leave(_oval_result_system_probe_session(SYSTEM));
 
 	test_check = oval_test_get_check(test);
 	test_check_existence = oval_test_get_existence(test);
@@ -942,7 +954,9 @@ static oval_result_t _oval_result_test_result(struct oval_result_test *rtest, vo
 
 	struct oval_syschar_model *syschar_model = oval_result_system_get_syschar_model(sys);
 
+	oval_probe_sync_enter(probe_session);
 	struct oval_syschar * syschar = oval_syschar_model_get_syschar(syschar_model, object_id);
+	oval_probe_sync_leave(probe_session);
 	if (syschar == NULL) {
 		dW("No syschar for object: %s", object_id);
 		return OVAL_RESULT_UNKNOWN;
@@ -1006,7 +1020,10 @@ static void _oval_result_test_initialize_bindings(struct oval_result_test *rslt_
 		char *object_id = oval_object_get_id(oval_object);
 		struct oval_result_system *sys = oval_result_test_get_system(rslt_test);
 		struct oval_syschar_model *syschar_model = oval_result_system_get_syschar_model(sys);
+		struct oval_probe_session *probe_session = _oval_result_system_probe_session(sys);
+		oval_probe_sync_enter(probe_session);
 		struct oval_syschar *syschar = oval_syschar_model_get_syschar(syschar_model, object_id);
+		oval_probe_sync_leave(probe_session);
 		/* no syschar if system characteristics was a subset of definitions */
 		if(syschar) {
 			struct oval_variable_binding_iterator *bindings = oval_syschar_get_variable_bindings(syschar);
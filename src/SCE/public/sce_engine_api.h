@@ -229,6 +229,37 @@ struct sce_session* sce_parameters_get_session(struct sce_parameters* v);
  */
 void sce_parameters_allocate_session(struct sce_parameters* v);
 
+/**
+ * Limits how many scripts of these parameters may run at the same time when
+ * rules are evaluated in parallel, see \ref xccdf_policy_model_set_jobs.
+ * It has to be set before SCE is registered.
+ *
+ * @param max_jobs maximal number of running scripts, 0 means no limit
+ *                 (defaults to the OSCAP_SCE_JOBS environment variable or 0)
+ * @memberof sce_parameters
+ */
+void sce_parameters_set_max_jobs(struct sce_parameters* v, unsigned int max_jobs);
+
+/**
+ * Sets how long a script may run. A script which doesn't finish in time is
+ * killed together with the processes it started and its result is error.
+ *
+ * @param seconds the time limit, 0 means no limit
+ *                (defaults to the OSCAP_SCE_TIMEOUT environment variable or 0)
+ * @memberof sce_parameters
+ */
+void sce_parameters_set_timeout(struct sce_parameters* v, unsigned int seconds);
+
+/**
+ * Sets how much of the standard output and of the standard error output of
+ * a script is kept, the rest is read and thrown away.
+ *
+ * @param bytes the limit for each of the outputs, 0 means no limit
+ *              (defaults to the OSCAP_SCE_OUTPUT_LIMIT environment variable or 0)
+ * @memberof sce_parameters
+ */
+void sce_parameters_set_output_limit(struct sce_parameters* v, size_t bytes);
+
 /**
  * Internal rule evaluation callback, don't use directly
  *
@@ -33,7 +33,8 @@
 #include "common/_error.h"
 #include "common/util.h"
 #include "common/list.h"
-#include "common/oscap_acquire.h"
+#include "common/oscap_string.h"
+#include "common/debug_priv.h"
 #include "sce_engine_api.h"
 
 #include <stdlib.h>
@@ -45,12 +46,17 @@
 #include <assert.h>
 #include <fcntl.h>
 #include <sys/types.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
 #if defined(__linux__)
 #include <sys/prctl.h>
 #endif
 #include <limits.h>
 #include <unistd.h>
 #include <libgen.h>
+#include <pthread.h>
 
 struct sce_check_result
 {
@@ -213,12 +219,14 @@ void sce_check_result_export(struct sce_check_result* v, const char* target_file
 struct sce_session
 {
 	struct oscap_list* results;
+	pthread_mutex_t lock; ///< Scripts may be evaluated concurrently
 };
 
 struct sce_session* sce_session_new(void)
 {
 	struct sce_session* ret = oscap_alloc(sizeof(struct sce_session));
 	ret->results = oscap_list_new();
+	pthread_mutex_init(&ret->lock, NULL);
 
 	return ret;
 }
@@ -229,6 +237,7 @@ void sce_session_free(struct sce_session* s)
 		return;
 
 	oscap_list_free(s->results, (oscap_destruct_func) sce_check_result_free);
+	pthread_mutex_destroy(&s->lock);
 	oscap_free(s);
 }
 
@@ -240,7 +249,9 @@ void sce_session_reset(struct sce_session* s)
 
 void sce_session_add_check_result(struct sce_session* s, struct sce_check_result* result)
 {
+	pthread_mutex_lock(&s->lock);
 	oscap_list_push(s->results, result);
+	pthread_mutex_unlock(&s->lock);
 }
 
 OSCAP_ITERATOR_GEN(sce_check_result)
@@ -265,17 +276,66 @@ void sce_session_export_to_directory(struct sce_session* s, const char* director
 	sce_check_result_iterator_free(it);
 }
 
+/*
+ * Environment entries of one bound value, the exported block is kept by
+ * the parameters and reused by every check which binds the same value.
+ */
+struct sce_env_binding
+{
+	xccdf_value_type_t type;
+	xccdf_operator_t operator;
+	char* value;
+	char* entries[3];
+};
+
 struct sce_parameters
 {
 	char* xccdf_directory;
 	struct sce_session* session;
+	unsigned int max_jobs;
+	unsigned int timeout;
+	size_t output_limit;
+	struct oscap_htable* env_cache; ///< sce_env_binding by the value name
+	pthread_mutex_t env_lock;
 };
 
+static unsigned long sce_getenv_ulong(const char* name)
+{
+	const char* value = getenv(name);
+	if (value == NULL || *value == '\0')
+		return 0;
+
+	char* end;
+	unsigned long ret = strtoul(value, &end, 10);
+	if (*end != '\0')
+	{
+		dW("Ignoring invalid value of %s: '%s'.", name, value);
+		return 0;
+	}
+	return ret;
+}
+
+static void sce_env_binding_free(struct sce_env_binding* b)
+{
+	if (!b)
+		return;
+
+	oscap_free(b->value);
+	for (size_t i = 0; i < 3; ++i)
+		oscap_free(b->entries[i]);
+	oscap_free(b);
+}
+
 struct sce_parameters* sce_parameters_new(void)
 {
 	struct sce_parameters *ret = oscap_alloc(sizeof(struct sce_parameters));
 	ret->xccdf_directory = NULL;
 	ret->session = NULL;
+	ret->max_jobs = sce_getenv_ulong("OSCAP_SCE_JOBS");
+	ret->timeout = sce_getenv_ulong("OSCAP_SCE_TIMEOUT");
+	ret->output_limit = sce_getenv_ulong("OSCAP_SCE_OUTPUT_LIMIT");
+	ret->env_cache = oscap_htable_new();
+	pthread_mutex_init(&ret->env_lock, NULL);
 
 	return ret;
 }
@@ -290,9 +350,26 @@ void sce_parameters_free(struct sce_parameters* v)
 	if (v->session)
 		sce_session_free(v->session);
 
+	oscap_htable_free(v->env_cache, (oscap_destruct_func) sce_env_binding_free);
+	pthread_mutex_destroy(&v->env_lock);
 	oscap_free(v);
 }
 
+void sce_parameters_set_max_jobs(struct sce_parameters* v, unsigned int max_jobs)
+{
+	v->max_jobs = max_jobs;
+}
+
+void sce_parameters_set_timeout(struct sce_parameters* v, unsigned int seconds)
+{
+	v->timeout = seconds;
+}
+
+void sce_parameters_set_output_limit(struct sce_parameters* v, size_t bytes)
+{
+	v->output_limit = bytes;
+}
+
 void sce_parameters_set_xccdf_directory(struct sce_parameters* v, const char* value)
 {
 	if (v->xccdf_directory)
@@ -327,6 +404,283 @@ void sce_parameters_allocate_session(struct sce_parameters* v)
 	sce_parameters_set_session(v, sce_session_new());
 }
 
+/*
+ * Open a pipe which isn't inherited by executed scripts. Scripts of concurrent
+ * evaluations would keep the pipes of each other open otherwise. The child
+ * gets its ends by dup2, which clears the flag.
+ */
+static int sce_pipe(int pipefd[2])
+{
+#if defined(__linux__)
+	return pipe2(pipefd, O_CLOEXEC);
+#else
+	if (pipe(pipefd) == -1)
+		return -1;
+	fcntl(pipefd[0], F_SETFD, FD_CLOEXEC);
+	fcntl(pipefd[1], F_SETFD, FD_CLOEXEC);
+	return 0;
+#endif
+}
+
+// all the result codes are shifted by 100, because otherwise syntax errors in scripts
+// or even their nonexistence would cause XCCDF_RESULT_PASS to be the result
+static const char* sce_env_base[] = {
+	"PATH=/bin:/sbin:/usr/bin:/usr/sbin",
+	"XCCDF_RESULT_PASS=101",
+	"XCCDF_RESULT_FAIL=102",
+	"XCCDF_RESULT_ERROR=103",
+	"XCCDF_RESULT_UNKNOWN=104",
+	"XCCDF_RESULT_NOT_APPLICABLE=105",
+	"XCCDF_RESULT_NOT_CHECKED=106",
+	"XCCDF_RESULT_NOT_SELECTED=107",
+	"XCCDF_RESULT_INFORMATIONAL=108",
+	"XCCDF_RESULT_FIXED=109"
+};
+#define SCE_ENV_BASE_COUNT (sizeof(sce_env_base) / sizeof(sce_env_base[0]))
+
+static struct sce_env_binding* sce_env_binding_new(const char* name, xccdf_value_type_t type, const char* value, xccdf_operator_t operator)
+{
+	const char* type_str;
+	switch (type)
+	{
+	case XCCDF_TYPE_BOOLEAN:
+		type_str = "BOOLEAN";
+		break;
+	case XCCDF_TYPE_NUMBER:
+		type_str = "NUMBER";
+		break;
+	case XCCDF_TYPE_STRING:
+		type_str = "STRING";
+		break;
+	default:
+		assert(0);
+		type_str = NULL;
+		break;
+	}
+
+	const char* operator_str;
+	switch (operator)
+	{
+	case XCCDF_OPERATOR_EQUALS:
+		operator_str = "EQUALS";
+		break;
+	case XCCDF_OPERATOR_NOT_EQUAL:
+		operator_str = "NOT_EQUAL";
+		break;
+	case XCCDF_OPERATOR_GREATER:
+		operator_str = "GREATER";
+		break;
+	case XCCDF_OPERATOR_GREATER_EQUAL:
+		operator_str = "GREATER_EQUAL";
+		break;
+	case XCCDF_OPERATOR_LESS:
+		operator_str = "LESS";
+		break;
+	case XCCDF_OPERATOR_LESS_EQUAL:
+		operator_str = "LESS_EQUAL";
+		break;
+	case XCCDF_OPERATOR_PATTERN_MATCH:
+		operator_str = "PATTERN_MATCH";
+		break;
+	default:
+		assert(0);
+		operator_str = NULL;
+		break;
+	}
+
+	struct sce_env_binding* ret = oscap_alloc(sizeof(struct sce_env_binding));
+	ret->type = type;
+	ret->operator = operator;
+	ret->value = oscap_strdup(value);
+	ret->entries[0] = oscap_sprintf("XCCDF_TYPE_%s=%s", name, type_str);
+	ret->entries[1] = oscap_sprintf("XCCDF_VALUE_%s=%s", name, value);
+	ret->entries[2] = oscap_sprintf("XCCDF_OPERATOR_%s=%s", name, operator_str);
+
+	return ret;
+}
+
+/*
+ * Get the environment entries of a bound value. The entries are built only
+ * once for each value, unless the same name is bound to a different value,
+ * then the caller gets its own entries in the list of owned bindings.
+ */
+static struct sce_env_binding* sce_parameters_get_env_binding(struct sce_parameters* parameters,
+		struct xccdf_value_binding* binding, struct oscap_list* owned)
+{
+	const char* name = xccdf_value_binding_get_name(binding);
+	xccdf_value_type_t type = xccdf_value_binding_get_type(binding);
+	const char* value = xccdf_value_binding_get_setvalue(binding);
+	if (value == NULL)
+	{
+		value = xccdf_value_binding_get_value(binding);
+	}
+	xccdf_operator_t operator = xccdf_value_binding_get_operator(binding);
+
+	pthread_mutex_lock(&parameters->env_lock);
+	struct sce_env_binding* ret = oscap_htable_get(parameters->env_cache, name);
+	if (ret == NULL)
+	{
+		ret = sce_env_binding_new(name, type, value, operator);
+		oscap_htable_add(parameters->env_cache, name, ret);
+	}
+	else if (ret->type != type || ret->operator != operator || oscap_strcmp(ret->value, value) != 0)
+	{
+		ret = sce_env_binding_new(name, type, value, operator);
+		oscap_list_add(owned, ret);
+	}
+	pthread_mutex_unlock(&parameters->env_lock);
+
+	return ret;
+}
+
+struct sce_output
+{
+	int fd;
+	struct oscap_string* buffer;
+	size_t length; ///< bytes read from the script, not counting the escaping
+	bool truncated;
+};
+
+static void sce_output_append(struct sce_output* output, const char* data, size_t length, size_t limit)
+{
+	if (limit > 0 && output->length + length > limit)
+	{
+		// keep reading, so that the script doesn't block, but drop the rest
+		output->truncated = true;
+		length = limit - output->length;
+	}
+	output->length += length;
+
+	for (size_t i = 0; i < length; ++i)
+	{
+		if (data[i] == '&') {
+			// & is a special case, we have to "escape" it manually
+			// (all else will eventually get handled by libxml)
+			oscap_string_append_string(output->buffer, "&amp;");
+		} else {
+			oscap_string_append_char(output->buffer, data[i]);
+		}
+	}
+}
+
+// milliseconds left until the deadline, clamped to the range of poll()
+static int sce_time_left(const struct timespec* deadline)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	long left = (deadline->tv_sec - now.tv_sec) * 1000 + (deadline->tv_nsec - now.tv_nsec) / 1000000;
+	if (left < 0)
+		return 0;
+	return left > INT_MAX ? INT_MAX : (int)left;
+}
+
+// interval of checking whether the script exited after it closed its output
+#define SCE_WAIT_INTERVAL 50
+
+/*
+ * Read stdout and stderr of the script as they come, so that neither pipe
+ * fills up while we wait for the other one, then wait for the script to exit.
+ * Returns false if the script ran out of time, the whole process group of
+ * the script is killed then.
+ */
+static bool sce_collect_output(struct sce_parameters* parameters, pid_t pid, struct sce_output* outputs, size_t count, int* wstatus)
+{
+	struct pollfd fds[count];
+	size_t open_count = count;
+	struct timespec deadline;
+	bool timed_out = false;
+	char chunk[4096];
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		fds[i].fd = outputs[i].fd;
+		fds[i].events = POLLIN;
+	}
+
+	if (parameters->timeout > 0)
+	{
+		clock_gettime(CLOCK_MONOTONIC, &deadline);
+		deadline.tv_sec += parameters->timeout;
+	}
+
+	while (open_count > 0)
+	{
+		int wait = -1;
+		if (parameters->timeout > 0)
+		{
+			wait = sce_time_left(&deadline);
+			if (wait == 0)
+			{
+				timed_out = true;
+				break;
+			}
+		}
+
+		if (poll(fds, count, wait) == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			dW("poll() failed while reading output of the script: %s.", strerror(errno));
+			break;
+		}
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (fds[i].fd < 0 || fds[i].revents == 0)
+				continue;
+
+			ssize_t length = read(fds[i].fd, chunk, sizeof(chunk));
+			if (length == -1 && errno == EINTR)
+				continue;
+			if (length <= 0)
+			{
+				close(fds[i].fd);
+				fds[i].fd = -1;
+				open_count--;
+				continue;
+			}
+			sce_output_append(&outputs[i], chunk, length, parameters->output_limit);
+		}
+	}
+
+	// the script may close its output and keep running, the deadline still applies
+	*wstatus = 0;
+	while (!timed_out)
+	{
+		pid_t waited = waitpid(pid, wstatus, parameters->timeout > 0 ? WNOHANG : 0);
+		if (waited == pid)
+			break;
+		if (waited == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			dW("waitpid() failed for the script: %s.", strerror(errno));
+			break;
+		}
+
+		int left = sce_time_left(&deadline);
+		if (left == 0)
+			timed_out = true;
+		else
+			poll(NULL, 0, left < SCE_WAIT_INTERVAL ? left : SCE_WAIT_INTERVAL);
+	}
+
+	if (timed_out)
+	{
+		kill(-pid, SIGKILL);
+		while (waitpid(pid, wstatus, 0) == -1 && errno == EINTR)
+			;
+	}
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (fds[i].fd >= 0)
+			close(fds[i].fd);
+	}
+
+	return !timed_out;
+}
+
 xccdf_test_result_type_t sce_engine_eval_rule(struct xccdf_policy *policy, const char *rule_id, const char *id, const char *href,
 		struct xccdf_value_binding_iterator *value_binding_it,
 		struct xccdf_check_import_iterator *check_import_it,
@@ -360,257 +714,188 @@ xccdf_test_result_type_t sce_engine_eval_rule(struct xccdf_policy *policy, const
 		return XCCDF_RESULT_ERROR;
 	}
 
-	// all the result codes are shifted by 100, because otherwise syntax errors in scripts
-	// or even their nonexistence would cause XCCDF_RESULT_PASS to be the result
-
 	char* argvp[1 + 1] = {
 		tmp_href,
 		NULL
 	};
 
-	// bound values in KEY=VALUE form, ready to be passed as environment variables
-	char ** env_values = oscap_alloc(10 * sizeof(char * ));
-	size_t env_value_count = 10;
-
-	env_values[0] = "PATH=/bin:/sbin:/usr/bin:/usr/sbin";
-
-	env_values[1] = "XCCDF_RESULT_PASS=101";
-	env_values[2] = "XCCDF_RESULT_FAIL=102";
-	env_values[3] = "XCCDF_RESULT_ERROR=103";
-	env_values[4] = "XCCDF_RESULT_UNKNOWN=104";
-	env_values[5] = "XCCDF_RESULT_NOT_APPLICABLE=105";
-	env_values[6] = "XCCDF_RESULT_NOT_CHECKED=106";
-	env_values[7] = "XCCDF_RESULT_NOT_SELECTED=107";
-	env_values[8] = "XCCDF_RESULT_INFORMATIONAL=108";
-	env_values[9] = "XCCDF_RESULT_FIXED=109";
+	// bound values in KEY=VALUE form, ready to be passed as environment variables,
+	// the entries are owned by sce_env_base and the bindings, not by this array
+	size_t env_value_count = SCE_ENV_BASE_COUNT;
+	const char** env_values = oscap_alloc((env_value_count + 1) * sizeof(char*));
+	memcpy(env_values, sce_env_base, sizeof(sce_env_base));
+	struct oscap_list* owned_bindings = oscap_list_new();
 
 	while (xccdf_value_binding_iterator_has_more(value_binding_it))
 	{
 		struct xccdf_value_binding* binding = xccdf_value_binding_iterator_next(value_binding_it);
+		struct sce_env_binding* env_binding = sce_parameters_get_env_binding(parameters, binding, owned_bindings);
 
-		env_values = oscap_realloc(env_values, (env_value_count + 3) * sizeof(char*));
-
-		char* name = xccdf_value_binding_get_name(binding);
-		xccdf_value_type_t type = xccdf_value_binding_get_type(binding);
-		char* value = xccdf_value_binding_get_setvalue(binding);
-		if (value == NULL)
-		{
-			value = xccdf_value_binding_get_value(binding);
-		}
-		xccdf_operator_t operator = xccdf_value_binding_get_operator(binding);
-
-		char* type_str;
-		switch (type)
-		{
-		case XCCDF_TYPE_BOOLEAN:
-			type_str = "BOOLEAN";
-			break;
-		case XCCDF_TYPE_NUMBER:
-			type_str = "NUMBER";
-			break;
-		case XCCDF_TYPE_STRING:
-			type_str = "STRING";
-			break;
-		default:
-			assert(0);
-			type_str = NULL;
-			break;
-		}
-
-		char* env_type_entry = oscap_sprintf("XCCDF_TYPE_%s=%s", name, type_str);
-		char* env_value_entry = oscap_sprintf("XCCDF_VALUE_%s=%s", name, value);
-
-		char* operator_str;
-		switch (operator)
+		env_values = oscap_realloc(env_values, (env_value_count + 3 + 1) * sizeof(char*));
+		for (size_t i = 0; i < 3; ++i)
 		{
-		case XCCDF_OPERATOR_EQUALS:
-			operator_str = "EQUALS";
-			break;
-		case XCCDF_OPERATOR_NOT_EQUAL:
-			operator_str = "NOT_EQUAL";
-			break;
-		case XCCDF_OPERATOR_GREATER:
-			operator_str = "GREATER";
-			break;
-		case XCCDF_OPERATOR_GREATER_EQUAL:
-			operator_str = "GREATER_EQUAL";
-			break;
-		case XCCDF_OPERATOR_LESS:
-			operator_str = "LESS";
-			break;
-		case XCCDF_OPERATOR_LESS_EQUAL:
-			operator_str = "LESS_EQUAL";
-			break;
-		case XCCDF_OPERATOR_PATTERN_MATCH:
-			operator_str = "PATTERN_MATCH";
-			break;
-		default:
-			assert(0);
-			operator_str = NULL;
-			break;
+			env_values[env_value_count] = env_binding->entries[i];
+			env_value_count++;
 		}
-
-		char* env_operator_entry = oscap_sprintf("XCCDF_OPERATOR_%s=%s", name, operator_str);
-
-		env_values[env_value_count] = env_type_entry;
-		env_value_count++;
-		env_values[env_value_count] = env_value_entry;
-		env_value_count++;
-		env_values[env_value_count] = env_operator_entry;
-		env_value_count++;
 	}
-
-	env_values = oscap_realloc(env_values, (env_value_count + 1) * sizeof(char*));
 	env_values[env_value_count] = NULL;
 
 	// We open a pipe for communication with the forked process
-	int stdout_pipefd[2];
-	int stderr_pipefd[2];
-	if (pipe(stdout_pipefd) == -1 || pipe(stderr_pipefd) == -1)
+	int stdout_pipefd[2] = { -1, -1 };
+	int stderr_pipefd[2] = { -1, -1 };
+	if (sce_pipe(stdout_pipefd) == -1 || sce_pipe(stderr_pipefd) == -1)
 	{
 		perror("pipe");
-		// the first 9 values (0 to 8) are compiled in
-		for (size_t i = 9; i < env_value_count; ++i)
-		{
-			oscap_free(env_values[i]);
-		}
-		oscap_free(env_values);
-		return XCCDF_RESULT_ERROR;
+		goto cleanup;
 	}
 
 	// FIXME: We definitely want to impose security restrictions in the forked child process in the future.
 	//        This would prevent scripts from writing to files or deleting them.
 
-	int fork_result = fork();
-	if (fork_result >= 0)
+	pid_t fork_result = fork();
+	if (fork_result < 0)
 	{
-		// fork successful
+		goto cleanup;
+	}
 
-		if (fork_result == 0)
-		{
-		    // we won't read from the pipes, so close the reading fd
-		    close(stdout_pipefd[0]);
-		    close(stderr_pipefd[0]);
-
-			// forward stdout and stderr to our custom opened pipes
-			dup2(stdout_pipefd[1], fileno(stdout));
-			dup2(stderr_pipefd[1], fileno(stderr));
-
-			// we duplicated the file descriptors twice, we can close the original
-			// ones now, stdout and stderr will be closed properly after the execved
-			// script/executable finishes
-			close(stdout_pipefd[1]);
-			close(stderr_pipefd[1]);
-
-			// before we execute the script, lets make sure we get SIGTERM when
-			// oscap is killed, crashes or otherwise terminates
+	if (fork_result == 0)
+	{
+		// we won't read from the pipes, so close the reading fd
+		close(stdout_pipefd[0]);
+		close(stderr_pipefd[0]);
+
+		// forward stdout and stderr to our custom opened pipes
+		dup2(stdout_pipefd[1], fileno(stdout));
+		dup2(stderr_pipefd[1], fileno(stderr));
+
+		// we duplicated the file descriptors twice, we can close the original
+		// ones now, stdout and stderr will be closed properly after the execved
+		// script/executable finishes
+		close(stdout_pipefd[1]);
+		close(stderr_pipefd[1]);
+
+		// a script which runs out of time is killed together with its children
+		if (parameters->timeout > 0)
+			setpgid(0, 0);
+
+		// before we execute the script, lets make sure we get SIGTERM when
+		// oscap is killed, crashes or otherwise terminates
 #ifdef PR_SET_PDEATHSIG
-			// requires Linux 2.1.57 or later
-			prctl(PR_SET_PDEATHSIG, SIGTERM);
+		// requires Linux 2.1.57 or later
+		prctl(PR_SET_PDEATHSIG, SIGTERM);
 #else
-			// TODO: Please provide alternatives
+		// TODO: Please provide alternatives
 #endif
 
-			// we are the child process
-			execve(tmp_href, argvp, env_values);
+		// we are the child process
+		execve(tmp_href, argvp, (char**)env_values);
 
-			// no need to check the return value of execve, if it returned at all we are in trouble
-			printf("Unexpected error when executing script '%s'. Error message follows.\n", href);
-			perror("execve");
+		// no need to check the return value of execve, if it returned at all we are in trouble
+		printf("Unexpected error when executing script '%s'. Error message follows.\n", href);
+		perror("execve");
 
-			// the parent process considers us a script check, we have to return a value that will mean XCCDF_RESULT_ERROR
-			exit(103);
-		}
-		else
-		{
-			// we won't write to the pipes, so close the writing fd
-			close(stdout_pipefd[1]);
-			close(stderr_pipefd[1]);
-
-			char* stdout_buffer = oscap_acquire_pipe_to_string(stdout_pipefd[0]);
-			char* stderr_buffer = oscap_acquire_pipe_to_string(stderr_pipefd[0]);
-
-			// we are the parent process
-			int wstatus;
-			waitpid(fork_result, &wstatus, 0);
+		// the parent process considers us a script check, we have to return a value that will mean XCCDF_RESULT_ERROR
+		exit(103);
+	}
 
-			// we subtract 100 here to shift the exit code to xccdf_test_result_type_t enum range
-			int raw_result = WEXITSTATUS(wstatus) - 100;
-			if (raw_result <= 0 || raw_result > XCCDF_RESULT_FIXED)
-			{
-				// the script returned invalid exit code, we need to safeguard us against that
-				raw_result = XCCDF_RESULT_ERROR;
-			}
+	// we are the parent process
+	if (parameters->timeout > 0)
+		setpgid(fork_result, fork_result);
 
-			struct sce_session* session = sce_parameters_get_session(parameters);
-			if (session)
-			{
-				struct sce_check_result* check_result = sce_check_result_new();
-				sce_check_result_set_href(check_result, tmp_href);
-				sce_check_result_set_basename(check_result, basename(tmp_href));
-				sce_check_result_set_stdout(check_result, stdout_buffer);
-				sce_check_result_set_stderr(check_result, stderr_buffer);
-				sce_check_result_set_exit_code(check_result, WEXITSTATUS(wstatus));
-				sce_check_result_set_xccdf_result(check_result, (xccdf_test_result_type_t)raw_result);
-
-				for (size_t i = 0; i < env_value_count; ++i)
-				{
-					sce_check_result_add_environment_variable(check_result, env_values[i]);
-				}
-
-				sce_session_add_check_result(session, check_result);
-			}
+	// we won't write to the pipes, so close the writing fd
+	close(stdout_pipefd[1]);
+	close(stderr_pipefd[1]);
 
-			// the first 10 values (0 to 9) are compiled in
-			for (size_t i = 10; i < env_value_count; ++i)
-			{
-				oscap_free(env_values[i]);
-			}
-			oscap_free(env_values);
+	struct sce_output outputs[2] = {
+		{ stdout_pipefd[0], oscap_string_new(), 0, false },
+		{ stderr_pipefd[0], oscap_string_new(), 0, false }
+	};
+	int wstatus;
+	bool finished = sce_collect_output(parameters, fork_result, outputs, 2, &wstatus);
 
-			// lets interpret the check imports passed to us
-			xccdf_check_import_iterator_reset(check_import_it);
-			while (xccdf_check_import_iterator_has_more(check_import_it))
-			{
-				struct xccdf_check_import * check_import = xccdf_check_import_iterator_next(check_import_it);
-				const char *name = xccdf_check_import_get_name(check_import);
-
-				if (strcmp(name, "stdout") == 0)
-				{
-					xccdf_check_import_set_content(check_import, stdout_buffer);
-				}
-				else if (strcmp(name, "stderr") == 0)
-				{
-					xccdf_check_import_set_content(check_import, stderr_buffer);
-				}
-			}
+	if (!finished)
+	{
+		oscap_seterr(OSCAP_EFAMILY_SCE, "SCE script '%s' didn't finish in %u seconds and was killed.",
+				href, parameters->timeout);
+	}
+	for (size_t i = 0; i < 2; ++i)
+	{
+		if (outputs[i].truncated)
+			dW("Output of SCE script '%s' truncated to %zu bytes.", href, parameters->output_limit);
+	}
+	char* stdout_buffer = oscap_string_bequeath(outputs[0].buffer);
+	char* stderr_buffer = oscap_string_bequeath(outputs[1].buffer);
 
-			oscap_free(tmp_href);
-			oscap_free(stdout_buffer);
-			oscap_free(stderr_buffer);
+	// we subtract 100 here to shift the exit code to xccdf_test_result_type_t enum range
+	int raw_result = WEXITSTATUS(wstatus) - 100;
+	if (!finished || !WIFEXITED(wstatus) || raw_result <= 0 || raw_result > XCCDF_RESULT_FIXED)
+	{
+		// the script returned invalid exit code, we need to safeguard us against that
+		raw_result = XCCDF_RESULT_ERROR;
+	}
 
-			return (xccdf_test_result_type_t)raw_result;
+	struct sce_session* session = sce_parameters_get_session(parameters);
+	if (session)
+	{
+		struct sce_check_result* check_result = sce_check_result_new();
+		sce_check_result_set_href(check_result, tmp_href);
+		sce_check_result_set_basename(check_result, basename(tmp_href));
+		sce_check_result_set_stdout(check_result, stdout_buffer);
+		sce_check_result_set_stderr(check_result, stderr_buffer);
+		sce_check_result_set_exit_code(check_result, WEXITSTATUS(wstatus));
+		sce_check_result_set_xccdf_result(check_result, (xccdf_test_result_type_t)raw_result);
+
+		for (size_t i = 0; i < env_value_count; ++i)
+		{
+			sce_check_result_add_environment_variable(check_result, env_values[i]);
 		}
+
+		sce_session_add_check_result(session, check_result);
 	}
-	else
+
+	// lets interpret the check imports passed to us
+	xccdf_check_import_iterator_reset(check_import_it);
+	while (xccdf_check_import_iterator_has_more(check_import_it))
 	{
-		// the first 9 values (0 to 8) are compiled in
-		for (size_t i = 9; i < env_value_count; ++i)
+		struct xccdf_check_import * check_import = xccdf_check_import_iterator_next(check_import_it);
+		const char *name = xccdf_check_import_get_name(check_import);
+
+		if (strcmp(name, "stdout") == 0)
+		{
+			xccdf_check_import_set_content(check_import, stdout_buffer);
+		}
+		else if (strcmp(name, "stderr") == 0)
 		{
-			oscap_free(env_values[i]);
+			xccdf_check_import_set_content(check_import, stderr_buffer);
 		}
-		oscap_free(env_values);
+	}
 
-		close(stdout_pipefd[0]);
-		close(stdout_pipefd[1]);
-		close(stderr_pipefd[0]);
-		close(stderr_pipefd[1]);
-		return XCCDF_RESULT_ERROR;
+	oscap_free(stdout_buffer);
+	oscap_free(stderr_buffer);
+	oscap_free(tmp_href);
+	oscap_free(env_values);
+	oscap_list_free(owned_bindings, (oscap_destruct_func) sce_env_binding_free);
+	return (xccdf_test_result_type_t)raw_result;
+
+cleanup:
+	for (size_t i = 0; i < 2; ++i)
+	{
+		if (stdout_pipefd[i] >= 0)
+			close(stdout_pipefd[i]);
+		if (stderr_pipefd[i] >= 0)
+			close(stderr_pipefd[i]);
 	}
+	oscap_free(tmp_href);
+	oscap_free(env_values);
+	oscap_list_free(owned_bindings, (oscap_destruct_func) sce_env_binding_free);
+	return XCCDF_RESULT_ERROR;
 }
 
 bool xccdf_policy_model_register_engine_sce(struct xccdf_policy_model * model, struct sce_parameters *parameters)
 {
-	return xccdf_policy_model_register_engine_and_query_callback(model,
-		"http://open-scap.org/page/SCE", sce_engine_eval_rule, (void*)parameters, NULL);
+	if (!xccdf_policy_model_register_engine_and_query_callback(model,
+		"http://open-scap.org/page/SCE", sce_engine_eval_rule, (void*)parameters, NULL))
+		return false;
+	// every script runs in its own process, 0 means no limit
+	return xccdf_policy_model_set_engine_max_jobs(model, "http://open-scap.org/page/SCE", (void*)parameters, parameters->max_jobs);
 }
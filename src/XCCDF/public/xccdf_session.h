@@ -202,6 +202,26 @@ bool xccdf_session_set_product_cpe(struct xccdf_session *session, const char *pr
  */
 void xccdf_session_set_oval_results_export(struct xccdf_session *session, bool to_export_oval_results);
 
+/**
+ * Set whether the OVAL result files shall be written without building the
+ * whole documents in memory, see \ref oval_results_model_export_stream.
+ * The documents are still built when they are put into an ARF file or
+ * validated.
+ * @memberof xccdf_session
+ * @param session XCCDF Session
+ * @param stream whether to stream the OVAL result files (defaults to false)
+ */
+void xccdf_session_set_oval_results_stream(struct xccdf_session *session, bool stream);
+
+/**
+ * Set how many rules may be evaluated at the same time, see
+ * \ref xccdf_policy_model_set_jobs.
+ * @memberof xccdf_session
+ * @param session XCCDF Session
+ * @param jobs maximal number of concurrently evaluated rules (defaults to 1)
+ */
+void xccdf_session_set_jobs(struct xccdf_session *session, unsigned int jobs);
+
 /**
  * Set that check engine plugin's result files shall be exported.
  * @memberof xccdf_session
@@ -95,6 +95,7 @@ struct xccdf_session {
 		char *xccdf_file;			///< Path to XCCDF file to export
 		char *report_file;			///< Path to HTML file to eport
 		bool oval_results;			///< Shall be the OVAL results files exported?
+		bool oval_results_stream;		///< Shall be the OVAL results files written without building them in memory?
 		bool oval_variables;			///< Shall be the OVAL variable files exported?
 		bool check_engine_plugins_results; ///< Shall the check engine plugins results be exported?
 	} export;					///< Settings of Session export
@@ -105,6 +106,7 @@ struct xccdf_session {
 	} tailoring;
 	bool validate;					///< False value indicates to skip any XSD validation.
 	bool full_validation;				///< True value indicates that every possible step will be validated by XSD.
+	unsigned int jobs;				///< Number of rules evaluated concurrently.
 
 	struct oscap_list *check_engine_plugins; ///< Extra non-OVAL check engines that may or may not have been loaded
 };
@@ -137,6 +139,7 @@ struct xccdf_session *xccdf_session_new(const char *filename)
 		return NULL;
 	}
 	session->validate = true;
+	session->jobs = 1;
 	session->xccdf.base_score = 0;
 	session->oval.progress = download_progress_empty_calllback;
 	session->check_engine_plugins = oscap_list_new();
@@ -354,6 +357,16 @@ void xccdf_session_set_oval_results_export(struct xccdf_session *session, bool t
 	session->export.oval_results = to_export_oval_results;
 }
 
+void xccdf_session_set_oval_results_stream(struct xccdf_session *session, bool stream)
+{
+	session->export.oval_results_stream = stream;
+}
+
+void xccdf_session_set_jobs(struct xccdf_session *session, unsigned int jobs)
+{
+	session->jobs = jobs;
+}
+
 void xccdf_session_set_oval_variables_export(struct xccdf_session *session, bool to_export_oval_variables)
 {
 	session->export.oval_variables = to_export_oval_variables;
@@ -1016,6 +1029,7 @@ int xccdf_session_evaluate(struct xccdf_session *session)
 		return 1;
 	}
 
+	xccdf_policy_model_set_jobs(session->xccdf.policy_model, session->jobs);
 	session->xccdf.result = xccdf_policy_evaluate(policy);
 	if (session->xccdf.result == NULL)
 		return 1;
@@ -1167,7 +1181,7 @@ static void _xccdf_session_free_oval_result_sources(struct xccdf_session *sessio
 	}
 }
 
-static char *_xccdf_session_get_unique_oval_result_filename(struct xccdf_session *session, struct oval_agent_session *oval_session, const char *oval_results_directory)
+static char *_xccdf_session_get_unique_oval_result_filename(struct xccdf_session *session, struct oval_agent_session *oval_session, const char *oval_results_directory, struct oscap_htable *exported)
 {
 	char *escaped_url = NULL;
 	const char *filename = oval_agent_get_filename(oval_session);
@@ -1219,7 +1233,7 @@ static char *_xccdf_session_get_unique_oval_result_filename(struct xccdf_session
 			oscap_free(escaped_url);
 			return NULL;
 		}
-		if (oscap_htable_get(session->oval.result_sources, name) == NULL) {
+		if (oscap_htable_get(exported, name) == NULL) {
 			// Check if this export name conflicts with any other exported OVAL result.
 			//
 			// One example where a conflict can easily happen is if we have the
@@ -1259,7 +1273,7 @@ static char *_xccdf_session_export_oval_result_file(struct xccdf_session *sessio
 		oval_results_directory = session->temp_dir;
 	}
 
-	char *name = _xccdf_session_get_unique_oval_result_filename(session, oval_session, oval_results_directory);
+	char *name = _xccdf_session_get_unique_oval_result_filename(session, oval_session, oval_results_directory, session->oval.result_sources);
 
 	if (name == NULL) {
 		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Can't figure out the right filename for OVAL result file. Can't export that file!");
@@ -1327,9 +1341,54 @@ static int _build_oval_result_sources(struct xccdf_session *session)
 	return 0;
 }
 
+static int _xccdf_session_stream_oval_result_file(struct xccdf_session *session, struct oval_agent_session *oval_session, struct oscap_htable *exported)
+{
+	char *name = _xccdf_session_get_unique_oval_result_filename(session, oval_session, ".", exported);
+	if (name == NULL) {
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Can't figure out the right filename for OVAL result file. Can't export that file!");
+		return 1;
+	}
+
+	struct oval_results_model *res_model = oval_agent_get_results_model(oval_session);
+	if (oval_results_model_export_stream(res_model, NULL, name) != 0) {
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not save file: %s", name);
+		free(name);
+		return 1;
+	}
+	oscap_htable_add(exported, name, oval_session);
+	free(name);
+	return 0;
+}
+
+static int _xccdf_session_stream_oval_results(struct xccdf_session *session)
+{
+	/* The files are written straight from the results models, the names
+	 * of the written files are only kept to keep them unique */
+	struct oscap_htable *exported = oscap_htable_new();
+	int ret = 0;
+
+	for (int i = 0; session->oval.agents[i] && ret == 0; i++)
+		ret = _xccdf_session_stream_oval_result_file(session, session->oval.agents[i], exported);
+
+	struct oscap_htable_iterator *cpe_it = xccdf_policy_model_get_cpe_oval_sessions(session->xccdf.policy_model);
+	while (oscap_htable_iterator_has_more(cpe_it) && ret == 0) {
+		struct oval_agent_session *value = oscap_htable_iterator_next_value(cpe_it);
+		ret = _xccdf_session_stream_oval_result_file(session, value, exported);
+	}
+	oscap_htable_iterator_free(cpe_it);
+	oscap_htable_free0(exported);
+	return ret;
+}
+
 int xccdf_session_export_oval(struct xccdf_session *session)
 {
-	if ((session->export.oval_results || session->export.arf_file != NULL) && session->oval.agents) {
+	/* Results which are neither validated nor put into ARF don't need the DOM */
+	if (session->export.oval_results && session->export.oval_results_stream && session->oval.agents &&
+			session->export.arf_file == NULL && !(session->validate && session->full_validation)) {
+		if (_xccdf_session_stream_oval_results(session) != 0)
+			return 1;
+	}
+	else if ((session->export.oval_results || session->export.arf_file != NULL) && session->oval.agents) {
 		if (_build_oval_result_sources(session) != 0) {
 			return 1;
 		}
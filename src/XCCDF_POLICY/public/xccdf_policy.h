@@ -265,6 +265,29 @@ OSCAP_DEPRECATED(bool xccdf_policy_model_register_engine_callback(struct xccdf_p
  */
 bool xccdf_policy_model_register_engine_and_query_callback(struct xccdf_policy_model *model, char *sys, xccdf_policy_engine_eval_fn eval_fn, void *usr, xccdf_policy_engine_query_fn query_fn);
 
+/**
+ * Declare how many evaluations the checking engine supports at once. The
+ * engine is never called more often concurrently. An engine which doesn't
+ * declare anything is called by one evaluation at a time.
+ * @param model XCCDF Policy Model
+ * @param sys String representing the checking system of the engine
+ * @param usr user data the engine was registered with
+ * @param max_jobs maximal number of concurrent evaluations, 0 for no limit
+ * @memberof xccdf_policy_model
+ * @return true if such engine is registered, false otherwise
+ */
+bool xccdf_policy_model_set_engine_max_jobs(struct xccdf_policy_model *model, const char *sys, void *usr, unsigned int max_jobs);
+
+/**
+ * Set the number of rules evaluated concurrently by xccdf_policy_evaluate.
+ * Rule results are added to the TestResult and passed to the start and output
+ * callbacks in the benchmark order regardless of the number. Default is 1.
+ * @param model XCCDF Policy Model
+ * @param jobs number of rules evaluated concurrently
+ * @memberof xccdf_policy_model
+ */
+void xccdf_policy_model_set_jobs(struct xccdf_policy_model *model, unsigned int jobs);
+
 typedef int (*policy_reporter_output)(struct xccdf_rule_result *, void *);
 
 /**
@@ -30,6 +30,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <libgen.h>
+#include <pthread.h>
 
 #include "xccdf_policy_priv.h"
 #include "xccdf_policy_model_priv.h"
@@ -49,6 +50,7 @@
 #include "common/list.h"
 #include "common/_error.h"
 #include "common/debug_priv.h"
+#include "common/timing_priv.h"
 #include "common/assume.h"
 #include "common/text_priv.h"
 #include "XCCDF/result_scoring_priv.h"
@@ -170,65 +172,18 @@ static struct xccdf_setvalue * xccdf_policy_get_setvalue(struct xccdf_policy * p
     if (id == NULL) return NULL;
     if (policy == NULL) return NULL;
 
-    struct xccdf_setvalue_iterator  * s_value_it;
-    struct xccdf_setvalue           * s_value;
-    struct xccdf_profile            * profile = xccdf_policy_get_profile(policy);;
-
-    /* If profile is NULL we don't have setvalue's
-     * and we return NULL, otherwise we could cause SIGSEG
-     * with accessing NULL structure
-     */
-    if (profile == NULL) return NULL;
-
-    /* We need to return *LAST* setvalue in Profile.
-     * and iterate to the end of setvalue list
-     */
-    struct xccdf_setvalue * final = NULL;
-    s_value_it = xccdf_profile_get_setvalues(profile);
-    while (xccdf_setvalue_iterator_has_more(s_value_it)) {
-        s_value = xccdf_setvalue_iterator_next(s_value_it);
-        if (!strcmp(id, xccdf_setvalue_get_item(s_value))) {
-            final = s_value;
-        }
-    }
-    xccdf_setvalue_iterator_free(s_value_it);
-
-    return final;
+    return oscap_htable_get(policy->setvalues_internal, id);
 }
 
+/**
+ * Get last refine-value from policy that match specified id
+ */
 static struct xccdf_refine_value * xccdf_policy_get_refine_value(struct xccdf_policy * policy, const char * id)
 {
-    /* return NULL if id or policy is NULL but don't use
-     * __attribute_not_null__ here, it will cause abort
-     * which is not desired
-     */
     if (id == NULL) return NULL;
     if (policy == NULL) return NULL;
 
-    struct xccdf_refine_value_iterator  * r_value_it;
-    struct xccdf_refine_value           * r_value;
-    struct xccdf_profile            * profile = xccdf_policy_get_profile(policy);;
-
-    /* If profile is NULL we don't have setvalue's
-     * and we return NULL, otherwise we could cause SIGSEG
-     * with accessing NULL structure
-     */
-    if (profile == NULL) return NULL;
-
-    /* We need to return *LAST* setvalue in Profile.
-     * and iterate to the end of setvalue list
-     */
-    struct xccdf_refine_value * final = NULL;
-    r_value_it = xccdf_profile_get_refine_values(profile);
-    while (xccdf_refine_value_iterator_has_more(r_value_it)) {
-        r_value = xccdf_refine_value_iterator_next(r_value_it);
-        if (!strcmp(id, xccdf_refine_value_get_item(r_value))) {
-            final = r_value;
-        }
-    }
-    xccdf_refine_value_iterator_free(r_value_it);
-
-    return final;
+    return oscap_htable_get(policy->refine_values_internal, id);
 }
 
 /**
@@ -368,6 +323,8 @@ xccdf_policy_evaluate_cb(struct xccdf_policy * policy, const char * sysname, con
     struct oscap_iterator * cb_it = _xccdf_policy_get_engines_by_sysname(policy, sysname);
     while (oscap_iterator_has_more(cb_it)) {
         struct xccdf_policy_engine *engine = (struct xccdf_policy_engine *) oscap_iterator_next(cb_it);
+	if (!xccdf_policy_engine_accepts(engine, href))
+		continue;
 	retval = xccdf_policy_engine_eval(engine, policy, content, href, bindings, check_import_it);
         if (retval != XCCDF_RESULT_NOT_CHECKED) break;
     }
@@ -390,6 +347,8 @@ _xccdf_policy_get_namesfor_href(struct xccdf_policy *policy, const char *sysname
 		struct xccdf_policy_engine *engine = (struct xccdf_policy_engine *) oscap_iterator_next(cb_it);
 		if (engine == NULL)
 			break;
+		if (!xccdf_policy_engine_accepts(engine, href))
+			continue;
 		result = xccdf_policy_engine_query(engine, POLICY_ENGINE_QUERY_NAMES_FOR_HREF, (void *) href);
 	}
 	oscap_iterator_free(cb_it);
@@ -955,48 +914,112 @@ bool xccdf_policy_model_item_is_applicable(struct xccdf_policy_model *model, str
 }
 
 /**
- * Evaluate given check which is immediate child of the rule.
- * A possibe child checks will be evaluated by xccdf_policy_check_evaluate.
- * This duplication is needed to handle @multi-check correctly,
- * which is (in general) not predictable in any way.
+ * Rule evaluated by a worker thread of the parallel evaluation. Outcomes
+ * of the rule are kept until all the preceding rules are reported.
  */
-static inline int
-_xccdf_policy_rule_evaluate(struct xccdf_policy * policy, const struct xccdf_rule *rule, struct xccdf_result *result)
+struct xccdf_policy_job {
+	const struct xccdf_rule *rule;
+	xccdf_role_t role;
+	struct xccdf_check *check;      ///< check to evaluate, NULL if the outcome is known
+	struct oscap_list *outcomes;    ///< list of xccdf_policy_outcome
+	struct err_queue *errors;       ///< errors set during the evaluation
+	int ret;
+	bool done;
+};
+
+/**
+ * One rule-result of a rule
+ */
+struct xccdf_policy_outcome {
+	struct xccdf_check *check;
+	int res;
+	const char *message;
+};
+
+/**
+ * Report one outcome of the rule evaluation. If job is given, the outcome
+ * is stored in the job to be reported later.
+ */
+static int _xccdf_policy_rule_outcome(struct xccdf_policy *policy, struct xccdf_policy_job *job,
+				      struct xccdf_result *result, const struct xccdf_rule *rule,
+				      struct xccdf_check *check, int res, const char *message)
+{
+	if (job == NULL)
+		return _xccdf_policy_report_rule_result(policy, result, rule, check, res, message);
+	if (res == -1)
+		return res;
+
+	struct xccdf_policy_outcome *outcome = oscap_alloc(sizeof(struct xccdf_policy_outcome));
+	outcome->check = check;
+	outcome->res = res;
+	outcome->message = message;
+	oscap_list_add(job->outcomes, outcome);
+	return 0;
+}
+
+/**
+ * Find out the outcome of the rule which can be known without evaluation of its check.
+ * @returns true if the outcome is known, false if the check has to be evaluated
+ */
+static bool
+_xccdf_policy_rule_prepare(struct xccdf_policy *policy, const struct xccdf_rule *rule, xccdf_role_t *role,
+			   struct xccdf_check **check, int *res, const char **message)
 {
 	const char* rule_id = xccdf_rule_get_id(rule);
 	const bool is_selected = xccdf_policy_is_item_selected(policy, rule_id);
-	const char *message = NULL;
 
-	int report = xccdf_policy_report_cb(policy, XCCDF_POLICY_OUTCB_START, (void *) rule);
-	if (report)
-		return report;
+	*check = NULL;
+	*message = NULL;
 
 	struct xccdf_refine_rule_internal* r_rule = oscap_htable_get(policy->refine_rules_internal, rule_id);
 
-	xccdf_role_t role = xccdf_get_final_role(rule, r_rule);
+	*role = xccdf_get_final_role(rule, r_rule);
 	if (!is_selected) {
 		dI("Rule '%s' is not selected.", rule_id);
-		return _xccdf_policy_report_rule_result(policy, result, rule, NULL, XCCDF_RESULT_NOT_SELECTED, NULL);
+		*res = XCCDF_RESULT_NOT_SELECTED;
+		return true;
 	}
 
-	if (role == XCCDF_ROLE_UNCHECKED)
-		return _xccdf_policy_report_rule_result(policy, result, rule, NULL, XCCDF_RESULT_NOT_CHECKED, NULL);
+	if (*role == XCCDF_ROLE_UNCHECKED) {
+		*res = XCCDF_RESULT_NOT_CHECKED;
+		return true;
+	}
 
 	const bool is_applicable = xccdf_policy_model_item_is_applicable(policy->model, (struct xccdf_item*)rule);
 	if (!is_applicable) {
 		dI("Rule '%s' is not applicable.", rule_id);
-		return _xccdf_policy_report_rule_result(policy, result, rule, NULL, XCCDF_RESULT_NOT_APPLICABLE, NULL);
+		*res = XCCDF_RESULT_NOT_APPLICABLE;
+		return true;
 	}
 
 	const struct xccdf_check *orig_check = _xccdf_policy_rule_get_applicable_check(policy, (struct xccdf_item *) rule);
-	if (orig_check == NULL)
+	if (orig_check == NULL) {
 		// No candidate or applicable check found.
-		return _xccdf_policy_report_rule_result(policy, result, rule, NULL, XCCDF_RESULT_NOT_CHECKED, "No candidate or applicable check found.");
+		*res = XCCDF_RESULT_NOT_CHECKED;
+		*message = "No candidate or applicable check found.";
+		return true;
+	}
 
 	// we need to clone the check to avoid changing the original content
-	struct xccdf_check *check = xccdf_check_clone(orig_check);
+	*check = xccdf_check_clone(orig_check);
+	return false;
+}
+
+/**
+ * Evaluate given check which is immediate child of the rule.
+ * A possibe child checks will be evaluated by xccdf_policy_check_evaluate.
+ * This duplication is needed to handle @multi-check correctly,
+ * which is (in general) not predictable in any way.
+ */
+static int
+_xccdf_policy_rule_check(struct xccdf_policy *policy, struct xccdf_policy_job *job, const struct xccdf_rule *rule,
+			 xccdf_role_t role, struct xccdf_check *check, struct xccdf_result *result)
+{
+	const char *message = NULL;
+	int report = 0;
+
 	if (xccdf_check_get_complex(check))
-		return _xccdf_policy_report_rule_result(policy, result, rule, check, xccdf_policy_check_evaluate(policy, check), NULL);
+		return _xccdf_policy_rule_outcome(policy, job, result, rule, check, xccdf_policy_check_evaluate(policy, check), NULL);
 
 	// Now we are evaluating single simple xccdf:check within xccdf:rule.
 	// Since the fact that a check will yield multi-check is not predictable in general
@@ -1007,7 +1030,7 @@ _xccdf_policy_rule_evaluate(struct xccdf_policy * policy, const struct xccdf_rul
 	const char *system_name = xccdf_check_get_system(check);
 	struct oscap_list *bindings = xccdf_policy_check_get_value_bindings(policy, xccdf_check_get_exports(check));
 	if (bindings == NULL)
-		return _xccdf_policy_report_rule_result(policy, result, rule, check, XCCDF_RESULT_UNKNOWN, "Value bindings not found.");
+		return _xccdf_policy_rule_outcome(policy, job, result, rule, check, XCCDF_RESULT_UNKNOWN, "Value bindings not found.");
 
 
 	struct xccdf_check_content_ref_iterator *content_it = xccdf_check_get_content_refs(check);
@@ -1030,7 +1053,7 @@ _xccdf_policy_rule_evaluate(struct xccdf_policy * policy, const struct xccdf_rul
 				if (!oscap_string_iterator_has_more(name_it)) {
 					// Super special case when oval file contains no definitions
 					// thus multi-check shall yield zero rule-results.
-					report = _xccdf_policy_report_rule_result(policy, result, rule, check, XCCDF_RESULT_UNKNOWN, "No definitions found for @multi-check.");
+					report = _xccdf_policy_rule_outcome(policy, job, result, rule, check, XCCDF_RESULT_UNKNOWN, "No definitions found for @multi-check.");
 					oscap_string_iterator_free(name_it);
 					oscap_stringlist_free(names);
 					xccdf_check_content_ref_iterator_free(content_it);
@@ -1047,9 +1070,9 @@ _xccdf_policy_rule_evaluate(struct xccdf_policy * policy, const struct xccdf_rul
 						report = inner_ret;
 						break;
 					}
-					if ((report = _xccdf_policy_report_rule_result(policy, result, rule, cloned_check, inner_ret, NULL)) != 0)
+					if ((report = _xccdf_policy_rule_outcome(policy, job, result, rule, cloned_check, inner_ret, NULL)) != 0)
 						break;
-					if (oscap_string_iterator_has_more(name_it))
+					if (job == NULL && oscap_string_iterator_has_more(name_it))
 						if ((report = xccdf_policy_report_cb(policy, XCCDF_POLICY_OUTCB_START, (void *) rule)) != 0)
 							break;
 				}
@@ -1087,7 +1110,44 @@ _xccdf_policy_rule_evaluate(struct xccdf_policy * policy, const struct xccdf_rul
 	oscap_list_free(bindings, (oscap_destruct_func) xccdf_value_binding_free);
 	/* Negate only once */
 	ret = _resolve_negate(ret, check);
-	return _xccdf_policy_report_rule_result(policy, result, rule, check, ret, message);
+	return _xccdf_policy_rule_outcome(policy, job, result, rule, check, ret, message);
+}
+
+/**
+ * Evaluate the check of the rule, see _xccdf_policy_rule_check, and record
+ * the time it took for the timing report.
+ */
+static int
+_xccdf_policy_rule_check_timed(struct xccdf_policy *policy, struct xccdf_policy_job *job, const struct xccdf_rule *rule,
+			       xccdf_role_t role, struct xccdf_check *check, struct xccdf_result *result)
+{
+	if (!oscap_timing_enabled())
+		return _xccdf_policy_rule_check(policy, job, rule, role, check, result);
+
+	char *system = oscap_strdup(xccdf_check_get_system(check));
+	double start = oscap_timing_now();
+	int ret = _xccdf_policy_rule_check(policy, job, rule, role, check, result);
+	oscap_timing_rule(xccdf_rule_get_id(rule), system, oscap_timing_now() - start);
+	oscap_free(system);
+	return ret;
+}
+
+static inline int
+_xccdf_policy_rule_evaluate(struct xccdf_policy * policy, const struct xccdf_rule *rule, struct xccdf_result *result)
+{
+	xccdf_role_t role;
+	struct xccdf_check *check;
+	int res;
+	const char *message;
+
+	int report = xccdf_policy_report_cb(policy, XCCDF_POLICY_OUTCB_START, (void *) rule);
+	if (report)
+		return report;
+
+	if (_xccdf_policy_rule_prepare(policy, rule, &role, &check, &res, &message))
+		return _xccdf_policy_report_rule_result(policy, result, rule, check, res, message);
+
+	return _xccdf_policy_rule_check_timed(policy, NULL, rule, role, check, result);
 }
 
 /** 
@@ -1133,6 +1193,170 @@ static int xccdf_policy_item_evaluate(struct xccdf_policy * policy, struct xccdf
     return ret;
 }
 
+/**
+ * State of the parallel evaluation shared by the worker threads
+ */
+struct xccdf_policy_jobs {
+	struct xccdf_policy *policy;
+	struct xccdf_policy_job *jobs;
+	size_t count;
+	size_t next;                    ///< the first job which may wait for a worker
+	bool stop;
+	pthread_mutex_t lock;
+	pthread_cond_t job_done;
+};
+
+/* Add rules under the item to the jobs in the document order. */
+static void _xccdf_policy_jobs_add_item(struct xccdf_policy_jobs *p, struct xccdf_item *item)
+{
+	if (xccdf_item_get_type(item) == XCCDF_RULE) {
+		p->jobs = oscap_realloc(p->jobs, (p->count + 1) * sizeof(struct xccdf_policy_job));
+		memset(&p->jobs[p->count], 0, sizeof(struct xccdf_policy_job));
+		p->jobs[p->count++].rule = (const struct xccdf_rule *) item;
+	}
+	else if (xccdf_item_get_type(item) == XCCDF_GROUP) {
+		struct xccdf_item_iterator *child_it = xccdf_group_get_content((const struct xccdf_group *) item);
+		while (xccdf_item_iterator_has_more(child_it))
+			_xccdf_policy_jobs_add_item(p, xccdf_item_iterator_next(child_it));
+		xccdf_item_iterator_free(child_it);
+	}
+}
+
+static void *_xccdf_policy_jobs_worker(void *arg)
+{
+	struct xccdf_policy_jobs *p = arg;
+
+	pthread_mutex_lock(&p->lock);
+	for (;;) {
+		while (p->next < p->count && p->jobs[p->next].done)
+			p->next++;
+		if (p->stop || p->next >= p->count)
+			break;
+		struct xccdf_policy_job *job = &p->jobs[p->next++];
+		pthread_mutex_unlock(&p->lock);
+
+		dI("Evaluating XCCDF rule '%s'.", xccdf_rule_get_id(job->rule));
+		job->ret = _xccdf_policy_rule_check_timed(p->policy, job, job->rule, job->role, job->check, NULL);
+		job->errors = oscap_err_detach();
+
+		pthread_mutex_lock(&p->lock);
+		job->done = true;
+		pthread_cond_broadcast(&p->job_done);
+	}
+	pthread_mutex_unlock(&p->lock);
+	return NULL;
+}
+
+/* Report the outcomes of a finished job, in the same way as the sequential evaluation does. */
+static int _xccdf_policy_jobs_report(struct xccdf_policy *policy, struct xccdf_policy_job *job, struct xccdf_result *result)
+{
+	int ret = 0;
+
+	struct oscap_iterator *outcome_it = oscap_iterator_new(job->outcomes);
+	while (ret == 0 && oscap_iterator_has_more(outcome_it)) {
+		struct xccdf_policy_outcome *outcome = oscap_iterator_next(outcome_it);
+		ret = xccdf_policy_report_cb(policy, XCCDF_POLICY_OUTCB_START, (void *) job->rule);
+		if (ret == 0) {
+			ret = _xccdf_policy_report_rule_result(policy, result, job->rule, outcome->check, outcome->res, outcome->message);
+			outcome->check = NULL;
+		}
+	}
+	oscap_iterator_free(outcome_it);
+	return (ret != 0) ? ret : job->ret;
+}
+
+static void _xccdf_policy_outcome_free(struct xccdf_policy_outcome *outcome)
+{
+	xccdf_check_free(outcome->check);
+	oscap_free(outcome);
+}
+
+/**
+ * Evaluate rules of the benchmark concurrently. Outcomes which don't depend
+ * on checking engines are found out right away, checks are evaluated by the
+ * worker threads. The results are reported in the document order as soon
+ * as all the preceding rules are reported.
+ */
+static int _xccdf_policy_evaluate_parallel(struct xccdf_policy *policy, struct xccdf_benchmark *benchmark, struct xccdf_result *result)
+{
+	struct xccdf_policy_jobs p;
+	size_t pending = 0;
+	int ret = 0;
+
+	memset(&p, 0, sizeof(p));
+	p.policy = policy;
+	pthread_mutex_init(&p.lock, NULL);
+	pthread_cond_init(&p.job_done, NULL);
+
+	struct xccdf_item_iterator *item_it = xccdf_benchmark_get_content(benchmark);
+	while (xccdf_item_iterator_has_more(item_it))
+		_xccdf_policy_jobs_add_item(&p, xccdf_item_iterator_next(item_it));
+	xccdf_item_iterator_free(item_it);
+
+	/* CPE applicability isn't thread safe, find out all the known outcomes first */
+	for (size_t i = 0; i < p.count; i++) {
+		struct xccdf_policy_job *job = &p.jobs[i];
+		struct xccdf_check *check;
+		int res;
+		const char *message;
+
+		job->outcomes = oscap_list_new();
+		if (_xccdf_policy_rule_prepare(policy, job->rule, &job->role, &check, &res, &message)) {
+			_xccdf_policy_rule_outcome(policy, job, result, job->rule, check, res, message);
+			job->done = true;
+		} else {
+			job->check = check;
+			pending++;
+		}
+	}
+
+	size_t nthreads = policy->model->jobs < pending ? policy->model->jobs : pending;
+	pthread_t *threads = oscap_alloc((nthreads + 1) * sizeof(pthread_t));
+	size_t started = 0;
+	while (started < nthreads) {
+		if (pthread_create(&threads[started], NULL, _xccdf_policy_jobs_worker, &p) != 0)
+			break;
+		started++;
+	}
+	if (started == 0 && pending > 0) {
+		/* no worker, evaluate the checks here */
+		_xccdf_policy_jobs_worker(&p);
+	}
+	dI("Evaluating %zu XCCDF rules in %zu threads.", pending, started);
+
+	for (size_t i = 0; i < p.count && ret == 0; i++) {
+		struct xccdf_policy_job *job = &p.jobs[i];
+
+		pthread_mutex_lock(&p.lock);
+		while (!job->done)
+			pthread_cond_wait(&p.job_done, &p.lock);
+		pthread_mutex_unlock(&p.lock);
+
+		oscap_err_attach(job->errors);
+		job->errors = NULL;
+		ret = _xccdf_policy_jobs_report(policy, job, result);
+	}
+
+	pthread_mutex_lock(&p.lock);
+	p.stop = true;
+	pthread_mutex_unlock(&p.lock);
+	for (size_t i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+	oscap_free(threads);
+
+	for (size_t i = 0; i < p.count; i++) {
+		struct xccdf_policy_job *job = &p.jobs[i];
+		oscap_list_free(job->outcomes, (oscap_destruct_func) _xccdf_policy_outcome_free);
+		oscap_err_attach(job->errors);
+		if (!job->done)
+			xccdf_check_free(job->check);
+	}
+	oscap_free(p.jobs);
+	pthread_mutex_destroy(&p.lock);
+	pthread_cond_destroy(&p.job_done);
+	return ret;
+}
+
 struct oscap_file_entry {
 	char* system_name;
 	char* file;
@@ -1568,18 +1792,58 @@ xccdf_policy_model_register_engine_and_query_callback(struct xccdf_policy_model
 	return oscap_list_add(model->engines, engine);
 }
 
+static struct xccdf_policy_engine *
+_xccdf_policy_model_get_engine(struct xccdf_policy_model *model, const char *sys, void *usr)
+{
+	struct xccdf_policy_engine *result = NULL;
+	struct oscap_iterator *cb_it = oscap_iterator_new(model->engines);
+	while (oscap_iterator_has_more(cb_it) && result == NULL) {
+		struct xccdf_policy_engine *engine = oscap_iterator_next(cb_it);
+		if (xccdf_policy_engine_match(engine, sys, usr))
+			result = engine;
+	}
+	oscap_iterator_free(cb_it);
+	return result;
+}
+
+bool xccdf_policy_model_set_engine_max_jobs(struct xccdf_policy_model *model, const char *sys, void *usr, unsigned int max_jobs)
+{
+	__attribute__nonnull__(model);
+	struct xccdf_policy_engine *engine = _xccdf_policy_model_get_engine(model, sys, usr);
+	if (engine == NULL)
+		return false;
+	xccdf_policy_engine_set_max_jobs(engine, max_jobs);
+	return true;
+}
+
+bool xccdf_policy_model_set_engine_href(struct xccdf_policy_model *model, const char *sys, void *usr, const char *href)
+{
+	__attribute__nonnull__(model);
+	struct xccdf_policy_engine *engine = _xccdf_policy_model_get_engine(model, sys, usr);
+	if (engine == NULL)
+		return false;
+	xccdf_policy_engine_set_href(engine, href);
+	return true;
+}
+
+void xccdf_policy_model_set_jobs(struct xccdf_policy_model *model, unsigned int jobs)
+{
+	__attribute__nonnull__(model);
+	model->jobs = (jobs > 0) ? jobs : 1;
+}
+
 void xccdf_policy_model_unregister_engines(struct xccdf_policy_model *model, const char *sys)
 {
 	__attribute__nonnull__(model);
 	if (sys == NULL)
-		oscap_list_free(model->engines, (oscap_destruct_func) oscap_free);
+		oscap_list_free(model->engines, (oscap_destruct_func) xccdf_policy_engine_free);
 	else {
 		struct oscap_list *rest = oscap_list_new();
 		struct oscap_iterator *cb_it = oscap_iterator_new(model->engines);
 		while (oscap_iterator_has_more(cb_it)) {
 			struct xccdf_policy_engine *engine = oscap_iterator_next(cb_it);
 			if (xccdf_policy_engine_filter(engine, sys))
-				oscap_free(engine);
+				xccdf_policy_engine_free(engine);
 			else
 				oscap_list_add(rest, engine);
 		}
@@ -1649,6 +1913,7 @@ struct xccdf_policy_model * xccdf_policy_model_new(struct xccdf_benchmark * benc
 	model->policies  = oscap_list_new();
         model->callbacks = oscap_list_new();
 	model->engines = oscap_list_new();
+	model->jobs = 1;
 
 	model->cpe = cpe_session_new();
 
@@ -1760,6 +2025,35 @@ static void _xccdf_policy_add_profile_selectors(struct xccdf_policy* policy, str
 	xccdf_select_iterator_free(sel_it);
 }
 
+/**
+ * Index set-values and refine-values of the profile by item id, the last
+ * one specified for an item wins.
+ */
+static void _xccdf_policy_add_profile_values(struct xccdf_policy *policy, struct xccdf_profile *profile)
+{
+	struct xccdf_setvalue_iterator *s_value_it = xccdf_profile_get_setvalues(profile);
+	while (xccdf_setvalue_iterator_has_more(s_value_it)) {
+		struct xccdf_setvalue *s_value = xccdf_setvalue_iterator_next(s_value_it);
+		const char *id = xccdf_setvalue_get_item(s_value);
+		if (id == NULL)
+			continue;
+		oscap_htable_detach(policy->setvalues_internal, id);
+		oscap_htable_add(policy->setvalues_internal, id, s_value);
+	}
+	xccdf_setvalue_iterator_free(s_value_it);
+
+	struct xccdf_refine_value_iterator *r_value_it = xccdf_profile_get_refine_values(profile);
+	while (xccdf_refine_value_iterator_has_more(r_value_it)) {
+		struct xccdf_refine_value *r_value = xccdf_refine_value_iterator_next(r_value_it);
+		const char *id = xccdf_refine_value_get_item(r_value);
+		if (id == NULL)
+			continue;
+		oscap_htable_detach(policy->refine_values_internal, id);
+		oscap_htable_add(policy->refine_values_internal, id, r_value);
+	}
+	xccdf_refine_value_iterator_free(r_value_it);
+}
+
 /**
  * Constructor for structure XCCDF Policy. Create the structure and resolve all rules
  * from benchmark that are not present in selectors. This step is necessary because of 
@@ -1787,6 +2081,8 @@ struct xccdf_policy * xccdf_policy_new(struct xccdf_policy_model * model, struct
 	policy->selected_internal = oscap_htable_new();
 	policy->selected_final = oscap_htable_new();
 	policy->refine_rules_internal = oscap_htable_new();
+	policy->setvalues_internal = oscap_htable_new();
+	policy->refine_values_internal = oscap_htable_new();
 	policy->model = model;
 
 	benchmark = xccdf_policy_model_get_benchmark(model);
@@ -1794,6 +2090,7 @@ struct xccdf_policy * xccdf_policy_new(struct xccdf_policy_model * model, struct
 	if (profile) {
 		_xccdf_policy_add_profile_selectors(policy, benchmark, profile);
 		xccdf_policy_add_profile_refine_rules(policy, benchmark, profile);
+		_xccdf_policy_add_profile_values(policy, profile);
 	}
 
         /* Iterate through items in benchmark and resolve rules */
@@ -2040,19 +2337,28 @@ struct xccdf_result * xccdf_policy_evaluate(struct xccdf_policy * policy)
 
 	/** We need to process document top-down order.
 	 * See conflicts/requires and Item Processing Algorithm */
-	struct xccdf_item_iterator *item_it = xccdf_benchmark_get_content(benchmark);
-	while (xccdf_item_iterator_has_more(item_it)) {
-		struct xccdf_item *item = xccdf_item_iterator_next(item_it);
-		ret = xccdf_policy_item_evaluate(policy, item, result);
+	if (policy->model->jobs > 1) {
+		ret = _xccdf_policy_evaluate_parallel(policy, benchmark, result);
 		if (ret == -1) {
-			xccdf_item_iterator_free(item_it);
 			xccdf_result_free(result);
 			return NULL;
 		}
-		if (ret != 0)
-			break;
 	}
-	xccdf_item_iterator_free(item_it);
+	else {
+		struct xccdf_item_iterator *item_it = xccdf_benchmark_get_content(benchmark);
+		while (xccdf_item_iterator_has_more(item_it)) {
+			struct xccdf_item *item = xccdf_item_iterator_next(item_it);
+			ret = xccdf_policy_item_evaluate(policy, item, result);
+			if (ret == -1) {
+				xccdf_item_iterator_free(item_it);
+				xccdf_result_free(result);
+				return NULL;
+			}
+			if (ret != 0)
+				break;
+		}
+		xccdf_item_iterator_free(item_it);
+	}
 
 	xccdf_policy_add_final_setvalues(policy, xccdf_benchmark_to_item(benchmark), result);
 
@@ -2084,28 +2390,14 @@ const char *xccdf_policy_get_value_of_item(struct xccdf_policy * policy, struct
 
 	if (profile != NULL) {
 		/* Get set_value for this item */
-		struct xccdf_setvalue *s_value = NULL;
-		struct xccdf_setvalue *last_s_value = NULL;
-		struct xccdf_setvalue_iterator *s_value_it = xccdf_profile_get_setvalues(profile);
-		while (xccdf_setvalue_iterator_has_more(s_value_it)) {
-			s_value = xccdf_setvalue_iterator_next(s_value_it);
-			if (strcmp(xccdf_setvalue_get_item(s_value), xccdf_value_get_id((struct xccdf_value *) item)) == 0)
-				last_s_value = s_value;
-		}
-		xccdf_setvalue_iterator_free(s_value_it);
-		if (last_s_value != NULL)
-			return xccdf_setvalue_get_value(last_s_value);
+		struct xccdf_setvalue *s_value = xccdf_policy_get_setvalue(policy, xccdf_value_get_id((struct xccdf_value *) item));
+		if (s_value != NULL)
+			return xccdf_setvalue_get_value(s_value);
 
 		/* We don't have set-value in profile, look for refine-value */
-		struct xccdf_refine_value_iterator *r_value_it = xccdf_profile_get_refine_values(profile);
-		while (xccdf_refine_value_iterator_has_more(r_value_it)) {
-			struct xccdf_refine_value *r_value = xccdf_refine_value_iterator_next(r_value_it);
-			if (!strcmp(xccdf_refine_value_get_item(r_value), xccdf_value_get_id((struct xccdf_value *) item))) {
-				selector = xccdf_refine_value_get_selector(r_value);
-				break;
-			}
-		}
-		xccdf_refine_value_iterator_free(r_value_it);
+		struct xccdf_refine_value *r_value = xccdf_policy_get_refine_value(policy, xccdf_value_get_id((struct xccdf_value *) item));
+		if (r_value != NULL)
+			selector = xccdf_refine_value_get_selector(r_value);
 	}
 
 	struct xccdf_value_instance *instance = xccdf_value_get_instance_by_selector((struct xccdf_value *) item, selector);
@@ -2120,19 +2412,7 @@ const char *xccdf_policy_get_value_of_item(struct xccdf_policy * policy, struct
 
 static int xccdf_policy_get_refine_value_oper(struct xccdf_policy * policy, struct xccdf_item * item)
 {
-    struct xccdf_refine_value * r_value = NULL;
-    struct xccdf_profile * profile = xccdf_policy_get_profile(policy);
-    if (profile == NULL) return -1;
-
-    /* We don't have set-value in profile, look for refine-value */
-    struct xccdf_refine_value_iterator * r_value_it = xccdf_profile_get_refine_values(profile);
-    while (xccdf_refine_value_iterator_has_more(r_value_it)) {
-        r_value = xccdf_refine_value_iterator_next(r_value_it);
-        if (!strcmp(xccdf_refine_value_get_item(r_value), xccdf_value_get_id((struct xccdf_value *) item)))
-            break;
-        else r_value = NULL;
-    }
-    xccdf_refine_value_iterator_free(r_value_it);
+    struct xccdf_refine_value * r_value = xccdf_policy_get_refine_value(policy, xccdf_value_get_id((struct xccdf_value *) item));
     if (r_value != NULL) {
         return xccdf_refine_value_get_oper(r_value);
     }
@@ -2258,6 +2538,8 @@ void xccdf_policy_free(struct xccdf_policy * policy) {
 	oscap_htable_free0(policy->selected_internal);
 	oscap_htable_free0(policy->selected_final);
 	oscap_htable_free(policy->refine_rules_internal, (oscap_destruct_func) xccdf_refine_rule_internal_free);
+	oscap_htable_free0(policy->setvalues_internal);
+	oscap_htable_free0(policy->refine_values_internal);
         oscap_free(policy);
 }
 
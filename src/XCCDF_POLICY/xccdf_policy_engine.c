@@ -24,6 +24,8 @@
 #include <config.h>
 #endif
 
+#include <pthread.h>
+
 #include "common/util.h"
 #include "common/list.h"
 #include "common/_error.h"
@@ -35,6 +37,11 @@ struct xccdf_policy_engine {
 	xccdf_policy_engine_eval_fn callback;   ///< format of callback function
 	void * usr;                             ///< User data structure
 	xccdf_policy_engine_query_fn query_fn;  ///< query callback function
+	char *href;                             ///< The only href the engine evaluates (NULL for any)
+	unsigned int max_jobs;                  ///< Maximal number of concurrent calls (0 for no limit)
+	unsigned int running;                   ///< Number of calls in progress
+	pthread_mutex_t lock;
+	pthread_cond_t slot_free;
 };
 
 struct xccdf_policy_engine *xccdf_policy_engine_new(char *sys, xccdf_policy_engine_eval_fn eval_fn, void *usr, xccdf_policy_engine_query_fn query_fn)
@@ -45,10 +52,67 @@ struct xccdf_policy_engine *xccdf_policy_engine_new(char *sys, xccdf_policy_engi
 		engine->callback = eval_fn;
 		engine->usr = usr;
 		engine->query_fn = query_fn;
+		engine->href = NULL;
+		engine->max_jobs = 1;
+		engine->running = 0;
+		pthread_mutex_init(&engine->lock, NULL);
+		pthread_cond_init(&engine->slot_free, NULL);
 	}
 	return engine;
 }
 
+void xccdf_policy_engine_free(struct xccdf_policy_engine *engine)
+{
+	if (engine == NULL)
+		return;
+	pthread_mutex_destroy(&engine->lock);
+	pthread_cond_destroy(&engine->slot_free);
+	oscap_free(engine->href);
+	oscap_free(engine);
+}
+
+bool xccdf_policy_engine_match(struct xccdf_policy_engine *engine, const char *sys, void *usr)
+{
+	return oscap_strcmp(engine->system, sys) == 0 && engine->usr == usr;
+}
+
+void xccdf_policy_engine_set_max_jobs(struct xccdf_policy_engine *engine, unsigned int max_jobs)
+{
+	pthread_mutex_lock(&engine->lock);
+	engine->max_jobs = max_jobs;
+	pthread_cond_broadcast(&engine->slot_free);
+	pthread_mutex_unlock(&engine->lock);
+}
+
+void xccdf_policy_engine_set_href(struct xccdf_policy_engine *engine, const char *href)
+{
+	oscap_free(engine->href);
+	engine->href = oscap_strdup(href);
+}
+
+bool xccdf_policy_engine_accepts(struct xccdf_policy_engine *engine, const char *href)
+{
+	return engine->href == NULL || oscap_strcmp(engine->href, href) == 0;
+}
+
+/* Wait until the engine can take one more call. */
+static void _xccdf_policy_engine_acquire(struct xccdf_policy_engine *engine)
+{
+	pthread_mutex_lock(&engine->lock);
+	while (engine->max_jobs != 0 && engine->running >= engine->max_jobs)
+		pthread_cond_wait(&engine->slot_free, &engine->lock);
+	engine->running++;
+	pthread_mutex_unlock(&engine->lock);
+}
+
+static void _xccdf_policy_engine_release(struct xccdf_policy_engine *engine)
+{
+	pthread_mutex_lock(&engine->lock);
+	engine->running--;
+	pthread_cond_signal(&engine->slot_free);
+	pthread_mutex_unlock(&engine->lock);
+}
+
 bool xccdf_policy_engine_filter(struct xccdf_policy_engine *engine, const char *sysname)
 {
 	return oscap_strcmp(engine->system, sysname) == 0;
@@ -62,7 +126,9 @@ xccdf_test_result_type_t xccdf_policy_engine_eval(struct xccdf_policy_engine *en
 	}
 	else {
 		struct xccdf_value_binding_iterator * binding_it = (struct xccdf_value_binding_iterator *) oscap_iterator_new(value_bindings);
+		_xccdf_policy_engine_acquire(engine);
 		ret = engine->callback(policy, NULL, definition_id, href_id, binding_it, check_import_it, engine->usr);
+		_xccdf_policy_engine_release(engine);
 		if (binding_it != NULL)
 			xccdf_value_binding_iterator_free(binding_it);
 	}
@@ -73,5 +139,8 @@ struct oscap_stringlist *xccdf_policy_engine_query(struct xccdf_policy_engine *e
 {
 	if (engine->query_fn == NULL)
 		return NULL;
-	return (struct oscap_stringlist *) engine->query_fn(engine->usr, query_type, query_data);
+	_xccdf_policy_engine_acquire(engine);
+	struct oscap_stringlist *result = (struct oscap_stringlist *) engine->query_fn(engine->usr, query_type, query_data);
+	_xccdf_policy_engine_release(engine);
+	return result;
 }
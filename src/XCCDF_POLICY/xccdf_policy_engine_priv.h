@@ -48,6 +48,12 @@ struct xccdf_policy_engine;
  */
 struct xccdf_policy_engine *xccdf_policy_engine_new(char *sys, xccdf_policy_engine_eval_fn eval_fn, void *usr, xccdf_policy_engine_query_fn query_fn);
 
+/**
+ * Destructor of the checking engine structure
+ * @memberof xccdf_policy_engine
+ */
+void xccdf_policy_engine_free(struct xccdf_policy_engine *engine);
+
 /**
  * Filter function returning true if given callback is for the given checking engine,
  * false otherwise.
@@ -55,7 +61,38 @@ struct xccdf_policy_engine *xccdf_policy_engine_new(char *sys, xccdf_policy_engi
 bool xccdf_policy_engine_filter(struct xccdf_policy_engine *cb, const char *sysname);
 
 /**
- * Execute the eval function of the given checking engine
+ * Return true if the checking engine was registered with the given system name
+ * and user data, false otherwise.
+ * @memberof xccdf_policy_engine
+ */
+bool xccdf_policy_engine_match(struct xccdf_policy_engine *engine, const char *sys, void *usr);
+
+/**
+ * Set the maximal number of concurrent calls of the checking engine.
+ * @memberof xccdf_policy_engine
+ * @param engine Checking engine
+ * @param max_jobs maximal number of calls in progress, 0 for no limit
+ */
+void xccdf_policy_engine_set_max_jobs(struct xccdf_policy_engine *engine, unsigned int max_jobs);
+
+/**
+ * Restrict the checking engine to checks of the given check-content-ref/@href.
+ * @memberof xccdf_policy_engine
+ * @param engine Checking engine
+ * @param href the href, NULL if the engine evaluates any href
+ */
+void xccdf_policy_engine_set_href(struct xccdf_policy_engine *engine, const char *href);
+
+/**
+ * Return true if the checking engine evaluates checks with the given
+ * check-content-ref/@href, false otherwise.
+ * @memberof xccdf_policy_engine
+ */
+bool xccdf_policy_engine_accepts(struct xccdf_policy_engine *engine, const char *href);
+
+/**
+ * Execute the eval function of the given checking engine. The call waits while
+ * the engine runs as many calls as it supports.
  * @memberof xccdf_policy_engine
  * @param engine Checking engine
  * @param policy XCCDF Policy
@@ -42,6 +42,19 @@ OSCAP_HIDDEN_START;
  */
 void xccdf_policy_model_unregister_engines(struct xccdf_policy_model *model, const char *sys);
 
+/**
+ * Restrict the checking engine registered with the given system name and user
+ * data to checks of the given check-content-ref/@href. Checks of other hrefs
+ * aren't passed to the engine, so they don't need to wait for it.
+ * @memberof xccdf_policy_model
+ * @param model XCCDF Policy Model
+ * @param sys sytem name of the callback
+ * @param usr user data the engine was registered with
+ * @param href the href
+ * @returns true if such engine is registered
+ */
+bool xccdf_policy_model_set_engine_href(struct xccdf_policy_model *model, const char *sys, void *usr, const char *href);
+
 /**
  * Query whether the given list platforms qualifies as 'applicable'. When considering
  * policy_model CPE settings in the given policy model
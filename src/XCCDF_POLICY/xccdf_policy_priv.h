@@ -43,6 +43,7 @@ struct xccdf_policy_model {
 	struct oscap_list       * policies;     ///< List of xccdf_policy structures
 	struct oscap_list       * callbacks;    ///< Callbacks for output callbacks (see callback_out_t)
 	struct oscap_list       * engines;      ///< Callbacks for checking engines (see xccdf_policy_engine)
+	unsigned int              jobs;         ///< Number of rules evaluated concurrently
 
 	struct cpe_session *cpe;
 };
@@ -70,6 +71,10 @@ struct xccdf_policy {
 	struct oscap_htable		*selected_final;
 	/* The hash-table contains the latest refine-rule for specified item-id. */
 	struct oscap_htable		*refine_rules_internal;
+	/* The hash-table contains the latest set-value of the profile for specified item-id. */
+	struct oscap_htable		*setvalues_internal;
+	/* The hash-table contains the latest refine-value of the profile for specified item-id. */
+	struct oscap_htable		*refine_values_internal;
 };
 
 
@@ -57,4 +57,19 @@ struct oscap_err_t {
  */
 void __oscap_seterr(const char *file, uint32_t line, const char *func, oscap_errfamily_t family, ...);
 
+struct err_queue;
+
+/**
+ * Take the errors of the calling thread, the thread has no errors afterwards.
+ * @returns the errors or NULL if there are none
+ */
+struct err_queue *oscap_err_detach(void);
+
+/**
+ * Append errors taken by oscap_err_detach (possibly in another thread) to
+ * the errors of the calling thread.
+ * @param errors the errors, the function takes the ownership (may be NULL)
+ */
+void oscap_err_attach(struct err_queue *errors);
+
 #endif				/* _OSCAP_ERROR_H */
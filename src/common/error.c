@@ -135,6 +135,29 @@ void oscap_clearerr(void)
 	err_queue_free(q, (oscap_destruct_func) oscap_err_free);
 }
 
+struct err_queue *oscap_err_detach(void)
+{
+	struct err_queue *q;
+
+	(void)pthread_once(&__once, oscap_errkey_init);
+
+	q = pthread_getspecific(__key);
+	(void)pthread_setspecific(__key, NULL);
+	return q;
+}
+
+void oscap_err_attach(struct err_queue *errors)
+{
+	struct oscap_err_t *err;
+
+	if (errors == NULL)
+		return;
+	(void)pthread_once(&__once, oscap_errkey_init);
+	while ((err = err_queue_pop_first(errors)) != NULL)
+		_push_err(err);
+	err_queue_free(errors, (oscap_destruct_func) oscap_err_free);
+}
+
 bool oscap_err(void)
 {
 	(void)pthread_once(&__once, oscap_errkey_init);
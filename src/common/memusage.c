@@ -31,6 +31,9 @@
 #include <ctype.h>
 #include <errno.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <limits.h>
 
 #include "debug_priv.h"
 #include "memusage.h"
@@ -211,3 +214,123 @@ int oscap_proc_memusage(struct proc_memusage *mu)
 #endif
 	return 0;
 }
+
+#if defined(__linux__)
+/* Read a single number or "max" (returned as 0) from a cgroup file */
+static int read_cgroup_value(const char *dir, const char *name, size_t *val)
+{
+	char path[PATH_MAX], buf[64];
+	FILE *fp;
+
+	if ((size_t)snprintf(path, sizeof path, "%s/%s", dir, name) >= sizeof path)
+		return (-1);
+
+	fp = fopen(path, "r");
+
+	if (fp == NULL)
+		return (-1);
+
+	if (fgets(buf, sizeof buf, fp) == NULL) {
+		fclose(fp);
+		return (-1);
+	}
+
+	fclose(fp);
+
+	if (strncmp(buf, "max", 3) == 0)
+		*val = 0;
+	else
+		*val = strtoull(buf, NULL, 10) / 1024;
+
+	return (0);
+}
+
+static size_t read_cgroup_file(const char *dir)
+{
+	char path[PATH_MAX], line[256];
+	size_t file = 0;
+	FILE *fp;
+
+	if ((size_t)snprintf(path, sizeof path, "%s/memory.stat", dir) >= sizeof path)
+		return (0);
+
+	fp = fopen(path, "r");
+
+	if (fp == NULL)
+		return (0);
+
+	while (fgets(line, sizeof line, fp) != NULL) {
+		if (strncmp(line, "file ", 5) == 0) {
+			file = strtoull(line + 5, NULL, 10) / 1024;
+			break;
+		}
+	}
+
+	fclose(fp);
+
+	return (file);
+}
+#endif /* __linux__ */
+
+int oscap_cgroup_memusage(struct cgroup_memusage *mu)
+{
+	if (mu == NULL)
+		return -1;
+
+	mu->mu_limit   = 0;
+	mu->mu_current = 0;
+	mu->mu_file    = 0;
+#if defined(__linux__)
+	{
+		/* the cgroup path fits into dir after the root */
+		char line[PATH_MAX - sizeof MEMUSAGE_LINUX_CGROUP_ROOT], dir[PATH_MAX], *slash;
+		size_t limit;
+		FILE *fp;
+		bool found = false;
+
+		fp = fopen(MEMUSAGE_LINUX_CGROUP, "r");
+
+		if (fp == NULL)
+			return 0;
+
+		/* the cgroup v2 hierarchy is the "0::<path>" line */
+		while (fgets(line, sizeof line, fp) != NULL) {
+			if (strncmp(line, "0::", 3) == 0) {
+				/* a longer path would be truncated */
+				found = strchr(line, '\n') != NULL || feof(fp);
+				line[strcspn(line, "\n")] = '\0';
+				break;
+			}
+		}
+
+		fclose(fp);
+
+		if (!found)
+			return 0;
+
+		if ((size_t)snprintf(dir, sizeof dir, "%s%s", MEMUSAGE_LINUX_CGROUP_ROOT,
+		                     strcmp(line + 3, "/") == 0 ? "" : line + 3) >= sizeof dir)
+			return 0;
+
+		if (read_cgroup_value(dir, "memory.current", &mu->mu_current) != 0)
+			return 0;
+
+		mu->mu_file = read_cgroup_file(dir);
+
+		/* the limits of the parents apply too */
+		for (;;) {
+			if (read_cgroup_value(dir, "memory.max", &limit) == 0 &&
+			    limit != 0 && (mu->mu_limit == 0 || limit < mu->mu_limit))
+				mu->mu_limit = limit;
+
+			slash = strrchr(dir, '/');
+
+			if (slash == NULL || (size_t)(slash - dir) < strlen(MEMUSAGE_LINUX_CGROUP_ROOT))
+				break;
+
+			*slash = '\0';
+		}
+	}
+#endif
+	return 0;
+}
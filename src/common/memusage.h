@@ -6,6 +6,8 @@
 # define MEMUSAGE_LINUX_PROC_ENV    "MEMUSAGE_PROC_STATUS"
 # define MEMUSAGE_LINUX_SYS_STATUS "/proc/meminfo"
 # define MEMUSAGE_LINUX_SYS_ENV "MEMUSAGE_SYS_STATUS"
+# define MEMUSAGE_LINUX_CGROUP "/proc/self/cgroup"
+# define MEMUSAGE_LINUX_CGROUP_ROOT "/sys/fs/cgroup"
 #endif /* __linux__ */
 
 struct proc_memusage {
@@ -28,7 +30,21 @@ struct sys_memusage {
 	size_t mu_inactive;
 };
 
+/* cgroup v2 memory controller, all values in kB */
+struct cgroup_memusage {
+	size_t mu_limit;   /* lowest memory.max on the path to the root, 0 = no limit */
+	size_t mu_current; /* memory.current of the cgroup of the process */
+	size_t mu_file;    /* page cache charged to the cgroup (reclaimable) */
+};
+
 int oscap_proc_memusage(struct proc_memusage *mu);
 int oscap_sys_memusage(struct sys_memusage *mu);
 
+/**
+ * Get the memory limit and usage of the cgroup v2 the process runs in.
+ * If there's no such cgroup (cgroup v1 or no memory controller) the limit
+ * is 0 and 0 is returned.
+ */
+int oscap_cgroup_memusage(struct cgroup_memusage *mu);
+
 #endif /* MEMUSAGE_H */
@@ -45,6 +45,7 @@
 #include "debug_priv.h"
 #include "oscap_source.h"
 #include "oscapxml.h"
+#include "timing_priv.h"
 #include "source/schematron_priv.h"
 #include "source/validate_priv.h"
 #include "source/xslt_priv.h"
@@ -109,7 +110,9 @@ void oscap_init(void)
 
 void oscap_cleanup(void)
 {
-	oscap_clearerr();
+	/* the caller reports the failures by oscap_write_timing_report */
+	if (oscap_timing_write() != 0)
+		oscap_clearerr();
 	xsltCleanupGlobals();
 	xmlCleanupParser();
 }
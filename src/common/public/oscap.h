@@ -70,6 +70,23 @@ void oscap_init(void);
  */
 void oscap_cleanup(void);
 
+/**
+ * Record how long the collection of OVAL objects, the evaluation of OVAL
+ * definitions and the checking of XCCDF rules take. The report is written
+ * in JSON into the file by \ref oscap_write_timing_report, or silently by
+ * \ref oscap_cleanup if it hasn't been written yet. It can also be enabled by
+ * the OSCAP_TIMING_REPORT environment variable.
+ * @param file path of the report ("-" for the standard output), NULL disables the report
+ */
+void oscap_set_timing_report(const char *file);
+
+/**
+ * Write the timing report and stop recording. Nothing is done if the report
+ * isn't enabled.
+ * @return 0 on success, -1 on failure with the error set (see \ref oscap_err_desc)
+ */
+int oscap_write_timing_report(void);
+
 /// Get version of the OpenSCAP library
 const char *oscap_get_version(void);
 
@@ -0,0 +1,484 @@
+/**
+ * @file timing.c
+ * \brief Timing report of the evaluation
+ */
+/*
+ * Copyright 2016 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "alloc.h"
+#include "list.h"
+#include "util.h"
+#include "_error.h"
+#include "debug_priv.h"
+#include "timing_priv.h"
+#include "public/oscap.h"
+
+struct oscap_timing_object {
+	char *id;
+	char *type;
+	double start;
+	double wall;
+	double nested;			///< time of the objects collected during this one
+	size_t items;
+	uint64_t sent;
+	uint64_t received;
+	oscap_timing_cache_t cache;
+	struct oscap_timing_object *outer;
+};
+
+struct oscap_timing_definition {
+	char *id;
+	double wall;
+	double criteria;
+};
+
+struct oscap_timing_rule {
+	char *id;
+	char *system;
+	double wall;
+};
+
+/* state of a thread */
+struct oscap_timing_thread {
+	struct oscap_timing_object *current;
+	double collecting;
+};
+
+static struct {
+	pthread_once_t once;
+	pthread_key_t key;
+	pthread_mutex_t lock;
+	bool enabled;
+	char *file;
+	struct oscap_list *objects;
+	struct oscap_list *definitions;
+	struct oscap_list *rules;
+} timing = { PTHREAD_ONCE_INIT };
+
+static void oscap_timing_object_free(struct oscap_timing_object *object)
+{
+	if (object == NULL)
+		return;
+	oscap_free(object->id);
+	oscap_free(object->type);
+	oscap_free(object);
+}
+
+static void oscap_timing_definition_free(struct oscap_timing_definition *definition)
+{
+	if (definition == NULL)
+		return;
+	oscap_free(definition->id);
+	oscap_free(definition);
+}
+
+static void oscap_timing_rule_free(struct oscap_timing_rule *rule)
+{
+	if (rule == NULL)
+		return;
+	oscap_free(rule->id);
+	oscap_free(rule->system);
+	oscap_free(rule);
+}
+
+static void oscap_timing_thread_free(void *arg)
+{
+	struct oscap_timing_thread *thread = arg;
+
+	while (thread->current != NULL) {
+		struct oscap_timing_object *outer = thread->current->outer;
+		oscap_timing_object_free(thread->current);
+		thread->current = outer;
+	}
+	oscap_free(thread);
+}
+
+static void oscap_timing_init(void)
+{
+	const char *file = getenv("OSCAP_TIMING_REPORT");
+
+	(void)pthread_key_create(&timing.key, oscap_timing_thread_free);
+	pthread_mutex_init(&timing.lock, NULL);
+	timing.objects = oscap_list_new();
+	timing.definitions = oscap_list_new();
+	timing.rules = oscap_list_new();
+
+	if (file != NULL && *file != '\0') {
+		timing.file = oscap_strdup(file);
+		timing.enabled = true;
+	}
+}
+
+void oscap_set_timing_report(const char *file)
+{
+	pthread_once(&timing.once, oscap_timing_init);
+
+	pthread_mutex_lock(&timing.lock);
+	oscap_free(timing.file);
+	timing.file = oscap_strdup(file);
+	timing.enabled = (file != NULL);
+	pthread_mutex_unlock(&timing.lock);
+}
+
+bool oscap_timing_enabled(void)
+{
+	pthread_once(&timing.once, oscap_timing_init);
+	return timing.enabled;
+}
+
+double oscap_timing_now(void)
+{
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+		return 0;
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static struct oscap_timing_thread *oscap_timing_thread(void)
+{
+	struct oscap_timing_thread *thread = pthread_getspecific(timing.key);
+
+	if (thread == NULL) {
+		thread = oscap_calloc(1, sizeof(struct oscap_timing_thread));
+		(void)pthread_setspecific(timing.key, thread);
+	}
+	return thread;
+}
+
+void oscap_timing_object_begin(const char *id, const char *type)
+{
+	if (!oscap_timing_enabled())
+		return;
+
+	struct oscap_timing_thread *thread = oscap_timing_thread();
+	struct oscap_timing_object *object = oscap_calloc(1, sizeof(struct oscap_timing_object));
+
+	object->id = oscap_strdup(id);
+	object->type = oscap_strdup(type);
+	object->outer = thread->current;
+	thread->current = object;
+	object->start = oscap_timing_now();
+}
+
+void oscap_timing_object_cache(oscap_timing_cache_t cache)
+{
+	if (!oscap_timing_enabled())
+		return;
+
+	struct oscap_timing_thread *thread = oscap_timing_thread();
+	if (thread->current != NULL)
+		thread->current->cache = cache;
+}
+
+void oscap_timing_object_traffic(uint64_t sent, uint64_t received)
+{
+	if (!oscap_timing_enabled())
+		return;
+
+	struct oscap_timing_thread *thread = oscap_timing_thread();
+	if (thread->current != NULL) {
+		thread->current->sent += sent;
+		thread->current->received += received;
+	}
+}
+
+void oscap_timing_object_end(size_t items)
+{
+	if (!oscap_timing_enabled())
+		return;
+
+	struct oscap_timing_thread *thread = oscap_timing_thread();
+	struct oscap_timing_object *object = thread->current;
+
+	if (object == NULL)
+		return;
+
+	object->wall = oscap_timing_now() - object->start;
+	object->items = items;
+	thread->current = object->outer;
+	object->outer = NULL;
+
+	if (thread->current != NULL)
+		thread->current->nested += object->wall;
+	else
+		thread->collecting += object->wall;
+
+	pthread_mutex_lock(&timing.lock);
+	oscap_list_add(timing.objects, object);
+	pthread_mutex_unlock(&timing.lock);
+}
+
+void oscap_timing_object_add(const char *id, const char *type, double wall, size_t items,
+		uint64_t sent, uint64_t received, oscap_timing_cache_t cache)
+{
+	if (!oscap_timing_enabled())
+		return;
+
+	struct oscap_timing_object *object = oscap_calloc(1, sizeof(struct oscap_timing_object));
+
+	object->id = oscap_strdup(id);
+	object->type = oscap_strdup(type);
+	object->wall = wall;
+	object->items = items;
+	object->sent = sent;
+	object->received = received;
+	object->cache = cache;
+
+	pthread_mutex_lock(&timing.lock);
+	oscap_list_add(timing.objects, object);
+	pthread_mutex_unlock(&timing.lock);
+}
+
+double oscap_timing_collecting(void)
+{
+	if (!oscap_timing_enabled())
+		return 0;
+
+	return oscap_timing_thread()->collecting;
+}
+
+void oscap_timing_definition(const char *id, double wall, double criteria)
+{
+	if (!oscap_timing_enabled())
+		return;
+
+	struct oscap_timing_definition *definition = oscap_alloc(sizeof(struct oscap_timing_definition));
+
+	definition->id = oscap_strdup(id);
+	definition->wall = wall;
+	definition->criteria = criteria;
+
+	pthread_mutex_lock(&timing.lock);
+	oscap_list_add(timing.definitions, definition);
+	pthread_mutex_unlock(&timing.lock);
+}
+
+void oscap_timing_rule(const char *id, const char *system, double wall)
+{
+	if (!oscap_timing_enabled())
+		return;
+
+	struct oscap_timing_rule *rule = oscap_alloc(sizeof(struct oscap_timing_rule));
+
+	rule->id = oscap_strdup(id);
+	rule->system = oscap_strdup(system);
+	rule->wall = wall;
+
+	pthread_mutex_lock(&timing.lock);
+	oscap_list_add(timing.rules, rule);
+	pthread_mutex_unlock(&timing.lock);
+}
+
+static void oscap_timing_json_string(FILE *f, const char *str)
+{
+	if (str == NULL) {
+		fputs("null", f);
+		return;
+	}
+
+	fputc('"', f);
+	for (const unsigned char *c = (const unsigned char *) str; *c != '\0'; c++) {
+		if (*c == '"' || *c == '\\')
+			fprintf(f, "\\%c", *c);
+		else if (*c < 0x20)
+			fprintf(f, "\\u%04x", *c);
+		else
+			fputc(*c, f);
+	}
+	fputc('"', f);
+}
+
+static const char *oscap_timing_cache_text(oscap_timing_cache_t cache)
+{
+	switch (cache) {
+	case OSCAP_TIMING_CACHE_HIT:
+		return "hit";
+	case OSCAP_TIMING_CACHE_MISS:
+		return "miss";
+	default:
+		return "none";
+	}
+}
+
+/* totals of the objects of one type */
+struct oscap_timing_probe {
+	const char *type;
+	size_t objects;
+	double wall;			///< time of the objects without the nested ones
+	size_t items;
+	uint64_t sent;
+	uint64_t received;
+	size_t cache_hits;
+};
+
+static void oscap_timing_write_probes(FILE *f)
+{
+	struct oscap_timing_probe *probes = NULL;
+	size_t count = 0;
+
+	struct oscap_iterator *it = oscap_iterator_new(timing.objects);
+	while (oscap_iterator_has_more(it)) {
+		struct oscap_timing_object *object = oscap_iterator_next(it);
+		size_t i;
+
+		for (i = 0; i < count; i++) {
+			if (oscap_streq(probes[i].type, object->type))
+				break;
+		}
+		if (i == count) {
+			probes = oscap_realloc(probes, (count + 1) * sizeof(struct oscap_timing_probe));
+			memset(&probes[count], 0, sizeof(struct oscap_timing_probe));
+			probes[count++].type = object->type;
+		}
+		probes[i].objects++;
+		probes[i].wall += object->wall - object->nested;
+		probes[i].items += object->items;
+		probes[i].sent += object->sent;
+		probes[i].received += object->received;
+		if (object->cache == OSCAP_TIMING_CACHE_HIT)
+			probes[i].cache_hits++;
+	}
+	oscap_iterator_free(it);
+
+	fputs("  \"probes\": [", f);
+	for (size_t i = 0; i < count; i++) {
+		fputs(i > 0 ? ",\n    {" : "\n    {", f);
+		fputs("\"type\": ", f);
+		oscap_timing_json_string(f, probes[i].type);
+		fprintf(f, ", \"objects\": %zu, \"wall_time_ms\": %.3f, \"items\": %zu, "
+				"\"bytes_sent\": %" PRIu64 ", \"bytes_received\": %" PRIu64 ", \"cache_hits\": %zu}",
+				probes[i].objects, probes[i].wall, probes[i].items,
+				probes[i].sent, probes[i].received, probes[i].cache_hits);
+	}
+	fputs(count > 0 ? "\n  ],\n" : "],\n", f);
+	oscap_free(probes);
+}
+
+static void oscap_timing_write_report(FILE *f)
+{
+	struct oscap_iterator *it;
+	bool first;
+
+	fputs("{\n  \"objects\": [", f);
+	first = true;
+	it = oscap_iterator_new(timing.objects);
+	while (oscap_iterator_has_more(it)) {
+		struct oscap_timing_object *object = oscap_iterator_next(it);
+
+		fputs(first ? "\n    {" : ",\n    {", f);
+		fputs("\"id\": ", f);
+		oscap_timing_json_string(f, object->id);
+		fputs(", \"type\": ", f);
+		oscap_timing_json_string(f, object->type);
+		fprintf(f, ", \"wall_time_ms\": %.3f, \"items\": %zu, \"bytes_sent\": %" PRIu64
+				", \"bytes_received\": %" PRIu64 ", \"cache\": \"%s\"}",
+				object->wall, object->items, object->sent, object->received,
+				oscap_timing_cache_text(object->cache));
+		first = false;
+	}
+	oscap_iterator_free(it);
+	fputs(first ? "],\n" : "\n  ],\n", f);
+
+	oscap_timing_write_probes(f);
+
+	fputs("  \"definitions\": [", f);
+	first = true;
+	it = oscap_iterator_new(timing.definitions);
+	while (oscap_iterator_has_more(it)) {
+		struct oscap_timing_definition *definition = oscap_iterator_next(it);
+
+		fputs(first ? "\n    {" : ",\n    {", f);
+		fputs("\"id\": ", f);
+		oscap_timing_json_string(f, definition->id);
+		fprintf(f, ", \"wall_time_ms\": %.3f, \"criteria_time_ms\": %.3f}",
+				definition->wall, definition->criteria);
+		first = false;
+	}
+	oscap_iterator_free(it);
+	fputs(first ? "],\n" : "\n  ],\n", f);
+
+	fputs("  \"rules\": [", f);
+	first = true;
+	it = oscap_iterator_new(timing.rules);
+	while (oscap_iterator_has_more(it)) {
+		struct oscap_timing_rule *rule = oscap_iterator_next(it);
+
+		fputs(first ? "\n    {" : ",\n    {", f);
+		fputs("\"id\": ", f);
+		oscap_timing_json_string(f, rule->id);
+		fputs(", \"system\": ", f);
+		oscap_timing_json_string(f, rule->system);
+		fprintf(f, ", \"wall_time_ms\": %.3f}", rule->wall);
+		first = false;
+	}
+	oscap_iterator_free(it);
+	fputs(first ? "]\n}\n" : "\n  ]\n}\n", f);
+}
+
+int oscap_timing_write(void)
+{
+	int ret = 0;
+
+	if (!oscap_timing_enabled())
+		return 0;
+
+	pthread_mutex_lock(&timing.lock);
+
+	FILE *f = strcmp(timing.file, "-") == 0 ? stdout : fopen(timing.file, "w");
+	if (f == NULL) {
+		oscap_seterr(OSCAP_EFAMILY_GLIBC, "%s '%s'", strerror(errno), timing.file);
+		ret = -1;
+	} else {
+		oscap_timing_write_report(f);
+		if (ferror(f) || (f != stdout && fclose(f) != 0)) {
+			oscap_seterr(OSCAP_EFAMILY_GLIBC, "Can't write the timing report '%s'.", timing.file);
+			ret = -1;
+		}
+	}
+
+	oscap_list_free(timing.objects, (oscap_destruct_func) oscap_timing_object_free);
+	oscap_list_free(timing.definitions, (oscap_destruct_func) oscap_timing_definition_free);
+	oscap_list_free(timing.rules, (oscap_destruct_func) oscap_timing_rule_free);
+	timing.objects = oscap_list_new();
+	timing.definitions = oscap_list_new();
+	timing.rules = oscap_list_new();
+	/* the report is written once, don't overwrite it with an empty one */
+	timing.enabled = false;
+
+	pthread_mutex_unlock(&timing.lock);
+	return ret;
+}
+
+int oscap_write_timing_report(void)
+{
+	return oscap_timing_write();
+}
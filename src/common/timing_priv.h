@@ -0,0 +1,116 @@
+/**
+ * @file timing_priv.h
+ * @brief Timing report of the evaluation
+ *
+ * When the report is enabled (by oscap_set_timing_report or by the
+ * OSCAP_TIMING_REPORT environment variable), the time spent collecting
+ * every OVAL object, evaluating every OVAL definition and checking every
+ * XCCDF rule is recorded and written in JSON by oscap_cleanup.
+ *
+ * The collection of an object is recorded by the thread which queries it.
+ * Objects queried while another object is being collected (e.g. for the
+ * variables of the object) are recorded separately and their time is
+ * included in the time of the outer object.
+ */
+/*
+ * Copyright 2016 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef OSCAP_TIMING_PRIV_H
+#define OSCAP_TIMING_PRIV_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "util.h"
+
+OSCAP_HIDDEN_START;
+
+typedef enum {
+	OSCAP_TIMING_CACHE_NONE = 0,	///< the object wasn't looked up in the probe cache
+	OSCAP_TIMING_CACHE_HIT,
+	OSCAP_TIMING_CACHE_MISS
+} oscap_timing_cache_t;
+
+/**
+ * Check whether the timing report is enabled.
+ */
+bool oscap_timing_enabled(void);
+
+/**
+ * Get the monotonic time in milliseconds.
+ */
+double oscap_timing_now(void);
+
+/**
+ * Start recording the collection of an object in this thread.
+ * Every call has to be paired with \ref oscap_timing_object_end.
+ */
+void oscap_timing_object_begin(const char *id, const char *type);
+
+/**
+ * Note whether the object being collected by this thread was found in the
+ * probe cache.
+ */
+void oscap_timing_object_cache(oscap_timing_cache_t cache);
+
+/**
+ * Add bytes exchanged with the probe to the object being collected by this thread.
+ */
+void oscap_timing_object_traffic(uint64_t sent, uint64_t received);
+
+/**
+ * Finish recording the collection of the object started last by this thread.
+ * @param items number of the collected items
+ */
+void oscap_timing_object_end(size_t items);
+
+/**
+ * Record the collection of an object which wasn't collected by a single
+ * call (objects collected asynchronously).
+ */
+void oscap_timing_object_add(const char *id, const char *type, double wall, size_t items,
+		uint64_t sent, uint64_t received, oscap_timing_cache_t cache);
+
+/**
+ * Get the time this thread spent collecting objects, in milliseconds. The
+ * time of nested objects is counted only once.
+ */
+double oscap_timing_collecting(void);
+
+/**
+ * Record the evaluation of an OVAL definition.
+ * @param wall the whole evaluation time
+ * @param criteria the time of the evaluation without collecting the objects
+ */
+void oscap_timing_definition(const char *id, double wall, double criteria);
+
+/**
+ * Record the checking of an XCCDF rule.
+ */
+void oscap_timing_rule(const char *id, const char *system, double wall);
+
+/**
+ * Write the report into the report file, drop the recorded data and
+ * disable the report.
+ * @return 0 on success or if there's nothing to write, -1 on failure
+ */
+int oscap_timing_write(void);
+
+OSCAP_HIDDEN_END;
+
+#endif /* OSCAP_TIMING_PRIV_H */
@@ -26,12 +26,18 @@
 #endif
 
 #include <libxml/tree.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
 #include "bz2_priv.h"
 #include "common/_error.h"
+#include "common/alloc.h"
+#include "common/debug_priv.h"
 
 #ifdef HAVE_BZ2
 
@@ -171,8 +177,358 @@ static int bz2_mem_close(void *bzmem) {
 	return bzerror == BZ_OK ? 0 : -1;
 }
 
+/*
+ * Parallel decompression
+ *
+ * The blocks of a bzip2 stream are independent, each of them starts with
+ * a 48 bit magic number followed by the CRC of its data and the stream ends
+ * with another magic number followed by the combined CRC of all blocks.
+ * The blocks aren't aligned to bytes, so their boundaries are found by
+ * searching for the magic numbers bit by bit. Every block is then wrapped
+ * into a stream of its own and decompressed by one of the worker threads.
+ * The parser reads the decompressed blocks in order, the workers stay at
+ * most BZ2_PARALLEL_WINDOW blocks per thread ahead of it.
+ */
+
+#define BZ2_BLOCK_MAGIC 0x314159265359ULL
+#define BZ2_EOS_MAGIC   0x177245385090ULL
+#define BZ2_MAGIC_MASK  0xffffffffffffULL
+#define BZ2_HEADER_BITS 32	// "BZh" and the block size
+#define BZ2_PARALLEL_WINDOW 2
+
+enum bz2_block_state {
+	BZ2_BLOCK_PENDING,
+	BZ2_BLOCK_WORKING,
+	BZ2_BLOCK_DONE,
+	BZ2_BLOCK_FAILED
+};
+
+struct bz2_block {
+	uint64_t start;			///< bit offset of the block magic number
+	uint64_t end;			///< bit offset of the next magic number
+	uint32_t crc;
+	enum bz2_block_state state;
+	int error;			///< libbz2 error of a failed block
+	char *out;			///< decompressed data
+	size_t out_len;
+};
+
+struct bz2_parallel {
+	const unsigned char *in;
+	size_t in_size;
+	struct bz2_block *blocks;
+	size_t nblocks;
+	size_t next_block;		///< next block to be decompressed
+	size_t read_block;		///< block being read by the parser
+	size_t read_offset;
+	size_t window;
+	bool stop;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	pthread_t *threads;
+	int nthreads;
+};
+
+static uint64_t bz2_bits(const unsigned char *in, size_t in_size, uint64_t pos, int count)
+{
+	uint64_t ret = 0;
+	for (int i = 0; i < count; ++i, ++pos) {
+		size_t byte = pos >> 3;
+		int bit = byte < in_size ? (in[byte] >> (7 - (pos & 7))) & 1 : 0;
+		ret = (ret << 1) | bit;
+	}
+	return ret;
+}
+
+static void bz2_put_bits(unsigned char *out, uint64_t pos, uint64_t value, int count)
+{
+	for (int i = count - 1; i >= 0; --i, ++pos) {
+		if ((value >> i) & 1)
+			out[pos >> 3] |= 0x80 >> (pos & 7);
+	}
+}
+
+/*
+ * Find the blocks of the first stream. Returns false if the boundaries
+ * can't be trusted, i.e. the combined CRC doesn't match the blocks found.
+ */
+static bool bz2_find_blocks(struct bz2_parallel *p)
+{
+	static bool filter[256];
+	static bool filter_ready = false;
+	const uint64_t magic[] = { BZ2_BLOCK_MAGIC, BZ2_EOS_MAGIC };
+
+	if (!filter_ready) {
+		// the second byte at any bit offset is fully covered by a magic number
+		for (int m = 0; m < 2; ++m)
+			for (int shift = 0; shift < 8; ++shift)
+				filter[(magic[m] >> (48 - 16 + shift)) & 0xff] = true;
+		filter_ready = true;
+	}
+
+	size_t capacity = 16;
+	p->blocks = oscap_calloc(capacity, sizeof(struct bz2_block));
+	p->nblocks = 0;
+
+	uint64_t expected = BZ2_HEADER_BITS;
+	for (size_t i = BZ2_HEADER_BITS / 8 - 1; i + 1 < p->in_size; ++i) {
+		if (!filter[p->in[i + 1]])
+			continue;
+
+		uint64_t window = 0;
+		for (int j = 0; j < 8; ++j)
+			window = (window << 8) | (i + j < p->in_size ? p->in[i + j] : 0);
+
+		for (int shift = 0; shift < 8; ++shift) {
+			uint64_t pos = (uint64_t) i * 8 + shift;
+			uint64_t value = (window >> (16 - shift)) & BZ2_MAGIC_MASK;
+
+			if (pos < expected || (value != BZ2_BLOCK_MAGIC && value != BZ2_EOS_MAGIC))
+				continue;
+			if (pos + 80 > (uint64_t) p->in_size * 8)
+				return false;
+			if (p->nblocks > 0)
+				p->blocks[p->nblocks - 1].end = pos;
+			else if (pos != BZ2_HEADER_BITS)
+				return false;
+
+			uint32_t crc = bz2_bits(p->in, p->in_size, pos + 48, 32);
+			if (value == BZ2_EOS_MAGIC) {
+				uint32_t combined = 0;
+				for (size_t b = 0; b < p->nblocks; ++b)
+					combined = ((combined << 1) | (combined >> 31)) ^ p->blocks[b].crc;
+				return p->nblocks > 0 && combined == crc;
+			}
+
+			if (p->nblocks == capacity) {
+				capacity *= 2;
+				p->blocks = oscap_realloc(p->blocks, capacity * sizeof(struct bz2_block));
+			}
+			memset(&p->blocks[p->nblocks], 0, sizeof(struct bz2_block));
+			p->blocks[p->nblocks].start = pos;
+			p->blocks[p->nblocks].crc = crc;
+			p->nblocks++;
+			// a block has at least its magic number and CRC
+			expected = pos + 80;
+		}
+	}
+	return false;
+}
+
+static int bz2_block_decompress(const struct bz2_parallel *p, struct bz2_block *block)
+{
+	// "BZh" and the block size, the block and the end of stream
+	uint64_t bits = block->end - block->start;
+	size_t stream_size = 4 + (bits + 80 + 7) / 8;
+	unsigned char *stream = oscap_calloc(stream_size, 1);
+	memcpy(stream, p->in, 4);
+
+	size_t first = block->start >> 3;
+	int shift = block->start & 7;
+	size_t bytes = (bits + 7) / 8;
+	for (size_t i = 0; i < bytes; ++i) {
+		unsigned int hi = p->in[first + i];
+		unsigned int lo = first + i + 1 < p->in_size ? p->in[first + i + 1] : 0;
+		stream[4 + i] = (unsigned char) ((hi << shift) | (lo >> (8 - shift)));
+	}
+	if (bits & 7)
+		stream[4 + bytes - 1] &= 0xff << (8 - (bits & 7));
+	// a stream of a single block has the block CRC as the combined CRC
+	bz2_put_bits(stream + 4, bits, BZ2_EOS_MAGIC, 48);
+	bz2_put_bits(stream + 4, bits + 48, block->crc, 32);
+
+	bz_stream bz;
+	memset(&bz, 0, sizeof(bz));
+	int bzerror = BZ2_bzDecompressInit(&bz, 0, 0);
+	if (bzerror != BZ_OK) {
+		oscap_free(stream);
+		return bzerror;
+	}
+	bz.next_in = (char *) stream;
+	bz.avail_in = stream_size;
+
+	size_t capacity = (p->in[3] - '0') * 100000 + 1;
+	block->out = oscap_alloc(capacity);
+	block->out_len = 0;
+	do {
+		if (block->out_len == capacity) {
+			capacity *= 2;
+			block->out = oscap_realloc(block->out, capacity);
+		}
+		bz.next_out = block->out + block->out_len;
+		bz.avail_out = capacity - block->out_len;
+		bzerror = BZ2_bzDecompress(&bz);
+		block->out_len = capacity - bz.avail_out;
+	} while (bzerror == BZ_OK && (bz.avail_out == 0 || bz.avail_in > 0));
+
+	BZ2_bzDecompressEnd(&bz);
+	oscap_free(stream);
+	if (bzerror == BZ_OK)
+		bzerror = BZ_UNEXPECTED_EOF;
+	return bzerror == BZ_STREAM_END ? BZ_OK : bzerror;
+}
+
+static void *bz2_parallel_worker(void *arg)
+{
+	struct bz2_parallel *p = arg;
+
+	pthread_mutex_lock(&p->lock);
+	for (;;) {
+		while (!p->stop && p->next_block < p->nblocks && p->next_block >= p->read_block + p->window)
+			pthread_cond_wait(&p->cond, &p->lock);
+		if (p->stop || p->next_block >= p->nblocks)
+			break;
+
+		struct bz2_block *block = &p->blocks[p->next_block++];
+		block->state = BZ2_BLOCK_WORKING;
+		pthread_mutex_unlock(&p->lock);
+
+		int bzerror = bz2_block_decompress(p, block);
+
+		pthread_mutex_lock(&p->lock);
+		block->error = bzerror;
+		block->state = bzerror == BZ_OK ? BZ2_BLOCK_DONE : BZ2_BLOCK_FAILED;
+		pthread_cond_broadcast(&p->cond);
+	}
+	pthread_mutex_unlock(&p->lock);
+	return NULL;
+}
+
+// xmlInputReadCallback
+static int bz2_parallel_read(struct bz2_parallel *p, char *buffer, int len)
+{
+	int ret = 0;
+
+	pthread_mutex_lock(&p->lock);
+	while (ret < len && p->read_block < p->nblocks) {
+		struct bz2_block *block = &p->blocks[p->read_block];
+		if (block->state == BZ2_BLOCK_PENDING || block->state == BZ2_BLOCK_WORKING) {
+			if (ret > 0)
+				break;
+			pthread_cond_wait(&p->cond, &p->lock);
+			continue;
+		}
+		if (block->state == BZ2_BLOCK_FAILED) {
+			if (ret == 0) {
+				oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not read from bz_stream: BZ2_bzDecompress returns %d", block->error);
+				ret = -1;
+			}
+			break;
+		}
+
+		size_t count = block->out_len - p->read_offset;
+		if (count > (size_t) (len - ret))
+			count = len - ret;
+		memcpy(buffer + ret, block->out + p->read_offset, count);
+		ret += count;
+		p->read_offset += count;
+
+		if (p->read_offset == block->out_len) {
+			oscap_free(block->out);
+			block->out = NULL;
+			p->read_block++;
+			p->read_offset = 0;
+			pthread_cond_broadcast(&p->cond);
+		}
+	}
+	pthread_mutex_unlock(&p->lock);
+	return ret;
+}
+
+static void bz2_parallel_free(struct bz2_parallel *p)
+{
+	for (size_t i = 0; i < p->nblocks; ++i)
+		oscap_free(p->blocks[i].out);
+	oscap_free(p->blocks);
+	oscap_free(p->threads);
+	pthread_cond_destroy(&p->cond);
+	pthread_mutex_destroy(&p->lock);
+	oscap_free(p);
+}
+
+// xmlInputCloseCallback
+static int bz2_parallel_close(void *context)
+{
+	struct bz2_parallel *p = context;
+
+	pthread_mutex_lock(&p->lock);
+	p->stop = true;
+	pthread_cond_broadcast(&p->cond);
+	pthread_mutex_unlock(&p->lock);
+
+	for (int i = 0; i < p->nthreads; ++i)
+		pthread_join(p->threads[i], NULL);
+	bz2_parallel_free(p);
+	return 0;
+}
+
+/*
+ * Number of decompression threads. Defaults to the number of online CPUs,
+ * can be overridden using OSCAP_DECOMPRESS_THREADS.
+ */
+static int bz2_parallel_threads(void)
+{
+	char *str, *end;
+	long size = 0;
+
+	str = getenv("OSCAP_DECOMPRESS_THREADS");
+	if (str != NULL) {
+		errno = 0;
+		size = strtol(str, &end, 10);
+		if (errno != 0 || *end != '\0' || size <= 0) {
+			dW("Invalid value of OSCAP_DECOMPRESS_THREADS: \"%s\"", str);
+			size = 0;
+		}
+	}
+	if (size == 0) {
+		size = sysconf(_SC_NPROCESSORS_ONLN);
+		if (size <= 0)
+			size = 1;
+	}
+	return size > INT_MAX ? INT_MAX : (int) size;
+}
+
+static struct bz2_parallel *bz2_parallel_open(const char *buffer, size_t size)
+{
+	int nthreads = bz2_parallel_threads();
+	if (nthreads < 2 || size < 4 || buffer[2] != 'h' || buffer[3] < '1' || buffer[3] > '9')
+		return NULL;
+
+	struct bz2_parallel *p = oscap_calloc(1, sizeof(struct bz2_parallel));
+	p->in = (const unsigned char *) buffer;
+	p->in_size = size;
+	pthread_mutex_init(&p->lock, NULL);
+	pthread_cond_init(&p->cond, NULL);
+
+	if (!bz2_find_blocks(p) || p->nblocks < 2) {
+		dD("Decompressing bzip2 data in a single thread.");
+		bz2_parallel_free(p);
+		return NULL;
+	}
+
+	if ((size_t) nthreads > p->nblocks)
+		nthreads = p->nblocks;
+	p->window = (size_t) nthreads * BZ2_PARALLEL_WINDOW;
+	p->threads = oscap_calloc(nthreads, sizeof(pthread_t));
+	for (int i = 0; i < nthreads; ++i) {
+		if (pthread_create(&p->threads[p->nthreads], NULL, bz2_parallel_worker, p) == 0)
+			p->nthreads++;
+	}
+	if (p->nthreads == 0) {
+		bz2_parallel_free(p);
+		return NULL;
+	}
+	dD("Decompressing %zu bzip2 blocks in %d threads.", p->nblocks, p->nthreads);
+	return p;
+}
+
 xmlDoc *bz2_mem_read_doc(const char *buffer, size_t size)
 {
+	struct bz2_parallel *p = bz2_parallel_open(buffer, size);
+	if (p != NULL) {
+		return xmlReadIO((xmlInputReadCallback) bz2_parallel_read, bz2_parallel_close, p, "url", NULL, XML_PARSE_PEDANTIC);
+	}
+
 	struct bz2_mem *bzmem = bz2_mem_open(buffer, size);
 	if (bzmem == NULL) {
 		return NULL;
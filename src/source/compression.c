@@ -0,0 +1,195 @@
+/*
+ * Copyright 2016 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <libxml/parser.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_LZMA
+#include <lzma.h>
+#endif
+
+#include "bz2_priv.h"
+#include "compression_priv.h"
+#include "common/_error.h"
+#include "common/alloc.h"
+
+static const unsigned char gzip_magic[] = {0x1f, 0x8b};
+static const unsigned char xz_magic[] = {0xfd, '7', 'z', 'X', 'Z', 0x00};
+
+oscap_compression_t oscap_compression_detect(const char *memory, size_t size)
+{
+	if (bz2_memory_is_bzip(memory, size))
+		return OSCAP_COMPRESSION_BZIP2;
+	if (size >= sizeof(gzip_magic) && memcmp(memory, gzip_magic, sizeof(gzip_magic)) == 0)
+		return OSCAP_COMPRESSION_GZIP;
+	if (size >= sizeof(xz_magic) && memcmp(memory, xz_magic, sizeof(xz_magic)) == 0)
+		return OSCAP_COMPRESSION_XZ;
+	return OSCAP_COMPRESSION_NONE;
+}
+
+#ifdef HAVE_ZLIB
+
+struct gzip_mem {
+	z_stream stream;
+	bool eof;
+};
+
+static int gzip_mem_read(struct gzip_mem *gz, char *buffer, int len)
+{
+	if (gz->eof || len < 1)
+		return 0;
+
+	gz->stream.next_out = (Bytef *) buffer;
+	gz->stream.avail_out = len;
+	while (gz->stream.avail_out > 0) {
+		int ret = inflate(&gz->stream, Z_NO_FLUSH);
+		if (ret == Z_STREAM_END) {
+			// gzip files may consist of several members
+			if (gz->stream.avail_in == 0 || inflateReset(&gz->stream) != Z_OK) {
+				gz->eof = true;
+				break;
+			}
+		} else if (ret != Z_OK) {
+			oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not decompress gzip data: %s",
+					gz->stream.msg != NULL ? gz->stream.msg : "unexpected end of data");
+			return -1;
+		}
+	}
+	return len - gz->stream.avail_out;
+}
+
+static int gzip_mem_close(void *context)
+{
+	struct gzip_mem *gz = context;
+	inflateEnd(&gz->stream);
+	oscap_free(gz);
+	return 0;
+}
+
+static xmlDoc *gzip_mem_read_doc(const char *buffer, size_t size)
+{
+	if (size > UINT_MAX) {
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not decompress gzip data: too large");
+		return NULL;
+	}
+	struct gzip_mem *gz = oscap_calloc(1, sizeof(struct gzip_mem));
+	gz->stream.next_in = (Bytef *) buffer;
+	gz->stream.avail_in = size;
+	// 32 enables the gzip header detection
+	if (inflateInit2(&gz->stream, 15 + 32) != Z_OK) {
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not initialize gzip decompression");
+		oscap_free(gz);
+		return NULL;
+	}
+	return xmlReadIO((xmlInputReadCallback) gzip_mem_read, gzip_mem_close, gz, "url", NULL, XML_PARSE_PEDANTIC);
+}
+
+#endif
+
+#ifdef HAVE_LZMA
+
+struct xz_mem {
+	lzma_stream stream;
+	bool eof;
+};
+
+static int xz_mem_read(struct xz_mem *xz, char *buffer, int len)
+{
+	if (xz->eof || len < 1)
+		return 0;
+
+	xz->stream.next_out = (uint8_t *) buffer;
+	xz->stream.avail_out = len;
+	while (xz->stream.avail_out > 0) {
+		lzma_ret ret = lzma_code(&xz->stream, LZMA_FINISH);
+		if (ret == LZMA_STREAM_END) {
+			xz->eof = true;
+			break;
+		} else if (ret != LZMA_OK) {
+			oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not decompress xz data: error %d", ret);
+			return -1;
+		}
+	}
+	return len - xz->stream.avail_out;
+}
+
+static int xz_mem_close(void *context)
+{
+	struct xz_mem *xz = context;
+	lzma_end(&xz->stream);
+	oscap_free(xz);
+	return 0;
+}
+
+static xmlDoc *xz_mem_read_doc(const char *buffer, size_t size)
+{
+	struct xz_mem *xz = oscap_calloc(1, sizeof(struct xz_mem));
+	lzma_stream init = LZMA_STREAM_INIT;
+	xz->stream = init;
+	if (lzma_stream_decoder(&xz->stream, UINT64_MAX, LZMA_CONCATENATED) != LZMA_OK) {
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not initialize xz decompression");
+		oscap_free(xz);
+		return NULL;
+	}
+	xz->stream.next_in = (const uint8_t *) buffer;
+	xz->stream.avail_in = size;
+	return xmlReadIO((xmlInputReadCallback) xz_mem_read, xz_mem_close, xz, "url", NULL, XML_PARSE_PEDANTIC);
+}
+
+#endif
+
+xmlDoc *oscap_compression_read_doc(oscap_compression_t compression, const char *buffer, size_t size, const char *origin)
+{
+	switch (compression) {
+	case OSCAP_COMPRESSION_BZIP2:
+#ifdef HAVE_BZ2
+		return bz2_mem_read_doc(buffer, size);
+#else
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Unable to unpack bz2 from '%s'. Please compile OpenSCAP with bz2 support.", origin);
+		return NULL;
+#endif
+	case OSCAP_COMPRESSION_GZIP:
+#ifdef HAVE_ZLIB
+		return gzip_mem_read_doc(buffer, size);
+#else
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Unable to unpack gzip from '%s'. Please compile OpenSCAP with zlib support.", origin);
+		return NULL;
+#endif
+	case OSCAP_COMPRESSION_XZ:
+#ifdef HAVE_LZMA
+		return xz_mem_read_doc(buffer, size);
+#else
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Unable to unpack xz from '%s'. Please compile OpenSCAP with lzma support.", origin);
+		return NULL;
+#endif
+	default:
+		return xmlReadMemory(buffer, size, NULL, NULL, 0);
+	}
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2016 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#ifndef OSCAP_SOURCE_COMPRESSION_H
+#define OSCAP_SOURCE_COMPRESSION_H
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "common/public/oscap.h"
+#include "common/util.h"
+#include <libxml/tree.h>
+
+OSCAP_HIDDEN_START;
+
+/**
+ * Compression formats recognized in oscap_source content
+ */
+typedef enum oscap_compression {
+	OSCAP_COMPRESSION_NONE = 0,
+	OSCAP_COMPRESSION_BZIP2,
+	OSCAP_COMPRESSION_GZIP,
+	OSCAP_COMPRESSION_XZ
+} oscap_compression_t;
+
+/**
+ * Recognize the compression format of data by its magic number.
+ * @param memory Raw memory with file content
+ * @param size Size of memory
+ * @return the compression format, OSCAP_COMPRESSION_NONE if the data
+ * isn't compressed
+ */
+oscap_compression_t oscap_compression_detect(const char *memory, size_t size);
+
+/**
+ * Parse compressed memory to XML DOM.
+ * @param compression the compression format
+ * @param buffer compressed XML
+ * @param size length of data
+ * @param origin readable origin of the data, for error messages
+ * @returns DOM representation of the data, NULL if the data can't be
+ * decompressed or parsed (the error is set)
+ */
+xmlDoc *oscap_compression_read_doc(oscap_compression_t compression, const char *buffer, size_t size, const char *origin);
+
+OSCAP_HIDDEN_END;
+
+#endif // OSCAP_SOURCE_COMPRESSION_H
@@ -27,6 +27,8 @@
 #include <string.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <libxml/parser.h>
 #include <libxml/xmlreader.h>
 #include <libxml/xmlerror.h>
@@ -47,6 +49,7 @@
 #include "OVAL/oval_parser_impl.h"
 #include "OVAL/public/oval_definitions.h"
 #include "source/bz2_priv.h"
+#include "source/compression_priv.h"
 #include "source/schematron_priv.h"
 #include "source/validate_priv.h"
 #include "XCCDF/elements.h"
@@ -67,6 +70,8 @@ struct oscap_source {
 		char *filepath;                         ///< Filepath (if originated from file)
 		char *memory;                           ///< Memory buffer (if originated from memory)
 		size_t memory_size;                     ///< Size of the memory buffer (if originated from memory)
+		char *mapped;                           ///< The file mapped into memory (if originated from file)
+		size_t mapped_size;                     ///< Size of the mapping
 	} origin;                                       ///
 	struct {
 		xmlDoc *doc;                            /// DOM
@@ -128,6 +133,9 @@ void oscap_source_free(struct oscap_source *source)
 	if (source != NULL) {
 		oscap_free(source->origin.filepath);
 		oscap_free(source->origin.memory);
+		if (source->origin.mapped != NULL) {
+			munmap(source->origin.mapped, source->origin.mapped_size);
+		}
 		if (source->xml.doc != NULL) {
 			xmlFreeDoc(source->xml.doc);
 		}
@@ -160,10 +168,99 @@ xmlTextReader *oscap_source_get_xmlTextReader(struct oscap_source *source)
 	return reader;
 }
 
+/**
+ * Map the file the source originates from into memory.
+ * @return true if the file is mapped
+ */
+static bool oscap_source_map_file(struct oscap_source *source)
+{
+	if (source->origin.mapped != NULL) {
+		return true;
+	}
+	int fd = open(source->origin.filepath, O_RDONLY);
+	if (fd == -1) {
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+		void *mapped = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapped != MAP_FAILED) {
+			source->origin.mapped = mapped;
+			source->origin.mapped_size = st.st_size;
+		}
+	}
+	close(fd);
+	return source->origin.mapped != NULL;
+}
+
+const char *oscap_source_get_raw_content(struct oscap_source *source, size_t *size)
+{
+	if (source->origin.memory != NULL) {
+		if (oscap_compression_detect(source->origin.memory, source->origin.memory_size) != OSCAP_COMPRESSION_NONE) {
+			return NULL;
+		}
+		*size = source->origin.memory_size;
+		return source->origin.memory;
+	}
+	if (source->origin.type != OSCAP_SRC_FROM_USER_XML_FILE || !oscap_source_map_file(source)) {
+		return NULL;
+	}
+	if (oscap_compression_detect(source->origin.mapped, source->origin.mapped_size) != OSCAP_COMPRESSION_NONE) {
+		return NULL;
+	}
+	*size = source->origin.mapped_size;
+	return source->origin.mapped;
+}
+
+static void xmlSilentErrorCb(void *arg, const char *msg, xmlParserSeverities severity, xmlTextReaderLocatorPtr locator)
+{
+	// errors are reported when the DOM is built
+}
+
+xmlTextReader *oscap_source_get_streaming_xmlTextReader(struct oscap_source *source)
+{
+	if (source->xml.doc != NULL) {
+		return NULL;
+	}
+	size_t size = 0;
+	const char *buffer = oscap_source_get_raw_content(source, &size);
+	if (buffer == NULL) {
+		return NULL;
+	}
+	xmlTextReader *reader = xmlReaderForMemory(buffer, size, NULL, NULL, 0);
+	if (reader != NULL) {
+		xmlTextReaderSetErrorHandler(reader, xmlSilentErrorCb, NULL);
+	}
+	return reader;
+}
+
+/**
+ * Check that the root element can be read without building the DOM,
+ * otherwise the document is left to the DOM parser which reports the errors.
+ */
+static bool oscap_source_has_streaming_root(struct oscap_source *source)
+{
+	xmlTextReader *reader = oscap_source_get_streaming_xmlTextReader(source);
+	if (reader == NULL) {
+		return false;
+	}
+	bool ret = false;
+	while (xmlTextReaderRead(reader) == 1) {
+		if (xmlTextReaderNodeType(reader) == XML_READER_TYPE_ELEMENT) {
+			ret = true;
+			break;
+		}
+	}
+	xmlFreeTextReader(reader);
+	return ret;
+}
+
 oscap_document_type_t oscap_source_get_scap_type(struct oscap_source *source)
 {
 	if (source->scap_type == OSCAP_DOCUMENT_UNKNOWN) {
-		xmlTextReader *reader = oscap_source_get_xmlTextReader(source);
+		xmlTextReader *reader = oscap_source_has_streaming_root(source) ?
+			oscap_source_get_streaming_xmlTextReader(source) :
+			oscap_source_get_xmlTextReader(source);
 		if (reader == NULL) {
 			// the oscap error is already set
 			return OSCAP_DOCUMENT_UNKNOWN;
@@ -237,12 +334,9 @@ xmlDoc *oscap_source_get_xmlDoc(struct oscap_source *source)
 
 	if (source->xml.doc == NULL) {
 		if (source->origin.memory != NULL) {
-			if (bz2_memory_is_bzip(source->origin.memory, source->origin.memory_size)) {
-#ifdef HAVE_BZ2
-				source->xml.doc = bz2_mem_read_doc(source->origin.memory, source->origin.memory_size);
-#else
-				oscap_seterr(OSCAP_EFAMILY_OSCAP, "Unable to unpack bz2 from buffer memory '%s'. Please compile OpenSCAP with bz2 support.", oscap_source_readable_origin(source));
-#endif
+			oscap_compression_t compression = oscap_compression_detect(source->origin.memory, source->origin.memory_size);
+			if (compression != OSCAP_COMPRESSION_NONE) {
+				source->xml.doc = oscap_compression_read_doc(compression, source->origin.memory, source->origin.memory_size, oscap_source_readable_origin(source));
 			} else
 			{
 				source->xml.doc = xmlReadMemory(source->origin.memory, source->origin.memory_size, NULL, NULL, 0);
@@ -259,6 +353,13 @@ xmlDoc *oscap_source_get_xmlDoc(struct oscap_source *source)
 				}
 			}
 		}
+		else if (oscap_source_map_file(source) &&
+				oscap_compression_detect(source->origin.mapped, source->origin.mapped_size) != OSCAP_COMPRESSION_NONE) {
+			// Compressed files are decompressed straight from the mapping
+			source->xml.doc = oscap_compression_read_doc(
+					oscap_compression_detect(source->origin.mapped, source->origin.mapped_size),
+					source->origin.mapped, source->origin.mapped_size, oscap_source_readable_origin(source));
+		}
 		else {
 			int fd = open(source->origin.filepath, O_RDONLY);
 			if ( fd == -1 ){
@@ -336,7 +437,9 @@ int oscap_source_validate_schematron(struct oscap_source *source, const char *ou
 const char *oscap_source_get_schema_version(struct oscap_source *source)
 {
 	if (source->origin.version == NULL) {
-		xmlTextReader *reader = oscap_source_get_xmlTextReader(source);
+		xmlTextReader *reader = oscap_source_has_streaming_root(source) ?
+			oscap_source_get_streaming_xmlTextReader(source) :
+			oscap_source_get_xmlTextReader(source);
 		if (reader == NULL) {
 			return NULL;
 		}
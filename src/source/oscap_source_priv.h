@@ -68,6 +68,28 @@ struct oscap_source *oscap_source_new_from_xmlDoc(xmlDoc *doc, const char *filep
  */
 xmlTextReader *oscap_source_get_xmlTextReader(struct oscap_source *source);
 
+/**
+ * Get an xmlTextReader reading the raw content of this resource, the DOM
+ * representation isn't built. The reader doesn't report any errors and it
+ * needs to be disposed by caller.
+ * @memberof oscap_source
+ * @param source Resource to read the content
+ * @returns xmlTextReader structure or NULL if the DOM has been already built
+ * or the raw content isn't available
+ */
+xmlTextReader *oscap_source_get_streaming_xmlTextReader(struct oscap_source *source);
+
+/**
+ * Get the raw content of this resource, files are mapped into memory.
+ * The content is still owned by oscap_source.
+ * @memberof oscap_source
+ * @param source Resource to read the content
+ * @param size Size of the content
+ * @returns the content or NULL if it isn't available (the resource was
+ * built from DOM, it's compressed or the file can't be mapped)
+ */
+const char *oscap_source_get_raw_content(struct oscap_source *source, size_t *size);
+
 /**
  * Get a DOM representation of this resource. The document ins still owned
  * by oscap_source.
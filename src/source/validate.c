@@ -39,13 +39,14 @@ struct ctxt {
 	xml_reporter reporter;
 	void *arg;
 	char *filename;
+	unsigned int errors; ///< errors found by the validation, reported or not
 };
 
 static void oscap_xml_validity_handler(void *user, xmlErrorPtr error)
 {
 	struct ctxt * context = (struct ctxt *) user;
 
-	if (context == NULL || context->reporter == NULL)
+	if (context == NULL)
 		return;
 
 	if (error == NULL)
@@ -71,6 +72,10 @@ static void oscap_xml_validity_handler(void *user, xmlErrorPtr error)
 		return;
 	}
 
+	context->errors++;
+	if (context->reporter == NULL)
+		return;
+
 	const char *file = error->file;
 	if (file == NULL)
 		file = context->filename;
@@ -78,15 +83,16 @@ static void oscap_xml_validity_handler(void *user, xmlErrorPtr error)
 	context->reporter(file, error->line, error->message, context->arg);
 }
 
-static inline int oscap_validate_xml(struct oscap_source *source, const char *schemafile, xml_reporter reporter, void *arg)
+static inline int oscap_validate_xml(struct oscap_source *source, const char *schemafile, bool streaming, xml_reporter reporter, void *arg)
 {
 	int result = -1;
 	xmlSchemaParserCtxtPtr parser_ctxt = NULL;
 	xmlSchemaPtr schema = NULL;
 	xmlSchemaValidCtxtPtr ctxt = NULL;
+	xmlTextReaderPtr reader = NULL;
 	xmlDocPtr doc = NULL;
 
-	struct ctxt context = { reporter, arg, (void*) oscap_source_readable_origin(source)};
+	struct ctxt context = { reporter, arg, (void*) oscap_source_readable_origin(source), 0 };
 
 	if (schemafile == NULL) {
 		oscap_seterr(OSCAP_EFAMILY_OSCAP, "'schemafile' == NULL");
@@ -122,6 +128,27 @@ static inline int oscap_validate_xml(struct oscap_source *source, const char *sc
 
 	xmlSchemaSetValidStructuredErrors(ctxt, oscap_xml_validity_handler, &context);
 
+	/*
+	 * Validate the raw content while reading it, unless the DOM has been
+	 * built already. A document which isn't well formed is left to the DOM
+	 * parser, which reports the errors, unless the validation has reported
+	 * some already.
+	 */
+	reader = streaming ? oscap_source_get_streaming_xmlTextReader(source) : NULL;
+	if (reader != NULL && xmlTextReaderSchemaValidateCtxt(reader, ctxt, 0) == 0) {
+		int ret;
+		while ((ret = xmlTextReaderRead(reader)) == 1)
+			;
+		if (ret == 0) {
+			result = (xmlTextReaderIsValid(reader) == 1) ? 0 : 1;
+			goto cleanup;
+		}
+		if (context.errors > 0) {
+			result = 1;
+			goto cleanup;
+		}
+	}
+
 	doc = oscap_source_get_xmlDoc(source);
 	if (!doc)
 		goto cleanup;
@@ -141,6 +168,8 @@ static inline int oscap_validate_xml(struct oscap_source *source, const char *sc
 	*/
 
 cleanup:
+	if (reader)
+		xmlFreeTextReader(reader);
 	if (ctxt)
 		xmlSchemaFreeValidCtxt(ctxt);
 	if (schema)
@@ -237,7 +266,8 @@ int oscap_source_validate_priv(struct oscap_source *source, oscap_document_type_
 		if (entry->doc_type != doc_type || strcmp(entry->schema_version, version))
 			continue;
 
-		return oscap_validate_xml(source, entry->schema_path, reporter, user);
+		/* components of source datastreams are read separately, the DOM of the whole datastream isn't needed */
+		return oscap_validate_xml(source, entry->schema_path, doc_type == OSCAP_DOCUMENT_SDS, reporter, user);
 	}
 
 	oscap_seterr(OSCAP_EFAMILY_OSCAP, "Schema file not found when trying to validate '%s'", oscap_source_readable_origin(source));
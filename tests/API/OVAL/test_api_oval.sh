@@ -35,6 +35,14 @@ function test_api_oval_directives {
     cmp $srcdir/directives.xml exported-directives.xml
 }
 
+function test_api_oval_string_map {
+    ./test_api_string_map 50000 10
+}
+
+function test_api_oval_probe_cache {
+    ./test_api_probe_cache
+}
+
 # Testing.
 
 test_init "test_api_oval.log"
@@ -43,5 +51,7 @@ test_run "test_api_oval_definition" test_api_oval_definition
 test_run "test_api_oval_syschar" test_api_oval_syschar
 test_run "test_api_oval_results" test_api_oval_results
 test_run "test_api_oval_directives" test_api_oval_directives
+test_run "test_api_oval_string_map" test_api_oval_string_map
+test_run "test_api_oval_probe_cache" test_api_oval_probe_cache
 
 test_exit
@@ -0,0 +1,287 @@
+/*
+ * Test of the process-wide cache of collected objects: the key, the
+ * expiry, the invalidation by a change of a watched file or of the rpm
+ * database and the reload of the cache file by another process, which
+ * gives the loaded items new IDs.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <ftw.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <sexp.h>
+#include "probe-api.h"
+#include "oval_definitions.h"
+#include "OVAL/oval_probe_cache.h"
+
+#define FAIL(...)                                             \
+	do {                                                  \
+		fprintf (stderr, "FAIL: " __VA_ARGS__);       \
+		exit (1);                                     \
+	} while (0)
+
+#define TTL 3600
+
+static char root[] = "/tmp/pcache.XXXXXX";
+
+/* create the file and its directories, all of them modified in the past */
+static void mkfile (const char *rel)
+{
+	char path[PATH_MAX], *p;
+	struct timeval tv[2];
+	FILE *fp;
+
+	snprintf (path, sizeof path, "%s%s", root, rel);
+
+	for (p = path + strlen (root) + 1; (p = strchr (p, '/')) != NULL; ++p) {
+		*p = '\0';
+		if (mkdir (path, 0755) != 0 && errno != EEXIST)
+			FAIL("mkdir %s: %s\n", path, strerror (errno));
+		*p = '/';
+	}
+
+	if ((fp = fopen (path, "w")) == NULL)
+		FAIL("fopen %s: %s\n", path, strerror (errno));
+	fputs ("data\n", fp);
+	fclose (fp);
+
+	/* files modified after the collection started aren't cached */
+	gettimeofday (&tv[0], NULL);
+	tv[0].tv_sec -= 100;
+	tv[1] = tv[0];
+
+	while ((p = strrchr (path, '/')) != NULL && p > path + strlen (root)) {
+		utimes (path, tv);
+		*p = '\0';
+	}
+	utimes (path, tv);
+}
+
+static void append (const char *rel)
+{
+	char path[PATH_MAX];
+	FILE *fp;
+
+	snprintf (path, sizeof path, "%s%s", root, rel);
+	if ((fp = fopen (path, "a")) == NULL)
+		FAIL("fopen %s: %s\n", path, strerror (errno));
+	fputs ("more data\n", fp);
+	fclose (fp);
+}
+
+static int rm_cb (const char *path, const struct stat *st, int flag, struct FTW *ftw)
+{
+	(void)st, (void)flag, (void)ftw;
+	return remove (path);
+}
+
+static SEXP_t *file_obj (const char *id, const char *path)
+{
+	SEXP_t *attrs, *obj;
+
+	attrs = probe_attr_creat ("id", SEXP_string_newf ("%s", id), NULL);
+	obj   = probe_obj_creat ("file_object", attrs, "filepath", NULL, SEXP_string_newf ("%s", path), NULL);
+	SEXP_free (attrs);
+
+	return obj;
+}
+
+/*
+ * A collected object with one item, the item has the given ID. The ID is
+ * set like the item cache of the probes does it.
+ */
+static SEXP_t *cobj_new (const char *name, const char *item_id, const char *path)
+{
+	SEXP_t *cobj, *item, *name_ref, *s_id, *old_id;
+
+	cobj = probe_cobj_new (SYSCHAR_FLAG_COMPLETE, NULL, NULL, NULL);
+	item = probe_item_creat (name, NULL, "filepath", NULL, SEXP_string_newf ("%s", path), NULL);
+
+	s_id     = SEXP_string_newf ("%s", item_id);
+	name_ref = SEXP_listref_first (item);
+	old_id   = SEXP_list_replace (name_ref, 3, s_id);
+	SEXP_vfree (s_id, name_ref, old_id, NULL);
+
+	probe_cobj_add_item (cobj, item);
+	SEXP_free (item);
+
+	return cobj;
+}
+
+static void key (struct oval_definition_model *model, oval_subtype_t type,
+                 const char *id, const SEXP_t *obj, char *buf, int exp)
+{
+	struct oval_object *object = oval_object_new (model, id);
+
+	oval_object_set_subtype (object, type);
+
+	if (oval_pcache_key (object, obj, buf) != exp)
+		FAIL("unexpected result of oval_pcache_key for %s\n", id);
+}
+
+static char *item_id (const char *key)
+{
+	SEXP_t *cobj, *items, *item, *s_id;
+	char *id;
+
+	if ((cobj = oval_pcache_get (key)) == NULL)
+		FAIL("%s isn't cached\n", key);
+
+	items = probe_cobj_get_items (cobj);
+	item  = SEXP_list_first (items);
+	s_id  = probe_ent_getattrval (item, "id");
+	id    = SEXP_string_cstr (s_id);
+	SEXP_vfree (cobj, items, item, s_id, NULL);
+
+	return id;
+}
+
+static void store (char *k_file, char *k_shared, char *k_rpm)
+{
+	struct oval_definition_model *model = oval_definition_model_new ();
+	char k_other[OVAL_PCACHE_KEYLEN + 1], k_old[OVAL_PCACHE_KEYLEN + 1];
+	SEXP_t *obj1, *obj2, *obj3, *obj4, *rpm, *attrs, *cobj;
+	time_t now = time (NULL);
+
+	/* the object ID isn't a part of the key, the entities are */
+	obj1 = file_obj ("oval:x:obj:1", "/file");
+	obj2 = file_obj ("oval:x:obj:2", "/file");
+	obj3 = file_obj ("oval:x:obj:3", "/other");
+	obj4 = file_obj ("oval:x:obj:4", "/old");
+	key (model, OVAL_UNIX_FILE, "oval:x:obj:1", obj1, k_file, 0);
+	key (model, OVAL_UNIX_FILE, "oval:x:obj:2", obj2, k_other, 0);
+	if (strcmp (k_file, k_other) != 0)
+		FAIL("the key depends on the object ID\n");
+	key (model, OVAL_UNIX_FILE, "oval:x:obj:3", obj3, k_shared, 0);
+	if (strcmp (k_file, k_shared) == 0)
+		FAIL("the key doesn't depend on the entities\n");
+	key (model, OVAL_UNIX_FILE, "oval:x:obj:4", obj4, k_old, 0);
+
+	/* the values of a variable_object are looked up by the ID */
+	key (model, OVAL_INDEPENDENT_VARIABLE, "oval:x:obj:5", obj1, k_other, 1);
+
+	attrs = probe_attr_creat ("id", SEXP_string_newf ("oval:x:obj:6"), NULL);
+	rpm   = probe_obj_creat ("rpminfo_object", attrs, "name", NULL, SEXP_string_newf ("bash"), NULL);
+	key (model, OVAL_LINUX_RPM_INFO, "oval:x:obj:6", rpm, k_rpm, 0);
+
+	/* both objects have an item with the same ID, like items shared by objects */
+	cobj = cobj_new ("file_item", "1000011", "/file");
+	oval_pcache_put (k_file, OVAL_UNIX_FILE, now, obj1, cobj);
+	SEXP_free (cobj);
+	cobj = cobj_new ("file_item", "1000011", "/file");
+	oval_pcache_put (k_shared, OVAL_UNIX_FILE, now, obj3, cobj);
+	SEXP_free (cobj);
+
+	free (item_id (k_file));
+
+	/* expiry */
+	cobj = cobj_new ("file_item", "1000012", "/old");
+	oval_pcache_put (k_old, OVAL_UNIX_FILE, now - TTL, obj4, cobj);
+	SEXP_free (cobj);
+	if (oval_pcache_get (k_old) != NULL)
+		FAIL("an expired object is cached\n");
+
+	/* a package object is dropped when the rpm database changes */
+	cobj = probe_cobj_new (SYSCHAR_FLAG_DOES_NOT_EXIST, NULL, NULL, NULL);
+	oval_pcache_put (k_rpm, OVAL_LINUX_RPM_INFO, now, rpm, cobj);
+	SEXP_free (cobj);
+	if ((cobj = oval_pcache_get (k_rpm)) == NULL)
+		FAIL("the rpminfo object isn't cached\n");
+	SEXP_free (cobj);
+	append ("/usr/lib/sysimage/rpm/rpmdb.sqlite");
+	if (oval_pcache_get (k_rpm) != NULL)
+		FAIL("the rpminfo object isn't invalidated by a change of the rpm database\n");
+
+	if (oval_pcache_save () != 0)
+		FAIL("can't save the cache\n");
+
+	SEXP_vfree (obj1, obj2, obj3, obj4, rpm, attrs, NULL);
+	oval_definition_model_free (model);
+}
+
+static void load (const char *k_file, const char *k_shared, const char *k_rpm)
+{
+	char *id1, *id2;
+
+	id1 = item_id (k_file);
+	id2 = item_id (k_shared);
+
+	/* the probes of this process may assign the old ID to another item */
+	if (id1[0] != '2')
+		FAIL("the loaded item keeps its ID %s\n", id1);
+	if (strcmp (id1, id2) != 0)
+		FAIL("a shared item got two IDs: %s, %s\n", id1, id2);
+
+	if (oval_pcache_get (k_rpm) != NULL)
+		FAIL("the invalidated object was saved\n");
+
+	append ("/file");
+	if (oval_pcache_get (k_file) != NULL)
+		FAIL("the object isn't invalidated by a change of the file\n");
+
+	free (id1);
+	free (id2);
+}
+
+int main (void)
+{
+	char k_file[OVAL_PCACHE_KEYLEN + 1], k_shared[OVAL_PCACHE_KEYLEN + 1], k_rpm[OVAL_PCACHE_KEYLEN + 1];
+	char path[PATH_MAX], ttl[16];
+	int status;
+	pid_t pid;
+
+	if (mkdtemp (root) == NULL)
+		FAIL("mkdtemp: %s\n", strerror (errno));
+
+	mkfile ("/file");
+	mkfile ("/usr/lib/sysimage/rpm/rpmdb.sqlite");
+
+	snprintf (path, sizeof path, "%s/cache", root);
+	snprintf (ttl, sizeof ttl, "%d", TTL);
+	setenv ("OSCAP_PROBE_CACHE_FILE", path, 1);
+	setenv ("OSCAP_PROBE_CACHE_TTL", ttl, 1);
+	setenv ("OSCAP_PROBE_ROOT", root, 1);
+	unsetenv ("OSCAP_PROBE_RPMDB_PATH");
+
+	/* the cache is set up once per process, the file is loaded by another one */
+	if ((pid = fork ()) == -1)
+		FAIL("fork: %s\n", strerror (errno));
+
+	if (pid == 0) {
+		store (k_file, k_shared, k_rpm);
+		exit (0);
+	}
+
+	if (waitpid (pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+		FAIL("storing the objects failed\n");
+
+	/* the keys don't depend on the process */
+	{
+		struct oval_definition_model *model = oval_definition_model_new ();
+		SEXP_t *obj1 = file_obj ("oval:x:obj:1", "/file");
+		SEXP_t *obj3 = file_obj ("oval:x:obj:3", "/other");
+		SEXP_t *attrs = probe_attr_creat ("id", SEXP_string_newf ("oval:x:obj:6"), NULL);
+		SEXP_t *rpm = probe_obj_creat ("rpminfo_object", attrs, "name", NULL, SEXP_string_newf ("bash"), NULL);
+
+		key (model, OVAL_UNIX_FILE, "oval:x:obj:1", obj1, k_file, 0);
+		key (model, OVAL_UNIX_FILE, "oval:x:obj:3", obj3, k_shared, 0);
+		key (model, OVAL_LINUX_RPM_INFO, "oval:x:obj:6", rpm, k_rpm, 0);
+		SEXP_vfree (obj1, obj3, attrs, rpm, NULL);
+		oval_definition_model_free (model);
+	}
+
+	load (k_file, k_shared, k_rpm);
+	nftw (root, rm_cb, 16, FTW_DEPTH | FTW_PHYS);
+
+	return 0;
+}
@@ -0,0 +1,191 @@
+/*
+ * Copyright 2016 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Checks the oval_string_map and compares its speed with the red-black
+ * tree it replaced. The IDs look like the ones of a SCAP Security Guide
+ * data stream.
+ *
+ * Usage: test_api_string_map [number of IDs [number of lookup rounds]]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "adt/oval_string_map_impl.h"
+#include <rbt/rbt.h>
+
+static const char *types[] = { "def", "tst", "obj", "ste", "var" };
+
+static char **make_ids(size_t count)
+{
+	char **ids = malloc(count * sizeof(char *));
+	size_t i;
+
+	for (i = 0; i < count; ++i) {
+		ids[i] = malloc(64);
+		snprintf(ids[i], 64, "oval:ssg-%s_%zu:%s:1",
+			 i % 3 ? "accounts_password_pam_minlen" : "package_installed",
+			 i, types[i % 5]);
+	}
+
+	return ids;
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void rbt_node_free(struct rbt_str_node *n)
+{
+	free(n->key);
+}
+
+static int free_count = 0;
+
+static void count_free(void *val)
+{
+	(void)val;
+	++free_count;
+}
+
+static int check(char **ids, size_t count)
+{
+	struct oval_string_map *map = oval_string_map_new();
+	struct oval_iterator *it;
+	const char *prev = NULL, *key;
+	size_t i, n;
+
+	for (i = 0; i < count; ++i)
+		oval_string_map_put(map, ids[i], ids[i]);
+
+	/* the first value is kept */
+	oval_string_map_put(map, ids[0], ids[1]);
+
+	for (i = 0; i < count; ++i) {
+		if (oval_string_map_get_value(map, ids[i]) != ids[i]) {
+			fprintf(stderr, "wrong value of '%s'\n", ids[i]);
+			return 1;
+		}
+	}
+
+	if (oval_string_map_get_value(map, "oval:ssg-missing:def:1") != NULL) {
+		fprintf(stderr, "found a missing key\n");
+		return 1;
+	}
+
+	/* the iterator returns the keys in descending order, as it always did */
+	it = oval_string_map_keys(map);
+	for (n = 0; oval_collection_iterator_has_more(it); ++n) {
+		key = oval_collection_iterator_next(it);
+		if (prev != NULL && strcmp(prev, key) <= 0) {
+			fprintf(stderr, "keys out of order: '%s', '%s'\n", prev, key);
+			return 1;
+		}
+		prev = key;
+	}
+	oval_collection_iterator_free(it);
+
+	if (n != count) {
+		fprintf(stderr, "%zu keys iterated, expected %zu\n", n, count);
+		return 1;
+	}
+
+	oval_string_map_free(map, count_free);
+
+	if ((size_t)free_count != count) {
+		fprintf(stderr, "%d values freed, expected %zu\n", free_count, count);
+		return 1;
+	}
+
+	return 0;
+}
+
+static void bench(char **ids, size_t count, size_t rounds)
+{
+	struct oval_string_map *map;
+	rbt_t *rbt;
+	double t0, t1, t2;
+	size_t i, r;
+	void *val;
+
+	t0 = now();
+	map = oval_string_map_new();
+	for (i = 0; i < count; ++i)
+		oval_string_map_put(map, ids[i], ids[i]);
+	t1 = now();
+	for (r = 0; r < rounds; ++r)
+		for (i = 0; i < count; ++i)
+			oval_string_map_get_value(map, ids[(i * 7919) % count]);
+	t2 = now();
+	oval_string_map_free0(map);
+
+	printf("oval_string_map: insert %8.1f ns/op, lookup %8.1f ns/op\n",
+	       (t1 - t0) * 1e9 / count, (t2 - t1) * 1e9 / (count * rounds));
+
+	t0 = now();
+	rbt = rbt_str_new();
+	for (i = 0; i < count; ++i)
+		rbt_str_add(rbt, strdup(ids[i]), ids[i]);
+	t1 = now();
+	for (r = 0; r < rounds; ++r)
+		for (i = 0; i < count; ++i)
+			rbt_str_get(rbt, ids[(i * 7919) % count], &val);
+	t2 = now();
+	rbt_str_free_cb(rbt, rbt_node_free);
+
+	printf("rbt_str:         insert %8.1f ns/op, lookup %8.1f ns/op\n",
+	       (t1 - t0) * 1e9 / count, (t2 - t1) * 1e9 / (count * rounds));
+}
+
+int main(int argc, char **argv)
+{
+	size_t count = 50000, rounds = 10, i;
+	char **ids;
+	int ret;
+
+	if (argc > 1)
+		count = strtoul(argv[1], NULL, 10);
+	if (argc > 2)
+		rounds = strtoul(argv[2], NULL, 10);
+	if (count < 2)
+		count = 2;
+
+	ids = make_ids(count);
+	ret = check(ids, count);
+
+	if (ret == 0)
+		bench(ids, count, rounds);
+
+	for (i = 0; i < count; ++i)
+		free(ids[i]);
+	free(ids);
+
+	return ret;
+}
@@ -0,0 +1,42 @@
+#!/bin/bash
+
+# Definitions evaluated by several threads have to give the same results as
+# the sequential evaluation, including objects shared through sets, variables
+# and extended definitions.
+
+set -e
+set -o pipefail
+
+xpath="$XPATH"
+dir=`mktemp -d`
+content=`mktemp`
+result=`mktemp`
+stdout_seq=`mktemp`
+stdout_par=`mktemp`
+stderr=`mktemp`
+
+printf 'value=one\n'   > $dir/f1
+printf 'value=one\n'   > $dir/f2
+printf 'value=three\n' > $dir/f3
+printf 'value=four\n'  > $dir/f4
+printf 'x\n'           > $dir/fx
+
+sed "s|@DIR@|$dir|g" $srcdir/test_parallel_eval.oval.xml > $content
+
+$OSCAP oval eval $content > $stdout_seq
+$OSCAP oval eval --jobs 4 --results $result $content > $stdout_par
+
+diff $stdout_seq $stdout_par
+grep -q "Definition oval:x:def:3: false" $stdout_par
+grep -q "Definition oval:x:def:4: true" $stdout_par
+
+# the set object is built from the items of the object it references
+[ $($xpath $result 'count(/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:x:obj:2"]/reference)') == "1" ]
+
+if $OSCAP oval eval --jobs 0 $content 2> $stderr; then
+	exit 1
+fi
+grep -q "Invalid number of jobs" $stderr
+
+rm -rf $dir
+rm $content $result $stdout_seq $stdout_par $stderr
@@ -0,0 +1,37 @@
+#!/bin/bash
+
+# Streamed OVAL Results and System Characteristics have to be the same as
+# the ones built in memory first.
+
+set -e
+set -o pipefail
+
+dir=`mktemp -d`
+content=`mktemp`
+result_dom=`mktemp`
+result_stream=`mktemp`
+syschar_dom=`mktemp`
+syschar_stream=`mktemp`
+
+printf 'value=one\n'   > $dir/f1
+printf 'value=one\n'   > $dir/f2
+printf 'value=three\n' > $dir/f3
+printf 'value=four\n'  > $dir/f4
+printf 'x\n'           > $dir/fx
+
+sed "s|@DIR@|$dir|g" $srcdir/test_parallel_eval.oval.xml > $content
+
+$OSCAP oval eval --results $result_dom $content
+$OSCAP oval eval --stream-results --results $result_stream $content
+$OSCAP oval eval --stream-results --results $dir/result.xml.gz $content
+$OSCAP oval collect --syschar $syschar_dom $content
+$OSCAP oval collect --stream-results --syschar $syschar_stream $content
+
+# only the timestamps of the generators differ
+diff <(grep -v timestamp $result_dom) <(grep -v timestamp $result_stream)
+diff <(grep -v timestamp $result_dom) <(zcat $dir/result.xml.gz | grep -v timestamp)
+diff <(grep -v timestamp $syschar_dom) <(grep -v timestamp $syschar_stream)
+grep -q "<system_data>" $result_stream
+
+rm -rf $dir
+rm $content $result_dom $result_stream $syschar_dom $syschar_stream
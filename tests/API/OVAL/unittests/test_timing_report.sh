@@ -0,0 +1,34 @@
+#!/bin/bash
+
+# The timing report lists every collected object and every evaluated definition.
+
+set -e
+set -o pipefail
+
+dir=`mktemp -d`
+content=`mktemp`
+report=`mktemp`
+stdout=`mktemp`
+
+printf 'value=one\n'   > $dir/f1
+printf 'value=one\n'   > $dir/f2
+printf 'value=three\n' > $dir/f3
+printf 'value=four\n'  > $dir/f4
+printf 'x\n'           > $dir/fx
+
+sed "s|@DIR@|$dir|g" $srcdir/test_parallel_eval.oval.xml > $content
+
+$OSCAP oval eval --timing-report $report $content > $stdout
+
+for key in objects probes definitions rules; do
+	grep -q "\"$key\": \[" $report
+done
+grep -q '"id": "oval:x:obj:3", "type": "textfilecontent54"' $report
+grep -q '"id": "oval:x:def:4", "wall_time_ms": ' $report
+
+# the environment variable enables the report too, "-" is the standard output
+OSCAP_TIMING_REPORT=- $OSCAP oval eval $content > $stdout
+grep -q '"definitions": \[' $stdout
+
+rm -rf $dir
+rm $content $report $stdout
@@ -0,0 +1,618 @@
+/*
+ * Copyright 2016 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Throughput of the S-exp and SEAP layer.
+ *
+ *   bench_api_seap [-q] [-n items] [-t seconds] [benchmark...]
+ *
+ * Every benchmark is run repeatedly for at least the given time (1 s by
+ * default) and the number of operations per second is printed together
+ * with the number of heap allocations and allocated bytes per operation.
+ * An operation is one S-exp, or one item of the synthetic item sets,
+ * which look like the output of the rpminfo and file probes. With -q
+ * every benchmark runs only once. Benchmarks can be selected by a part of
+ * their name. The allocations are counted only with glibc, "n/a" is
+ * printed otherwise.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sexp.h>
+#include <seap.h>
+#include <strbuf.h>
+#include "_sexp-output.h"
+#include "_sexp-parser.h"
+#include "_seap-types.h"
+
+/*
+ * Count the heap allocations, including the ones made by the library.
+ */
+static volatile uint64_t alloc_count = 0;
+static volatile uint64_t alloc_bytes = 0;
+
+#if defined(__GLIBC__)
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t n, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+extern void *__libc_memalign (size_t align, size_t size);
+
+static inline void alloc_note (size_t size)
+{
+        __sync_fetch_and_add (&alloc_count, 1);
+        __sync_fetch_and_add (&alloc_bytes, size);
+}
+
+void *malloc (size_t size)
+{
+        alloc_note (size);
+        return __libc_malloc (size);
+}
+
+void *calloc (size_t n, size_t size)
+{
+        alloc_note (n * size);
+        return __libc_calloc (n, size);
+}
+
+void *realloc (void *ptr, size_t size)
+{
+        alloc_note (size);
+        return __libc_realloc (ptr, size);
+}
+
+int posix_memalign (void **ptr, size_t align, size_t size)
+{
+        void *m;
+
+        alloc_note (size);
+        m = __libc_memalign (align, size);
+
+        if (m == NULL)
+                return (ENOMEM);
+
+        *ptr = m;
+        return (0);
+}
+# define ALLOC_COUNTED 1
+#else
+# define ALLOC_COUNTED 0
+#endif
+
+static uint32_t bench_items = 1000;
+
+static double bench_now (void)
+{
+        struct timespec ts;
+
+        clock_gettime (CLOCK_MONOTONIC, &ts);
+        return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+/*
+ * Synthetic probe output
+ */
+static SEXP_t *bench_entity (const char *name, SEXP_t *value)
+{
+        SEXP_t *n, *e;
+
+        n = SEXP_string_new (name, strlen (name));
+        e = SEXP_list_new (n, value, NULL);
+        SEXP_vfree (n, value, NULL);
+
+        return (e);
+}
+
+static SEXP_t *bench_item_head (const char *name, uint32_t id)
+{
+        SEXP_t *n, *a, *i, *h;
+
+        n = SEXP_string_new (name, strlen (name));
+        a = SEXP_string_new (":id", 3);
+        i = SEXP_number_newu_32 (id);
+        h = SEXP_list_new (n, a, i, NULL);
+        SEXP_vfree (n, a, i, NULL);
+
+        return (h);
+}
+
+static SEXP_t *bench_rpminfo_item (uint32_t i)
+{
+        SEXP_t *e[10], *item;
+
+        e[0] = bench_item_head ("rpminfo_item", i);
+        e[1] = bench_entity ("name", SEXP_string_newf ("package-%" PRIu32, (i * 7919) % 100000));
+        e[2] = bench_entity ("arch", SEXP_string_newf ("x86_64"));
+        e[3] = bench_entity ("epoch", SEXP_string_newf ("%" PRIu32, i % 3));
+        e[4] = bench_entity ("release", SEXP_string_newf ("%" PRIu32 ".el7", i % 20));
+        e[5] = bench_entity ("version", SEXP_string_newf ("%" PRIu32 ".%" PRIu32 ".%" PRIu32, i % 5, i % 13, i % 101));
+        e[6] = bench_entity ("evr", SEXP_string_newf ("%" PRIu32 ":%" PRIu32 ".%" PRIu32 ".%" PRIu32 "-%" PRIu32 ".el7",
+                                                      i % 3, i % 5, i % 13, i % 101, i % 20));
+        e[7] = bench_entity ("signature_keyid", SEXP_string_newf ("199e2f91fd431d51"));
+        e[8] = bench_entity ("extended_name", SEXP_string_newf ("package-%" PRIu32 "-%" PRIu32 ":%" PRIu32 ".%" PRIu32 "-%" PRIu32 ".el7.x86_64",
+                                                                (i * 7919) % 100000, i % 3, i % 5, i % 13, i % 20));
+        e[9] = bench_entity ("filepath", SEXP_string_newf ("/usr/share/doc/package-%" PRIu32 "/README", (i * 7919) % 100000));
+
+        item = SEXP_list_new (e[0], e[1], e[2], e[3], e[4], e[5], e[6], e[7], e[8], e[9], NULL);
+        SEXP_vfree (e[0], e[1], e[2], e[3], e[4], e[5], e[6], e[7], e[8], e[9], NULL);
+
+        return (item);
+}
+
+static SEXP_t *bench_file_item (uint32_t i)
+{
+        SEXP_t *e[16], *item;
+
+        e[0]  = bench_item_head ("file_item", i);
+        e[1]  = bench_entity ("filepath", SEXP_string_newf ("/usr/lib/dir-%" PRIu32 "/file-%" PRIu32 ".so", i % 97, i));
+        e[2]  = bench_entity ("path", SEXP_string_newf ("/usr/lib/dir-%" PRIu32, i % 97));
+        e[3]  = bench_entity ("filename", SEXP_string_newf ("file-%" PRIu32 ".so", i));
+        e[4]  = bench_entity ("type", SEXP_string_newf ("regular"));
+        e[5]  = bench_entity ("group_id", SEXP_number_newu_32 (0));
+        e[6]  = bench_entity ("user_id", SEXP_number_newu_32 (i % 1000));
+        e[7]  = bench_entity ("a_time", SEXP_number_newi_64 (1450000000 + i));
+        e[8]  = bench_entity ("c_time", SEXP_number_newi_64 (1440000000 + i));
+        e[9]  = bench_entity ("m_time", SEXP_number_newi_64 (1430000000 + i));
+        e[10] = bench_entity ("size", SEXP_number_newu_64 ((uint64_t) i * 4096));
+        e[11] = bench_entity ("suid", SEXP_number_newb (false));
+        e[12] = bench_entity ("uread", SEXP_number_newb (true));
+        e[13] = bench_entity ("uwrite", SEXP_number_newb (i % 2 == 0));
+        e[14] = bench_entity ("oexec", SEXP_number_newb (i % 3 == 0));
+        e[15] = bench_entity ("has_extended_acl", SEXP_number_newb (false));
+
+        item = SEXP_list_new (e[0], e[1], e[2], e[3], e[4], e[5], e[6], e[7], e[8], e[9],
+                              e[10], e[11], e[12], e[13], e[14], e[15], NULL);
+        for (int j = 0; j < 16; ++j)
+                SEXP_free (e[j]);
+
+        return (item);
+}
+
+static SEXP_t *bench_item_set (SEXP_t *(*item_new) (uint32_t))
+{
+        SEXP_t *set = SEXP_list_new (NULL);
+
+        for (uint32_t i = 0; i < bench_items; ++i) {
+                SEXP_t *item = item_new (i);
+
+                SEXP_list_add (set, item);
+                SEXP_free (item);
+        }
+
+        return (set);
+}
+
+static SEXP_t *bench_set_new (const char *set)
+{
+        return bench_item_set (strcmp (set, "rpminfo") == 0 ? bench_rpminfo_item : bench_file_item);
+}
+
+/*
+ * Benchmarks. The setup and teardown functions aren't measured.
+ */
+struct bench {
+        const char *name;
+        const char *set;        ///< item set the benchmark works on, if any
+        void  (*setup) (struct bench *b);
+        void  (*run) (struct bench *b);
+        void  (*teardown) (struct bench *b);
+
+        SEXP_t   *sexp[2];
+        strbuf_t *sb;
+        char     *buf;
+        size_t    len;
+        SEAP_CTX_t *ctx[2];
+        int        sd[2];
+        int        fd[4];
+};
+
+static void bench_free_sexp (struct bench *b)
+{
+        for (int i = 0; i < 2; ++i) {
+                if (b->sexp[i] != NULL)
+                        SEXP_free (b->sexp[i]);
+                b->sexp[i] = NULL;
+        }
+}
+
+static void bench_string_new (struct bench *b)
+{
+        for (uint32_t i = 0; i < bench_items; ++i)
+                SEXP_free (SEXP_string_newf ("/usr/lib/dir-%" PRIu32 "/file.so", i));
+}
+
+static void bench_number_new (struct bench *b)
+{
+        for (uint32_t i = 0; i < bench_items; ++i) {
+                switch (i % 4) {
+                case 0: SEXP_free (SEXP_number_newu_32 (i)); break;
+                case 1: SEXP_free (SEXP_number_newi_64 (-(int64_t) i)); break;
+                case 2: SEXP_free (SEXP_number_newb (i % 2)); break;
+                case 3: SEXP_free (SEXP_number_newf (i / 3.0)); break;
+                }
+        }
+}
+
+static void bench_list_add (struct bench *b)
+{
+        SEXP_t *list = SEXP_list_new (NULL);
+
+        for (uint32_t i = 0; i < bench_items; ++i)
+                SEXP_list_add (list, b->sexp[0]);
+
+        SEXP_free (list);
+}
+
+static void bench_list_add_setup (struct bench *b)
+{
+        b->sexp[0] = SEXP_string_newf ("member");
+}
+
+static void bench_list_nth_setup (struct bench *b)
+{
+        b->sexp[0] = bench_set_new (b->set);
+}
+
+static void bench_list_nth (struct bench *b)
+{
+        for (uint32_t i = 1; i <= bench_items; ++i)
+                SEXP_free (SEXP_list_nth (b->sexp[0], i));
+}
+
+static void bench_list_sort_setup (struct bench *b)
+{
+        uint32_t x = 12345;
+
+        b->sexp[0] = SEXP_list_new (NULL);
+
+        for (uint32_t i = 0; i < bench_items; ++i) {
+                SEXP_t *s;
+
+                x = x * 1103515245 + 12345;
+                s = SEXP_string_newf ("package-%08" PRIx32, x);
+                SEXP_list_add (b->sexp[0], s);
+                SEXP_free (s);
+        }
+}
+
+static void bench_list_sort (struct bench *b)
+{
+        SEXP_list_sort (b->sexp[0], SEXP_string_cmp);
+}
+
+static void bench_deepcmp_setup (struct bench *b)
+{
+        b->sexp[0] = bench_set_new (b->set);
+        b->sexp[1] = bench_set_new (b->set);
+}
+
+static void bench_deepcmp (struct bench *b)
+{
+        if (!SEXP_deepcmp (b->sexp[0], b->sexp[1]))
+                abort ();
+}
+
+static void bench_build (struct bench *b)
+{
+        SEXP_free (bench_set_new (b->set));
+}
+
+/* the same as bench_build, but allocated from an arena like a probe request */
+static void bench_arena (struct bench *b)
+{
+        SEXP_arena_t *arena, *prev;
+
+        arena = SEXP_arena_new ();
+        prev  = SEXP_arena_enter (arena);
+        SEXP_free (bench_set_new (b->set));
+        SEXP_arena_enter (prev);
+        SEXP_arena_release (arena);
+}
+
+/* build the items in an arena and copy them out like the probe caches do */
+static void bench_promote (struct bench *b)
+{
+        SEXP_arena_t *arena, *prev;
+        SEXP_t *set;
+
+        arena = SEXP_arena_new ();
+        prev  = SEXP_arena_enter (arena);
+        set   = bench_set_new (b->set);
+        SEXP_arena_enter (prev);
+
+        b->sexp[0] = SEXP_promote (set);
+        SEXP_free (set);
+        SEXP_arena_release (arena);
+        bench_free_sexp (b);
+}
+
+static void bench_print_setup (struct bench *b)
+{
+        b->sexp[0] = bench_set_new (b->set);
+}
+
+static void bench_print_t (struct bench *b)
+{
+        strbuf_t *sb = strbuf_new (SEAP_STRBUF_MAX);
+
+        SEXP_sbprintf_t (b->sexp[0], sb);
+        strbuf_free (sb);
+}
+
+static void bench_print_b (struct bench *b)
+{
+        strbuf_t *sb = strbuf_new (SEAP_STRBUF_MAX);
+
+        SEXP_sbprintf_b (b->sexp[0], sb);
+        strbuf_free (sb);
+}
+
+static void bench_parse_setup (struct bench *b, int (*print) (SEXP_t *, strbuf_t *))
+{
+        SEXP_t   *set = bench_set_new (b->set);
+        strbuf_t *sb = strbuf_new (SEAP_STRBUF_MAX);
+
+        if (print (set, sb) != 0)
+                abort ();
+
+        b->len = strbuf_size (sb);
+        b->buf = malloc (b->len);
+        strbuf_copy (sb, b->buf, b->len);
+        strbuf_free (sb);
+        SEXP_free (set);
+}
+
+static void bench_parse_t_setup (struct bench *b)
+{
+        bench_parse_setup (b, SEXP_sbprintf_t);
+}
+
+static void bench_parse_b_setup (struct bench *b)
+{
+        bench_parse_setup (b, SEXP_sbprintf_b);
+}
+
+static void bench_parse_t (struct bench *b)
+{
+        SEXP_psetup_t *psetup = SEXP_psetup_new ();
+        SEXP_pstate_t *pstate = NULL;
+        SEXP_t *s_exp;
+
+        s_exp = SEXP_parse (psetup, b->buf, b->len, &pstate);
+
+        if (s_exp == NULL)
+                abort ();
+
+        SEXP_free (s_exp);
+        SEXP_psetup_free (psetup);
+}
+
+static void bench_parse_b (struct bench *b)
+{
+        SEXP_t *s_exp = SEXP_parse_b (b->buf, b->len);
+
+        if (s_exp == NULL)
+                abort ();
+
+        SEXP_free (s_exp);
+}
+
+/*
+ * The SEAP benchmarks send the item set over a pipe to another SEAP
+ * context and receive it, the sending side runs in its own thread.
+ */
+static void bench_seap_setup (struct bench *b, bool binary)
+{
+        SEAP_desc_t *dsc;
+
+        b->sexp[0] = bench_set_new (b->set);
+
+        if (pipe (b->fd) != 0 || pipe (b->fd + 2) != 0)
+                abort ();
+
+        b->ctx[0] = SEAP_CTX_new ();
+        b->ctx[1] = SEAP_CTX_new ();
+        b->sd[0]  = SEAP_openfd2 (b->ctx[0], b->fd[2], b->fd[1], 0);
+        b->sd[1]  = SEAP_openfd2 (b->ctx[1], b->fd[0], b->fd[3], 0);
+
+        if (b->sd[0] < 0 || b->sd[1] < 0)
+                abort ();
+
+        dsc = SEAP_desc_get (b->ctx[0]->sd_table, b->sd[0]);
+
+        if (binary)
+                SEAP_desc_offer_binary (dsc);
+        else
+                dsc->ofmt = SEAP_DESC_FMT_TEXT;
+}
+
+static void bench_seap_t_setup (struct bench *b)
+{
+        bench_seap_setup (b, false);
+}
+
+static void bench_seap_b_setup (struct bench *b)
+{
+        bench_seap_setup (b, true);
+}
+
+static void *bench_seap_sender (void *arg)
+{
+        struct bench *b = arg;
+
+        if (SEAP_sendsexp (b->ctx[0], b->sd[0], b->sexp[0]) != 0)
+                abort ();
+
+        return (NULL);
+}
+
+static void bench_seap (struct bench *b)
+{
+        pthread_t th;
+        SEXP_t *s_exp = NULL;
+
+        if (pthread_create (&th, NULL, bench_seap_sender, b) != 0)
+                abort ();
+
+        if (SEAP_recvsexp (b->ctx[1], b->sd[1], &s_exp) != 0)
+                abort ();
+
+        pthread_join (th, NULL);
+        SEXP_free (s_exp);
+}
+
+static void bench_seap_teardown (struct bench *b)
+{
+        SEAP_close (b->ctx[0], b->sd[0]);
+        SEAP_close (b->ctx[1], b->sd[1]);
+        SEAP_CTX_free (b->ctx[0]);
+        SEAP_CTX_free (b->ctx[1]);
+        bench_free_sexp (b);
+}
+
+static void bench_teardown (struct bench *b)
+{
+        bench_free_sexp (b);
+        free (b->buf);
+        b->buf = NULL;
+}
+
+static struct bench benchmarks[] = {
+        { "string_new",         NULL,      NULL,                  bench_string_new, bench_teardown },
+        { "number_new",         NULL,      NULL,                  bench_number_new, bench_teardown },
+        { "list_add",           NULL,      bench_list_add_setup,  bench_list_add,   bench_teardown },
+        { "list_nth",           "file",    bench_list_nth_setup,  bench_list_nth,   bench_teardown },
+        { "list_sort",          NULL,      bench_list_sort_setup, bench_list_sort,  bench_teardown },
+        { "build_rpminfo",      "rpminfo", NULL,                  bench_build,      bench_teardown },
+        { "build_file",         "file",    NULL,                  bench_build,      bench_teardown },
+        { "arena_rpminfo",      "rpminfo", NULL,                  bench_arena,      bench_teardown },
+        { "arena_file",         "file",    NULL,                  bench_arena,      bench_teardown },
+        { "promote_file",       "file",    NULL,                  bench_promote,    bench_teardown },
+        { "deepcmp_rpminfo",    "rpminfo", bench_deepcmp_setup,   bench_deepcmp,    bench_teardown },
+        { "deepcmp_file",       "file",    bench_deepcmp_setup,   bench_deepcmp,    bench_teardown },
+        { "print_text_rpminfo", "rpminfo", bench_print_setup,     bench_print_t,    bench_teardown },
+        { "print_text_file",    "file",    bench_print_setup,     bench_print_t,    bench_teardown },
+        { "parse_text_rpminfo", "rpminfo", bench_parse_t_setup,   bench_parse_t,    bench_teardown },
+        { "parse_text_file",    "file",    bench_parse_t_setup,   bench_parse_t,    bench_teardown },
+        { "print_bin_rpminfo",  "rpminfo", bench_print_setup,     bench_print_b,    bench_teardown },
+        { "print_bin_file",     "file",    bench_print_setup,     bench_print_b,    bench_teardown },
+        { "parse_bin_rpminfo",  "rpminfo", bench_parse_b_setup,   bench_parse_b,    bench_teardown },
+        { "parse_bin_file",     "file",    bench_parse_b_setup,   bench_parse_b,    bench_teardown },
+        { "seap_text_rpminfo",  "rpminfo", bench_seap_t_setup,    bench_seap,       bench_seap_teardown },
+        { "seap_text_file",     "file",    bench_seap_t_setup,    bench_seap,       bench_seap_teardown },
+        { "seap_bin_rpminfo",   "rpminfo", bench_seap_b_setup,    bench_seap,       bench_seap_teardown },
+        { "seap_bin_file",      "file",    bench_seap_b_setup,    bench_seap,       bench_seap_teardown },
+};
+
+static void bench_run (struct bench *b, double min_time)
+{
+        uint64_t runs = 0, count, bytes;
+        double   t0, t, ops;
+
+        if (b->setup != NULL)
+                b->setup (b);
+
+        count = alloc_count;
+        bytes = alloc_bytes;
+        t0 = bench_now ();
+
+        do {
+                b->run (b);
+                ++runs;
+                t = bench_now () - t0;
+        } while (t < min_time);
+
+        count = alloc_count - count;
+        bytes = alloc_bytes - bytes;
+
+        if (b->teardown != NULL)
+                b->teardown (b);
+
+        /* list_sort sorts the whole list once, the rest handle bench_items S-exps */
+        ops = (double) runs * (strcmp (b->name, "list_sort") == 0 ? 1 : bench_items);
+
+        if (ALLOC_COUNTED)
+                printf ("%-20s %14.0f %12.2f %12.1f\n", b->name, ops / t, count / ops, bytes / ops);
+        else
+                printf ("%-20s %14.0f %12s %12s\n", b->name, ops / t, "n/a", "n/a");
+}
+
+static bool bench_selected (const char *name, int argc, char *argv[])
+{
+        if (argc == 0)
+                return (true);
+
+        for (int i = 0; i < argc; ++i) {
+                if (strstr (name, argv[i]) != NULL)
+                        return (true);
+        }
+
+        return (false);
+}
+
+int main (int argc, char *argv[])
+{
+        double min_time = 1.0;
+        int    opt;
+
+        setbuf (stdout, NULL);
+
+        while ((opt = getopt (argc, argv, "qn:t:")) != -1) {
+                switch (opt) {
+                case 'q':
+                        min_time = 0;
+                        break;
+                case 'n':
+                        bench_items = strtoul (optarg, NULL, 10);
+                        break;
+                case 't':
+                        min_time = strtod (optarg, NULL);
+                        break;
+                default:
+                        fprintf (stderr, "Usage: %s [-q] [-n items] [-t seconds] [benchmark...]\n", argv[0]);
+                        return (2);
+                }
+        }
+
+        if (bench_items == 0) {
+                fprintf (stderr, "The number of items has to be positive.\n");
+                return (2);
+        }
+
+        printf ("# items: %" PRIu32 ", list_sort sorts a list of that many strings\n", bench_items);
+        printf ("%-20s %14s %12s %12s\n", "# benchmark", "ops/s", "allocs/op", "bytes/op");
+
+        for (size_t i = 0; i < sizeof benchmarks / sizeof benchmarks[0]; ++i) {
+                if (bench_selected (benchmarks[i].name, argc - optind, argv + optind))
+                        bench_run (&benchmarks[i], min_time);
+        }
+
+        return (0);
+}
@@ -492,7 +492,9 @@ test_run "test_api_seap_spb"                  ./test_api_seap_spb
 test_run "test_api_seap_list"                 ./test_api_seap_list
 test_run "test_api_seap_number_expression"    ./test_api_seap_number
 test_run "test_api_seap_string_expression"    ./test_api_seap_string
+test_run "test_api_seap_binary"               ./test_api_seap_binary
 test_run "test_api_SEXP_deepcmp"              ./test_api_SEXP_deepcmp
 test_run "test_api_strto"                     ./test_api_strto
+test_run "test_api_sexp_arena"                ./test_api_sexp_arena
 
 test_exit
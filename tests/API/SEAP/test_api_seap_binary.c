@@ -0,0 +1,152 @@
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <sexp.h>
+#include <string.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include "_sexp-output.h"
+#include "_sexp-parser.h"
+
+/* compare the text encoding, it includes the datatypes and number types */
+static bool textcmp (SEXP_t *a, SEXP_t *b)
+{
+        strbuf_t *sa, *sb;
+        char     *ca, *cb;
+        bool      ret;
+
+        sa = strbuf_new (SEAP_STRBUF_MAX);
+        sb = strbuf_new (SEAP_STRBUF_MAX);
+        SEXP_sbprintf_t (a, sa);
+        SEXP_sbprintf_t (b, sb);
+        ca = strbuf_cstr (sa);
+        cb = strbuf_cstr (sb);
+        ret = strbuf_size (sa) == strbuf_size (sb) && memcmp (ca, cb, strbuf_size (sa)) == 0;
+
+        free (ca);
+        free (cb);
+        strbuf_free (sa);
+        strbuf_free (sb);
+
+        return (ret);
+}
+
+static int roundtrip (SEXP_t *s_exp)
+{
+        strbuf_t *sb;
+        SEXP_t   *r_exp;
+        void     *buf;
+        size_t    len;
+        int       ret;
+
+        sb = strbuf_new (SEAP_STRBUF_MAX);
+
+        if (SEXP_sbprintf_b (s_exp, sb) != 0) {
+                printf ("FAIL: SEXP_sbprintf_b\n");
+                strbuf_free (sb);
+                return (1);
+        }
+
+        len = strbuf_size (sb);
+        buf = malloc (len);
+        strbuf_copy (sb, buf, len);
+        strbuf_free (sb);
+
+        r_exp = SEXP_parse_b (buf, len);
+
+        if (r_exp == NULL) {
+                printf ("FAIL: SEXP_parse_b\n");
+                free (buf);
+                return (1);
+        }
+
+        ret = 0;
+
+        if (!SEXP_deepcmp (s_exp, r_exp) || !textcmp (s_exp, r_exp)) {
+                printf ("FAIL: S-exps differ\n");
+                SEXP_fprintfa (stdout, s_exp);
+                putc ('\n', stdout);
+                SEXP_fprintfa (stdout, r_exp);
+                putc ('\n', stdout);
+                ret = 1;
+        }
+
+        /* every truncated buffer has to be rejected */
+        while (len-- > 0) {
+                SEXP_t *t_exp = SEXP_parse_b (buf, len);
+
+                if (t_exp != NULL) {
+                        printf ("FAIL: truncated buffer accepted, length: %zu\n", len);
+                        SEXP_free (t_exp);
+                        ret = 1;
+                        break;
+                }
+        }
+
+        SEXP_free (r_exp);
+        free (buf);
+
+        return (ret);
+}
+
+/* lists nested deeper than the parser allows have to be rejected */
+static int nesting (size_t depth, bool valid)
+{
+        uint8_t *buf = malloc (2 * depth);
+        SEXP_t  *s_exp;
+        int      ret = 0;
+
+        memset (buf, '(', depth);
+        memset (buf + depth, ')', depth);
+
+        s_exp = SEXP_parse_b (buf, 2 * depth);
+
+        if ((s_exp != NULL) != valid) {
+                printf ("FAIL: %zu nested lists %s\n", depth, valid ? "rejected" : "accepted");
+                ret = 1;
+        }
+
+        SEXP_free (s_exp);
+        free (buf);
+
+        return (ret);
+}
+
+int main (void)
+{
+        SEXP_t *s_exp, *l_exp, *v[8];
+        int     ret = 0;
+
+        setbuf (stdout, NULL);
+
+        v[0] = SEXP_number_newu_8 (1);
+        v[1] = SEXP_number_newi_32 (-70000);
+        v[2] = SEXP_number_newu_64 (UINT64_MAX);
+        v[3] = SEXP_number_newf (0.125);
+        v[4] = SEXP_number_newb (true);
+        v[5] = SEXP_string_new ("a\0\"b|", 5);
+        v[6] = SEXP_string_new ("", 0);
+        v[7] = SEXP_list_new (NULL);
+
+        SEXP_datatype_set (v[5], "bin");
+        SEXP_datatype_set (v[7], "empty");
+
+        for (int i = 0; i < 8; ++i)
+                ret += roundtrip (v[i]);
+
+        s_exp = SEXP_list_new (v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], NULL);
+        ret += roundtrip (s_exp);
+
+        l_exp = SEXP_list_new (s_exp, v[7], s_exp, NULL);
+        ret += roundtrip (l_exp);
+
+        SEXP_vfree (s_exp, l_exp, NULL);
+        SEXP_vfree (v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], NULL);
+
+        ret += nesting (64, true);
+        ret += nesting (1000000, false);
+
+        return (ret == 0 ? 0 : 1);
+}
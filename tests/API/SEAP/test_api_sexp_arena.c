@@ -0,0 +1,93 @@
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <sexp.h>
+#include <string.h>
+#include <stdio.h>
+
+#define CHECK(e)							\
+	do {								\
+		if (!(e)) {						\
+			printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #e); \
+			return (1);					\
+		}							\
+	} while(0)
+
+/* (item :id 1 (name "file<n>") (size <n>) ... ) */
+static SEXP_t *build_item(unsigned int n)
+{
+	SEXP_t *item, *attr, *val, *ent;
+
+	item = SEXP_list_new(NULL);
+	attr = SEXP_string_new("item", 4);
+	SEXP_list_add(item, attr);
+	SEXP_free(attr);
+
+	for (unsigned int i = 0; i < 20; ++i) {
+		val = SEXP_string_newf("file%u_%u", n, i);
+		ent = SEXP_list_new(val, NULL);
+		SEXP_free(val);
+		val = SEXP_number_newu(n * 100 + i);
+		SEXP_list_add(ent, val);
+		SEXP_free(val);
+		SEXP_list_add(item, ent);
+		SEXP_free(ent);
+	}
+
+	return (item);
+}
+
+int main (void)
+{
+	SEXP_arena_t *arena, *prev;
+	SEXP_t *a_item, *a_rest, *a_str, *h_item, *h_rest, *p_item, *p_rest, *p_str;
+
+	setbuf (stdout, NULL);
+
+	/* the same values built on the heap */
+	h_item = build_item(7);
+	h_rest = SEXP_list_rest(h_item);
+
+	arena = SEXP_arena_new();
+	prev  = SEXP_arena_enter(arena);
+	CHECK(prev == NULL);
+
+	a_item = build_item(7);
+	a_rest = SEXP_list_rest(a_item);
+	a_str  = SEXP_string_new("escaping", 8);
+
+	CHECK(SEXP_arena_enter(prev) == arena);
+
+	p_item = SEXP_promote(a_item);
+	p_rest = SEXP_promote(a_rest);
+	p_str  = SEXP_promote(a_str);
+
+	CHECK(SEXP_deepcmp(p_item, h_item));
+	CHECK(SEXP_deepcmp(p_rest, h_rest));
+	CHECK(SEXP_strcmp(p_str, "escaping") == 0);
+	CHECK(SEXP_refs(p_item) == 1);
+	CHECK(SEXP_refs(p_str) == 1);
+	CHECK(SEXP_list_length(p_rest) == SEXP_list_length(h_rest));
+
+	/* promoting a value which isn't in an arena doesn't copy it */
+	SEXP_free(p_str);
+	p_str = SEXP_promote(h_rest);
+	CHECK(SEXP_refs(h_rest) == 2);
+	SEXP_free(p_str);
+
+	/* a value referenced after the release keeps the arena alive */
+	SEXP_arena_release(arena);
+	SEXP_vfree(a_item, a_rest, NULL);
+	CHECK(SEXP_strcmp(a_str, "escaping") == 0);
+	SEXP_free(a_str);
+
+	/* the promoted values are independent of the arena */
+	CHECK(SEXP_deepcmp(p_item, h_item));
+	CHECK(SEXP_deepcmp(p_rest, h_rest));
+
+	SEXP_vfree(p_item, p_rest, h_item, h_rest, NULL);
+
+	return (0);
+}
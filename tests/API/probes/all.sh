@@ -5,4 +5,7 @@
 test_init "test_api_probes.log"
 test_run "fts test" $srcdir/fts.sh
 test_run "probe api smoke test" ./test_api_probes_smoke
+test_run "file system cache test" ./test_api_probes_fscache
+test_run "item cache test" ./test_api_probes_icache
+test_run "process table snapshot test" ./test_api_probes_process58
 test_exit
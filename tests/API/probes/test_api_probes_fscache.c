@@ -0,0 +1,189 @@
+/*
+ * Compare the walks done by the file system cache of oval_fts with the
+ * walks done by fts(3) on the same tree. Every walk is done twice, the
+ * second one is served from the cache.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <sys/stat.h>
+#include <fts.h>
+#include "fscache.h"
+
+#define FAIL(ret, ...)                                        \
+        do {                                                  \
+                fprintf (stderr, "FAIL: " __VA_ARGS__);       \
+                exit (ret);                                   \
+        } while (0)
+
+static char root[] = "/tmp/fscache.XXXXXX";
+
+static void gen_tree (void)
+{
+        static const char *dirs[] = {
+                "d1", "d1/d11", "d1/d11/d111", "d1/d12", "d2", "d2/d21", "d3", NULL
+        };
+        static const char *files[] = {
+                "f0", "d1/f11", "d1/d11/f111", "d1/d11/d111/f1111", "d2/f21", "d2/d21/f211", NULL
+        };
+        static const char *links[][2] = {
+                { "d1/d11", "d2/l1" },    /* symlink to a directory */
+                { "f0", "d2/l2" },        /* symlink to a file */
+                { "nonexistent", "d2/l3" }, /* dangling symlink */
+                { "..", "d2/l4" },        /* symlink to an ancestor */
+                { NULL, NULL }
+        };
+        char path[PATH_MAX], target[PATH_MAX];
+        int i, fd;
+
+        if (mkdtemp (root) == NULL)
+                FAIL(2, "mkdtemp: %s\n", strerror (errno));
+
+        for (i = 0; dirs[i] != NULL; ++i) {
+                snprintf (path, sizeof path, "%s/%s", root, dirs[i]);
+                if (mkdir (path, 0755) != 0)
+                        FAIL(2, "mkdir %s: %s\n", path, strerror (errno));
+        }
+
+        for (i = 0; files[i] != NULL; ++i) {
+                snprintf (path, sizeof path, "%s/%s", root, files[i]);
+                if ((fd = open (path, O_CREAT | O_WRONLY, 0644)) < 0)
+                        FAIL(2, "open %s: %s\n", path, strerror (errno));
+                close (fd);
+        }
+
+        for (i = 0; links[i][0] != NULL; ++i) {
+                if (links[i][0][0] == '.' || strcmp (links[i][0], "nonexistent") == 0)
+                        snprintf (target, sizeof target, "%s", links[i][0]);
+                else
+                        snprintf (target, sizeof target, "%s/%s", root, links[i][0]);
+                snprintf (path, sizeof path, "%s/%s", root, links[i][1]);
+                if (symlink (target, path) != 0)
+                        FAIL(2, "symlink %s: %s\n", path, strerror (errno));
+        }
+}
+
+static int rm_cb (const char *path, const struct stat *st, int flag, struct FTW *ftw)
+{
+        (void)st, (void)flag, (void)ftw;
+        return remove (path);
+}
+
+static void rm_tree (void)
+{
+        nftw (root, rm_cb, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+/*
+ * Symlinks are followed once, like oval_fts does it for the targets of
+ * the links found during the recursion.
+ */
+#define WALK(type, open, read, set, close)                                        \
+        do {                                                                      \
+                type *ent;                                                        \
+                                                                                  \
+                while ((ent = read) != NULL) {                                    \
+                        fprintf (out, "%d %d %s %s\n", ent->fts_info,             \
+                                 (int)ent->fts_level, ent->fts_name, ent->fts_path); \
+                        if (ent->fts_info == FTS_SL && ent->fts_level == 2)       \
+                                set (walk, ent, FTS_FOLLOW);                      \
+                        if (ent->fts_info == FTS_DC)                              \
+                                set (walk, ent, FTS_SKIP);                        \
+                }                                                                 \
+                close;                                                            \
+        } while (0)
+
+static char *walk_fts (const char *path, int options, size_t *len)
+{
+        char *paths[2] = { (char *)path, NULL };
+        char *buf = NULL;
+        FILE *out = open_memstream (&buf, len);
+        FTS  *walk = fts_open (paths, options, NULL);
+
+        if (walk == NULL)
+                FAIL(2, "fts_open %s: %s\n", path, strerror (errno));
+
+        WALK(FTSENT, walk, fts_read (walk), fts_set, fts_close (walk));
+        fclose (out);
+
+        return buf;
+}
+
+static char *walk_fscache (const char *path, int options, size_t *len)
+{
+        char *buf = NULL;
+        FILE *out = open_memstream (&buf, len);
+        FSCACHE_WALK *walk = fscache_walk_open (path, options);
+
+        if (walk == NULL)
+                FAIL(1, "fscache_walk_open %s: %s\n", path, strerror (errno));
+
+        WALK(FSCACHE_ENT, walk, fscache_walk_read (walk), fscache_walk_set, fscache_walk_close (walk));
+        fclose (out);
+
+        return buf;
+}
+
+static void compare (const char *path, int options)
+{
+        char *exp, *res;
+        size_t explen, reslen;
+        int pass;
+
+        exp = walk_fts (path, options, &explen);
+
+        for (pass = 0; pass < 2; ++pass) {
+                res = walk_fscache (path, options, &reslen);
+
+                if (explen != reslen || memcmp (exp, res, explen) != 0)
+                        FAIL(1, "walk of %s (options %d, pass %d) differs\n"
+                             "expected:\n%s\nresult:\n%s\n", path, options, pass, exp, res);
+                free (res);
+        }
+
+        free (exp);
+}
+
+int main (void)
+{
+        static const char *paths[] = { "", "/d1", "/d1/", "/d2/l1", "/d2/l2", "/d3", "/f0", NULL };
+        const int options = FTS_PHYSICAL | FTS_COMFOLLOW | FTS_NOCHDIR;
+        char path[PATH_MAX];
+        size_t hits, misses;
+        struct stat st;
+        int i;
+
+        gen_tree ();
+
+        for (i = 0; paths[i] != NULL; ++i) {
+                snprintf (path, sizeof path, "%s%s", root, paths[i]);
+                compare (path, options);
+                compare (path, options | FTS_XDEV);
+        }
+
+        snprintf (path, sizeof path, "%s/nonexistent", root);
+        if (fscache_walk_open (path, options) != NULL || fscache_lstat (path, &st) == 0)
+                FAIL(1, "%s exists\n", path);
+
+        fscache_stats (&hits, &misses);
+        printf ("hits: %zu, misses: %zu\n", hits, misses);
+
+        /* the cache can be turned off or made smaller using OSCAP_PROBE_FS_CACHE */
+        if (hits == 0 && getenv ("OSCAP_PROBE_FS_CACHE") == NULL)
+                FAIL(1, "no lookup was served from the cache\n");
+
+        fscache_free ();
+        rm_tree ();
+
+        return 0;
+}
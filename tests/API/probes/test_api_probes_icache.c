@@ -0,0 +1,146 @@
+/*
+ * Several threads collect overlapping sets of items through one item
+ * cache, like the workers of a probe do. Every distinct item has to be
+ * cached once and get a single ID, distinct items have to get distinct
+ * IDs and every collected object has to contain all of its items.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sexp.h>
+#include "probe-api.h"
+#include "probe/probe.h"
+
+#define FAIL(ret, ...)                                        \
+        do {                                                  \
+                fprintf (stderr, "FAIL: " __VA_ARGS__);       \
+                exit (ret);                                   \
+        } while (0)
+
+#define THREADS  8
+#define ITEMS    500  /* collected by each thread */
+#define DISTINCT 200  /* distinct items among them */
+
+struct worker {
+        pthread_t        th;
+        int              n;
+        struct probe_ctx ctx;
+};
+
+static void *collect (void *arg)
+{
+        struct worker *w = arg;
+        SEXP_t *item;
+        int i;
+
+        for (i = 0; i < ITEMS; ++i) {
+                /* every thread starts elsewhere to make them race for the same items */
+                item = probe_item_creat ("file_item", NULL,
+                                         "filepath", NULL, SEXP_string_newf ("/file%d", (i + w->n * 97) % DISTINCT),
+                                         NULL);
+
+                if (probe_item_collect (&w->ctx, item) != 0)
+                        FAIL(1, "thread %d: can't collect item %d\n", w->n, i);
+        }
+
+        return (NULL);
+}
+
+int main (void)
+{
+        struct worker w[THREADS];
+        char  *ids[DISTINCT];
+        size_t hits, misses;
+        probe_icache_t *cache;
+        SEXP_t *items, *item, *ent, *val, *s_id;
+        char   *id, *path;
+        int i, j, n;
+
+        if ((cache = probe_icache_new ()) == NULL)
+                FAIL(2, "can't create the item cache\n");
+
+        for (i = 0; i < THREADS; ++i) {
+                w[i].n = i;
+                w[i].ctx.probe_in  = NULL;
+                w[i].ctx.probe_out = probe_cobj_new (SYSCHAR_FLAG_UNKNOWN, NULL, NULL, NULL);
+                w[i].ctx.filters   = NULL;
+                w[i].ctx.icache    = cache;
+        }
+
+        for (i = 0; i < THREADS; ++i) {
+                if (pthread_create (&w[i].th, NULL, &collect, w + i) != 0)
+                        FAIL(2, "can't create thread %d\n", i);
+        }
+
+        for (i = 0; i < THREADS; ++i)
+                pthread_join (w[i].th, NULL);
+
+        probe_icache_stats (cache, &hits, &misses);
+
+        if (misses != DISTINCT || hits != THREADS * ITEMS - DISTINCT)
+                FAIL(1, "hits=%zu, misses=%zu, expected %d, %d\n",
+                     hits, misses, THREADS * ITEMS - DISTINCT, DISTINCT);
+
+        memset (ids, 0, sizeof ids);
+
+        for (i = 0; i < THREADS; ++i) {
+                items = probe_cobj_get_items (w[i].ctx.probe_out);
+
+                if (SEXP_list_length (items) != ITEMS)
+                        FAIL(1, "thread %d: %zu items collected, expected %d\n",
+                             i, SEXP_list_length (items), ITEMS);
+
+                SEXP_list_foreach (item, items) {
+                        ent  = probe_item_getent (item, "filepath", 1);
+                        val  = probe_ent_getval (ent);
+                        path = SEXP_string_cstr (val);
+                        s_id = probe_ent_getattrval (item, "id");
+                        id   = SEXP_string_cstr (s_id);
+
+                        if (path == NULL || sscanf (path, "/file%d", &n) != 1 || n < 0 || n >= DISTINCT)
+                                FAIL(1, "unexpected item: %s\n", path != NULL ? path : "(null)");
+                        if (id == NULL || id[0] != '1')
+                                FAIL(1, "%s: invalid ID %s\n", path, id != NULL ? id : "(null)");
+
+                        /* the same item has the same ID in every collected object */
+                        if (ids[n] == NULL)
+                                ids[n] = id;
+                        else {
+                                if (strcmp (ids[n], id) != 0)
+                                        FAIL(1, "%s has two IDs: %s, %s\n", path, ids[n], id);
+                                free (id);
+                        }
+
+                        free (path);
+                        SEXP_vfree (ent, val, s_id, NULL);
+                }
+
+                SEXP_free (items);
+        }
+
+        /* distinct items have distinct IDs */
+        for (i = 0; i < DISTINCT; ++i) {
+                if (ids[i] == NULL)
+                        FAIL(1, "/file%d wasn't collected\n", i);
+
+                for (j = 0; j < i; ++j) {
+                        if (strcmp (ids[i], ids[j]) == 0)
+                                FAIL(1, "/file%d and /file%d have the same ID %s\n", i, j, ids[i]);
+                }
+        }
+
+        for (i = 0; i < DISTINCT; ++i)
+                free (ids[i]);
+        for (i = 0; i < THREADS; ++i)
+                SEXP_free (w[i].ctx.probe_out);
+
+        probe_icache_free (cache);
+
+        return (0);
+}
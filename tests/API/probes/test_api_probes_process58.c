@@ -0,0 +1,153 @@
+/*
+ * Compare the entry of this process in the process table snapshot of
+ * the process58 probe with the values it knows about itself and check
+ * that a reset of the snapshot makes it read the process table again.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+#if defined(__linux__)
+#include <sys/prctl.h>
+#include "process58-snapshot.h"
+#endif
+
+#define FAIL(ret, ...)                                        \
+        do {                                                  \
+                fprintf (stderr, "FAIL: " __VA_ARGS__);       \
+                exit (ret);                                   \
+        } while (0)
+
+#if defined(__linux__)
+
+#define COMM "oscap-snaptest"
+
+static struct proc_entry *find (struct proc_snapshot *snap, int pid)
+{
+        struct proc_entry *entry;
+        size_t count, i;
+
+        if ((entry = proc_snapshot_entries (snap, &count)) == NULL)
+                FAIL(1, "can't read the process table\n");
+
+        for (i = 0; i < count; ++i) {
+                /* kernel threads are left out */
+                if (entry[i].pid == 2 || entry[i].stat.ppid == 2)
+                        FAIL(1, "the kernel thread %d is in the snapshot\n", entry[i].pid);
+        }
+
+        for (i = 0; i < count; ++i) {
+                if (entry[i].pid == pid)
+                        return (entry + i);
+        }
+
+        return (NULL);
+}
+
+int main (int argc, char *argv[])
+{
+        struct proc_snapshot *snap;
+        struct proc_entry *entry;
+        const char *cmdline;
+        char expected[4096], buf[32];
+        unsigned loginuid;
+        pid_t child;
+        FILE *fp;
+        int i;
+
+        /* run again with arguments which are printed differently */
+        if (argc == 1) {
+                execl ("/proc/self/exe", argv[0], "param1", "two words", "\033[1;33m", (char *)NULL);
+                FAIL(2, "execl: %s\n", strerror (errno));
+        }
+
+        prctl (PR_SET_NAME, COMM, 0, 0, 0);
+
+        snprintf (expected, sizeof expected, "%s", argv[0]);
+        for (i = 1; i < argc; ++i) {
+                strncat (expected, " ", sizeof expected - strlen (expected) - 1);
+                strncat (expected, argv[i], sizeof expected - strlen (expected) - 1);
+        }
+        /* non-printable characters are replaced like ps does it */
+        for (i = 0; expected[i] != '\0'; ++i) {
+                if (expected[i] == '\033')
+                        expected[i] = '.';
+        }
+
+        if ((snap = proc_snapshot_new ()) == NULL)
+                FAIL(2, "can't create the snapshot\n");
+
+        if ((entry = find (snap, getpid ())) == NULL)
+                FAIL(1, "this process (%d) isn't in the snapshot\n", getpid ());
+
+        if (entry->stat.ppid != getppid ())
+                FAIL(1, "ppid: %d != %d\n", entry->stat.ppid, getppid ());
+        if (strcmp (entry->stat.comm, COMM) != 0)
+                FAIL(1, "comm: \"%s\" != \"%s\"\n", entry->stat.comm, COMM);
+        if (entry->stat.state != 'R')
+                FAIL(1, "state: %c != R\n", entry->stat.state);
+        if (entry->stat.session != getsid (0))
+                FAIL(1, "session: %d != %d\n", entry->stat.session, getsid (0));
+
+        cmdline = proc_entry_cmdline (snap, entry);
+        if (cmdline == NULL || strcmp (cmdline, expected) != 0)
+                FAIL(1, "command line: \"%s\" != \"%s\"\n", cmdline != NULL ? cmdline : "(null)", expected);
+
+        proc_entry_uids (snap, entry);
+        if (entry->ruid != (int)getuid ())
+                FAIL(1, "ruid: %d != %d\n", entry->ruid, (int)getuid ());
+        if (entry->user_id != (int)geteuid ())
+                FAIL(1, "user_id: %d != %d\n", entry->user_id, (int)geteuid ());
+
+        loginuid = (unsigned)-1;
+        if ((fp = fopen ("/proc/self/loginuid", "r")) != NULL) {
+                if (fgets (buf, sizeof buf, fp) != NULL)
+                        sscanf (buf, "%u", &loginuid);
+                fclose (fp);
+        }
+        if (entry->loginuid != loginuid)
+                FAIL(1, "loginuid: %u != %u\n", entry->loginuid, loginuid);
+
+        /* the snapshot doesn't change until it's reset */
+        if ((child = fork ()) == -1)
+                FAIL(2, "fork: %s\n", strerror (errno));
+        if (child == 0) {
+                pause ();
+                _exit (0);
+        }
+
+        if (find (snap, child) != NULL)
+                FAIL(1, "the snapshot was read again without a reset\n");
+
+        proc_snapshot_reset (snap);
+
+        if ((entry = find (snap, child)) == NULL)
+                FAIL(1, "the child (%d) isn't in the snapshot after the reset\n", child);
+        if (entry->stat.ppid != getpid ())
+                FAIL(1, "ppid of the child: %d != %d\n", entry->stat.ppid, getpid ());
+
+        kill (child, SIGKILL);
+        waitpid (child, NULL, 0);
+        proc_snapshot_free (snap);
+
+        return (0);
+}
+
+#else
+
+int main (void)
+{
+        /* the snapshot is read from /proc, not applicable */
+        return (255);
+}
+
+#endif
@@ -526,11 +526,14 @@ int main (void)
         {
 	        struct sys_memusage mu_sys;
 	        struct proc_memusage mu_proc;
+	        struct cgroup_memusage mu_cg;
 
 	        if (oscap_sys_memusage(&mu_sys) != 0)
 		        FAIL(1, "oscap_sys_memusage != 0\n");
 	        if (oscap_proc_memusage(&mu_proc) != 0)
 		        FAIL(1, "oscap_proc_memusage != 0\n");
+	        if (oscap_cgroup_memusage(&mu_cg) != 0)
+		        FAIL(1, "oscap_cgroup_memusage != 0\n");
 
 	        printf("mu_sys:\n"
 	               "   mu_active: %zu\n"
@@ -563,6 +566,14 @@ int main (void)
 	               mu_proc.mu_lib,
 	               mu_proc.mu_rss,
 	               mu_proc.mu_stack);
+
+	        printf("mu_cg:\n"
+	               "    mu_limit: %zu\n"
+	               "  mu_current: %zu\n"
+	               "     mu_file: %zu\n",
+	               mu_cg.mu_limit,
+	               mu_cg.mu_current,
+	               mu_cg.mu_file);
         }
 
         /*
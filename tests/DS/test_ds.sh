@@ -368,6 +368,24 @@ function test_sds_tailoring {
 	rm -f "$result"
 }
 
+function test_sds_split_components {
+	local SDS_FILE="${srcdir}/$1"
+	local DOM_FILE=$(mktemp)
+	local raw_dir=$(mktemp -d)
+	local dom_dir=$(mktemp -d)
+
+	# Components of a datastream with a DTD are looked up in the DOM of the
+	# whole datastream, the output has to be the same as with components
+	# read separately.
+	sed '1a <!DOCTYPE data-stream-collection>' "$SDS_FILE" > "$DOM_FILE"
+
+	$OSCAP ds sds-split "$SDS_FILE" "$raw_dir"
+	$OSCAP ds sds-split "$DOM_FILE" "$dom_dir"
+	diff -r "$raw_dir" "$dom_dir"
+
+	rm -rf "$raw_dir" "$dom_dir" "$DOM_FILE"
+}
+
 # Testing.
 test_init "test_ds.log"
 
@@ -383,6 +401,8 @@ test_run "sds_extended_component" test_sds sds_extended_component fake-check-xcc
 test_run "sds_extended_component_plain_text" test_sds sds_extended_component_plain_text fake-check-xccdf.xml 0
 test_run "sds_extended_component_plain_text_entities" test_sds sds_extended_component_plain_text_entities fake-check-xccdf.xml 0
 test_run "sds_extended_component_plain_text_whitespace" test_sds sds_extended_component_plain_text_whitespace fake-check-xccdf.xml 0
+test_run "sds_split_components_simple" test_sds_split_components eval_simple/sds.xml
+test_run "sds_split_components_cpe" test_sds_split_components eval_cpe/sds.xml
 test_run "sds_tailoring" test_sds_tailoring sds_tailoring sds_tailoring/sds.ds.xml scap_com.example_datastream_with_tailoring xccdf_com.example_cref_tailoring_01 xccdf_com.example_profile_tailoring
 
 test_run "eval_simple" test_eval eval_simple/sds.xml
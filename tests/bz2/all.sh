@@ -10,5 +10,6 @@ set -e -o pipefail
 test_init "test_bz2.log"
 
 test_run "DataStream operations .xml.bz2" $srcdir/test_bz2_datastream.sh
+test_run "Compressed sources" $srcdir/test_compressed_sources.sh
 
 test_exit
@@ -0,0 +1,62 @@
+#!/bin/bash
+#
+# Copyright 2016 Red Hat Inc., Durham, North Carolina.
+# All Rights Reserved.
+
+set -e -o pipefail
+set -x
+
+name=$(basename $0 .sh)
+dir=$(mktemp -d -t ${name}.XXXXXX)
+stderr=$(mktemp -t ${name}.err.XXXXXX)
+echo "Stderr file = $stderr"
+xccdf=$dir/xccdf.xml
+cp $srcdir/../DS/sds_multiple_oval/*.xml $dir/
+mv $dir/multiple-oval-xccdf.xml $xccdf
+
+# Pad the benchmark with a comment, so that it spans many bzip2 blocks
+sed -i '$d' $xccdf
+echo '<!--' >> $xccdf
+head -c 2000000 /dev/urandom | base64 >> $xccdf
+echo '--></xccdf:Benchmark>' >> $xccdf
+
+$OSCAP info $xccdf 2> $stderr | grep -v Imported > $dir/info.out
+[ ! -s $stderr ]
+
+bzip2 -1 -k $xccdf
+for threads in 1 2 4; do
+	OSCAP_DECOMPRESS_THREADS=$threads $OSCAP info "${xccdf}.bz2" 2> $stderr | grep -v Imported > $dir/info.bz2.out
+	[ ! -s $stderr ]
+	diff $dir/info.out $dir/info.bz2.out
+
+	OSCAP_DECOMPRESS_THREADS=$threads $OSCAP xccdf validate-xml "${xccdf}.bz2" > $stderr
+	[ ! -s $stderr ]
+done
+./test_bz2_memory_source "${xccdf}.bz2" | grep 'XCCDF Checklist'
+
+# A corrupted archive is rejected
+cp "${xccdf}.bz2" $dir/corrupted.xml.bz2
+printf 'xxxxxxxx' | dd of=$dir/corrupted.xml.bz2 bs=1 seek=100000 conv=notrunc
+ret=0
+$OSCAP info $dir/corrupted.xml.bz2 2> $stderr || ret=$?
+[ $ret -ne 0 ]
+[ -s $stderr ]
+
+if command -v gzip > /dev/null; then
+	gzip -k $xccdf
+	$OSCAP info "${xccdf}.gz" 2> $stderr | grep -v Imported > $dir/info.gz.out
+	[ ! -s $stderr ]
+	diff $dir/info.out $dir/info.gz.out
+	./test_bz2_memory_source "${xccdf}.gz" | grep 'XCCDF Checklist'
+fi
+
+if command -v xz > /dev/null; then
+	xz -k $xccdf
+	$OSCAP info "${xccdf}.xz" 2> $stderr | grep -v Imported > $dir/info.xz.out
+	[ ! -s $stderr ]
+	diff $dir/info.out $dir/info.xz.out
+	./test_bz2_memory_source "${xccdf}.xz" | grep 'XCCDF Checklist'
+fi
+
+rm $stderr
+rm -rf $dir
@@ -38,10 +38,33 @@ function test_probes_family {
     return $ret_val
 }
 
+function test_probes_family_pipelined {
+
+    probecheck "family" || return 255
+
+    local ret_val=0;
+    local DF="${srcdir}/test_probes_family.xml"
+    local RF="results_pipelined.xml"
+
+    [ -f $RF ] && rm -f $RF
+
+    OSCAP_PROBE_ASYNC_WINDOW=4 $OSCAP oval eval --results $RF $DF
+
+    if [ -f $RF ]; then
+	verify_results "def" $DF $RF 7 && verify_results "tst" $DF $RF 42
+	ret_val=$?
+    else
+	ret_val=1
+    fi
+
+    return $ret_val
+}
+
 # Testing.
 
 test_init "test_probes_family.log"
 
 test_run "test_probes_family" test_probes_family
+test_run "test_probes_family_pipelined" test_probes_family_pipelined
 
 test_exit
@@ -120,6 +120,86 @@ function test_probes_file_invalid_utf8 {
 	return $ret_val
 }
 
+function test_probes_file_acl {
+
+	probecheck "file" || return 255
+
+	local ret_val=0
+	local DF="$srcdir/test_probes_file_acl.xml"
+	result="results.xml"
+
+	[ -f $result ] && rm -f $result
+
+	$OSCAP oval eval --results $result $DF || ret_val=1
+	$OSCAP oval validate $result || ret_val=1
+
+	# the extended ACL is read only if a state references it
+	assert_exists 1 '//unix-sys:file_item[unix-sys:filepath="/etc/passwd"]/unix-sys:has_extended_acl[@status="not collected"]' || ret_val=1
+	assert_exists 1 '//unix-sys:file_item[unix-sys:filepath="/etc/group"]/unix-sys:has_extended_acl' || ret_val=1
+	assert_exists 0 '//unix-sys:file_item[unix-sys:filepath="/etc/group"]/unix-sys:has_extended_acl[@status="not collected"]' || ret_val=1
+
+	return $ret_val
+}
+
+function test_probes_file_parallel {
+
+	probecheck "file" || return 255
+	probecheck "filehash" || return 255
+	probecheck "filehash58" || return 255
+	probecheck "fileextendedattribute" || return 255
+
+	local ret_val=0
+	local DIRS=4 FILES
+	local DF="test_probes_file_parallel.xml"
+	result="results.xml"
+	files_dir=$(mktemp -d)
+
+	# every object walks its own tree
+	for d in $(seq $DIRS); do
+		for s in $(seq 5); do
+			mkdir -p "$files_dir/d$d/s$s/t"
+			for f in $(seq 4); do
+				echo "$d $s $f" > "$files_dir/d$d/s$s/f$f"
+				echo "$d $s $f" > "$files_dir/d$d/s$s/t/f$f"
+			done
+		done
+	done
+	FILES=$(find "$files_dir" -type f | wc -l)
+
+	# the extended attributes aren't supported by every file system
+	XATTRS=0
+	if command -v setfattr >/dev/null &&
+	   setfattr -n user.oscap -v 1 "$files_dir/d1/s1/f1" 2>/dev/null; then
+		XATTRS=$DIRS
+		for d in $(seq 2 $DIRS); do
+			setfattr -n user.oscap -v 1 "$files_dir/d$d/s1/f1"
+		done
+	fi
+
+	bash ${srcdir}/test_probes_file_parallel.xml.sh "$files_dir" $DIRS > $DF
+
+	# the same objects collected by one worker and by several workers
+	# sending the objects at once and sharing a limited number of walks
+	for threads in 1 4; do
+		[ -f $result ] && rm -f $result
+
+		OSCAP_PROBE_THREADS=$threads OSCAP_PROBE_FS_WALKS=2 OSCAP_PROBE_ASYNC_WINDOW=8 \
+			$OSCAP oval eval --results $result $DF || ret_val=1
+		$OSCAP oval validate $result || ret_val=1
+
+		assert_exists 1 '//results//definition[@definition_id="oval:1:def:1"][@result="true"]' || ret_val=1
+		assert_exists $FILES '//unix-sys:file_item' || ret_val=1
+		assert_exists $FILES '//ind-sys:filehash_item' || ret_val=1
+		assert_exists $FILES '//ind-sys:filehash58_item' || ret_val=1
+		assert_exists $XATTRS '//unix-sys:fileextendedattribute_item' || ret_val=1
+		assert_exists 0 '//*[local-name()="object"][@flag="error"]' || ret_val=1
+	done
+
+	rm -rf "$files_dir"
+
+	return $ret_val
+}
+
 # Testing.
 
 test_init "test_probes_file.log"
@@ -128,5 +208,7 @@ test_run "test_probes_file with verbose mode" test_probes_file verbose
 test_run "test_probes_file" test_probes_file
 test_run "test_probes_file_filenames" test_probes_file_filenames
 test_run "test_probes_file_invalid_utf8" test_probes_file_invalid_utf8
+test_run "test_probes_file_acl" test_probes_file_acl
+test_run "test_probes_file_parallel" test_probes_file_parallel
 
 test_exit
@@ -0,0 +1,95 @@
+#!/usr/bin/env bash
+
+# Objects of the file system probes, each of them walks one of the
+# directories $1/d1 ... $1/d$2.
+
+DIR="$1"
+DIRS="$2"
+
+cat <<EOF
+<?xml version="1.0"?>
+<oval_definitions xmlns:oval-def="http://oval.mitre.org/XMLSchema/oval-definitions-5" xmlns:oval="http://oval.mitre.org/XMLSchema/oval-common-5" xmlns:xsi="http://www.w3.org/2001/XMLSchema-instance" xmlns:ind-def="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent" xmlns:unix-def="http://oval.mitre.org/XMLSchema/oval-definitions-5#unix" xmlns:lin-def="http://oval.mitre.org/XMLSchema/oval-definitions-5#linux" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5" xsi:schemaLocation="http://oval.mitre.org/XMLSchema/oval-definitions-5#unix unix-definitions-schema.xsd http://oval.mitre.org/XMLSchema/oval-definitions-5#independent independent-definitions-schema.xsd http://oval.mitre.org/XMLSchema/oval-definitions-5#linux linux-definitions-schema.xsd http://oval.mitre.org/XMLSchema/oval-definitions-5 oval-definitions-schema.xsd http://oval.mitre.org/XMLSchema/oval-common-5 oval-common-schema.xsd">
+
+  <generator>
+    <oval:product_name>file</oval:product_name>
+    <oval:product_version>1.0</oval:product_version>
+    <oval:schema_version>5.10.1</oval:schema_version>
+    <oval:timestamp>2008-03-31T00:00:00-00:00</oval:timestamp>
+  </generator>
+
+  <definitions>
+    <definition class="compliance" version="1" id="oval:1:def:1">
+      <metadata>
+        <title></title>
+        <description></description>
+      </metadata>
+      <criteria operator="AND">
+EOF
+
+for ((i = 1; i <= 4 * DIRS; ++i)); do
+    echo "        <criterion test_ref=\"oval:1:tst:$i\"/>"
+done
+
+cat <<EOF
+      </criteria>
+    </definition>
+  </definitions>
+
+  <tests>
+EOF
+
+for ((d = 1; d <= DIRS; ++d)); do
+    cat <<EOF
+    <file_test version="1" id="oval:1:tst:$d" check="all" check_existence="at_least_one_exists" comment="true" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#unix">
+      <object object_ref="oval:1:obj:$d"/>
+    </file_test>
+    <filehash_test version="1" id="oval:1:tst:$((DIRS + d))" check="all" check_existence="at_least_one_exists" comment="true" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+      <object object_ref="oval:1:obj:$((DIRS + d))"/>
+    </filehash_test>
+    <filehash58_test version="1" id="oval:1:tst:$((2 * DIRS + d))" check="all" check_existence="at_least_one_exists" comment="true" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+      <object object_ref="oval:1:obj:$((2 * DIRS + d))"/>
+    </filehash58_test>
+    <fileextendedattribute_test version="1" id="oval:1:tst:$((3 * DIRS + d))" check="all" check_existence="any_exist" comment="true" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#unix">
+      <object object_ref="oval:1:obj:$((3 * DIRS + d))"/>
+    </fileextendedattribute_test>
+EOF
+done
+
+cat <<EOF
+  </tests>
+
+  <objects>
+EOF
+
+for ((d = 1; d <= DIRS; ++d)); do
+    cat <<EOF
+    <file_object version="1" id="oval:1:obj:$d" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#unix">
+      <behaviors recurse_direction="down" max_depth="-1"/>
+      <path>$DIR/d$d</path>
+      <filename operation="pattern match">^f</filename>
+    </file_object>
+    <filehash_object version="1" id="oval:1:obj:$((DIRS + d))" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+      <behaviors recurse_direction="down" max_depth="-1"/>
+      <path>$DIR/d$d</path>
+      <filename operation="pattern match">^f</filename>
+    </filehash_object>
+    <filehash58_object version="1" id="oval:1:obj:$((2 * DIRS + d))" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+      <behaviors recurse_direction="down" max_depth="-1"/>
+      <path>$DIR/d$d</path>
+      <filename operation="pattern match">^f</filename>
+      <hash_type>SHA-1</hash_type>
+    </filehash58_object>
+    <fileextendedattribute_object version="1" id="oval:1:obj:$((3 * DIRS + d))" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#unix">
+      <behaviors recurse_direction="down" max_depth="-1"/>
+      <path>$DIR/d$d</path>
+      <filename operation="pattern match">^f</filename>
+      <attribute_name>user.oscap</attribute_name>
+    </fileextendedattribute_object>
+EOF
+done
+
+cat <<EOF
+  </objects>
+
+</oval_definitions>
+EOF
@@ -0,0 +1,32 @@
+#!/usr/bin/env bash
+
+. ../test_common.sh
+
+set -e -o pipefail
+
+# Rules evaluated concurrently have to give the same results,
+# in the same order, as rules evaluated one after another.
+function test_sce_jobs {
+
+    local DEFFILE=${srcdir}/$1
+    local SEQFILE=$1.seq.results
+    local PARFILE=$1.jobs.results
+    local seq=$1.seq.progress.results
+    local par=$1.jobs.progress.results
+
+    $OSCAP xccdf eval --progress --results "$SEQFILE" --profile "default" "$DEFFILE" > "$seq"
+    $OSCAP xccdf eval --progress --jobs 4 --results "$PARFILE" --profile "default" "$DEFFILE" > "$par"
+
+    diff "$seq" "$par"
+    diff <(grep -e "<rule-result" -e "<result>" "$SEQFILE" | sed 's/time="[^"]*"//') \
+         <(grep -e "<rule-result" -e "<result>" "$PARFILE" | sed 's/time="[^"]*"//')
+
+    # an invalid number of jobs is refused
+    if $OSCAP xccdf eval --jobs 0 --profile "default" "$DEFFILE"; then
+        return 1
+    fi
+}
+
+test_init "test_sce_jobs.log"
+test_run "sce --jobs" test_sce_jobs sce_xccdf.xml
+test_exit
@@ -0,0 +1,41 @@
+#!/usr/bin/env bash
+
+# Test time and output limits of SCE scripts.
+
+. ../test_common.sh
+
+set -e -o pipefail
+
+function test_sce_limits {
+
+    local DEFFILE=${srcdir}/$1
+    local RESFILE=$1.results
+    local result=$RESFILE
+    local start=$(date +%s)
+
+    [ -f $RESFILE ] && rm $RESFILE
+
+    # returns 2, because a rule ends with error
+    OSCAP_SCE_TIMEOUT=2 OSCAP_SCE_OUTPUT_LIMIT=1000 \
+        $OSCAP xccdf eval --check-engine-results --results "$RESFILE" "$DEFFILE" || [ $? -eq 2 ]
+
+    # the sleeping scripts have been killed, even the one with closed output
+    [ $(($(date +%s) - start)) -lt 30 ]
+    assert_exists 1 '//rule-result[@idref="xccdf_moc.elpmaxe.www_rule_sleeper"]/result[text()="error"]'
+    assert_exists 1 '//rule-result[@idref="xccdf_moc.elpmaxe.www_rule_silent"]/result[text()="error"]'
+
+    # both outputs of the flooding script have been read, only the beginning is kept
+    assert_exists 1 '//rule-result[@idref="xccdf_moc.elpmaxe.www_rule_flood"]/result[text()="pass"]'
+    local stdout=$($XPATH $RESFILE 'string(//rule-result[@idref="xccdf_moc.elpmaxe.www_rule_flood"]//check-import[@import-name="stdout"])' 2>/dev/null)
+    [ ${#stdout} -eq 1000 ]
+    grep -q "yyyy" test_sce_limits_flood.sh.result.xml
+    [ $(stat -c %s test_sce_limits_flood.sh.result.xml) -lt 10000 ]
+
+    assert_exists 1 '//rule-result[@idref="xccdf_moc.elpmaxe.www_rule_passer"]/result[text()="pass"]'
+
+    rm test_sce_limits_*.sh.result.xml bash_passer.sh.result.xml
+}
+
+test_init "test_sce_limits.log"
+test_run "sce limits" test_sce_limits test_sce_limits.xccdf.xml
+test_exit
@@ -0,0 +1,6 @@
+#!/usr/bin/env bash
+
+# more than a pipe can hold, the script blocks unless stderr is read
+head -c 1048576 /dev/zero | tr '\0' 'x' >&2
+head -c 1048576 /dev/zero | tr '\0' 'y'
+exit $XCCDF_RESULT_PASS
@@ -0,0 +1,4 @@
+#!/usr/bin/env bash
+
+sleep 60
+exit $XCCDF_RESULT_PASS
@@ -111,6 +111,7 @@ static struct oscap_module OVAL_EVAL = {
         "   --directives <file>\r\t\t\t\t - Use OVAL Directives content to specify desired results content.\n"
         "   --without-syschar \r\t\t\t\t - Don't provide system characteristic in result file.\n"
         "   --results <file>\r\t\t\t\t - Write OVAL Results into file.\n"
+        "   --stream-results\r\t\t\t\t - Write OVAL Results without building them in memory.\n"
         "   --report <file>\r\t\t\t\t - Create human readable (HTML) report from OVAL Results.\n"
         "   --skip-valid\r\t\t\t\t - Skip validation.\n"
         "   --datastream-id <id> \r\t\t\t\t - ID of the datastream in the collection to use.\n"
@@ -118,6 +119,8 @@ static struct oscap_module OVAL_EVAL = {
         "   --oval-id <id> \r\t\t\t\t - ID of the OVAL component ref in the datastream to use.\n"
         "                  \r\t\t\t\t   (only applicable for source datastreams)\n"
 	"   --probe-root <dir>\r\t\t\t\t - Change the root directory before scanning the system.\n"
+	"   --jobs <n>\r\t\t\t\t - Evaluate independent definitions using n threads.\n"
+	"   --timing-report <file>\r\t\t\t\t - Write the time spent collecting every object into file (JSON).\n"
 	"   --verbose <verbosity_level>\r\t\t\t\t - Turn on verbose mode at specified verbosity level.\n"
 	"   --verbose-log-file <file>\r\t\t\t\t - Write verbose information into file.\n",
     .opt_parser = getopt_oval_eval,
@@ -133,6 +136,7 @@ static struct oscap_module OVAL_COLLECT = {
 	"Options:\n"
 	"   --id <object>\r\t\t\t\t - Collect system characteristics ONLY for specified OVAL Object.\n"
         "   --syschar <file>\r\t\t\t\t - Write OVAL System Characteristic into file.\n"
+        "   --stream-results\r\t\t\t\t - Write OVAL System Characteristic without building it in memory.\n"
 	"   --variables <file>\r\t\t\t\t - Provide external variables expected by OVAL Definitions.\n"
         "   --skip-valid\r\t\t\t\t - Skip validation.\n"
 	"   --verbose <verbosity_level>\r\t\t\t\t - Turn on verbose mode at specified verbosity level.\n"
@@ -312,7 +316,10 @@ int app_collect_oval(const struct oscap_action *action)
 	/* output */
 	if (action->f_syschar != NULL) {
 		/* export OVAL System Characteristics */
-		oval_syschar_model_export(sys_model, action->f_syschar);
+		if (action->stream_results)
+			oval_syschar_model_export_stream(sys_model, action->f_syschar);
+		else
+			oval_syschar_model_export(sys_model, action->f_syschar);
 
 		/* validate OVAL System Characteristics */
 		if (action->validate && full_validation) {
@@ -351,6 +358,9 @@ int app_evaluate_oval(const struct oscap_action *action)
 		goto cleanup;
 	}
 
+	if (action->f_timing_report != NULL)
+		oscap_set_timing_report(action->f_timing_report);
+
 	/* create a new OVAL session */
 	if ((session = oval_session_new(action->f_oval)) == NULL) {
 		oscap_print_error();
@@ -371,6 +381,7 @@ int app_evaluate_oval(const struct oscap_action *action)
 	oval_session_set_variables(session, action->f_variables);
 
 	oval_session_set_remote_resources(session, action->remote_resources, download_reporting_callback);
+	oval_session_set_jobs(session, action->jobs);
 	/* load all necesary OVAL Definitions and bind OVAL Variables if provided */
 	if ((oval_session_load(session)) != 0)
 		goto cleanup;
@@ -392,6 +403,7 @@ int app_evaluate_oval(const struct oscap_action *action)
 	oval_session_set_results_export(session, action->f_results);
 	oval_session_set_report_export(session, action->f_report);
 	oval_session_set_export_system_characteristics(session, !action->without_sys_chars);
+	oval_session_set_results_stream(session, action->stream_results);
 	if (oval_session_export(session) != 0)
 		goto cleanup;
 
@@ -544,14 +556,17 @@ enum oval_opt {
     OVAL_OPT_OVAL_ID,
     OVAL_OPT_OUTPUT = 'o',
 	OVAL_OPT_PROBE_ROOT,
+	OVAL_OPT_JOBS,
 	OVAL_OPT_VERBOSE,
-	OVAL_OPT_VERBOSE_LOG_FILE
+	OVAL_OPT_VERBOSE_LOG_FILE,
+	OVAL_OPT_TIMING_REPORT
 };
 
 bool getopt_oval_eval(int argc, char **argv, struct oscap_action *action)
 {
 	action->doctype = OSCAP_DOCUMENT_OVAL_DEFINITIONS;
 	action->probe_root = NULL;
+	action->jobs = 1;
 
 	/* Command-options */
 	struct option long_options[] = {
@@ -561,10 +576,13 @@ bool getopt_oval_eval(int argc, char **argv, struct oscap_action *action)
 		{ "variables",	required_argument, NULL, OVAL_OPT_VARIABLES    },
 		{ "directives",	required_argument, NULL, OVAL_OPT_DIRECTIVES   },
 		{ "without-syschar",	no_argument, &action->without_sys_chars, 1},
+		{ "stream-results",	no_argument, &action->stream_results, 1},
 		{ "datastream-id",required_argument, NULL, OVAL_OPT_DATASTREAM_ID},
 		{ "oval-id",    required_argument, NULL, OVAL_OPT_OVAL_ID},
 		{ "skip-valid",	no_argument, &action->validate, 0 },
 		{ "probe-root", required_argument, NULL, OVAL_OPT_PROBE_ROOT},
+		{ "jobs", required_argument, NULL, OVAL_OPT_JOBS},
+		{ "timing-report", required_argument, NULL, OVAL_OPT_TIMING_REPORT},
 		{ "verbose", required_argument, NULL, OVAL_OPT_VERBOSE },
 		{ "verbose-log-file", required_argument, NULL, OVAL_OPT_VERBOSE_LOG_FILE },
 		{ "fetch-remote-resources", no_argument, &action->remote_resources, 1},
@@ -582,6 +600,11 @@ bool getopt_oval_eval(int argc, char **argv, struct oscap_action *action)
 		case OVAL_OPT_DATASTREAM_ID: action->f_datastream_id = optarg;	break;
 		case OVAL_OPT_OVAL_ID: action->f_oval_id = optarg;	break;
 		case OVAL_OPT_PROBE_ROOT: action->probe_root = optarg; break;
+		case OVAL_OPT_JOBS:
+			if (!parse_jobs_option(action, optarg))
+				return false;
+			break;
+		case OVAL_OPT_TIMING_REPORT: action->f_timing_report = optarg; break;
 		case OVAL_OPT_VERBOSE:
 			action->verbosity_level = optarg;
 			break;
@@ -613,6 +636,7 @@ bool getopt_oval_collect(int argc, char **argv, struct oscap_action *action)
 		{ "id",        	required_argument, NULL, OVAL_OPT_ID           },
 		{ "variables",	required_argument, NULL, OVAL_OPT_VARIABLES    },
 		{ "syschar",	required_argument, NULL, OVAL_OPT_SYSCHAR      },
+		{ "stream-results",	no_argument, &action->stream_results, 1},
 		{ "skip-valid",	no_argument, &action->validate, 0 },
 		{ "verbose", required_argument, NULL, OVAL_OPT_VERBOSE },
 		{ "verbose-log-file", required_argument, NULL, OVAL_OPT_VERBOSE_LOG_FILE },
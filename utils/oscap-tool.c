@@ -32,6 +32,7 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <stdarg.h>
+#include <stdlib.h>
 #include <errno.h>
 #include <limits.h>
 #include <cvss_score.h>
@@ -392,6 +393,24 @@ bool check_verbose_options(struct oscap_action *action)
 	return true;
 }
 
+bool parse_jobs_option(struct oscap_action *action, const char *arg)
+{
+	char *end;
+	long jobs;
+
+	errno = 0;
+	jobs = strtol(arg, &end, 10);
+
+	if (errno != 0 || end == arg || *end != '\0' || jobs < 1 || jobs > 256) {
+		oscap_module_usage(action->module, stderr,
+			"Invalid number of jobs '%s'! Please provide a number between 1 and 256.", arg);
+		return false;
+	}
+
+	action->jobs = (int)jobs;
+	return true;
+}
+
 void download_reporting_callback(bool warning, const char *format, ...)
 {
 	FILE *dest = stderr;
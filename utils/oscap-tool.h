@@ -116,6 +116,7 @@ struct oscap_action {
         char *f_report;
 	char *f_variables;
 	char *f_verbose_log;
+	char *f_timing_report;
 	/* others */
         char *profile;
         char *show;
@@ -145,11 +146,13 @@ struct oscap_action {
 	int progress;
 	int oval_results;
 	int without_sys_chars;
+	int stream_results;
 	int remediate;
 	char *sce_template;
 	int check_engine_results;
 	int export_variables;
         int list_dynamic;
+	int jobs;
 	char *probe_root;
 	char *verbosity_level;
 };
@@ -163,6 +166,7 @@ int oscap_module_call(struct oscap_action *action);
 
 void oscap_print_error(void);
 bool check_verbose_options(struct oscap_action *action);
+bool parse_jobs_option(struct oscap_action *action, const char *arg);
 void download_reporting_callback(bool warning, const char *format, ...);
 
 extern struct oscap_module OSCAP_ROOT_MODULE;
@@ -143,6 +143,7 @@ static struct oscap_module XCCDF_EVAL = {
         "   --cpe <name>\r\t\t\t\t - Use given CPE dictionary or language (autodetected)\n"
         "               \r\t\t\t\t   for applicability checks.\n"
         "   --oval-results\r\t\t\t\t - Save OVAL results as well.\n"
+        "   --stream-oval-results\r\t\t\t\t - Write OVAL results without building them in memory.\n"
         "   --sce-results\r\t\t\t\t - Save SCE results as well. (DEPRECATED! use --check-engine-results)\n"
         "   --check-engine-results\r\t\t\t\t - Save results from check engines loaded from plugins as well.\n"
         "   --export-variables\r\t\t\t\t - Export OVAL external variables provided by XCCDF.\n"
@@ -162,6 +163,9 @@ static struct oscap_module XCCDF_EVAL = {
 	"                   \r\t\t\t\t   (only applicable when datastream-id AND xccdf-id are not specified)\n"
 	"   --remediate \r\t\t\t\t - Automatically execute XCCDF fix elements for failed rules.\n"
 	"               \r\t\t\t\t   Use of this option is always at your own risk.\n"
+	"   --jobs <n>\r\t\t\t\t - Evaluate up to n rules at the same time.\n"
+	"   --timing-report <file>\r\t\t\t\t - Write the time spent checking every rule and collecting\n"
+	"                         \r\t\t\t\t   every OVAL object into file (JSON).\n"
 	"   --verbose <verbosity_level>\r\t\t\t\t - Turn on verbose mode at specified verbosity level.\n"
 	"   --verbose-log-file <file>\r\t\t\t\t - Write verbose informations into file.\n",
     .opt_parser = getopt_xccdf,
@@ -184,6 +188,7 @@ static struct oscap_module XCCDF_REMEDIATE = {
 			"  --results-arf <file>\r\t\t\t\t - Write ARF (result data stream) into file.\n"
 			"  --report <file>\r\t\t\t\t - Write HTML report into file.\n"
 			"  --oval-results\r\t\t\t\t - Save OVAL results.\n"
+			"  --stream-oval-results\r\t\t\t\t - Write OVAL results without building them in memory.\n"
 			"  --export-variables\r\t\t\t\t - Export OVAL external variables provided by XCCDF.\n"
 			"  --sce-results\r\t\t\t\t - Save SCE results. (DEPRECATED! use --check-engine-results)\n"
 			"  --check-engine-results\r\t\t\t\t - Save results from check engines loaded from plugins as well.\n"
@@ -451,6 +456,9 @@ int app_evaluate_xccdf(const struct oscap_action *action)
 		goto cleanup;
 	}
 
+	if (action->f_timing_report != NULL)
+		oscap_set_timing_report(action->f_timing_report);
+
 	/* syslog message */
 	syslog(priority, "Evaluation started. Content: %s, Profile: %s.", action->f_xccdf, action->profile);
 
@@ -487,12 +495,14 @@ int app_evaluate_xccdf(const struct oscap_action *action)
 	}
 
 	_register_progress_callback(session, action->progress);
+	xccdf_session_set_jobs(session, action->jobs);
 
 	/* Perform evaluation */
 	if (xccdf_session_evaluate(session) != 0)
 		goto cleanup;
 
 	xccdf_session_set_oval_results_export(session, action->oval_results);
+	xccdf_session_set_oval_results_stream(session, action->stream_results);
 	xccdf_session_set_oval_variables_export(session, action->export_variables);
 	xccdf_session_set_arf_export(session, action->f_results_arf);
 
@@ -627,6 +637,7 @@ int app_xccdf_remediate(const struct oscap_action *action)
 	xccdf_session_remediate(session);
 
 	xccdf_session_set_oval_results_export(session, action->oval_results);
+	xccdf_session_set_oval_results_stream(session, action->stream_results);
 	xccdf_session_set_oval_variables_export(session, action->export_variables);
 	xccdf_session_set_arf_export(session, action->f_results_arf);
 	xccdf_session_set_xccdf_export(session, action->f_results);
@@ -907,7 +918,9 @@ enum oval_opt {
     XCCDF_OPT_OUTPUT = 'o',
     XCCDF_OPT_RESULT_ID = 'i',
 	XCCDF_OPT_VERBOSE,
-	XCCDF_OPT_VERBOSE_LOG_FILE
+	XCCDF_OPT_VERBOSE_LOG_FILE,
+	XCCDF_OPT_JOBS,
+	XCCDF_OPT_TIMING_REPORT
 };
 
 bool getopt_xccdf(int argc, char **argv, struct oscap_action *action)
@@ -915,6 +928,7 @@ bool getopt_xccdf(int argc, char **argv, struct oscap_action *action)
 	assert(action != NULL);
 
 	action->doctype = OSCAP_DOCUMENT_XCCDF;
+	action->jobs = 1;
 
 	/* Command-options */
 	const struct option long_options[] = {
@@ -939,9 +953,12 @@ bool getopt_xccdf(int argc, char **argv, struct oscap_action *action)
 		{"sce-template", 	required_argument, NULL, XCCDF_OPT_SCE_TEMPLATE},
 		{ "verbose", required_argument, NULL, XCCDF_OPT_VERBOSE },
 		{ "verbose-log-file", required_argument, NULL, XCCDF_OPT_VERBOSE_LOG_FILE },
+		{"jobs",	required_argument, NULL, XCCDF_OPT_JOBS},
+		{"timing-report",	required_argument, NULL, XCCDF_OPT_TIMING_REPORT},
 	// flags
 		{"force",		no_argument, &action->force, 1},
 		{"oval-results",	no_argument, &action->oval_results, 1},
+		{"stream-oval-results",	no_argument, &action->stream_results, 1},
 		{"sce-results",	no_argument, &action->check_engine_results, 1},
 		{"check-engine-results", no_argument, &action->check_engine_results, 1},
 		{"skip-valid",		no_argument, &action->validate, 0},
@@ -989,6 +1006,11 @@ bool getopt_xccdf(int argc, char **argv, struct oscap_action *action)
 		case XCCDF_OPT_VERBOSE_LOG_FILE:
 			action->f_verbose_log = optarg;
 			break;
+		case XCCDF_OPT_JOBS:
+			if (!parse_jobs_option(action, optarg))
+				return false;
+			break;
+		case XCCDF_OPT_TIMING_REPORT:	action->f_timing_report = optarg; break;
 		case 0: break;
 		default: return oscap_module_usage(action->module, stderr, NULL);
 		}
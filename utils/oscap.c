@@ -78,6 +78,8 @@ int main(int argc, char **argv)
 {
     oscap_init();
     int ret = oscap_module_process(&OSCAP_ROOT_MODULE, argc, argv);
+    if (oscap_write_timing_report() != 0)
+        oscap_print_error();
     oscap_cleanup();
     return ret;
 }